@@ -0,0 +1,107 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BenchRunner.h"
+
+#include <chrono>
+#include <algorithm>
+#include <ctime>
+
+void BenchRunner::add(const std::string &name, const Fn &run, size_t bytes, const Fn &prepare) {
+    cases.push_back({name, run, bytes, prepare});
+}
+
+void BenchRunner::setFilter(const std::string &f) {
+    filter = f;
+}
+
+void BenchRunner::setMinTimeMs(uint32_t ms) {
+    minTimeMs = ms;
+}
+
+void BenchRunner::setMaxIterations(uint32_t n) {
+    maxIterations = n;
+}
+
+const std::vector<BenchRunner::Result> &BenchRunner::run() {
+    using clk = std::chrono::steady_clock;
+    results.clear();
+
+    for(auto &c: cases){
+        if(!filter.empty() and c.name.find(filter) == std::string::npos)
+            continue;
+
+        // Warm up caches and lazily initialised state
+        if(c.prepare) c.prepare();
+        c.run();
+
+        std::vector<double> samples;
+        clk::time_point start = clk::now();
+        while(samples.size() < maxIterations){
+            if(c.prepare) c.prepare();
+
+            clk::time_point t0 = clk::now();
+            c.run();
+            clk::time_point t1 = clk::now();
+            samples.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+            if(samples.size() >= minIterations and (t1 - start) >= std::chrono::milliseconds(minTimeMs))
+                break;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for(double s: samples)
+            sum += s;
+
+        Result r{};
+        r.name = c.name;
+        r.bytes = c.bytes;
+        r.iterations = samples.size();
+        r.nsMin = samples.front();
+        r.nsMedian = samples[samples.size() / 2];
+        r.nsP90 = samples[std::min(samples.size() - 1, samples.size() * 9 / 10)];
+        r.nsMean = sum / samples.size();
+        results.push_back(r);
+    }
+
+    return results;
+}
+
+void BenchRunner::writeJson(FILE *f, const std::string &suite) const {
+    fprintf(f, "{\n  \"suite\": \"%s\",\n  \"timestamp\": %ld,\n  \"results\": [\n", suite.c_str(), (long)time(nullptr));
+    for(size_t i=0; i<results.size(); i++){
+        const Result &r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"bytes\": %zu, \"iterations\": %u, \"ns_min\": %.0f, "
+                   "\"ns_median\": %.0f, \"ns_p90\": %.0f, \"ns_mean\": %.0f}%s\n",
+                r.name.c_str(), r.bytes, r.iterations, r.nsMin, r.nsMedian, r.nsP90, r.nsMean,
+                (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+void BenchRunner::printTable(FILE *f) const {
+    fprintf(f, "%-40s %10s %12s %12s %12s\n", "case", "iters", "median [us]", "p90 [us]", "MB/s");
+    for(auto &r: results){
+        double mbs = (r.bytes > 0 and r.nsMedian > 0) ? (double)r.bytes * 1000.0 / r.nsMedian : 0;
+        fprintf(f, "%-40s %10u %12.2f %12.2f %12.2f\n", r.name.c_str(), r.iterations,
+                r.nsMedian / 1000.0, r.nsP90 / 1000.0, mbs);
+    }
+}
@@ -0,0 +1,75 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BENCHRUNNER_H
+#define MGLIGHTFW_BENCHRUNNER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+/**
+ * Minimal micro-benchmark harness. Every case is timed call by call with the real (not simulated)
+ * monotonic clock, so median and p90 are not distorted by scheduler hiccups of a single long batch.
+ */
+class BenchRunner {
+public:
+    typedef std::function<void()> Fn;
+
+    struct Result {
+        std::string name;
+        size_t bytes;
+        uint32_t iterations;
+        double nsMin;
+        double nsMedian;
+        double nsP90;
+        double nsMean;
+    };
+
+    // prepare is called before every timed call and is not measured
+    void add(const std::string &name, const Fn &run, size_t bytes = 0, const Fn &prepare = nullptr);
+
+    void setFilter(const std::string &filter);
+    void setMinTimeMs(uint32_t ms);
+    void setMaxIterations(uint32_t n);
+
+    const std::vector<Result>& run();
+    void writeJson(FILE *f, const std::string &suite) const;
+    void printTable(FILE *f) const;
+
+private:
+    struct Case {
+        std::string name;
+        Fn run;
+        size_t bytes;
+        Fn prepare;
+    };
+
+    std::vector<Case> cases;
+    std::vector<Result> results;
+    std::string filter;
+    uint32_t minTimeMs = 300;
+    uint32_t minIterations = 10;
+    uint32_t maxIterations = 200000;
+};
+
+#endif //MGLIGHTFW_BENCHRUNNER_H
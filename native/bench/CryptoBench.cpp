@@ -0,0 +1,206 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Benches.h"
+#include "bleln/Encryption.h"
+#include "bleln/BLELNSessionEnc.h"
+
+#include <memory>
+
+namespace {
+    const size_t PAYLOAD_SIZES[] = {16, 64, 128, 240};
+
+    struct KeyPair {
+        mbedtls_mpi d{};
+        uint8_t pub[65]{};
+
+        KeyPair() { Encryption::ecdh_gen(pub, d); }
+        ~KeyPair() { mbedtls_mpi_free(&d); }
+    };
+
+    // Two ends of one BLELN session, as after the keys exchange
+    struct SessionPair {
+        BLELNSessionEnc srv, cli;
+        uint8_t salt[32]{};
+        uint8_t frameVer;
+
+        explicit SessionPair(uint8_t frameVer) : frameVer(frameVer) {
+            Encryption::random_bytes(salt, 32);
+            srv.makeMyKeys();
+            cli.makeMyKeys();
+            srv.deriveFriendsKey(cli.getMyPub(), cli.getMyNonce(), salt, 1, frameVer);
+            cli.deriveFriendsKey(srv.getMyPub(), srv.getMyNonce(), salt, 1, frameVer);
+        }
+    };
+}
+
+void registerCryptoBenches(BenchRunner &b) {
+    Encryption::randomizer_init();
+
+    auto kpA = std::make_shared<KeyPair>();
+    auto kpB = std::make_shared<KeyPair>();
+
+    /// *************** Key agreement ***************
+
+    b.add("ecdh_gen", [](){
+        KeyPair kp;
+    });
+
+    b.add("ecdh_shared", [kpA, kpB](){
+        uint8_t ss[32];
+        Encryption::ecdh_shared(kpA->d, kpB->pub, ss);
+    });
+
+    b.add("hkdf_sha256/32", [](){
+        uint8_t salt[36]{}, ikm[32]{}, info[13 + 65 + 65 + 12 + 12]{}, okm[32];
+        Encryption::hkdf_sha256(salt, sizeof(salt), ikm, sizeof(ikm), info, sizeof(info), okm, sizeof(okm));
+    }, 32);
+
+    /// *************** Signatures ***************
+
+    auto data = std::make_shared<std::vector<uint8_t>>(48);
+    Encryption::random_bytes(data->data(), data->size());
+
+    auto priv = std::make_shared<std::vector<uint8_t>>(32);
+    mbedtls_mpi_write_binary(&kpA->d, priv->data(), 32);
+
+    auto sign = std::make_shared<std::vector<uint8_t>>(64);
+    Encryption::signData_ECDSA_P256(data->data(), data->size(), priv->data(), 32, sign->data(), 64);
+
+    b.add("signData_ECDSA_P256", [data, priv](){
+        uint8_t s[64];
+        Encryption::signData_ECDSA_P256(data->data(), data->size(), priv->data(), 32, s, 64);
+    });
+
+    b.add("verifySign_ECDSA_P256", [data, sign, kpA](){
+        Encryption::verifySign_ECDSA_P256(data->data(), data->size(), sign->data(), 64, kpA->pub, 65);
+    });
+
+    // Public key parsed once, as BLELNAuthentication keeps manufacturer key
+    auto pubPoint = std::shared_ptr<mbedtls_ecp_point>(new mbedtls_ecp_point, [](mbedtls_ecp_point *p){
+        mbedtls_ecp_point_free(p);
+        delete p;
+    });
+    mbedtls_ecp_point_init(pubPoint.get());
+    Encryption::readPubKey_P256(kpA->pub, 65, *pubPoint);
+
+    b.add("verifySign_ECDSA_P256_parsed", [data, sign, pubPoint](){
+        Encryption::verifySign_ECDSA_P256(data->data(), data->size(), sign->data(), 64, *pubPoint);
+    });
+
+    /// *************** AES-GCM ***************
+
+    auto key = std::make_shared<std::vector<uint8_t>>(32);
+    Encryption::random_bytes(key->data(), 32);
+
+    // Keyed once, as BLELNSessionEnc does after deriveFriendsKey
+    auto gcm = std::shared_ptr<mbedtls_gcm_context>(new mbedtls_gcm_context, [](mbedtls_gcm_context *g){
+        mbedtls_gcm_free(g);
+        delete g;
+    });
+    mbedtls_gcm_init(gcm.get());
+    mbedtls_gcm_setkey(gcm.get(), MBEDTLS_CIPHER_ID_AES, key->data(), 256);
+
+    for(size_t n: PAYLOAD_SIZES){
+        auto in = std::make_shared<std::string>(n, 'x');
+        auto ct = std::make_shared<std::string>(n, '\0');
+        auto iv = std::make_shared<std::vector<uint8_t>>(12);
+        auto tag = std::make_shared<std::vector<uint8_t>>(16);
+        auto aad = std::make_shared<std::vector<uint8_t>>(12);
+        Encryption::encryptAESGCM(in.get(), iv->data(), tag->data(), aad->data(), ct.get(), key->data());
+
+        b.add("encryptAESGCM/" + std::to_string(n), [in, iv, tag, aad, key](){
+            std::string out(in->size(), '\0');
+            uint8_t t[16];
+            Encryption::encryptAESGCM(in.get(), iv->data(), t, aad->data(), &out, key->data());
+        }, n);
+
+        b.add("decryptAESGCM/" + std::to_string(n), [ct, iv, tag, aad, key](){
+            std::string out;
+            Encryption::decryptAESGCM((const uint8_t*)ct->data(), ct->size(), iv->data(), tag->data(), aad->data(),
+                                      &out, key->data());
+        }, n);
+
+        b.add("encryptAESGCM_ctx/" + std::to_string(n), [in, iv, aad, gcm](){
+            std::string out(in->size(), '\0');
+            uint8_t t[16];
+            Encryption::encryptAESGCM(gcm.get(), in.get(), iv->data(), t, aad->data(), &out);
+        }, n);
+
+        b.add("decryptAESGCM_ctx/" + std::to_string(n), [ct, iv, tag, aad, gcm](){
+            std::string out;
+            Encryption::decryptAESGCM(gcm.get(), (const uint8_t*)ct->data(), ct->size(), iv->data(), tag->data(),
+                                      aad->data(), &out);
+        }, n);
+    }
+
+    /// *************** Base64 ***************
+
+    b.add("base64Encode/64", [kpA](){
+        Encryption::base64Encode(kpA->pub + 1, 64);
+    }, 64);
+
+    auto b64 = std::make_shared<std::string>(Encryption::base64Encode(kpA->pub + 1, 64));
+    b.add("base64Decode/64", [b64](){
+        uint8_t out[64];
+        Encryption::base64Decode(*b64, out, sizeof(out));
+    }, 64);
+
+    /// *************** Session ***************
+
+    auto sp = std::make_shared<SessionPair>(BLELN_FRAME_VERSION_MAX);
+    auto sp1 = std::make_shared<SessionPair>(BLELN_FRAME_V1);
+
+    b.add("BLELNSessionEnc::deriveFriendsKey", [sp](){
+        sp->srv.deriveFriendsKey(sp->cli.getMyPub(), sp->cli.getMyNonce(), sp->salt, 1, sp->frameVer);
+    }, 0, [sp](){
+        // Keep both ends in sync, derive resets counters
+        sp->cli.deriveFriendsKey(sp->srv.getMyPub(), sp->srv.getMyNonce(), sp->salt, 1, sp->frameVer);
+    });
+
+    // Ticket resumption - HKDF only, no ECDH
+    b.add("BLELNSessionEnc::deriveResumedKey", [sp](){
+        sp->srv.deriveResumedKey(sp->cli.getResumeSecret(), sp->cli.getMyNonce(), sp->salt, 1, sp->frameVer);
+    });
+
+    for(size_t n: PAYLOAD_SIZES){
+        auto msg = std::make_shared<std::string>(n, 'm');
+        auto frame = std::make_shared<std::string>();
+
+        b.add("BLELNSessionEnc::encryptMessage/" + std::to_string(n), [sp, msg](){
+            std::string out;
+            sp->srv.encryptMessage(*msg, out);
+        }, n);
+
+        b.add("BLELNSessionEnc::decryptMessage/" + std::to_string(n), [sp, frame](){
+            std::string out;
+            sp->cli.decryptMessage((const uint8_t*)frame->data(), frame->size(), out);
+        }, n, [sp, msg, frame](){
+            // Every frame has a fresh counter, otherwise anti-replay rejects it
+            sp->srv.encryptMessage(*msg, *frame);
+        });
+
+        // v1 frames: random IV from the RNG for every message
+        b.add("BLELNSessionEnc::encryptMessage_v1/" + std::to_string(n), [sp1, msg](){
+            std::string out;
+            sp1->srv.encryptMessage(*msg, out);
+        }, n);
+    }
+}
@@ -0,0 +1,62 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Benches.h"
+#include "bleln/Encryption.h"
+#include "bleln/BLELNFragment.h"
+
+#include <memory>
+
+namespace {
+    // Fragments frame as for ATT MTU 247 and reassembles it, returns number of fragments (0 on failure)
+    size_t roundTrip(const std::string &frame, BLELNReassembler &r, std::string &out) {
+        size_t frags= 0;
+        bool complete= false;
+        BLELNFragmenter::send(frame, 247 - 3, 0, [&](const std::string &frag){
+            frags++;
+            complete= r.push((const uint8_t*)frag.data(), frag.size(), out) == BLELNReassembler::Result::Complete;
+            return true;
+        });
+        return complete ? frags : 0;
+    }
+}
+
+void registerFragmentBenches(BenchRunner &b) {
+    /// *************** Fragmentation of data frames ***************
+    // bytes - encrypted v3 frame (message + 20 bytes of overhead)
+
+    for(size_t n: {64, 240, 1024, 4096}){
+        auto frame = std::make_shared<std::string>(n + 4 + 16, '\0');
+        Encryption::random_bytes((uint8_t*)&(*frame)[0], frame->size());
+        auto r = std::make_shared<BLELNReassembler>();
+
+        std::string out;
+        size_t frags= roundTrip(*frame, *r, out);
+        if(frags == 0 or out != *frame){
+            Serial.printf("[E] FragmentBench - round trip of %u bytes failed\r\n", (unsigned)n);
+            continue;
+        }
+
+        b.add("BLELNFragment::roundTrip/" + std::to_string(n), [frame, r](){
+            std::string o;
+            roundTrip(*frame, *r, o);
+        }, frame->size());
+    }
+}
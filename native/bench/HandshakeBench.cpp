@@ -0,0 +1,112 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Benches.h"
+#include "bleln/Encryption.h"
+#include "bleln/BLELNHandshakeMsg.h"
+
+#include <memory>
+
+namespace {
+    // Fields of every handshake message, random but of the real sizes
+    struct HandshakeFields {
+        BLELNCert cert{};
+        uint8_t nonce[BLELN_TEST_NONCE_LEN]{};
+        uint8_t nonceSign[BLELN_NONCE_SIGN_LEN]{};
+        uint8_t ticket[BLELN_RESUME_TICKET_LEN]{};
+
+        HandshakeFields() {
+            cert.gen= 2;
+            Encryption::random_bytes(cert.mac, 6);
+            Encryption::random_bytes(cert.pubKey, BLELN_DEV_PUB_KEY_LEN);
+            Encryption::random_bytes(cert.sign, BLELN_MANU_SIGN_LEN);
+            cert.text= "2;" + Encryption::base64Encode(cert.mac, 6) + ";"
+                       + Encryption::base64Encode(cert.pubKey, BLELN_DEV_PUB_KEY_LEN);
+            Encryption::random_bytes(nonce, sizeof(nonce));
+            Encryption::random_bytes(nonceSign, sizeof(nonceSign));
+            Encryption::random_bytes(ticket, sizeof(ticket));
+        }
+    };
+
+    // Every message of one full handshake, as both sides build and parse them
+    size_t runHandshake(const HandshakeFields &f, bool tlv) {
+        BLELNCert cert;
+        uint8_t nonce[BLELN_TEST_NONCE_LEN];
+        uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
+        uint8_t ticket[BLELN_RESUME_TICKET_LEN];
+        uint32_t lifetime;
+        size_t bytes= 0;
+        std::string m;
+
+        // Server and client certificates
+        for(int i=0; i<2; i++){
+            m= BLELNHandshakeMsg::makeCert(tlv, f.cert);
+            BLELNHandshakeMsg::readCert(tlv, m, cert);
+            bytes+= m.size();
+        }
+
+        m= BLELNHandshakeMsg::makeChallengeNonce(tlv, f.nonce);
+        BLELNHandshakeMsg::readChallengeNonce(tlv, m, nonce);
+        bytes+= m.size();
+
+        m= BLELNHandshakeMsg::makeChallengeAnswerAndNonce(tlv, f.nonceSign, f.nonce);
+        BLELNHandshakeMsg::readChallengeAnswerAndNonce(tlv, m, nonceSign, nonce);
+        bytes+= m.size();
+
+        m= BLELNHandshakeMsg::makeChallengeAnswer(tlv, f.nonceSign);
+        BLELNHandshakeMsg::readChallengeAnswer(tlv, m, nonceSign);
+        bytes+= m.size();
+
+        m= BLELNHandshakeMsg::makeAuthOk(tlv);
+        BLELNHandshakeMsg::readAuthOk(tlv, m);
+        bytes+= m.size();
+
+        m= BLELNHandshakeMsg::makeTicket(tlv, f.ticket, BLELN_RESUME_TICKET_LIFETIME_S);
+        BLELNHandshakeMsg::readTicket(tlv, m, ticket, &lifetime);
+        bytes+= m.size();
+
+        return bytes;
+    }
+}
+
+void registerHandshakeBenches(BenchRunner &b) {
+    auto f = std::make_shared<HandshakeFields>();
+
+    /// *************** Handshake messages encoding ***************
+    // bytes - plain handshake messages of one connection (frame overhead is the same for both)
+
+    for(bool tlv: {false, true}){
+        std::string enc= tlv ? "tlv" : "csv";
+
+        b.add("BLELNHandshakeMsg::handshake/" + enc, [f, tlv](){
+            runHandshake(*f, tlv);
+        }, runHandshake(*f, tlv));
+
+        auto cert = std::make_shared<std::string>(BLELNHandshakeMsg::makeCert(tlv, f->cert));
+        b.add("BLELNHandshakeMsg::makeCert/" + enc, [f, tlv](){
+            BLELNHandshakeMsg::makeCert(tlv, f->cert);
+        }, cert->size());
+
+        b.add("BLELNHandshakeMsg::readCert/" + enc, [cert, tlv](){
+            BLELNCert out;
+            BLELNHandshakeMsg::readCert(tlv, *cert, out);
+        }, cert->size());
+    }
+}
@@ -0,0 +1,187 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Benches.h"
+#include "HostNode.h"
+#include "HostRadio.h"
+#include "HostProvisioning.h"
+#include "config.h"
+#include "bleln/BLELNServer.h"
+#include "bleln/BLELNClient.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <set>
+
+#define STREAM_CLIENTS      4
+#define STREAM_MSG_LEN      4000
+
+namespace {
+    /**
+     * BLELN server with four connected and authorised clients, all on host nodes. One case is one longest
+     * message from server to every client at once - all of them in server TX queues together, competing
+     * for host TX buffers (HostRadio::LinkModel::hostTxBufs). Clients scan on their own, by name - server of
+     * worker rig advertises the same service.
+     */
+    class StreamRig : public NimBLEScanCallbacks {
+    public:
+        bool setUp() {
+            HostProvisioning::ManufacturerKey manuKey{};
+            if(!HostProvisioning::makeManufacturerKey(manuKey)
+               or !HostProvisioning::provisionCert(&srvNode, manuKey))
+                return false;
+            for(auto &n: cliNodes){
+                if(!HostProvisioning::provisionCert(&n, manuKey))
+                    return false;
+            }
+
+            HostNode::setCurrent(&srvNode);
+            prefs.begin("mgld", false);
+            server.setOnMessageReceivedCallback([this](uint16_t h, const std::string &msg){
+                std::lock_guard<std::mutex> lock(mtx);
+                handles.insert(h);
+                cv.notify_all();
+            });
+            server.start(&prefs, "stream-srv", BLELN_HTTP_REQUESTER_UUID);
+
+            for(int i=0; i<STREAM_CLIENTS; i++){
+                HostNode::setCurrent(&cliNodes[i]);
+                BLELNClient *c= &clients[i];
+                c->start(cliNodes[i].getName(), [this](const std::string &msg){
+                    if(msg.size() != STREAM_MSG_LEN)
+                        return;
+                    std::lock_guard<std::mutex> lock(mtx);
+                    received++;
+                    cv.notify_all();
+                });
+                auto *scan= NimBLEDevice::getScan();
+                scan->setScanCallbacks(this, false);
+                scan->setActiveScan(true);
+                scan->start(5000, false, false);
+            }
+
+            // Messages are dropped until handshake is done - send until server knows every client
+            for(int t=0; t<100; t++){
+                for(auto &c: clients)
+                    c.sendEncrypted("$NTP");
+
+                std::unique_lock<std::mutex> lock(mtx);
+                if(cv.wait_for(lock, std::chrono::milliseconds(100), [this]{ return handles.size() == STREAM_CLIENTS; }))
+                    return true;
+            }
+            return false;
+        }
+
+        // One message to every client, waits until all of them got it
+        bool stream() {
+            std::unique_lock<std::mutex> lock(mtx);
+            received= 0;
+            std::set<uint16_t> hs= handles;
+            lock.unlock();
+
+            for(uint16_t h: hs)
+                server.sendEncrypted(h, msg);
+
+            lock.lock();
+            return cv.wait_for(lock, std::chrono::seconds(2), [this]{ return received == STREAM_CLIENTS; });
+        }
+
+        // Parameters server links run at, as BLELNLinkPolicy of both ends requested them
+        void printLinks() {
+            HostNode::setCurrent(&srvNode);
+            std::lock_guard<std::mutex> lock(mtx);
+            for(uint16_t h: handles){
+                HostRadio::ConnParams p= HostRadio::get().getLinkParams(h);
+                Serial.printf("[D] StreamBench - link %u: interval %u, latency %u, data len %u, phy %s, updates %u\r\n",
+                              h, p.interval, p.latency, p.txOctets, p.phy2M ? "2M" : "1M", p.updates);
+            }
+        }
+
+        void onResult(const NimBLEAdvertisedDevice *dev) override {
+            if(dev->getName() != "stream-srv")
+                return;
+
+            for(int i=0; i<STREAM_CLIENTS; i++){
+                if(HostNode::current() == &cliNodes[i]){
+                    NimBLEDevice::getScan()->stop();
+                    clients[i].beginConnect(dev, [](bool, int){});
+                }
+            }
+        }
+
+    private:
+        HostNode srvNode{"stream-srv"};
+        HostNode cliNodes[STREAM_CLIENTS]{HostNode("stream-cli1"), HostNode("stream-cli2"), HostNode("stream-cli3"), HostNode("stream-cli4")};
+        Preferences prefs;
+        BLELNServer server;
+        BLELNClient clients[STREAM_CLIENTS];
+        std::string msg= "$STRM," + std::string(STREAM_MSG_LEN - 6, 'x');
+
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::set<uint16_t> handles;
+        uint32_t received= 0;
+    };
+}
+
+void registerStreamBenches(BenchRunner &b) {
+    /// *************** BLELN server streaming ***************
+    // bytes - plain data of all clients, rig is set up on first use only
+
+    static StreamRig *rig= nullptr;
+    static bool ready= false;
+
+    auto setUp= [](){
+        if(rig == nullptr){
+            rig= new StreamRig();
+            ready= rig->setUp();
+            if(!ready)
+                Serial.println("[E] StreamBench - BLELN rig set up failed");
+        }
+    };
+
+    auto stream= [](){
+        if(ready and !rig->stream()){
+            ready= false;
+            Serial.println("[E] StreamBench - message lost");
+        }
+    };
+
+    b.add("BLELNServer::streamTo4Clients", stream, STREAM_CLIENTS * STREAM_MSG_LEN, setUp);
+
+    // Link delivering in 15 ms at default 30 ms connection interval - time scales with interval chosen by
+    // link policy, so the case shows what the policy gains
+    static bool printed= false;
+    b.add("BLELNServer::streamTo4Clients/latency15", [stream](){
+        HostRadio::LinkModel m= HostRadio::get().getLinkModel();
+        HostRadio::LinkModel slow= m;
+        slow.latencyMs= 15;
+        HostRadio::get().setLinkModel(slow);
+        stream();
+        HostRadio::get().setLinkModel(m);
+    }, STREAM_CLIENTS * STREAM_MSG_LEN, [setUp](){
+        setUp();
+        if(ready and !printed){
+            printed= true;
+            rig->printLinks();
+        }
+    });
+}
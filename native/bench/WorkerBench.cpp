@@ -0,0 +1,145 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Benches.h"
+#include "HostNode.h"
+#include "HostProvisioning.h"
+#include "config.h"
+#include "bleln/BLELNServer.h"
+#include "bleln/BLELNClient.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace {
+    /**
+     * BLELN server and client on two host nodes, connected and authorised. Server's data characteristic
+     * callbacks are wrapped - a received write is held back until the timed call passes it on, so the case
+     * measures exactly NimBLE write callback to onMsgReceived (server worker wake-up, reassembly, decryption).
+     */
+    class WorkerRig : public NimBLECharacteristicCallbacks {
+    public:
+        bool setUp() {
+            HostProvisioning::ManufacturerKey manuKey{};
+            if(!HostProvisioning::makeManufacturerKey(manuKey)
+               or !HostProvisioning::provisionCert(&srvNode, manuKey)
+               or !HostProvisioning::provisionCert(&cliNode, manuKey))
+                return false;
+
+            HostNode::setCurrent(&srvNode);
+            prefs.begin("mgld", false);
+            server.setOnMessageReceivedCallback([this](uint16_t h, const std::string &msg){
+                std::lock_guard<std::mutex> lock(mtx);
+                received++;
+                cv.notify_all();
+            });
+            server.start(&prefs, "bench-srv", BLELN_HTTP_REQUESTER_UUID);
+
+            NimBLECharacteristic *ch= NimBLEDevice::getServer()->getServiceByUUID(BLELN_HTTP_REQUESTER_UUID)
+                                        ->getCharacteristic(BLELNBase::DATA_TO_SER_UUID);
+            serverClb= ch->getCallbacks();
+            ch->setCallbacks(this);
+
+            HostNode::setCurrent(&cliNode);
+            client.start("bench-cli", [](const std::string&){});
+            client.startServerSearch(5000, BLELN_HTTP_REQUESTER_UUID, [this](const NimBLEAdvertisedDevice *dev){
+                if(dev != nullptr)
+                    client.beginConnect(dev, [](bool, int){});
+            });
+
+            // Messages are dropped until handshake is done - send until one gets through
+            for(int i=0; i<100; i++){
+                if(sendAndHold() and deliver())
+                    return true;
+            }
+            return false;
+        }
+
+        // Client sends one message, server's write callback holds it
+        bool sendAndHold() {
+            std::unique_lock<std::mutex> lock(mtx);
+            held= false;
+            lock.unlock();
+
+            client.sendEncrypted("$NTP");
+
+            lock.lock();
+            return cv.wait_for(lock, std::chrono::milliseconds(100), [this]{ return held; });
+        }
+
+        // Passes held write to server as NimBLE would and waits for onMsgReceived
+        bool deliver() {
+            std::unique_lock<std::mutex> lock(mtx);
+            uint32_t before= received;
+            lock.unlock();
+
+            serverClb->onWrite(heldCh, heldInfo);
+
+            lock.lock();
+            return cv.wait_for(lock, std::chrono::milliseconds(500), [this, before]{ return received != before; });
+        }
+
+        void onWrite(NimBLECharacteristic *c, NimBLEConnInfo &info) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            heldCh= c;
+            heldInfo= info;
+            held= true;
+            cv.notify_all();
+        }
+
+    private:
+        HostNode srvNode{"bench-srv"};
+        HostNode cliNode{"bench-cli"};
+        Preferences prefs;
+        BLELNServer server;
+        BLELNClient client;
+        NimBLECharacteristicCallbacks *serverClb= nullptr;
+
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool held= false;
+        NimBLECharacteristic *heldCh= nullptr;
+        NimBLEConnInfo heldInfo;
+        uint32_t received= 0;
+    };
+}
+
+void registerWorkerBenches(BenchRunner &b) {
+    /// *************** BLELN worker latency ***************
+    // Rig is set up on first use only (it runs a full handshake) and keeps running until process exit
+
+    static WorkerRig *rig= nullptr;
+    static bool ready= false;
+
+    b.add("BLELNServer::writeToMsgReceived", [](){
+        if(ready)
+            rig->deliver();
+    }, 0, [](){
+        if(rig == nullptr){
+            rig= new WorkerRig();
+            ready= rig->setUp();
+            if(!ready)
+                Serial.println("[E] WorkerBench - BLELN rig set up failed");
+        }
+        if(ready)
+            ready= rig->sendAndHold();
+    });
+}
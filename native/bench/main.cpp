@@ -0,0 +1,80 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+/*
+ * Host micro-benchmarks of BLELN building blocks.
+ *
+ *   pio run -e native_bench && .pio/build/native_bench/program [--filter TEXT] [--min-time MS] [--out FILE]
+ *
+ * Results are printed as a table and written as JSON (to FILE or stdout). Compare them against a
+ * baseline with tools/bench_gate.py.
+ */
+
+#include <Arduino.h>
+#include <string>
+#include <cstdlib>
+
+#include "Benches.h"
+
+int main(int argc, char **argv) {
+    BenchRunner runner;
+    std::string out;
+
+    for(int i=1; i<argc; i++){
+        std::string a = argv[i];
+        if(a == "--filter" and i+1 < argc)
+            runner.setFilter(argv[++i]);
+        else if(a == "--min-time" and i+1 < argc)
+            runner.setMinTimeMs(strtoul(argv[++i], nullptr, 10));
+        else if(a == "--max-iterations" and i+1 < argc)
+            runner.setMaxIterations(strtoul(argv[++i], nullptr, 10));
+        else if(a == "--out" and i+1 < argc)
+            out = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--filter TEXT] [--min-time MS] [--max-iterations N] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    registerCryptoBenches(runner);
+    registerHandshakeBenches(runner);
+    registerFragmentBenches(runner);
+    registerWorkerBenches(runner);
+    registerStreamBenches(runner);
+
+    runner.run();
+    runner.printTable(stderr);
+
+    if(out.empty()){
+        runner.writeJson(stdout, "bleln");
+    } else {
+        FILE *f = fopen(out.c_str(), "w");
+        if(f == nullptr){
+            fprintf(stderr, "Cannot open %s\n", out.c_str());
+            return 1;
+        }
+        runner.writeJson(f, "bleln");
+        fclose(f);
+    }
+
+    fflush(stdout);
+    // BLELN rigs leave firmware tasks running - leave without running destructors under them
+    std::_Exit(0);
+}
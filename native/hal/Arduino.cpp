@@ -0,0 +1,183 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Arduino.h"
+#include "HostClock.h"
+#include "HostNode.h"
+
+#include <random>
+#include <mutex>
+
+#undef settimeofday
+
+EspClass ESP;
+HardwareSerial Serial;
+
+namespace {
+    std::mutex rndMtx;
+    std::random_device rndDev;
+    std::mt19937 rnd(rndDev());
+}
+
+/// *************** Time ***************
+
+unsigned long millis() {
+    return HostClock::millis();
+}
+
+unsigned long micros() {
+    return (unsigned long)HostClock::micros();
+}
+
+void delay(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms) {
+    time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return info->tm_year > (2016 - 1900);
+}
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3) {
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+int hostSetTimeOfDay(const struct timeval *tv, const struct timezone *tz) {
+    // Host clock is already synchronised - just report what device would set
+    char buf[64];
+    int n = snprintf(buf, sizeof(buf), "[HOST] settimeofday(%ld)\n", (long)tv->tv_sec);
+    HostNode::current()->log(buf, n);
+    return 0;
+}
+
+/// *************** GPIO and LEDC ***************
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+}
+
+int digitalRead(uint8_t pin) {
+    // Buttons are pulled-up and never pressed
+    return HIGH;
+}
+
+uint32_t ledcSetup(uint8_t ch, uint32_t freq, uint8_t resolutionBits) {
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t ch) {
+}
+
+void ledcWrite(uint8_t ch, uint32_t duty) {
+    HostNode::current()->setLedcDuty(ch, duty);
+}
+
+/// *************** ESP-IDF ***************
+
+uint32_t esp_random() {
+    std::lock_guard<std::mutex> lock(rndMtx);
+    return rnd();
+}
+
+void esp_fill_random(void *buf, size_t len) {
+    std::lock_guard<std::mutex> lock(rndMtx);
+    auto *b = static_cast<uint8_t*>(buf);
+    for(size_t i=0; i<len; i++)
+        b[i] = (uint8_t)rnd();
+}
+
+void esp_restart() {
+    Serial.println("[HOST] esp_restart() - exiting");
+    fflush(stdout);
+    std::_Exit(0);
+}
+
+uint64_t EspClass::getEfuseMac() {
+    return HostNode::current()->getEfuseMac();
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return 320 * 1024;
+}
+
+/// *************** Serial ***************
+
+void HardwareSerial::begin(unsigned long baud) {
+}
+
+size_t HardwareSerial::print(const char *s) {
+    size_t n = strlen(s);
+    HostNode::current()->log(s, n);
+    return n;
+}
+
+size_t HardwareSerial::print(const String &s) {
+    return print(s.c_str());
+}
+
+size_t HardwareSerial::print(char c) {
+    HostNode::current()->log(&c, 1);
+    return 1;
+}
+
+size_t HardwareSerial::print(int n) {
+    return print(std::to_string(n).c_str());
+}
+
+size_t HardwareSerial::print(unsigned int n) {
+    return print(std::to_string(n).c_str());
+}
+
+size_t HardwareSerial::print(long n) {
+    return print(std::to_string(n).c_str());
+}
+
+size_t HardwareSerial::print(unsigned long n) {
+    return print(std::to_string(n).c_str());
+}
+
+size_t HardwareSerial::print(double n) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.2f", n);
+    return print(buf);
+}
+
+size_t HardwareSerial::println() {
+    return print("\r\n");
+}
+
+size_t HardwareSerial::printf(const char *fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if(n < 0)
+        return 0;
+
+    n = std::min(n, (int)sizeof(buf) - 1);
+    HostNode::current()->log(buf, n);
+    return n;
+}
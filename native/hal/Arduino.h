@@ -0,0 +1,117 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_ARDUINO_H
+#define MGLIGHTFW_HOST_ARDUINO_H
+
+/**
+ * Host replacement of the ESP32 Arduino core. Only what firmware in src/ uses is provided.
+ * Device dependent state (MAC, GPIO, console) belongs to HostNode::current().
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <climits>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+#include <sys/time.h>
+
+#include "WString.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+using std::min;
+using std::max;
+
+#define F(s)            (s)
+#define PROGMEM
+
+#define LOW             0x0
+#define HIGH            0x1
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+
+// Time
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+void configTzTime(const char *tz, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+
+// settimeofday() would try to change clock of the host machine
+int hostSetTimeOfDay(const struct timeval *tv, const struct timezone *tz);
+#define settimeofday(tv, tz) hostSetTimeOfDay((tv), (tz))
+
+// GPIO and LEDC
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint32_t ledcSetup(uint8_t ch, uint32_t freq, uint8_t resolutionBits);
+void ledcAttachPin(uint8_t pin, uint8_t ch);
+void ledcWrite(uint8_t ch, uint32_t duty);
+
+// ESP-IDF
+uint32_t esp_random();
+void esp_fill_random(void *buf, size_t len);
+[[noreturn]] void esp_restart();
+
+class EspClass {
+public:
+    uint64_t getEfuseMac();
+    uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+
+    size_t print(const char *s);
+    size_t print(const String &s);
+    size_t print(char c);
+    size_t print(int n);
+    size_t print(unsigned int n);
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t print(double n);
+
+    size_t println();
+    template<typename T>
+    size_t println(const T &v) {
+        size_t n = print(v);
+        return n + println();
+    }
+
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+extern HardwareSerial Serial;
+
+#endif //MGLIGHTFW_HOST_ARDUINO_H
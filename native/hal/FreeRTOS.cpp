@@ -0,0 +1,250 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "HostClock.h"
+#include "HostNode.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+
+struct HostTask {
+    std::string name;
+    uint32_t stackDepth;
+    HostNode *node;
+};
+
+struct HostQueue {
+    std::mutex mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+namespace {
+    thread_local HostTask *selfTask = nullptr;
+
+    struct TaskStart {
+        TaskFunction_t fn;
+        void *arg;
+        HostTask *task;
+    };
+
+    template<typename Pred>
+    bool waitFor(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, TickType_t ticks, Pred pred) {
+        if(ticks == portMAX_DELAY) {
+            cv.wait(lock, pred);
+            return true;
+        }
+
+        return cv.wait_for(lock, HostClock::toRealDuration(ticks), pred);
+    }
+
+    BaseType_t queueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait, bool front) {
+        if(q == nullptr)
+            return errQUEUE_FULL;
+
+        std::unique_lock<std::mutex> lock(q->mtx);
+        if(!waitFor(q->notFull, lock, ticksToWait, [q]{ return q->items.size() < q->length; }))
+            return errQUEUE_FULL;
+
+        std::vector<uint8_t> v(q->itemSize);
+        if(q->itemSize > 0 and item != nullptr)
+            memcpy(v.data(), item, q->itemSize);
+
+        if(front)
+            q->items.push_front(std::move(v));
+        else
+            q->items.push_back(std::move(v));
+
+        q->notEmpty.notify_one();
+        return pdPASS;
+    }
+
+    BaseType_t queueReceive(QueueHandle_t q, void *buffer, TickType_t ticksToWait, bool remove) {
+        if(q == nullptr)
+            return pdFALSE;
+
+        std::unique_lock<std::mutex> lock(q->mtx);
+        if(!waitFor(q->notEmpty, lock, ticksToWait, [q]{ return !q->items.empty(); }))
+            return pdFALSE;
+
+        if(q->itemSize > 0 and buffer != nullptr)
+            memcpy(buffer, q->items.front().data(), q->itemSize);
+
+        if(remove) {
+            q->items.pop_front();
+            q->notFull.notify_one();
+        }
+
+        return pdTRUE;
+    }
+}
+
+/// *************** Tasks ***************
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *createdTask, BaseType_t coreId) {
+    auto *task = new HostTask{name != nullptr ? name : "", stackDepth, HostNode::current()};
+    auto *start = new TaskStart{fn, arg, task};
+
+    if(createdTask != nullptr)
+        *createdTask = task;
+
+    std::thread([start](){
+        selfTask = start->task;
+        HostNode::setCurrent(start->task->node);
+        start->fn(start->arg);
+        // Handles may still be held by firmware, so HostTask is intentionally never freed
+        delete start;
+    }).detach();
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *createdTask) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, createdTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if(task != nullptr and task != selfTask){
+        HostNode::current()->log("[HOST] vTaskDelete() of other task is not supported\n", 52);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if(ticks == 0)
+        std::this_thread::yield();
+    else
+        HostClock::sleepMs(ticks * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount() {
+    return HostClock::millis() / portTICK_PERIOD_MS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return selfTask;
+}
+
+const char *pcTaskGetName(TaskHandle_t task) {
+    if(task == nullptr)
+        task = selfTask;
+
+    return task != nullptr ? task->name.c_str() : "main";
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Host threads have megabytes of stack - report the configured depth
+    if(task == nullptr)
+        task = selfTask;
+
+    return task != nullptr ? task->stackDepth : 0;
+}
+
+/// *************** Queues ***************
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    auto *q = new HostQueue();
+    q->length = length;
+    q->itemSize = itemSize;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait) {
+    return queueSend(q, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void *item, TickType_t ticksToWait) {
+    return queueSend(q, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t ticksToWait) {
+    return queueSend(q, item, ticksToWait, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *buffer, TickType_t ticksToWait) {
+    return queueReceive(q, buffer, ticksToWait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *buffer, TickType_t ticksToWait) {
+    return queueReceive(q, buffer, ticksToWait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    if(q == nullptr)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(q->mtx);
+    return q->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+    if(q == nullptr)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(q->mtx);
+    return q->length - q->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    if(q == nullptr)
+        return pdFAIL;
+
+    std::lock_guard<std::mutex> lock(q->mtx);
+    q->items.clear();
+    q->notFull.notify_all();
+    return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    delete q;
+}
+
+/// *************** Semaphores ***************
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t s = xQueueCreate(1, 0);
+    xQueueSend(s, nullptr, 0);
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+    SemaphoreHandle_t s = xQueueCreate(maxCount, 0);
+    for(UBaseType_t i=0; i<initialCount; i++)
+        xQueueSend(s, nullptr, 0);
+
+    return s;
+}
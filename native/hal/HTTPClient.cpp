@@ -0,0 +1,246 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "HTTPClient.h"
+#include "HostNode.h"
+#include "HostClock.h"
+
+#include <ArduinoJson.h>
+#include <mutex>
+
+namespace {
+    std::mutex httpMtx;
+    uint32_t latencyMs = 150;
+    uint32_t dnsMs = 20;
+    uint32_t handshakeMs = 600;     // TCP and TLS with certificate verification on ESP32-C3
+    uint32_t keepAliveMs = 75000;   // nginx default
+    uint32_t requestCount = 0;
+    uint32_t connectionCount = 0;
+
+    const char *settingsResponse = R"({"DLI":1000,"DS":420,"DE":1320,"SSD":30,"SRD":30})";
+
+    HostHttp::Handler handler = HostHttp::apiHandler;
+}
+
+/// *************** HostHttp ***************
+
+void HostHttp::setHandler(const Handler &h) {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    handler = h ? h : Handler(apiHandler);
+}
+
+int HostHttp::apiHandler(const HostHttpRequest &req, std::string &response) {
+    const std::string batchPoint = "light/batch.php";
+    if(req.url.size() < batchPoint.size() or req.url.compare(req.url.size() - batchPoint.size(), batchPoint.size(), batchPoint) != 0){
+        response = settingsResponse;
+        return HTTP_CODE_OK;
+    }
+
+    DynamicJsonDocument in(4096);
+    if(req.method != "POST" or deserializeJson(in, req.body) != DeserializationError::Ok){
+        response.clear();
+        return 400;
+    }
+
+    DynamicJsonDocument out(4096);
+    JsonArray talks = out.createNestedArray("talks");
+    for(JsonObject t: in["talks"].as<JsonArray>()){
+        JsonObject r = talks.createNestedObject();
+        r["id"] = t["id"];
+        r["code"] = HTTP_CODE_OK;
+        r["body"] = settingsResponse;
+    }
+    response.clear();
+    serializeJson(out, response);
+    return HTTP_CODE_OK;
+}
+
+int HostHttp::handle(const HostHttpRequest &req, std::string &response) {
+    Handler h;
+    {
+        std::lock_guard<std::mutex> lock(httpMtx);
+        h = handler;
+    }
+    return h(req, response);
+}
+
+void HostHttp::setLatencyMs(uint32_t ms) {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    latencyMs = ms;
+}
+
+uint32_t HostHttp::getLatencyMs() {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    return latencyMs;
+}
+
+uint32_t HostHttp::getRequestCount() {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    return requestCount;
+}
+
+void HostHttp::setConnectTimes(uint32_t dns, uint32_t handshake, uint32_t keepAlive) {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    dnsMs = dns;
+    handshakeMs = handshake;
+    keepAliveMs = keepAlive;
+}
+
+uint32_t HostHttp::getDnsMs() {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    return dnsMs;
+}
+
+uint32_t HostHttp::getHandshakeMs() {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    return handshakeMs;
+}
+
+uint32_t HostHttp::getKeepAliveMs() {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    return keepAliveMs;
+}
+
+uint32_t HostHttp::getConnectionCount() {
+    std::lock_guard<std::mutex> lock(httpMtx);
+    return connectionCount;
+}
+
+/// *************** WiFiClient ***************
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+    IPAddress ip;
+    if(!WiFi.hostByName(host, ip))
+        return 0;
+    return connect(ip, port);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    stop();
+    if(!WiFi.isConnected())
+        return 0;
+
+    vTaskDelay(pdMS_TO_TICKS(HostHttp::getHandshakeMs()));
+    {
+        std::lock_guard<std::mutex> lock(httpMtx);
+        connectionCount++;
+    }
+    open = true;
+    lastUseMs = HostClock::millis();
+    return 1;
+}
+
+uint8_t WiFiClient::connected() {
+    // Close by API host after its keep-alive timeout is not seen here, only by the next request - like
+    // a socket whose FIN did not arrive yet
+    if(open and !WiFi.isConnected())
+        open = false;
+    return open;
+}
+
+void WiFiClient::stop() {
+    open = false;
+}
+
+/// *************** HTTPClient ***************
+
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+    req = HostHttpRequest();
+    req.url = url.c_str();
+    resp.clear();
+    this->client = &client;
+    return req.url.rfind("http", 0) == 0;
+}
+
+void HTTPClient::end() {
+    // Kept open for the next request, like keep-alive answer of HTTP/1.1 server
+    if(client != nullptr and !reuse)
+        client->stop();
+    client = nullptr;
+}
+
+void HTTPClient::setReuse(bool r) {
+    reuse = r;
+}
+
+void HTTPClient::addHeader(const String &name, const String &value) {
+    req.headers.emplace_back(name.c_str(), value.c_str());
+}
+
+int HTTPClient::GET() {
+    return send("GET", "");
+}
+
+int HTTPClient::POST(const String &payload) {
+    return send("POST", payload.c_str());
+}
+
+int HTTPClient::POST(uint8_t *payload, size_t size) {
+    return send("POST", std::string(reinterpret_cast<const char*>(payload), size));
+}
+
+String HTTPClient::getString() {
+    return String(resp.c_str());
+}
+
+int HTTPClient::getSize() {
+    return (int)resp.size();
+}
+
+String HTTPClient::errorToString(int error) {
+    switch(error){
+        case HTTPC_ERROR_CONNECTION_REFUSED: return String("connection refused");
+        case HTTPC_ERROR_SEND_HEADER_FAILED: return String("send header failed");
+        case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return String("send payload failed");
+        case HTTPC_ERROR_NOT_CONNECTED: return String("not connected");
+        case HTTPC_ERROR_CONNECTION_LOST: return String("connection lost");
+        case HTTPC_ERROR_NO_HTTP_SERVER: return String("no HTTP server");
+        case HTTPC_ERROR_READ_TIMEOUT: return String("read Timeout");
+        default: return String();
+    }
+}
+
+int HTTPClient::send(const char *method, const std::string &body) {
+    if(client == nullptr)
+        return HTTPC_ERROR_NOT_CONNECTED;
+
+    if(!client->connected()){
+        size_t hostStart = req.url.find("://");
+        hostStart = (hostStart == std::string::npos) ? 0 : hostStart + 3;
+        std::string host = req.url.substr(hostStart, req.url.find('/', hostStart) - hostStart);
+        if(!client->connect(host.c_str(), 443))
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+    } else if((HostClock::millis() - client->lastUseMs) >= HostHttp::getKeepAliveMs()){
+        // Reused connection already closed by API host
+        client->stop();
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    req.method = method;
+    req.body = body;
+    {
+        std::lock_guard<std::mutex> lock(httpMtx);
+        requestCount++;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(HostHttp::getLatencyMs()));
+    client->lastUseMs = HostClock::millis();
+    return HostHttp::handle(req, resp);
+}
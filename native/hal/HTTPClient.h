@@ -0,0 +1,104 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_HTTPCLIENT_H
+#define MGLIGHTFW_HOST_HTTPCLIENT_H
+
+/**
+ * Host replacement of ESP32 HTTPClient. Requests never leave the process - they are answered by
+ * HostHttp handler, which by default behaves like MioGiapicco API returning device settings.
+ */
+
+#include "Arduino.h"
+#include "WiFi.h"
+
+#include <vector>
+#include <utility>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_NO_STREAM           (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER      (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM        (-8)
+#define HTTPC_ERROR_ENCODING            (-9)
+#define HTTPC_ERROR_STREAM_WRITE        (-10)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+#define HTTP_CODE_OK                    200
+#define HTTP_CODE_NOT_FOUND             404
+
+struct HostHttpRequest {
+    std::string method;
+    std::string url;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+};
+
+class HostHttp {
+public:
+    // Returns HTTP code (or negative HTTPC_ERROR_*) and fills response body
+    typedef std::function<int(const HostHttpRequest &req, std::string &response)> Handler;
+
+    static void setHandler(const Handler &handler);
+    static int handle(const HostHttpRequest &req, std::string &response);
+    // Default handler - MioGiapicco API answering device settings, also to batch of talks (light/batch.php)
+    static int apiHandler(const HostHttpRequest &req, std::string &response);
+    // Simulated round trip time of a single request
+    static void setLatencyMs(uint32_t ms);
+    static uint32_t getLatencyMs();
+    // Simulated API host name resolution, TCP and TLS handshake and keep-alive timeout of idle connection
+    static void setConnectTimes(uint32_t dnsMs, uint32_t handshakeMs, uint32_t keepAliveMs);
+    static uint32_t getDnsMs();
+    static uint32_t getHandshakeMs();
+    static uint32_t getKeepAliveMs();
+    // Requests sent by all HTTPClients of the process and connections (TLS sessions on device) they took
+    static uint32_t getRequestCount();
+    static uint32_t getConnectionCount();
+};
+
+class HTTPClient {
+public:
+    bool begin(WiFiClient &client, const String &url);
+    void end();
+    void setReuse(bool reuse);
+    void addHeader(const String &name, const String &value);
+
+    int GET();
+    int POST(const String &payload);
+    int POST(uint8_t *payload, size_t size);
+
+    String getString();
+    int getSize();
+
+    static String errorToString(int error);
+
+private:
+    WiFiClient *client = nullptr;
+    bool reuse = true;
+    HostHttpRequest req;
+    std::string resp;
+
+    int send(const char *method, const std::string &body);
+};
+
+#endif //MGLIGHTFW_HOST_HTTPCLIENT_H
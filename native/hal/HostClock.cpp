@@ -0,0 +1,70 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "HostClock.h"
+#include <mutex>
+#include <thread>
+
+namespace {
+    std::mutex clkMtx;
+    double timeScale = 1.0;
+    // Simulated time is: simBaseUs + (real now - realBase) * timeScale
+    std::chrono::steady_clock::time_point realBase = std::chrono::steady_clock::now();
+    uint64_t simBaseUs = 0;
+
+    uint64_t simNowUs() {
+        auto realUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - realBase).count();
+        return simBaseUs + (uint64_t)((double)realUs * timeScale);
+    }
+}
+
+uint32_t HostClock::millis() {
+    return (uint32_t)(micros() / 1000);
+}
+
+uint64_t HostClock::micros() {
+    std::lock_guard<std::mutex> lock(clkMtx);
+    return simNowUs();
+}
+
+void HostClock::sleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(toRealDuration(ms));
+}
+
+void HostClock::setTimeScale(double scale) {
+    if(scale <= 0.0)
+        return;
+
+    std::lock_guard<std::mutex> lock(clkMtx);
+    simBaseUs = simNowUs();
+    realBase = std::chrono::steady_clock::now();
+    timeScale = scale;
+}
+
+double HostClock::getTimeScale() {
+    std::lock_guard<std::mutex> lock(clkMtx);
+    return timeScale;
+}
+
+std::chrono::nanoseconds HostClock::toRealDuration(uint32_t ms) {
+    double scale = getTimeScale();
+    return std::chrono::nanoseconds((int64_t)(((double)ms * 1000000.0) / scale));
+}
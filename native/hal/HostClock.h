@@ -0,0 +1,46 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOSTCLOCK_H
+#define MGLIGHTFW_HOSTCLOCK_H
+
+#include <cstdint>
+#include <chrono>
+
+/**
+ * Monotonic clock behind millis(), FreeRTOS ticks and the simulated radio.
+ * Time scale tells how many simulated milliseconds pass per real millisecond,
+ * so long protocol intervals (server checks, time syncs) can be compressed.
+ */
+class HostClock {
+public:
+    static uint32_t millis();
+    static uint64_t micros();
+    static void sleepMs(uint32_t ms);
+
+    static void setTimeScale(double scale);
+    static double getTimeScale();
+
+    // Real duration of given amount of simulated milliseconds
+    static std::chrono::nanoseconds toRealDuration(uint32_t ms);
+};
+
+
+#endif //MGLIGHTFW_HOSTCLOCK_H
@@ -0,0 +1,170 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "HostNode.h"
+#include "NimBLEDevice.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    std::mutex registryMtx;
+    std::vector<HostNode*> registry;
+    uint32_t nextMacSuffix = 1;
+
+    std::mutex consoleMtx;
+    HostNode::LogObserver logObserver;
+
+    thread_local HostNode *currentNode = nullptr;
+
+    HostNode& defaultNode() {
+        static HostNode node("host");
+        return node;
+    }
+}
+
+HostNode::HostNode(const std::string &name, const uint8_t *mac6) : name(name) {
+    std::lock_guard<std::mutex> lock(registryMtx);
+
+    if(mac6 != nullptr) {
+        memcpy(mac, mac6, 6);
+    } else {
+        // Locally administered, unique within process
+        uint32_t sfx = nextMacSuffix++;
+        mac[0] = 0x02; mac[1] = 0x4D; mac[2] = 0x47;
+        mac[3] = (uint8_t)(sfx >> 16); mac[4] = (uint8_t)(sfx >> 8); mac[5] = (uint8_t)sfx;
+    }
+
+    bleDev.reset(new HostBleDevice());
+    registry.push_back(this);
+}
+
+HostNode::~HostNode() {
+    std::lock_guard<std::mutex> lock(registryMtx);
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+HostNode *HostNode::current() {
+    if(currentNode == nullptr)
+        return &defaultNode();
+
+    return currentNode;
+}
+
+void HostNode::setCurrent(HostNode *node) {
+    currentNode = node;
+}
+
+HostNode *HostNode::findByMac(const uint8_t *mac6) {
+    std::lock_guard<std::mutex> lock(registryMtx);
+    for(auto *n: registry){
+        if(memcmp(n->mac, mac6, 6) == 0)
+            return n;
+    }
+
+    return nullptr;
+}
+
+std::vector<HostNode *> HostNode::all() {
+    std::lock_guard<std::mutex> lock(registryMtx);
+    return registry;
+}
+
+const std::string &HostNode::getName() const {
+    return name;
+}
+
+const uint8_t *HostNode::getMac() const {
+    return mac;
+}
+
+uint64_t HostNode::getEfuseMac() const {
+    // ESP.getEfuseMac() keeps MAC in the lowest 6 bytes, first byte is the LSB
+    uint64_t v = 0;
+    for(int i=5; i>=0; i--){
+        v = (v << 8) | mac[i];
+    }
+
+    return v;
+}
+
+HostBleDevice &HostNode::ble() {
+    return *bleDev;
+}
+
+void HostNode::setWiFiAvailable(bool available, int8_t rssi) {
+    wifiAvailable = available;
+    wifiRssi = rssi;
+}
+
+bool HostNode::isWiFiAvailable() const {
+    return wifiAvailable;
+}
+
+int8_t HostNode::getWiFiRssi() const {
+    return wifiRssi;
+}
+
+void HostNode::setLedcDuty(uint8_t ch, uint32_t duty) {
+    if(ch < 8)
+        ledcDuty[ch] = duty;
+}
+
+uint32_t HostNode::getLedcDuty(uint8_t ch) const {
+    return (ch < 8) ? ledcDuty[ch] : 0;
+}
+
+void HostNode::setLogEnabled(bool enabled) {
+    logEnabled = enabled;
+}
+
+bool HostNode::isLogEnabled() const {
+    return logEnabled;
+}
+
+void HostNode::setLogObserver(HostNode::LogObserver observer) {
+    std::lock_guard<std::mutex> lock(consoleMtx);
+    logObserver = std::move(observer);
+}
+
+void HostNode::log(const char *text, size_t len) {
+    std::lock_guard<std::mutex> lock(consoleMtx);
+    if(!logEnabled and !logObserver)
+        return;
+
+    for(size_t i=0; i<len; i++){
+        if(text[i] == '\r')
+            continue;
+
+        if(text[i] != '\n'){
+            line.push_back(text[i]);
+            continue;
+        }
+
+        if(logEnabled)
+            fprintf(stdout, "[%s] %s\n", name.c_str(), line.c_str());
+        if(logObserver)
+            logObserver(this, line);
+        line.clear();
+    }
+
+    if(logEnabled)
+        fflush(stdout);
+}
@@ -0,0 +1,92 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOSTNODE_H
+#define MGLIGHTFW_HOSTNODE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <functional>
+
+struct HostBleDevice;
+
+/**
+ * One simulated light device. Everything firmware sees as "the chip" (MAC, NVS, BLE controller, WiFi,
+ * LEDC outputs, serial console) is kept per node, so several devices can run in one host process.
+ * Every FreeRTOS task inherits node of the task that created it.
+ */
+class HostNode {
+public:
+    explicit HostNode(const std::string &name, const uint8_t *mac6 = nullptr);
+    ~HostNode();
+
+    static HostNode* current();
+    static void setCurrent(HostNode *node);
+    static HostNode* findByMac(const uint8_t *mac6);
+    static std::vector<HostNode*> all();
+
+    const std::string& getName() const;
+    const uint8_t* getMac() const;
+    uint64_t getEfuseMac() const;
+
+    // NVS - namespace -> key -> raw value
+    std::mutex nvsMtx;
+    std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+
+    // BLE controller and host state (see NimBLEDevice.cpp)
+    HostBleDevice& ble();
+
+    // WiFi
+    void setWiFiAvailable(bool available, int8_t rssi = -60);
+    bool isWiFiAvailable() const;
+    int8_t getWiFiRssi() const;
+
+    // LEDC
+    void setLedcDuty(uint8_t ch, uint32_t duty);
+    uint32_t getLedcDuty(uint8_t ch) const;
+
+    // Console. Observer gets every complete line of every node, also when printing is disabled.
+    using LogObserver = std::function<void(HostNode *node, const std::string &line)>;
+    static void setLogObserver(LogObserver observer);
+    void setLogEnabled(bool enabled);
+    bool isLogEnabled() const;
+    void log(const char *text, size_t len);
+
+private:
+    std::string name;
+    uint8_t mac[6]{};
+
+    std::unique_ptr<HostBleDevice> bleDev;
+
+    bool wifiAvailable = true;
+    int8_t wifiRssi = -60;
+
+    uint32_t ledcDuty[8]{};
+
+    bool logEnabled = true;
+    std::string line;
+};
+
+
+#endif //MGLIGHTFW_HOSTNODE_H
@@ -0,0 +1,100 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "HostProvisioning.h"
+#include "HostNode.h"
+#include "Preferences.h"
+#include "bleln/Encryption.h"
+#include "ConfigManager.h"
+
+namespace {
+    bool genKeyPair(uint8_t *priv32, uint8_t *pub64) {
+        mbedtls_mpi d;
+        uint8_t pub65[65];
+
+        bool ok = Encryption::ecdh_gen(pub65, d) and mbedtls_mpi_write_binary(&d, priv32, 32) == 0;
+        if(ok)
+            memcpy(pub64, pub65 + 1, 64);
+
+        mbedtls_mpi_free(&d);
+        return ok;
+    }
+
+    // Runs fn as given node, so Preferences and ESP.getEfuseMac() refer to it
+    template<typename F>
+    auto asNode(HostNode *node, F fn) -> decltype(fn()) {
+        HostNode *prev = HostNode::current();
+        HostNode::setCurrent(node);
+        auto r = fn();
+        HostNode::setCurrent(prev);
+        return r;
+    }
+}
+
+bool HostProvisioning::makeManufacturerKey(ManufacturerKey &key) {
+    Encryption::randomizer_init();
+    return genKeyPair(key.priv, key.pub);
+}
+
+bool HostProvisioning::provisionCert(HostNode *node, const ManufacturerKey &key) {
+    Encryption::randomizer_init();
+
+    return asNode(node, [&key](){
+        uint8_t priv[32], pub[64], sign[64];
+        if(!genKeyPair(priv, pub))
+            return false;
+
+        uint64_t mac = ESP.getEfuseMac();
+        std::string cert = "2;";
+        cert.append(Encryption::base64Encode((uint8_t*)&mac, 6));
+        cert.append(";");
+        cert.append(Encryption::base64Encode(pub, 64));
+
+        if(!Encryption::signData_ECDSA_P256((const uint8_t*)cert.data(), cert.size(), key.priv, 32, sign, 64))
+            return false;
+
+        Preferences prefs;
+        prefs.begin("cert", false);
+        prefs.putBytes("pc_sign", sign, 64);
+        prefs.putBytes("manu_pub", key.pub, 64);
+        prefs.putBytes("dev_priv", priv, 32);
+        prefs.putBytes("dev_pub", pub, 64);
+        prefs.end();
+        return true;
+    });
+}
+
+void HostProvisioning::provisionConfig(HostNode *node, char role, const std::string &ssid, const std::string &timezone) {
+    asNode(node, [&](){
+        DeviceConfig config;
+        config.setSsid(ssid.c_str());
+        config.setPsk("host-psk");
+        config.setUid(("uid-" + node->getName()).c_str());
+        config.setPicklock(("picklock-" + node->getName()).c_str());
+        config.setTimezone(timezone.c_str());
+        config.setRole(role);
+
+        Preferences prefs;
+        prefs.begin("mgld", false);
+        bool r = ConfigManager::writeDeviceConfig(&prefs, &config);
+        prefs.end();
+        return r;
+    });
+}
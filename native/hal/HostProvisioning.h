@@ -0,0 +1,46 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOSTPROVISIONING_H
+#define MGLIGHTFW_HOSTPROVISIONING_H
+
+#include <cstdint>
+#include <string>
+
+class HostNode;
+
+/**
+ * Factory provisioning of host nodes - the same data a device gets on production line:
+ * BLELN certificate signed with manufacturer key (NVS "cert") and device configuration (NVS "mgld").
+ */
+class HostProvisioning {
+public:
+    struct ManufacturerKey {
+        uint8_t priv[32];
+        uint8_t pub[64];
+    };
+
+    static bool makeManufacturerKey(ManufacturerKey &key);
+    static bool provisionCert(HostNode *node, const ManufacturerKey &key);
+    static void provisionConfig(HostNode *node, char role, const std::string &ssid = "HostWiFi",
+                                const std::string &timezone = "CET-1CEST,M3.5.0,M10.5.0/3");
+};
+
+#endif //MGLIGHTFW_HOSTPROVISIONING_H
@@ -0,0 +1,321 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "HostRadio.h"
+#include "HostClock.h"
+#include "HostNode.h"
+#include <future>
+#include <algorithm>
+
+HostRadio &HostRadio::get() {
+    static HostRadio radio;
+    return radio;
+}
+
+void HostRadio::startIfNeeded() {
+    if(!started){
+        started = true;
+        std::thread t([this](){ run(); });
+        radioThreadId = t.get_id();
+        t.detach();
+    }
+}
+
+void HostRadio::post(HostNode *target, uint32_t delayMs, std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(mtx);
+    postUs(target, HostClock::micros() + (uint64_t)delayMs * 1000, std::move(fn));
+}
+
+// Caller holds mtx
+void HostRadio::postUs(HostNode *target, uint64_t dueUs, std::function<void()> fn) {
+    startIfNeeded();
+    events.emplace(std::make_pair(dueUs, seq++), Event{target, std::move(fn)});
+    cv.notify_one();
+}
+
+void HostRadio::call(HostNode *target, uint32_t delayMs, std::function<void()> fn) {
+    if(isRadioThread()){
+        post(target, delayMs, std::move(fn));
+        return;
+    }
+
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> f = done->get_future();
+    post(target, delayMs, [fn, done](){
+        fn();
+        done->set_value();
+    });
+    f.wait();
+}
+
+bool HostRadio::transmit(uint16_t h, HostNode *from, HostNode *to, size_t len, std::function<void()> deliver) {
+    std::lock_guard<std::mutex> lock(mtx);
+    uint16_t &bufs = txBufsUsed[from];
+    if(model.hostTxBufs > 0 and bufs >= model.hostTxBufs)
+        return false;
+    bufs++;
+
+    AirStats &tx = stats[from];
+    AirStats &rx = stats[to];
+    uint64_t now = HostClock::micros();
+
+    ConnParams p;
+    bool fromCentral = false;
+    auto link = links.find(h);
+    if(link != links.end()){
+        settleLink(link->second, now);
+        p = link->second.params;
+        fromCentral = link->second.central == from;
+    }
+
+    // Model delays are for connIntervalMs, links with other interval wait proportionally longer or shorter
+    uint64_t itvlUs = intervalUs(p);
+    double scale = (model.connIntervalMs > 0 and itvlUs > 0) ? (double)itvlUs / (model.connIntervalMs * 1000.0) : 1.0;
+    uint16_t dataLen = p.txOctets > 0 ? p.txOctets : model.dataLen;
+    uint64_t byteUs = p.phy2M ? 4 : 8;
+
+    // ATT PDU gets L2CAP (4B) and ATT (3B) headers and is split into LL PDUs of dataLen bytes.
+    // Every LL PDU is payload + 10B (preamble, access address, header, CRC), acked by an empty PDU.
+    size_t l2cap = len + 4 + 3;
+    size_t fragments = (l2cap + dataLen - 1) / dataLen;
+    uint64_t delayUs = (uint64_t)model.latencyMs * 1000;
+    if(model.jitterMs > 0)
+        delayUs += rnd() % ((uint64_t)model.jitterMs * 1000);
+    delayUs = (uint64_t)(delayUs * scale);
+    // Peripheral with latency listens only in every (latency + 1)-th event, central waits for it half of that
+    if(fromCentral and p.latency > 0)
+        delayUs += itvlUs * p.latency / 2;
+
+    for(size_t i=0; i<fragments; i++){
+        size_t fragLen = std::min<size_t>(dataLen, l2cap - i * dataLen);
+        // Lost PDU is repeated in next connection event, give up after supervision timeout worth of tries
+        for(int tries=0; tries < 20; tries++){
+            tx.txPdus++;
+            tx.airtimeUs += (fragLen + 10) * byteUs;
+            if(!lost()){
+                rx.airtimeUs += 10 * byteUs;
+                break;
+            }
+            tx.lostPdus++;
+            delayUs += (uint64_t)(model.retransmitMs * 1000 * scale);
+        }
+    }
+    tx.txBytes += len;
+
+    uint64_t &last = linkDue[std::make_pair(from, to)];
+    uint64_t due = std::max(now + delayUs, last);
+    last = due;
+    postUs(to, due, [this, from, deliver](){
+        {
+            std::lock_guard<std::mutex> l(mtx);
+            txBufsUsed[from]--;
+        }
+        deliver();
+    });
+    return true;
+}
+
+void HostRadio::openLink(uint16_t h, HostNode *central, HostNode *peripheral, const ConnParams &params) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Link l{};
+    l.central = central;
+    l.peripheral = peripheral;
+    l.params = params;
+    l.eventsFromUs = HostClock::micros();
+    links[h] = l;
+}
+
+void HostRadio::closeLink(uint16_t h) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = links.find(h);
+    if(it == links.end())
+        return;
+
+    settleLink(it->second, HostClock::micros());
+    links.erase(it);
+}
+
+bool HostRadio::updateLink(uint16_t h, const std::function<bool(ConnParams &)> &change) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = links.find(h);
+    if(it == links.end())
+        return false;
+
+    Link &l = it->second;
+    uint64_t now = HostClock::micros();
+    settleLink(l, now);
+
+    const ConnParams &current = l.nextAtUs != 0 ? l.next : l.params;
+    ConnParams p = current;
+    if(!change(p))
+        return false;
+    if(p.sameAs(current))
+        return true;
+
+    // Procedure already in progress takes this change with it
+    p.updates++;
+    l.next = p;
+    if(l.nextAtUs == 0)
+        l.nextAtUs = now + 6 * intervalUs(l.params);
+    return true;
+}
+
+HostRadio::ConnParams HostRadio::getLinkParams(uint16_t h, bool requested) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = links.find(h);
+    if(it == links.end())
+        return ConnParams();
+
+    settleLink(it->second, HostClock::micros());
+    if(requested and it->second.nextAtUs != 0)
+        return it->second.next;
+    return it->second.params;
+}
+
+// Caller holds mtx
+uint64_t HostRadio::intervalUs(const ConnParams &p) const {
+    return p.interval > 0 ? (uint64_t)p.interval * 1250 : (uint64_t)model.connIntervalMs * 1000;
+}
+
+// Caller holds mtx. Central sends (at least empty) PDU in every connection event, peripheral answers it
+// in events it does not skip with latency.
+void HostRadio::countConnEvents(Link &l, uint64_t untilUs) {
+    uint64_t itvl = intervalUs(l.params);
+    if(itvl == 0){
+        l.eventsFromUs = std::max(l.eventsFromUs, untilUs);
+        return;
+    }
+    if(untilUs <= l.eventsFromUs)
+        return;
+
+    uint64_t events = (untilUs - l.eventsFromUs) / itvl;
+    l.eventsFromUs += events * itvl;
+    uint64_t byteUs = l.params.phy2M ? 4 : 8;
+    uint64_t every = l.params.latency + 1;
+    uint64_t peripheralEvents = (l.events + events) / every - l.events / every;
+    l.events += events;
+
+    AirStats &c = stats[l.central];
+    c.connEvents += events;
+    c.airtimeUs += events * 10 * byteUs;
+    AirStats &p = stats[l.peripheral];
+    p.connEvents += peripheralEvents;
+    p.airtimeUs += peripheralEvents * 10 * byteUs;
+}
+
+// Caller holds mtx
+void HostRadio::settleLink(Link &l, uint64_t nowUs) {
+    if(l.nextAtUs != 0 and l.nextAtUs <= nowUs){
+        countConnEvents(l, l.nextAtUs);
+        l.params = l.next;
+        l.nextAtUs = 0;
+    }
+    countConnEvents(l, nowUs);
+}
+
+void HostRadio::advertise(HostNode *from, size_t len, const std::vector<HostNode *> &scanners,
+                          const std::function<void(HostNode *)> &deliver) {
+    std::lock_guard<std::mutex> lock(mtx);
+    AirStats &tx = stats[from];
+
+    // ADV_IND: preamble, access address, header, AdvA (6B), AdvData, CRC - on channels 37, 38 and 39
+    tx.advEvents++;
+    tx.txPdus += 3;
+    tx.airtimeUs += 3 * (len + 16) * 8;
+
+    uint64_t now = HostClock::micros();
+    for(auto *s: scanners){
+        // Scanner listens on one channel at a time, it misses the event only if it is lost on every channel
+        if(lost() and lost() and lost()){
+            tx.lostPdus++;
+            continue;
+        }
+        postUs(s, now, [deliver, s](){
+            deliver(s);
+        });
+    }
+}
+
+void HostRadio::setLinkModel(const HostRadio::LinkModel &m) {
+    std::lock_guard<std::mutex> lock(mtx);
+    model = m;
+    if(model.dataLen < 27)
+        model.dataLen = 27;
+    if(model.maxConnections > CONFIG_BT_NIMBLE_MAX_CONNECTIONS)
+        model.maxConnections = CONFIG_BT_NIMBLE_MAX_CONNECTIONS;
+}
+
+HostRadio::LinkModel HostRadio::getLinkModel() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return model;
+}
+
+void HostRadio::setSeed(uint32_t s) {
+    std::lock_guard<std::mutex> lock(mtx);
+    rnd.seed(s);
+}
+
+HostRadio::AirStats HostRadio::getStats(HostNode *node) {
+    std::lock_guard<std::mutex> lock(mtx);
+    uint64_t now = HostClock::micros();
+    for(auto &l: links)
+        settleLink(l.second, now);
+
+    auto it = stats.find(node);
+    return it != stats.end() ? it->second : AirStats();
+}
+
+// Caller holds mtx
+bool HostRadio::lost() {
+    if(model.lossRate <= 0.0f)
+        return false;
+
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(rnd) < model.lossRate;
+}
+
+bool HostRadio::isRadioThread() const {
+    return std::this_thread::get_id() == radioThreadId;
+}
+
+void HostRadio::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while(true){
+        if(events.empty()){
+            cv.wait(lock);
+            continue;
+        }
+
+        auto it = events.begin();
+        uint64_t now = HostClock::micros();
+        if(it->first.first > now){
+            uint64_t waitUs = it->first.first - now;
+            cv.wait_for(lock, HostClock::toRealDuration((uint32_t)((waitUs + 999) / 1000)));
+            continue;
+        }
+
+        Event ev = std::move(it->second);
+        events.erase(it);
+
+        lock.unlock();
+        HostNode::setCurrent(ev.target);
+        ev.fn();
+        lock.lock();
+    }
+}
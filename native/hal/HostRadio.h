@@ -0,0 +1,156 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOSTRADIO_H
+#define MGLIGHTFW_HOSTRADIO_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <random>
+
+class HostNode;
+
+/**
+ * Shared air of all host nodes. Every BLE event (advertising report, connection, write, notification,
+ * disconnection) is an event scheduled on the single radio thread and executed in context of the
+ * receiving node - the same way NimBLE host task calls firmware callbacks on a device.
+ */
+class HostRadio {
+public:
+    /**
+     * Physical link model shared by all links. Defaults give a perfect, instant link.
+     * Connected PDUs lost on air are repeated in following connection event, so per link order is kept,
+     * lost advertising PDUs are simply not seen by a scanner.
+     * Delays are given for connIntervalMs and scale with connection interval of the link.
+     */
+    struct LinkModel {
+        uint32_t latencyMs = 0;         // Connected PDU delivery delay
+        uint32_t jitterMs = 0;          // Extra uniform random delay 0..jitterMs
+        float lossRate = 0.0f;          // Probability that single PDU is lost
+        uint32_t retransmitMs = 30;     // Delay added by every lost connected PDU (connection interval)
+        uint32_t connIntervalMs = 30;   // Connection interval of new links, 0 - no connection events airtime
+        uint16_t dataLen = 27;          // LL payload bytes per data PDU, until link negotiates more
+        uint8_t maxConnections = CONFIG_BT_NIMBLE_MAX_CONNECTIONS;
+        uint16_t hostTxBufs = 24;       // ATT PDUs one node may have waiting for air (NimBLE ACL buffers), 0 - no limit
+    };
+
+    /**
+     * Parameters of one connection, changed by connection update, data length update and PHY update procedures.
+     * Like on air, new parameters are used from the instant - 6 connection events after the request.
+     */
+    struct ConnParams {
+        uint16_t interval = 0;          // Connection interval in 1.25 ms units, 0 - LinkModel::connIntervalMs
+        uint16_t latency = 0;           // Connection events peripheral may skip when it has nothing to send
+        uint16_t timeout = 0;           // Supervision timeout in 10 ms units, not modelled
+        uint16_t txOctets = 0;          // LL payload bytes per data PDU, 0 - LinkModel::dataLen
+        bool phy2M = false;
+        uint32_t updates = 0;           // Procedures which changed parameters of the link
+
+        bool sameAs(const ConnParams &o) const {
+            return interval == o.interval and latency == o.latency and timeout == o.timeout
+                   and txOctets == o.txOctets and phy2M == o.phy2M;
+        }
+    };
+
+    // Radio usage of one node
+    struct AirStats {
+        uint64_t txPdus = 0;
+        uint64_t txBytes = 0;           // ATT payload bytes sent on connections
+        uint64_t lostPdus = 0;
+        uint64_t airtimeUs = 0;         // Time own radio was transmitting
+        uint64_t advEvents = 0;
+        uint64_t connEvents = 0;        // Connection events own radio took part in, with or without data
+    };
+
+    static HostRadio& get();
+
+    void setLinkModel(const LinkModel &model);
+    LinkModel getLinkModel();
+    void setSeed(uint32_t seed);
+
+    AirStats getStats(HostNode *node);
+
+    // Runs fn on radio thread, as receiving node, after delayMs of simulated time
+    void post(HostNode *target, uint32_t delayMs, std::function<void()> fn);
+    // Same as post() but waits for fn to finish. Called from radio thread it does not wait.
+    void call(HostNode *target, uint32_t delayMs, std::function<void()> fn);
+    // ATT PDU of len bytes from one node to another over established connection h.
+    // False (nothing sent) when all sender's TX buffers wait for air.
+    bool transmit(uint16_t h, HostNode *from, HostNode *to, size_t len, std::function<void()> deliver);
+    // One advertising event (3 channels) with len bytes of AdvData, deliver runs as every scanner which heard it
+    void advertise(HostNode *from, size_t len, const std::vector<HostNode*> &scanners,
+                   const std::function<void(HostNode*)> &deliver);
+
+    // Connection h exists from openLink() to closeLink(), every its connection event is counted as airtime
+    void openLink(uint16_t h, HostNode *central, HostNode *peripheral, const ConnParams &params);
+    void closeLink(uint16_t h);
+    // Starts procedure which changes parameters of connection h. False when link does not exist or change refuses.
+    bool updateLink(uint16_t h, const std::function<bool(ConnParams&)> &change);
+    // Parameters in use, or requested ones waiting for their instant
+    ConnParams getLinkParams(uint16_t h, bool requested = false);
+
+    bool isRadioThread() const;
+
+private:
+    struct Event {
+        HostNode *target;
+        std::function<void()> fn;
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::map<std::pair<uint64_t, uint64_t>, Event> events; // (due us, sequence) -> event
+    uint64_t seq = 0;
+    std::thread::id radioThreadId;
+    bool started = false;
+
+    LinkModel model;
+    std::mt19937 rnd{0x4D474C46};
+    std::map<HostNode*, AirStats> stats;
+    std::map<std::pair<HostNode*, HostNode*>, uint64_t> linkDue; // Last delivery time on link - keeps it FIFO
+    std::map<HostNode*, uint16_t> txBufsUsed;
+
+    struct Link {
+        HostNode *central;
+        HostNode *peripheral;
+        ConnParams params;
+        ConnParams next;
+        uint64_t nextAtUs = 0;          // Instant of next params, 0 - no procedure pending
+        uint64_t eventsFromUs;          // Connection events before this time are already counted
+        uint64_t events = 0;
+    };
+    std::map<uint16_t, Link> links;
+
+    void postUs(HostNode *target, uint64_t dueUs, std::function<void()> fn);
+    bool lost();
+    uint64_t intervalUs(const ConnParams &p) const;
+    void countConnEvents(Link &l, uint64_t untilUs);
+    void settleLink(Link &l, uint64_t nowUs);
+    void startIfNeeded();
+    void run();
+};
+
+
+#endif //MGLIGHTFW_HOSTRADIO_H
@@ -0,0 +1,1447 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "NimBLEDevice.h"
+#include "HostNode.h"
+#include "HostRadio.h"
+#include "HostClock.h"
+#include "Arduino.h"
+
+#include <mutex>
+#include <future>
+#include <memory>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+/**
+ * One established link between central (client) node and peripheral (server) node.
+ */
+struct HostBleConn {
+    uint16_t handle;
+    HostNode *central;
+    HostNode *peripheral;
+    NimBLEClient *client;
+    uint16_t mtu;
+    std::map<const NimBLECharacteristic*, uint16_t> subscriptions;
+};
+
+/**
+ * Implementation of everything that crosses node boundary. All shared state is guarded by a single
+ * recursive mutex which is never held while firmware callbacks run.
+ */
+class HostBle {
+public:
+    static std::recursive_mutex mtx;
+    static std::map<uint16_t, HostBleConn> conns;
+    static uint16_t nextHandle;
+
+    static constexpr uint32_t ADV_INTERVAL_MS = 100;
+    static constexpr uint32_t CONN_RETRY_MS = 50;
+    static constexpr int RSSI = -55;
+
+    // Controller connection limit - CONFIG_BT_NIMBLE_MAX_CONNECTIONS or lower if link model says so
+    static uint8_t maxConnections() {
+        return HostRadio::get().getLinkModel().maxConnections;
+    }
+
+    static HostBleDevice& dev() {
+        return HostNode::current()->ble();
+    }
+
+    static NimBLEAddress addressOf(HostNode *node) {
+        return {node->getMac(), BLE_ADDR_PUBLIC};
+    }
+
+    static HostBleConn* findConn(uint16_t h) {
+        auto it = conns.find(h);
+        return it != conns.end() ? &it->second : nullptr;
+    }
+
+    static NimBLECharacteristic* findCharacteristic(NimBLEServer *srv, const NimBLEUUID &svcUuid, const NimBLEUUID &chUuid) {
+        if(srv == nullptr)
+            return nullptr;
+
+        NimBLEService *svc = srv->getServiceByUUID(svcUuid);
+        return svc != nullptr ? svc->getCharacteristic(chUuid) : nullptr;
+    }
+
+    /// *************** Advertising and scanning ***************
+
+    static NimBLEAdvertisedDevice advertisedDevice(HostNode *node) {
+        NimBLEAdvertising &a = node->ble().advertising;
+        // Scanners scan actively - scan response is merged into the report
+        const std::string &name = (a.name.empty() and a.scanResponse) ? a.scanResponseName : a.name;
+        static const std::vector<std::pair<NimBLEUUID, std::string>> none;
+        return {addressOf(node), name, a.serviceUUIDs, a.manufacturerData,
+                a.scanResponse ? a.scanResponseServiceData : none, RSSI};
+    }
+
+    static bool isAdvertising(HostNode *node) {
+        HostBleDevice &d = node->ble();
+        return d.initialised and d.advertising.advertising;
+    }
+
+    // AdvData size: flags, complete name, 128-bit service UUIDs and manufacturer data, no more than 31 bytes
+    static size_t advDataLen(const NimBLEAdvertising &a) {
+        size_t len = 3;
+        if(!a.name.empty())
+            len += 2 + a.name.size();
+        if(!a.serviceUUIDs.empty())
+            len += 2 + 16 * a.serviceUUIDs.size();
+        if(!a.manufacturerData.empty())
+            len += 2 + a.manufacturerData.size();
+
+        return std::min<size_t>(len, 31);
+    }
+
+    // One advertising event every ADV_INTERVAL_MS plus 0-10 ms advDelay, as long as advertising generation lasts
+    static void advertisingEvent(HostNode *advertiser, uint32_t gen) {
+        std::vector<HostNode*> scanners;
+        std::vector<uint32_t> scanGens;
+        std::shared_ptr<NimBLEAdvertisedDevice> report;
+        size_t len;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            NimBLEAdvertising &a = advertiser->ble().advertising;
+            if(!isAdvertising(advertiser) or a.generation != gen)
+                return;
+
+            report = std::make_shared<NimBLEAdvertisedDevice>(advertisedDevice(advertiser));
+            len = advDataLen(a);
+            for(auto *n: HostNode::all()){
+                if(n != advertiser and n->ble().initialised and n->ble().scan.scanning){
+                    scanners.push_back(n);
+                    scanGens.push_back(n->ble().scan.generation);
+                }
+            }
+        }
+
+        HostRadio::get().advertise(advertiser, len, scanners, [scanners, scanGens, report](HostNode *scanner){
+            for(size_t i=0; i<scanners.size(); i++){
+                if(scanners[i] == scanner)
+                    scanner->ble().scan.onAdvertisement(scanGens[i], *report);
+            }
+        });
+
+        HostRadio::get().post(advertiser, ADV_INTERVAL_MS + esp_random() % 10, [advertiser, gen](){
+            advertisingEvent(advertiser, gen);
+        });
+    }
+
+    // Caller holds mtx
+    static void advertisingStarted(HostNode *advertiser) {
+        NimBLEAdvertising &a = advertiser->ble().advertising;
+        a.generation++;
+        uint32_t gen = a.generation;
+        HostRadio::get().post(advertiser, esp_random() % ADV_INTERVAL_MS, [advertiser, gen](){
+            advertisingEvent(advertiser, gen);
+        });
+    }
+
+    /// *************** Connections ***************
+
+    static void tryEstablish(HostNode *central, NimBLEClient *client, NimBLEAddress addr, uint32_t startMs) {
+        NimBLEClientCallbacks *clb = nullptr;
+        NimBLEServerCallbacks *srvClb = nullptr;
+        NimBLEServer *srv = nullptr;
+        HostNode *peripheral = nullptr;
+        uint16_t h = BLE_HS_CONN_HANDLE_NONE;
+        uint16_t mtu = 23;
+        bool failed = false;
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleDevice &cd = central->ble();
+            if(!cd.initialised or !cd.hasClient(client) or !client->connecting)
+                return;
+
+            peripheral = HostNode::findByMac(addr.getVal());
+            bool canConnect = peripheral != nullptr and isAdvertising(peripheral)
+                    and peripheral->ble().connectionsCount() < maxConnections()
+                    and cd.connectionsCount() < maxConnections();
+
+            if(canConnect){
+                HostBleDevice &pd = peripheral->ble();
+                h = nextHandle++;
+                if(nextHandle == BLE_HS_CONN_HANDLE_NONE)
+                    nextHandle = 1;
+
+                mtu = std::min(cd.mtu, pd.mtu);
+                conns[h] = HostBleConn{h, central, peripheral, client, mtu, {}};
+                HostRadio::ConnParams params;
+                params.interval = client->connItvl;
+                params.latency = client->connLatency;
+                params.timeout = client->connTimeout;
+                HostRadio::get().openLink(h, central, peripheral, params);
+
+                // Peripheral stops advertising when connection is established
+                pd.advertising.advertising = false;
+
+                client->connecting = false;
+                client->connHandle = h;
+                clb = client->clb;
+                srv = pd.server.get();
+                srvClb = srv != nullptr ? srv->clb : nullptr;
+            } else if(HostClock::millis() - startMs >= client->connectTimeoutMs){
+                client->connecting = false;
+                clb = client->clb;
+                failed = true;
+            }
+        }
+
+        if(h != BLE_HS_CONN_HANDLE_NONE){
+            NimBLEAddress centralAddr = addressOf(central);
+            HostRadio::get().post(peripheral, 0, [peripheral, srv, srvClb, h, centralAddr, mtu](){
+                {
+                    std::lock_guard<std::recursive_mutex> lock(mtx);
+                    if(peripheral->ble().server.get() != srv or findConn(h) == nullptr)
+                        return;
+                }
+                if(srvClb != nullptr){
+                    NimBLEConnInfo info(h, centralAddr, mtu);
+                    srvClb->onConnect(srv, info);
+                }
+            });
+
+            if(clb != nullptr)
+                clb->onConnect(client);
+        } else if(failed){
+            if(clb != nullptr)
+                clb->onConnectFail(client, BLE_HS_ETIMEOUT);
+        } else {
+            HostRadio::get().post(central, CONN_RETRY_MS, [central, client, addr, startMs](){
+                tryEstablish(central, client, addr, startMs);
+            });
+        }
+    }
+
+    // Drops the link. Callbacks are delivered to initiating side only if notifyLocal is set.
+    static bool closeConn(uint16_t h, HostNode *initiator, uint8_t reason, bool notifyLocal) {
+        HostBleConn c{};
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleConn *found = findConn(h);
+            if(found == nullptr)
+                return false;
+
+            c = *found;
+            conns.erase(h);
+            HostRadio::get().closeLink(h);
+
+            if(c.central->ble().hasClient(c.client))
+                c.client->connHandle = BLE_HS_CONN_HANDLE_NONE;
+        }
+
+        int remoteReason = BLE_HS_ERR_HCI_BASE + reason;
+        int localReason = BLE_HS_ERR_HCI_BASE + BLE_ERR_CONN_TERM_LOCAL;
+
+        // Peripheral side
+        if(notifyLocal or initiator != c.peripheral){
+            HostNode *p = c.peripheral;
+            NimBLEAddress centralAddr = addressOf(c.central);
+            int r = (initiator == p) ? localReason : remoteReason;
+            HostRadio::get().post(p, 0, [p, c, centralAddr, r](){
+                NimBLEServer *srv;
+                NimBLEServerCallbacks *clb;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(mtx);
+                    srv = p->ble().server.get();
+                    clb = srv != nullptr ? srv->clb : nullptr;
+                }
+                if(clb != nullptr){
+                    NimBLEConnInfo info(c.handle, centralAddr, c.mtu);
+                    clb->onDisconnect(srv, info, r);
+                }
+            });
+        }
+
+        // Central side
+        if(notifyLocal or initiator != c.central){
+            HostNode *cn = c.central;
+            NimBLEClient *client = c.client;
+            int r = (initiator == cn) ? localReason : remoteReason;
+            HostRadio::get().post(cn, 0, [cn, client, r](){
+                NimBLEClientCallbacks *clb;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(mtx);
+                    if(!cn->ble().hasClient(client))
+                        return;
+                    clb = client->clb;
+                }
+                if(clb != nullptr)
+                    clb->onDisconnect(client, r);
+            });
+        }
+
+        return true;
+    }
+
+    static void closeAllOf(HostNode *node) {
+        std::vector<uint16_t> hs;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            for(auto &kv: conns){
+                if(kv.second.central == node or kv.second.peripheral == node)
+                    hs.push_back(kv.first);
+            }
+        }
+
+        for(uint16_t h: hs)
+            closeConn(h, node, BLE_ERR_REM_USER_CONN_TERM, false);
+    }
+
+    /// *************** Connection parameters ***************
+
+    // Connection update, data length update and PHY update procedures, either end of the link may start them
+    static bool updateLink(uint16_t h, HostNode *node, const std::function<bool(HostRadio::ConnParams&)> &change) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleConn *c = findConn(h);
+            if(c == nullptr or (c->central != node and c->peripheral != node))
+                return false;
+        }
+
+        return HostRadio::get().updateLink(h, change);
+    }
+
+    static bool updateConnParams(uint16_t h, HostNode *node, uint16_t minItvl, uint16_t maxItvl, uint16_t latency,
+                                 uint16_t timeout) {
+        // Controller limits: interval 7.5 ms - 4 s, latency below 500, supervision timeout 100 ms - 32 s
+        // and longer than two intervals stretched by latency
+        if(minItvl < 6 or maxItvl > 3200 or minItvl > maxItvl or latency > 499 or timeout < 10 or timeout > 3200
+           or (uint32_t)timeout * 4 <= (uint32_t)(1 + latency) * maxItvl)
+            return false;
+
+        // Central picks the longest interval of the range
+        return updateLink(h, node, [maxItvl, latency, timeout](HostRadio::ConnParams &p){
+            p.interval = maxItvl;
+            p.latency = latency;
+            p.timeout = timeout;
+            return true;
+        });
+    }
+
+    static bool setDataLen(uint16_t h, HostNode *node, uint16_t txOctets) {
+        if(txOctets < 27 or txOctets > 251)
+            return false;
+
+        return updateLink(h, node, [txOctets](HostRadio::ConnParams &p){
+            p.txOctets = txOctets;
+            return true;
+        });
+    }
+
+    // Both ends support 1M and 2M, coded PHY is not modelled
+    static bool updatePhy(uint16_t h, HostNode *node, uint8_t txPhysMask, uint8_t rxPhysMask) {
+        uint8_t common = txPhysMask & rxPhysMask & (BLE_GAP_LE_PHY_1M_MASK | BLE_GAP_LE_PHY_2M_MASK);
+        if(common == 0)
+            return false;
+
+        return updateLink(h, node, [common](HostRadio::ConnParams &p){
+            p.phy2M = (common & BLE_GAP_LE_PHY_2M_MASK) != 0;
+            return true;
+        });
+    }
+
+    /// *************** GATT ***************
+
+    static bool notify(NimBLECharacteristic *ch, const std::string &value, uint16_t connHandle) {
+        HostNode *peripheral = HostNode::current();
+        NimBLEUUID svcUuid = ch->getService()->getUUID();
+        NimBLEUUID chUuid = ch->getUUID();
+
+        std::vector<std::pair<HostBleConn, std::string>> out;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            for(auto &kv: conns){
+                HostBleConn &c = kv.second;
+                if(c.peripheral != peripheral)
+                    continue;
+                if(connHandle != BLE_HS_CONN_HANDLE_NONE and c.handle != connHandle)
+                    continue;
+
+                auto sub = c.subscriptions.find(ch);
+                if(sub == c.subscriptions.end() or (sub->second & 0x0001) == 0)
+                    continue;
+
+                out.emplace_back(c, value.substr(0, c.mtu - 3));
+            }
+        }
+
+        // Like NimBLE, status of every notification is reported from inside notify()
+        bool sent = false;
+        for(auto &o: out){
+            HostBleConn c = o.first;
+            std::string v = o.second;
+            bool ok = HostRadio::get().transmit(c.handle, peripheral, c.central, v.size(), [c, v, svcUuid, chUuid](){
+                deliverNotify(c.handle, svcUuid, chUuid, v);
+            });
+            sent = sent or ok;
+            if(ch->clb)
+                ch->clb->onStatus(ch, ok ? 0 : BLE_HS_ENOMEM);
+        }
+
+        return connHandle == BLE_HS_CONN_HANDLE_NONE or sent;
+    }
+
+    static void deliverNotify(uint16_t h, const NimBLEUUID &svcUuid, const NimBLEUUID &chUuid, const std::string &v) {
+        NimBLERemoteCharacteristic *rc = nullptr;
+        NimBLERemoteCharacteristic::notify_callback cb;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleConn *c = findConn(h);
+            if(c == nullptr or !c->central->ble().hasClient(c->client))
+                return;
+
+            for(auto &rs: c->client->services){
+                if(rs->getUUID() == svcUuid)
+                    rc = rs->getCharacteristic(chUuid);
+            }
+            if(rc == nullptr)
+                return;
+
+            rc->value = v;
+            cb = rc->notifyClb;
+        }
+
+        if(cb){
+            std::string copy = v;
+            cb(rc, reinterpret_cast<uint8_t*>(&copy[0]), copy.size(), true);
+        }
+    }
+
+    // Sends ATT write. With response it waits until peripheral processed it.
+    static bool write(NimBLERemoteCharacteristic *rc, const std::string &value, bool response, bool cccd) {
+        HostNode *central = HostNode::current();
+        NimBLEClient *client = rc->getRemoteService()->getClient();
+        NimBLEUUID svcUuid = rc->getRemoteService()->getUUID();
+        NimBLEUUID chUuid = rc->getUUID();
+        HostBleConn c{};
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleConn *found = findConn(client->connHandle);
+            if(found == nullptr)
+                return false;
+            if(value.size() > 512 or (!response and value.size() > (size_t)(found->mtu - 3)))
+                return false;
+
+            c = *found;
+        }
+
+        auto deliver = [c, value, svcUuid, chUuid, cccd](){
+            deliverWrite(c.handle, svcUuid, chUuid, value, cccd);
+        };
+
+        if(!response or HostRadio::get().isRadioThread()){
+            return HostRadio::get().transmit(c.handle, central, c.peripheral, value.size(), deliver);
+        }
+
+        auto done = std::make_shared<std::promise<void>>();
+        std::future<void> f = done->get_future();
+        if(!HostRadio::get().transmit(c.handle, central, c.peripheral, value.size(), [deliver, done](){
+            deliver();
+            done->set_value();
+        }))
+            return false;
+        f.wait();
+
+        std::lock_guard<std::recursive_mutex> lock(mtx);
+        return findConn(c.handle) != nullptr;
+    }
+
+    // Sends ATT read request and waits for response with characteristic value
+    static bool read(NimBLERemoteCharacteristic *rc, std::string &out) {
+        HostNode *central = HostNode::current();
+        NimBLEClient *client = rc->getRemoteService()->getClient();
+        NimBLEUUID svcUuid = rc->getRemoteService()->getUUID();
+        NimBLEUUID chUuid = rc->getUUID();
+        HostBleConn c{};
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleConn *found = findConn(client->connHandle);
+            if(found == nullptr or HostRadio::get().isRadioThread())
+                return false;
+            c = *found;
+        }
+
+        auto value = std::make_shared<std::string>();
+        auto found = std::make_shared<bool>(false);
+        auto req = std::make_shared<std::promise<void>>();
+        std::future<void> reqDone = req->get_future();
+        if(!HostRadio::get().transmit(c.handle, central, c.peripheral, 3, [c, svcUuid, chUuid, value, found, req](){
+            {
+                std::lock_guard<std::recursive_mutex> lock(mtx);
+                NimBLECharacteristic *ch = (findConn(c.handle) != nullptr)
+                                           ? findCharacteristic(c.peripheral->ble().server.get(), svcUuid, chUuid)
+                                           : nullptr;
+                if(ch != nullptr){
+                    *value = std::string(ch->value).substr(0, c.mtu - 1);
+                    *found = true;
+                }
+            }
+            req->set_value();
+        }))
+            return false;
+        reqDone.wait();
+        if(!*found)
+            return false;
+
+        // Response
+        auto rsp = std::make_shared<std::promise<void>>();
+        std::future<void> rspDone = rsp->get_future();
+        if(!HostRadio::get().transmit(c.handle, c.peripheral, central, value->size() + 1, [rsp](){ rsp->set_value(); }))
+            return false;
+        rspDone.wait();
+
+        std::lock_guard<std::recursive_mutex> lock(mtx);
+        if(findConn(c.handle) == nullptr)
+            return false;
+        out = *value;
+        return true;
+    }
+
+    static void deliverWrite(uint16_t h, const NimBLEUUID &svcUuid, const NimBLEUUID &chUuid, const std::string &v, bool cccd) {
+        NimBLECharacteristic *ch;
+        NimBLECharacteristicCallbacks *clb;
+        NimBLEConnInfo info;
+        uint16_t subValue = 0;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+            HostBleConn *c = findConn(h);
+            if(c == nullptr)
+                return;
+
+            ch = findCharacteristic(c->peripheral->ble().server.get(), svcUuid, chUuid);
+            if(ch == nullptr)
+                return;
+
+            if(cccd){
+                if(v.size() >= 2)
+                    subValue = (uint8_t)v[0] | ((uint8_t)v[1] << 8);
+                c->subscriptions[ch] = subValue;
+            } else {
+                ch->value = v;
+            }
+
+            clb = ch->clb;
+            info = NimBLEConnInfo(h, addressOf(c->central), c->mtu);
+        }
+
+        if(clb == nullptr)
+            return;
+
+        if(cccd)
+            clb->onSubscribe(ch, info, subValue);
+        else
+            clb->onWrite(ch, info);
+    }
+};
+
+std::recursive_mutex HostBle::mtx;
+std::map<uint16_t, HostBleConn> HostBle::conns;
+uint16_t HostBle::nextHandle = 1;
+
+/// *************** NimBLEUUID ***************
+
+NimBLEUUID::NimBLEUUID(const std::string &uuid) : v(uuid) {
+    std::transform(v.begin(), v.end(), v.begin(), [](unsigned char c){ return (char)std::tolower(c); });
+}
+
+NimBLEUUID::NimBLEUUID(const char *uuid) : NimBLEUUID(std::string(uuid != nullptr ? uuid : "")) {
+}
+
+std::string NimBLEUUID::toString() const {
+    return v;
+}
+
+bool NimBLEUUID::operator==(const NimBLEUUID &o) const {
+    return v == o.v;
+}
+
+bool NimBLEUUID::operator!=(const NimBLEUUID &o) const {
+    return v != o.v;
+}
+
+/// *************** NimBLEAddress ***************
+
+NimBLEAddress::NimBLEAddress(const uint8_t *mac6, uint8_t type) : type(type) {
+    memcpy(val, mac6, 6);
+}
+
+const uint8_t *NimBLEAddress::getVal() const {
+    return val;
+}
+
+uint8_t NimBLEAddress::getType() const {
+    return type;
+}
+
+bool NimBLEAddress::isNull() const {
+    static const uint8_t zero[6]{};
+    return memcmp(val, zero, 6) == 0;
+}
+
+std::string NimBLEAddress::toString() const {
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x", val[0], val[1], val[2], val[3], val[4], val[5]);
+    return buf;
+}
+
+bool NimBLEAddress::operator==(const NimBLEAddress &o) const {
+    return memcmp(val, o.val, 6) == 0;
+}
+
+bool NimBLEAddress::operator!=(const NimBLEAddress &o) const {
+    return !(*this == o);
+}
+
+/// *************** NimBLECharacteristic ***************
+
+NimBLECharacteristic::NimBLECharacteristic(const NimBLEUUID &uuid, uint32_t properties, NimBLEService *service)
+    : uuid(uuid), props(properties), svc(service) {
+}
+
+const NimBLEUUID &NimBLECharacteristic::getUUID() const {
+    return uuid;
+}
+
+uint32_t NimBLECharacteristic::getProperties() const {
+    return props;
+}
+
+NimBLEService *NimBLECharacteristic::getService() const {
+    return svc;
+}
+
+void NimBLECharacteristic::setCallbacks(NimBLECharacteristicCallbacks *callbacks) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    clb = callbacks;
+}
+
+NimBLECharacteristicCallbacks *NimBLECharacteristic::getCallbacks() const {
+    return clb;
+}
+
+void NimBLECharacteristic::setValue(const uint8_t *data, size_t len) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    value = NimBLEAttValue(data, len);
+}
+
+void NimBLECharacteristic::setValue(const std::string &v) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    value = v;
+}
+
+const NimBLEAttValue& NimBLECharacteristic::getValue() const {
+    return value;
+}
+
+bool NimBLECharacteristic::notify(uint16_t connHandle) {
+    std::string v;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        v = value;
+    }
+    return HostBle::notify(this, v, connHandle);
+}
+
+bool NimBLECharacteristic::notify(const uint8_t *data, size_t length, uint16_t connHandle) {
+    return HostBle::notify(this, std::string(reinterpret_cast<const char*>(data), length), connHandle);
+}
+
+bool NimBLECharacteristic::notify(const std::string &v, uint16_t connHandle) {
+    return HostBle::notify(this, v, connHandle);
+}
+
+/// *************** NimBLEService ***************
+
+NimBLEService::NimBLEService(const NimBLEUUID &uuid, NimBLEServer *server) : uuid(uuid), srv(server) {
+}
+
+NimBLECharacteristic *NimBLEService::createCharacteristic(const char *u, uint32_t properties, uint16_t maxLen) {
+    return createCharacteristic(NimBLEUUID(u), properties, maxLen);
+}
+
+NimBLECharacteristic *NimBLEService::createCharacteristic(const NimBLEUUID &u, uint32_t properties, uint16_t maxLen) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    characteristics.emplace_back(new NimBLECharacteristic(u, properties, this));
+    return characteristics.back().get();
+}
+
+NimBLECharacteristic *NimBLEService::getCharacteristic(const NimBLEUUID &u) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    for(auto &c: characteristics){
+        if(c->getUUID() == u)
+            return c.get();
+    }
+    return nullptr;
+}
+
+const NimBLEUUID &NimBLEService::getUUID() const {
+    return uuid;
+}
+
+NimBLEServer *NimBLEService::getServer() const {
+    return srv;
+}
+
+bool NimBLEService::start() {
+    return true;
+}
+
+/// *************** NimBLEServer ***************
+
+NimBLEService *NimBLEServer::createService(const NimBLEUUID &uuid) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    services.emplace_back(new NimBLEService(uuid, this));
+    return services.back().get();
+}
+
+NimBLEService *NimBLEServer::getServiceByUUID(const NimBLEUUID &uuid) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    for(auto &s: services){
+        if(s->getUUID() == uuid)
+            return s.get();
+    }
+    return nullptr;
+}
+
+void NimBLEServer::setCallbacks(NimBLEServerCallbacks *callbacks, bool deleteCallbacks) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    clb = callbacks;
+    deleteClb = deleteCallbacks;
+}
+
+NimBLEServerCallbacks *NimBLEServer::getCallbacks() const {
+    return clb;
+}
+
+bool NimBLEServer::disconnect(uint16_t connHandle, uint8_t reason) {
+    return HostBle::closeConn(connHandle, HostNode::current(), reason, true);
+}
+
+uint8_t NimBLEServer::getConnectedCount() const {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    uint8_t n = 0;
+    for(auto &kv: HostBle::conns){
+        if(kv.second.peripheral->ble().server.get() == this)
+            n++;
+    }
+    return n;
+}
+
+uint16_t NimBLEServer::getPeerMTU(uint16_t connHandle) const {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    HostBleConn *c = HostBle::findConn(connHandle);
+    return (c != nullptr and c->peripheral->ble().server.get() == this) ? c->mtu : 0;
+}
+
+bool NimBLEServer::updateConnParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval, uint16_t latency,
+                                    uint16_t timeout) const {
+    return HostBle::updateConnParams(connHandle, HostNode::current(), minInterval, maxInterval, latency, timeout);
+}
+
+bool NimBLEServer::setDataLen(uint16_t connHandle, uint16_t txOctets) const {
+    return HostBle::setDataLen(connHandle, HostNode::current(), txOctets);
+}
+
+bool NimBLEServer::updatePhy(uint16_t connHandle, uint8_t txPhysMask, uint8_t rxPhysMask, uint16_t phyOptions) {
+    return HostBle::updatePhy(connHandle, HostNode::current(), txPhysMask, rxPhysMask);
+}
+
+NimBLEServer::~NimBLEServer() {
+    // Same as NimBLE - server owns its callbacks unless told otherwise
+    if(deleteClb)
+        delete clb;
+}
+
+/// *************** NimBLEAdvertising ***************
+
+bool NimBLEAdvertising::setName(const std::string &n) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    name = n;
+    return true;
+}
+
+bool NimBLEAdvertising::addServiceUUID(const NimBLEUUID &uuid) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    serviceUUIDs.push_back(uuid);
+    return true;
+}
+
+bool NimBLEAdvertising::removeServiceUUID(const NimBLEUUID &uuid) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    serviceUUIDs.erase(std::remove(serviceUUIDs.begin(), serviceUUIDs.end(), uuid), serviceUUIDs.end());
+    return true;
+}
+
+bool NimBLEAdvertising::enableScanResponse(bool enable) {
+    scanResponse = enable;
+    return true;
+}
+
+bool NimBLEAdvertising::setManufacturerData(const std::string &data) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    manufacturerData = data;
+    return true;
+}
+
+bool NimBLEAdvertising::setScanResponseData(const NimBLEAdvertisementData &data) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    scanResponseName = data.getName();
+    scanResponseServiceData = data.serviceData;
+    return true;
+}
+
+bool NimBLEAdvertising::refreshAdvertisingData() {
+    // Reports are made from current data at every advertising event
+    return true;
+}
+
+bool NimBLEAdvertisementData::setName(const std::string &n, bool isComplete) {
+    name = n;
+    return true;
+}
+
+bool NimBLEAdvertisementData::setServiceData(const NimBLEUUID &uuid, const std::string &data) {
+    serviceData.emplace_back(uuid, data);
+    return true;
+}
+
+bool NimBLEAdvertising::start(uint32_t duration) {
+    HostNode *node = HostNode::current();
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        HostBleDevice &d = node->ble();
+        if(!d.initialised or d.connectionsCount() >= HostBle::maxConnections())
+            return false;
+        if(advertising)
+            return true;
+
+        advertising = true;
+        HostBle::advertisingStarted(node);
+    }
+
+    return true;
+}
+
+bool NimBLEAdvertising::stop() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    advertising = false;
+    return true;
+}
+
+bool NimBLEAdvertising::isAdvertising() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return advertising;
+}
+
+/// *************** NimBLEAdvertisedDevice ***************
+
+NimBLEAdvertisedDevice::NimBLEAdvertisedDevice(const NimBLEAddress &address, const std::string &name,
+                                               const std::vector<NimBLEUUID> &uuids,
+                                               const std::string &manufacturerData,
+                                               const std::vector<std::pair<NimBLEUUID, std::string>> &serviceData,
+                                               int rssi)
+    : addr(address), name(name), uuids(uuids), manuData(manufacturerData), serviceData(serviceData), rssi(rssi) {
+}
+
+NimBLEAddress NimBLEAdvertisedDevice::getAddress() const {
+    return addr;
+}
+
+std::string NimBLEAdvertisedDevice::getName() const {
+    return name;
+}
+
+int NimBLEAdvertisedDevice::getRSSI() const {
+    return rssi;
+}
+
+bool NimBLEAdvertisedDevice::isAdvertisingService(const NimBLEUUID &uuid) const {
+    return std::find(uuids.begin(), uuids.end(), uuid) != uuids.end();
+}
+
+bool NimBLEAdvertisedDevice::haveManufacturerData() const {
+    return !manuData.empty();
+}
+
+std::string NimBLEAdvertisedDevice::getManufacturerData() const {
+    return manuData;
+}
+
+bool NimBLEAdvertisedDevice::haveServiceData() const {
+    return !serviceData.empty();
+}
+
+std::string NimBLEAdvertisedDevice::getServiceData(const NimBLEUUID &uuid) const {
+    for(auto &sd: serviceData){
+        if(sd.first == uuid)
+            return sd.second;
+    }
+    return "";
+}
+
+bool NimBLEAdvertisedDevice::isConnectable() const {
+    return true;
+}
+
+std::string NimBLEAdvertisedDevice::toString() const {
+    return "Name: " + name + ", Address: " + addr.toString() + ", RSSI: " + std::to_string(rssi);
+}
+
+/// *************** NimBLEScanResults ***************
+
+int NimBLEScanResults::getCount() const {
+    return (int)devices.size();
+}
+
+const NimBLEAdvertisedDevice *NimBLEScanResults::getDevice(uint32_t idx) const {
+    for(auto &d: devices){
+        if(idx-- == 0)
+            return &d;
+    }
+    return nullptr;
+}
+
+std::list<NimBLEAdvertisedDevice>::const_iterator NimBLEScanResults::begin() const {
+    return devices.begin();
+}
+
+std::list<NimBLEAdvertisedDevice>::const_iterator NimBLEScanResults::end() const {
+    return devices.end();
+}
+
+/// *************** NimBLEScan ***************
+
+void NimBLEScan::setScanCallbacks(NimBLEScanCallbacks *callbacks, bool wantDuplicates) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    clb = callbacks;
+    duplicates = wantDuplicates;
+}
+
+void NimBLEScan::setActiveScan(bool active) {
+}
+
+void NimBLEScan::setInterval(uint16_t intervalMs) {
+}
+
+void NimBLEScan::setWindow(uint16_t windowMs) {
+}
+
+bool NimBLEScan::start(uint32_t duration, bool isContinue, bool restart) {
+    HostNode *node = HostNode::current();
+    uint32_t gen;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        if(!node->ble().initialised)
+            return false;
+        if(scanning and !restart)
+            return true;
+
+        generation++;
+        gen = generation;
+        scanning = true;
+        if(!isContinue)
+            results.devices.clear();
+    }
+
+    if(duration > 0){
+        HostRadio::get().post(node, duration, [this, gen](){
+            onEnd(gen);
+        });
+    }
+
+    return true;
+}
+
+bool NimBLEScan::stop() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    // NimBLE does not call onScanEnd() when scan is stopped by application
+    scanning = false;
+    generation++;
+    return true;
+}
+
+bool NimBLEScan::isScanning() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return scanning;
+}
+
+NimBLEScanResults NimBLEScan::getResults() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return results;
+}
+
+void NimBLEScan::clearResults() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    results.devices.clear();
+}
+
+void NimBLEScan::onAdvertisement(uint32_t gen, const NimBLEAdvertisedDevice &dev) {
+    const NimBLEAdvertisedDevice *reported;
+    NimBLEScanCallbacks *c;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        if(!scanning or gen != generation)
+            return;
+
+        auto known = std::find_if(results.devices.begin(), results.devices.end(), [&dev](const NimBLEAdvertisedDevice &d){
+            return d.getAddress() == dev.getAddress();
+        });
+
+        if(known != results.devices.end()){
+            if(!duplicates)
+                return;
+            *known = dev;
+            reported = &(*known);
+        } else {
+            results.devices.push_back(dev);
+            reported = &results.devices.back();
+        }
+
+        c = clb;
+    }
+
+    if(c != nullptr){
+        c->onDiscovered(reported);
+        c->onResult(reported);
+    }
+}
+
+void NimBLEScan::onEnd(uint32_t gen) {
+    NimBLEScanCallbacks *c;
+    NimBLEScanResults r;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        if(!scanning or gen != generation)
+            return;
+
+        scanning = false;
+        c = clb;
+        r = results;
+    }
+
+    if(c != nullptr)
+        c->onScanEnd(r, 0);
+}
+
+/// *************** NimBLERemoteCharacteristic ***************
+
+NimBLERemoteCharacteristic::NimBLERemoteCharacteristic(const NimBLEUUID &uuid, uint32_t properties,
+                                                       NimBLERemoteService *service)
+    : uuid(uuid), props(properties), svc(service) {
+}
+
+const NimBLEUUID &NimBLERemoteCharacteristic::getUUID() const {
+    return uuid;
+}
+
+NimBLERemoteService *NimBLERemoteCharacteristic::getRemoteService() const {
+    return svc;
+}
+
+bool NimBLERemoteCharacteristic::canNotify() const {
+    return (props & NIMBLE_PROPERTY::NOTIFY) != 0;
+}
+
+bool NimBLERemoteCharacteristic::canWrite() const {
+    return (props & NIMBLE_PROPERTY::WRITE) != 0;
+}
+
+bool NimBLERemoteCharacteristic::canRead() const {
+    return (props & NIMBLE_PROPERTY::READ) != 0;
+}
+
+bool NimBLERemoteCharacteristic::subscribe(bool notifications, const notify_callback &notifyCallback, bool response) {
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        notifyClb = notifyCallback;
+    }
+
+    std::string cccd{(char)(notifications ? 0x01 : 0x02), 0x00};
+    return HostBle::write(this, cccd, response, true);
+}
+
+bool NimBLERemoteCharacteristic::unsubscribe(bool response) {
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        notifyClb = nullptr;
+    }
+
+    return HostBle::write(this, std::string(2, '\0'), response, true);
+}
+
+bool NimBLERemoteCharacteristic::writeValue(const uint8_t *data, size_t length, bool response) {
+    return writeValue(std::string(reinterpret_cast<const char*>(data), length), response);
+}
+
+bool NimBLERemoteCharacteristic::writeValue(const std::string &v, bool response) {
+    return HostBle::write(this, v, response, false);
+}
+
+NimBLEAttValue NimBLERemoteCharacteristic::getValue() const {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return NimBLEAttValue(value);
+}
+
+NimBLEAttValue NimBLERemoteCharacteristic::readValue() {
+    std::string v;
+    if(!HostBle::read(this, v))
+        return NimBLEAttValue();
+
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    value = v;
+    return NimBLEAttValue(value);
+}
+
+/// *************** NimBLERemoteService ***************
+
+NimBLERemoteService::NimBLERemoteService(const NimBLEUUID &uuid, NimBLEClient *client) : uuid(uuid), cli(client) {
+}
+
+NimBLERemoteCharacteristic *NimBLERemoteService::getCharacteristic(const NimBLEUUID &u) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    for(auto &c: characteristics){
+        if(c->getUUID() == u)
+            return c.get();
+    }
+    return nullptr;
+}
+
+const NimBLEUUID &NimBLERemoteService::getUUID() const {
+    return uuid;
+}
+
+NimBLEClient *NimBLERemoteService::getClient() const {
+    return cli;
+}
+
+/// *************** NimBLEClient ***************
+
+void NimBLEClient::setClientCallbacks(NimBLEClientCallbacks *callbacks, bool deleteCallbacks) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    clb = callbacks;
+    deleteClb = deleteCallbacks;
+}
+
+bool NimBLEClient::connect(const NimBLEAdvertisedDevice *device, bool deleteAttributes, bool asyncConnect,
+                           bool exchangeMTU) {
+    if(device == nullptr)
+        return false;
+
+    return connect(device->getAddress(), deleteAttributes, asyncConnect, exchangeMTU);
+}
+
+bool NimBLEClient::connect(const NimBLEAddress &address, bool deleteAttributes, bool asyncConnect, bool exchangeMTU) {
+    HostNode *central = HostNode::current();
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        if(connHandle != BLE_HS_CONN_HANDLE_NONE or connecting)
+            return false;
+
+        if(deleteAttributes)
+            services.clear();
+
+        connecting = true;
+        peer = address;
+    }
+
+    uint32_t startMs = HostClock::millis();
+    HostRadio::get().post(central, 0, [central, this, address, startMs](){
+        HostBle::tryEstablish(central, this, address, startMs);
+    });
+
+    if(asyncConnect)
+        return true;
+
+    while(true){
+        {
+            std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+            if(!connecting)
+                return connHandle != BLE_HS_CONN_HANDLE_NONE;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+bool NimBLEClient::disconnect(uint8_t reason) {
+    uint16_t h;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        if(connecting){
+            // Cancel pending connection
+            connecting = false;
+            return true;
+        }
+        h = connHandle;
+    }
+
+    return HostBle::closeConn(h, HostNode::current(), reason, true);
+}
+
+bool NimBLEClient::isConnected() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return connHandle != BLE_HS_CONN_HANDLE_NONE;
+}
+
+uint16_t NimBLEClient::getConnHandle() const {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return connHandle;
+}
+
+NimBLEAddress NimBLEClient::getPeerAddress() const {
+    return peer;
+}
+
+uint16_t NimBLEClient::getMTU() const {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    HostBleConn *c = HostBle::findConn(connHandle);
+    return c != nullptr ? c->mtu : 0;
+}
+
+void NimBLEClient::setConnectTimeout(uint32_t timeoutMs) {
+    connectTimeoutMs = timeoutMs;
+}
+
+void NimBLEClient::setConnectionParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout,
+                                       uint16_t scanInterval, uint16_t scanWindow) {
+    // Used by next connection, central picks the longest interval of the range
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    connItvl = maxInterval;
+    connLatency = latency;
+    connTimeout = timeout;
+}
+
+bool NimBLEClient::updateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    return HostBle::updateConnParams(connHandle, HostNode::current(), minInterval, maxInterval, latency, timeout);
+}
+
+bool NimBLEClient::setDataLen(uint16_t txOctets) {
+    return HostBle::setDataLen(connHandle, HostNode::current(), txOctets);
+}
+
+bool NimBLEClient::updatePhy(uint8_t txPhysMask, uint8_t rxPhysMask, uint16_t phyOptions) {
+    return HostBle::updatePhy(connHandle, HostNode::current(), txPhysMask, rxPhysMask);
+}
+
+NimBLERemoteService *NimBLEClient::getService(const NimBLEUUID &uuid) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    for(auto &s: services){
+        if(s->getUUID() == uuid)
+            return s.get();
+    }
+
+    // Service discovery
+    HostBleConn *c = HostBle::findConn(connHandle);
+    if(c == nullptr or c->peripheral->ble().server == nullptr)
+        return nullptr;
+
+    NimBLEService *svc = c->peripheral->ble().server->getServiceByUUID(uuid);
+    if(svc == nullptr)
+        return nullptr;
+
+    auto *rs = new NimBLERemoteService(uuid, this);
+    for(auto &ch: svc->characteristics)
+        rs->characteristics.emplace_back(new NimBLERemoteCharacteristic(ch->getUUID(), ch->getProperties(), rs));
+
+    services.emplace_back(rs);
+    return rs;
+}
+
+NimBLEClient::~NimBLEClient() {
+    if(deleteClb)
+        delete clb;
+}
+
+/// *************** NimBLEDevice ***************
+
+bool NimBLEDevice::init(const std::string &deviceName) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    HostBleDevice &d = HostBle::dev();
+    d.initialised = true;
+    d.name = deviceName;
+    return true;
+}
+
+bool NimBLEDevice::deinit(bool clearAll) {
+    HostNode *node = HostNode::current();
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        HostBleDevice &d = node->ble();
+        d.advertising.advertising = false;
+        d.scan.scanning = false;
+        d.scan.generation++;
+    }
+
+    HostBle::closeAllOf(node);
+
+    std::unique_ptr<NimBLEServer> srv;
+    std::vector<NimBLEClient*> clients;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        HostBleDevice &d = node->ble();
+        d.initialised = false;
+
+        if(clearAll){
+            srv = std::move(d.server);
+            uint32_t advGen = d.advertising.generation;
+            d.advertising = NimBLEAdvertising();
+            d.advertising.generation = advGen;
+            for(auto &c: d.clients){
+                if(c != nullptr)
+                    clients.push_back(c);
+                c = nullptr;
+            }
+        }
+    }
+
+    for(auto *c: clients)
+        delete c;
+
+    return true;
+}
+
+bool NimBLEDevice::isInitialized() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return HostBle::dev().initialised;
+}
+
+bool NimBLEDevice::setMTU(uint16_t mtu) {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    if(mtu < 23 or mtu > 527)
+        return false;
+
+    HostBle::dev().mtu = mtu;
+    return true;
+}
+
+uint16_t NimBLEDevice::getMTU() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return HostBle::dev().mtu;
+}
+
+void NimBLEDevice::setSecurityAuth(bool bonding, bool mitm, bool sc) {
+}
+
+void NimBLEDevice::setSecurityIOCap(uint8_t iocap) {
+}
+
+bool NimBLEDevice::injectPassKey(const NimBLEConnInfo &peerInfo, uint32_t passKey) {
+    return true;
+}
+
+NimBLEAddress NimBLEDevice::getAddress() {
+    return HostBle::addressOf(HostNode::current());
+}
+
+NimBLEServer *NimBLEDevice::createServer() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    HostBleDevice &d = HostBle::dev();
+    if(d.server == nullptr)
+        d.server.reset(new NimBLEServer());
+
+    return d.server.get();
+}
+
+NimBLEServer *NimBLEDevice::getServer() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    return HostBle::dev().server.get();
+}
+
+NimBLEAdvertising *NimBLEDevice::getAdvertising() {
+    return &HostBle::dev().advertising;
+}
+
+bool NimBLEDevice::startAdvertising(uint32_t duration) {
+    return getAdvertising()->start(duration);
+}
+
+bool NimBLEDevice::stopAdvertising() {
+    return getAdvertising()->stop();
+}
+
+NimBLEScan *NimBLEDevice::getScan() {
+    return &HostBle::dev().scan;
+}
+
+NimBLEClient *NimBLEDevice::createClient() {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    HostBleDevice &d = HostBle::dev();
+    for(auto &c: d.clients){
+        if(c == nullptr){
+            c = new NimBLEClient();
+            return c;
+        }
+    }
+
+    // Same as NimBLE - no more than CONFIG_BT_NIMBLE_MAX_CONNECTIONS client objects
+    return nullptr;
+}
+
+bool NimBLEDevice::deleteClient(NimBLEClient *client) {
+    HostNode *node = HostNode::current();
+    uint16_t h;
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        if(!node->ble().hasClient(client))
+            return false;
+        h = client->connHandle;
+        client->connecting = false;
+    }
+
+    if(h != BLE_HS_CONN_HANDLE_NONE)
+        HostBle::closeConn(h, node, BLE_ERR_REM_USER_CONN_TERM, false);
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+        for(auto &c: node->ble().clients){
+            if(c == client)
+                c = nullptr;
+        }
+    }
+
+    delete client;
+    return true;
+}
+
+/// *************** HostBleDevice ***************
+
+uint8_t HostBleDevice::connectionsCount() const {
+    std::lock_guard<std::recursive_mutex> lock(HostBle::mtx);
+    uint8_t n = 0;
+    for(auto &kv: HostBle::conns){
+        if(&kv.second.central->ble() == this or &kv.second.peripheral->ble() == this)
+            n++;
+    }
+    return n;
+}
+
+bool HostBleDevice::hasClient(const NimBLEClient *c) const {
+    if(c == nullptr)
+        return false;
+
+    for(auto *cl: clients){
+        if(cl == c)
+            return true;
+    }
+    return false;
+}
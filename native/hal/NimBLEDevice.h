@@ -0,0 +1,509 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_NIMBLEDEVICE_H
+#define MGLIGHTFW_HOST_NIMBLEDEVICE_H
+
+/**
+ * Host replacement of NimBLE-Arduino 2.x. Devices are HostNode objects and the air between them
+ * is HostRadio. Only the GAP/GATT subset used by BLELN is implemented.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <functional>
+
+#define BLE_HS_CONN_HANDLE_NONE         0xffff
+
+#define BLE_HS_EAGAIN                   1
+#define BLE_HS_EALREADY                 2
+#define BLE_HS_EINVAL                   3
+#define BLE_HS_ENOMEM                   6
+#define BLE_HS_ENOTCONN                 7
+#define BLE_HS_ETIMEOUT                 13
+#define BLE_HS_EDONE                    14
+#define BLE_HS_EBUSY                    15
+#define BLE_HS_ERR_HCI_BASE             0x200
+
+#define BLE_ERR_AUTH_FAIL               0x05
+#define BLE_ERR_CONN_LIMIT              0x09
+#define BLE_ERR_CONN_REJ_SECURITY       0x0e
+#define BLE_ERR_REM_USER_CONN_TERM      0x13
+#define BLE_ERR_RD_CONN_TERM_RESRCS     0x14
+#define BLE_ERR_CONN_TERM_LOCAL         0x16
+
+#define BLE_HS_IO_DISPLAY_ONLY          0x00
+#define BLE_HS_IO_DISPLAY_YESNO         0x01
+#define BLE_HS_IO_KEYBOARD_ONLY         0x02
+#define BLE_HS_IO_NO_INPUT_OUTPUT       0x03
+#define BLE_HS_IO_KEYBOARD_DISPLAY      0x04
+
+#define BLE_GAP_LE_PHY_1M_MASK          0x01
+#define BLE_GAP_LE_PHY_2M_MASK          0x02
+#define BLE_GAP_LE_PHY_CODED_MASK       0x04
+
+#define BLE_ADDR_PUBLIC                 0x00
+#define BLE_ADDR_RANDOM                 0x01
+
+#ifndef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define CONFIG_BT_NIMBLE_MAX_CONNECTIONS 3
+#endif
+
+struct NIMBLE_PROPERTY {
+    enum : uint16_t {
+        BROADCAST       = 0x0001,
+        READ            = 0x0002,
+        WRITE_NR        = 0x0004,
+        WRITE           = 0x0008,
+        NOTIFY          = 0x0010,
+        INDICATE        = 0x0020,
+        READ_ENC        = 0x0200,
+        READ_AUTHEN     = 0x0400,
+        READ_AUTHOR     = 0x0800,
+        WRITE_ENC       = 0x1000,
+        WRITE_AUTHEN    = 0x2000,
+        WRITE_AUTHOR    = 0x4000
+    };
+};
+
+class NimBLEServer;
+class NimBLEService;
+class NimBLECharacteristic;
+class NimBLEClient;
+class NimBLERemoteService;
+class NimBLERemoteCharacteristic;
+class NimBLEAdvertisedDevice;
+class NimBLEScanResults;
+struct HostBleDevice;
+class HostBle;
+
+class NimBLEUUID {
+public:
+    NimBLEUUID() = default;
+    NimBLEUUID(const std::string &uuid);
+    NimBLEUUID(const char *uuid);
+
+    std::string toString() const;
+    bool operator==(const NimBLEUUID &o) const;
+    bool operator!=(const NimBLEUUID &o) const;
+
+private:
+    std::string v;
+};
+
+class NimBLEAddress {
+public:
+    NimBLEAddress() = default;
+    NimBLEAddress(const uint8_t *mac6, uint8_t type);
+
+    const uint8_t* getVal() const;
+    uint8_t getType() const;
+    bool isNull() const;
+    std::string toString() const;
+    bool operator==(const NimBLEAddress &o) const;
+    bool operator!=(const NimBLEAddress &o) const;
+
+private:
+    uint8_t val[6]{};
+    uint8_t type = BLE_ADDR_PUBLIC;
+};
+
+class NimBLEAttValue {
+public:
+    NimBLEAttValue() = default;
+    NimBLEAttValue(const uint8_t *d, size_t len) : v(reinterpret_cast<const char*>(d), len) {}
+    NimBLEAttValue(const std::string &s) : v(s) {}
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(v.data()); }
+    size_t size() const { return v.size(); }
+    size_t length() const { return v.size(); }
+    const char* c_str() const { return v.c_str(); }
+    operator std::string() const { return v; }
+
+private:
+    std::string v;
+};
+
+class NimBLEConnInfo {
+public:
+    NimBLEConnInfo() = default;
+    NimBLEConnInfo(uint16_t handle, const NimBLEAddress &peer, uint16_t mtu)
+        : h(handle), addr(peer), m(mtu) {}
+
+    uint16_t getConnHandle() const { return h; }
+    NimBLEAddress getAddress() const { return addr; }
+    uint16_t getMTU() const { return m; }
+
+private:
+    uint16_t h = BLE_HS_CONN_HANDLE_NONE;
+    NimBLEAddress addr;
+    uint16_t m = 23;
+};
+
+/// *************** Callbacks ***************
+
+class NimBLEServerCallbacks {
+public:
+    virtual ~NimBLEServerCallbacks() = default;
+    virtual void onConnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo) {}
+    virtual void onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo, int reason) {}
+    virtual void onMTUChange(uint16_t mtu, NimBLEConnInfo &connInfo) {}
+};
+
+class NimBLECharacteristicCallbacks {
+public:
+    virtual ~NimBLECharacteristicCallbacks() = default;
+    virtual void onRead(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) {}
+    virtual void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) {}
+    virtual void onStatus(NimBLECharacteristic *pCharacteristic, int code) {}
+    virtual void onSubscribe(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue) {}
+};
+
+class NimBLEClientCallbacks {
+public:
+    virtual ~NimBLEClientCallbacks() = default;
+    virtual void onConnect(NimBLEClient *pClient) {}
+    virtual void onConnectFail(NimBLEClient *pClient, int reason) {}
+    virtual void onDisconnect(NimBLEClient *pClient, int reason) {}
+    virtual void onPassKeyEntry(NimBLEConnInfo &connInfo) {}
+};
+
+class NimBLEScanCallbacks {
+public:
+    virtual ~NimBLEScanCallbacks() = default;
+    virtual void onDiscovered(const NimBLEAdvertisedDevice *advertisedDevice) {}
+    virtual void onResult(const NimBLEAdvertisedDevice *advertisedDevice) {}
+    virtual void onScanEnd(const NimBLEScanResults &scanResults, int reason) {}
+};
+
+/// *************** Server (peripheral) ***************
+
+class NimBLECharacteristic {
+public:
+    NimBLECharacteristic(const NimBLEUUID &uuid, uint32_t properties, NimBLEService *service);
+
+    const NimBLEUUID& getUUID() const;
+    uint32_t getProperties() const;
+    NimBLEService* getService() const;
+
+    void setCallbacks(NimBLECharacteristicCallbacks *callbacks);
+    NimBLECharacteristicCallbacks* getCallbacks() const;
+
+    void setValue(const uint8_t *data, size_t len);
+    void setValue(const std::string &value);
+    // Reference to stored value, like NimBLE 2.x - no copy in write callbacks
+    const NimBLEAttValue& getValue() const;
+
+    bool notify(uint16_t connHandle = BLE_HS_CONN_HANDLE_NONE);
+    bool notify(const uint8_t *value, size_t length, uint16_t connHandle = BLE_HS_CONN_HANDLE_NONE);
+    bool notify(const std::string &value, uint16_t connHandle = BLE_HS_CONN_HANDLE_NONE);
+
+private:
+    friend class HostBle;
+    NimBLEUUID uuid;
+    uint32_t props;
+    NimBLEService *svc;
+    NimBLECharacteristicCallbacks *clb = nullptr;
+    NimBLEAttValue value;
+};
+
+class NimBLEService {
+public:
+    NimBLEService(const NimBLEUUID &uuid, NimBLEServer *server);
+
+    NimBLECharacteristic* createCharacteristic(const char *uuid, uint32_t properties, uint16_t maxLen = 512);
+    NimBLECharacteristic* createCharacteristic(const NimBLEUUID &uuid, uint32_t properties, uint16_t maxLen = 512);
+    NimBLECharacteristic* getCharacteristic(const NimBLEUUID &uuid);
+    const NimBLEUUID& getUUID() const;
+    NimBLEServer* getServer() const;
+    bool start();
+
+    std::list<std::unique_ptr<NimBLECharacteristic>> characteristics;
+
+private:
+    NimBLEUUID uuid;
+    NimBLEServer *srv;
+};
+
+class NimBLEServer {
+public:
+    NimBLEService* createService(const NimBLEUUID &uuid);
+    NimBLEService* getServiceByUUID(const NimBLEUUID &uuid);
+    void setCallbacks(NimBLEServerCallbacks *callbacks, bool deleteCallbacks = true);
+    NimBLEServerCallbacks* getCallbacks() const;
+
+    bool disconnect(uint16_t connHandle, uint8_t reason = BLE_ERR_REM_USER_CONN_TERM);
+    uint8_t getConnectedCount() const;
+    uint16_t getPeerMTU(uint16_t connHandle) const;
+    bool updateConnParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval, uint16_t latency,
+                          uint16_t timeout) const;
+    bool setDataLen(uint16_t connHandle, uint16_t txOctets) const;
+    bool updatePhy(uint16_t connHandle, uint8_t txPhysMask, uint8_t rxPhysMask, uint16_t phyOptions);
+
+    ~NimBLEServer();
+
+    std::list<std::unique_ptr<NimBLEService>> services;
+
+private:
+    friend class HostBle;
+    NimBLEServerCallbacks *clb = nullptr;
+    bool deleteClb = false;
+};
+
+// Only what scan response of BLELN server uses
+class NimBLEAdvertisementData {
+public:
+    bool setName(const std::string &name, bool isComplete = true);
+    bool setServiceData(const NimBLEUUID &uuid, const std::string &data);
+    const std::string& getName() const { return name; }
+
+private:
+    friend class NimBLEAdvertising;
+    std::string name;
+    std::vector<std::pair<NimBLEUUID, std::string>> serviceData;
+};
+
+class NimBLEAdvertising {
+public:
+    bool setName(const std::string &name);
+    bool addServiceUUID(const NimBLEUUID &uuid);
+    bool removeServiceUUID(const NimBLEUUID &uuid);
+    bool enableScanResponse(bool enable);
+    bool setManufacturerData(const std::string &data);
+    bool setScanResponseData(const NimBLEAdvertisementData &data);
+    bool refreshAdvertisingData();
+    bool start(uint32_t duration = 0);
+    bool stop();
+    bool isAdvertising();
+
+private:
+    friend class HostBle;
+    friend class NimBLEDevice;
+    std::string name;
+    std::vector<NimBLEUUID> serviceUUIDs;
+    std::string manufacturerData;
+    std::string scanResponseName;
+    std::vector<std::pair<NimBLEUUID, std::string>> scanResponseServiceData;
+    bool scanResponse = false;
+    bool advertising = false;
+    uint32_t generation = 0;
+};
+
+/// *************** Scanner (central) ***************
+
+class NimBLEAdvertisedDevice {
+public:
+    NimBLEAdvertisedDevice(const NimBLEAddress &address, const std::string &name, const std::vector<NimBLEUUID> &uuids,
+                           const std::string &manufacturerData,
+                           const std::vector<std::pair<NimBLEUUID, std::string>> &serviceData, int rssi);
+
+    NimBLEAddress getAddress() const;
+    std::string getName() const;
+    int getRSSI() const;
+    bool isAdvertisingService(const NimBLEUUID &uuid) const;
+    bool haveManufacturerData() const;
+    std::string getManufacturerData() const;
+    bool haveServiceData() const;
+    std::string getServiceData(const NimBLEUUID &uuid) const;
+    bool isConnectable() const;
+    std::string toString() const;
+
+private:
+    NimBLEAddress addr;
+    std::string name;
+    std::vector<NimBLEUUID> uuids;
+    std::string manuData;
+    std::vector<std::pair<NimBLEUUID, std::string>> serviceData;
+    int rssi;
+};
+
+class NimBLEScanResults {
+public:
+    int getCount() const;
+    const NimBLEAdvertisedDevice* getDevice(uint32_t idx) const;
+    std::list<NimBLEAdvertisedDevice>::const_iterator begin() const;
+    std::list<NimBLEAdvertisedDevice>::const_iterator end() const;
+
+private:
+    friend class NimBLEScan;
+    std::list<NimBLEAdvertisedDevice> devices;
+};
+
+class NimBLEScan {
+public:
+    void setScanCallbacks(NimBLEScanCallbacks *callbacks, bool wantDuplicates = false);
+    void setActiveScan(bool active);
+    void setInterval(uint16_t intervalMs);
+    void setWindow(uint16_t windowMs);
+    bool start(uint32_t duration, bool isContinue = false, bool restart = true);
+    bool stop();
+    bool isScanning();
+    NimBLEScanResults getResults();
+    void clearResults();
+
+private:
+    friend class HostBle;
+    friend class NimBLEDevice;
+    NimBLEScanCallbacks *clb = nullptr;
+    bool duplicates = false;
+    bool scanning = false;
+    uint32_t generation = 0;
+    NimBLEScanResults results;
+
+    void onAdvertisement(uint32_t gen, const NimBLEAdvertisedDevice &dev);
+    void onEnd(uint32_t gen);
+};
+
+/// *************** Client (central) ***************
+
+class NimBLERemoteCharacteristic {
+public:
+    typedef std::function<void(NimBLERemoteCharacteristic *pChar, uint8_t *pData, size_t length, bool isNotify)> notify_callback;
+
+    NimBLERemoteCharacteristic(const NimBLEUUID &uuid, uint32_t properties, NimBLERemoteService *service);
+
+    const NimBLEUUID& getUUID() const;
+    NimBLERemoteService* getRemoteService() const;
+    bool canNotify() const;
+    bool canWrite() const;
+    bool canRead() const;
+
+    bool subscribe(bool notifications = true, const notify_callback &notifyCallback = nullptr, bool response = true);
+    bool unsubscribe(bool response = true);
+    bool writeValue(const uint8_t *data, size_t length, bool response = false);
+    bool writeValue(const std::string &value, bool response = false);
+    NimBLEAttValue getValue() const;
+    // ATT read - waits for peripheral's answer, empty on failure
+    NimBLEAttValue readValue();
+
+private:
+    friend class HostBle;
+    NimBLEUUID uuid;
+    uint32_t props;
+    NimBLERemoteService *svc;
+    notify_callback notifyClb;
+    std::string value;
+};
+
+class NimBLERemoteService {
+public:
+    NimBLERemoteService(const NimBLEUUID &uuid, NimBLEClient *client);
+
+    NimBLERemoteCharacteristic* getCharacteristic(const NimBLEUUID &uuid);
+    const NimBLEUUID& getUUID() const;
+    NimBLEClient* getClient() const;
+
+    std::list<std::unique_ptr<NimBLERemoteCharacteristic>> characteristics;
+
+private:
+    NimBLEUUID uuid;
+    NimBLEClient *cli;
+};
+
+class NimBLEClient {
+public:
+    void setClientCallbacks(NimBLEClientCallbacks *callbacks, bool deleteCallbacks = true);
+    bool connect(const NimBLEAdvertisedDevice *device, bool deleteAttributes = true, bool asyncConnect = false,
+                 bool exchangeMTU = true);
+    bool connect(const NimBLEAddress &address, bool deleteAttributes = true, bool asyncConnect = false,
+                 bool exchangeMTU = true);
+    bool disconnect(uint8_t reason = BLE_ERR_REM_USER_CONN_TERM);
+    bool isConnected();
+    uint16_t getConnHandle() const;
+    NimBLEAddress getPeerAddress() const;
+    uint16_t getMTU() const;
+    void setConnectTimeout(uint32_t timeoutMs);
+    void setConnectionParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout,
+                             uint16_t scanInterval = 16, uint16_t scanWindow = 16);
+    bool updateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+    bool setDataLen(uint16_t txOctets);
+    bool updatePhy(uint8_t txPhysMask, uint8_t rxPhysMask, uint16_t phyOptions = 0);
+
+    NimBLERemoteService* getService(const NimBLEUUID &uuid);
+
+    ~NimBLEClient();
+
+private:
+    friend class HostBle;
+    friend class NimBLEDevice;
+    NimBLEClientCallbacks *clb = nullptr;
+    bool deleteClb = false;
+    uint16_t connHandle = BLE_HS_CONN_HANDLE_NONE;
+    bool connecting = false;
+    NimBLEAddress peer;
+    uint32_t connectTimeoutMs = 30000;
+    uint16_t connItvl = 0;              // Parameters of next connection, 0 - controller default
+    uint16_t connLatency = 0;
+    uint16_t connTimeout = 0;
+    std::list<std::unique_ptr<NimBLERemoteService>> services;
+};
+
+/// *************** Device ***************
+
+class NimBLEDevice {
+public:
+    static bool init(const std::string &deviceName);
+    static bool deinit(bool clearAll = false);
+    static bool isInitialized();
+
+    static bool setMTU(uint16_t mtu);
+    static uint16_t getMTU();
+    static void setSecurityAuth(bool bonding, bool mitm, bool sc);
+    static void setSecurityIOCap(uint8_t iocap);
+    static bool injectPassKey(const NimBLEConnInfo &peerInfo, uint32_t passKey);
+    static NimBLEAddress getAddress();
+
+    static NimBLEServer* createServer();
+    static NimBLEServer* getServer();
+    static NimBLEAdvertising* getAdvertising();
+    static bool startAdvertising(uint32_t duration = 0);
+    static bool stopAdvertising();
+
+    static NimBLEScan* getScan();
+    static NimBLEClient* createClient();
+    static bool deleteClient(NimBLEClient *client);
+};
+
+/// *************** Host internals ***************
+
+struct HostBleConn;
+
+/**
+ * BLE controller and host state of one HostNode.
+ */
+struct HostBleDevice {
+    bool initialised = false;
+    std::string name;
+    uint16_t mtu = 255;
+
+    std::unique_ptr<NimBLEServer> server;
+    NimBLEAdvertising advertising;
+    NimBLEScan scan;
+    NimBLEClient *clients[CONFIG_BT_NIMBLE_MAX_CONNECTIONS]{};
+
+    uint8_t connectionsCount() const;
+    bool hasClient(const NimBLEClient *c) const;
+};
+
+#endif //MGLIGHTFW_HOST_NIMBLEDEVICE_H
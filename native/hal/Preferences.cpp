@@ -0,0 +1,181 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "Preferences.h"
+#include "HostNode.h"
+#include <cstring>
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partitionLabel) {
+    if(started)
+        return false;
+
+    node = HostNode::current();
+    ns = name;
+    ro = readOnly;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    if(node->nvs.find(ns) == node->nvs.end()) {
+        // Like nvs_open(NVS_READONLY) - namespace has to exist
+        if(readOnly)
+            return false;
+        node->nvs[ns];
+    }
+
+    started = true;
+    return true;
+}
+
+void Preferences::end() {
+    started = false;
+}
+
+bool Preferences::clear() {
+    if(!started or ro)
+        return false;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    node->nvs[ns].clear();
+    return true;
+}
+
+bool Preferences::remove(const char *key) {
+    if(!started or ro)
+        return false;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    return node->nvs[ns].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char *key) {
+    if(!started)
+        return false;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    auto &n = node->nvs[ns];
+    return n.find(key) != n.end();
+}
+
+size_t Preferences::put(const char *key, const void *value, size_t len) {
+    if(!started or ro or key == nullptr)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    auto *b = static_cast<const uint8_t*>(value);
+    node->nvs[ns][key] = std::vector<uint8_t>(b, b + len);
+    return len;
+}
+
+bool Preferences::get(const char *key, void *value, size_t len) {
+    if(!started or key == nullptr)
+        return false;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    auto &n = node->nvs[ns];
+    auto it = n.find(key);
+    if(it == n.end() or it->second.size() != len)
+        return false;
+
+    memcpy(value, it->second.data(), len);
+    return true;
+}
+
+size_t Preferences::putChar(const char *key, int8_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putUChar(const char *key, uint8_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putInt(const char *key, int32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putUInt(const char *key, uint32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putLong(const char *key, int32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putULong(const char *key, uint32_t value) { return put(key, &value, sizeof(value)); }
+size_t Preferences::putBool(const char *key, bool value) { uint8_t v = value; return put(key, &v, sizeof(v)); }
+
+size_t Preferences::putString(const char *key, const char *value) {
+    // Stored with terminating zero, returned length does not include it
+    size_t r = put(key, value, strlen(value) + 1);
+    return r > 0 ? r - 1 : 0;
+}
+
+size_t Preferences::putString(const char *key, const String &value) {
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+    return put(key, value, len);
+}
+
+int8_t Preferences::getChar(const char *key, int8_t defaultValue) {
+    int8_t v = defaultValue; get(key, &v, sizeof(v)); return v;
+}
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue) {
+    uint8_t v = defaultValue; get(key, &v, sizeof(v)); return v;
+}
+int32_t Preferences::getInt(const char *key, int32_t defaultValue) {
+    int32_t v = defaultValue; get(key, &v, sizeof(v)); return v;
+}
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+    uint32_t v = defaultValue; get(key, &v, sizeof(v)); return v;
+}
+int32_t Preferences::getLong(const char *key, int32_t defaultValue) {
+    int32_t v = defaultValue; get(key, &v, sizeof(v)); return v;
+}
+uint32_t Preferences::getULong(const char *key, uint32_t defaultValue) {
+    uint32_t v = defaultValue; get(key, &v, sizeof(v)); return v;
+}
+bool Preferences::getBool(const char *key, bool defaultValue) {
+    uint8_t v = defaultValue; get(key, &v, sizeof(v)); return v != 0;
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen) {
+    size_t len = getBytesLength(key);
+    if(len == 0 or len > maxLen)
+        return 0;
+
+    return getBytes(key, value, maxLen);
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+    char buf[4000];
+    if(getString(key, buf, sizeof(buf)) == 0)
+        return defaultValue;
+
+    return String(buf);
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+    if(!started or key == nullptr)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    auto &n = node->nvs[ns];
+    auto it = n.find(key);
+    return it == n.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+    if(!started or key == nullptr)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(node->nvsMtx);
+    auto &n = node->nvs[ns];
+    auto it = n.find(key);
+    if(it == n.end() or it->second.size() > maxLen)
+        return 0;
+
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
@@ -0,0 +1,75 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_PREFERENCES_H
+#define MGLIGHTFW_HOST_PREFERENCES_H
+
+#include <cstdint>
+#include <cstddef>
+#include "WString.h"
+
+class HostNode;
+
+/**
+ * ESP32 Preferences API over in-memory NVS of HostNode::current().
+ */
+class Preferences {
+public:
+    bool begin(const char *name, bool readOnly = false, const char *partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putChar(const char *key, int8_t value);
+    size_t putUChar(const char *key, uint8_t value);
+    size_t putInt(const char *key, int32_t value);
+    size_t putUInt(const char *key, uint32_t value);
+    size_t putLong(const char *key, int32_t value);
+    size_t putULong(const char *key, uint32_t value);
+    size_t putBool(const char *key, bool value);
+    size_t putString(const char *key, const char *value);
+    size_t putString(const char *key, const String &value);
+    size_t putBytes(const char *key, const void *value, size_t len);
+
+    int8_t getChar(const char *key, int8_t defaultValue = 0);
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+    int32_t getInt(const char *key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    int32_t getLong(const char *key, int32_t defaultValue = 0);
+    uint32_t getULong(const char *key, uint32_t defaultValue = 0);
+    bool getBool(const char *key, bool defaultValue = false);
+    size_t getString(const char *key, char *value, size_t maxLen);
+    String getString(const char *key, const String &defaultValue = String());
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+private:
+    HostNode *node = nullptr;
+    std::string ns;
+    bool started = false;
+    bool ro = false;
+
+    size_t put(const char *key, const void *value, size_t len);
+    bool get(const char *key, void *value, size_t len);
+};
+
+#endif //MGLIGHTFW_HOST_PREFERENCES_H
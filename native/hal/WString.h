@@ -0,0 +1,70 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_WSTRING_H
+#define MGLIGHTFW_HOST_WSTRING_H
+
+#include <string>
+#include <cstdlib>
+
+/**
+ * Subset of Arduino String used by firmware and the host shims, backed by std::string.
+ */
+class String {
+public:
+    String() = default;
+    String(const char *s) : v(s != nullptr ? s : "") {}
+    String(const std::string &s) : v(s) {}
+    String(const char *s, size_t len) : v(s, len) {}
+    explicit String(char c) : v(1, c) {}
+    explicit String(int n) : v(std::to_string(n)) {}
+    explicit String(unsigned int n) : v(std::to_string(n)) {}
+    explicit String(long n) : v(std::to_string(n)) {}
+    explicit String(unsigned long n) : v(std::to_string(n)) {}
+
+    const char* c_str() const { return v.c_str(); }
+    char* begin() { return &v[0]; }
+    unsigned int length() const { return v.length(); }
+    bool isEmpty() const { return v.empty(); }
+    long toInt() const { return strtol(v.c_str(), nullptr, 10); }
+    int indexOf(const String &s) const {
+        size_t p = v.find(s.v);
+        return p == std::string::npos ? -1 : (int)p;
+    }
+    String substring(unsigned int from) const { return from < v.size() ? String(v.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < v.size() ? String(v.substr(from, to - from)) : String();
+    }
+
+    String& operator+=(const String &s) { v += s.v; return *this; }
+    String& operator+=(const char *s) { v += s; return *this; }
+    String& operator+=(char c) { v += c; return *this; }
+    friend String operator+(const String &a, const String &b) { return String(a.v + b.v); }
+    bool operator==(const String &s) const { return v == s.v; }
+    bool operator==(const char *s) const { return v == s; }
+    bool operator!=(const String &s) const { return v != s.v; }
+
+    const std::string& str() const { return v; }
+
+private:
+    std::string v;
+};
+
+#endif //MGLIGHTFW_HOST_WSTRING_H
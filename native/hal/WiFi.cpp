@@ -0,0 +1,140 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "WiFi.h"
+#include "HostNode.h"
+#include "HostClock.h"
+#include "HTTPClient.h"
+
+#include <map>
+#include <mutex>
+
+WiFiClass WiFi;
+
+namespace {
+    // Connection takes a moment, the same as association and DHCP on device
+    constexpr uint32_t CONNECT_TIME_MS = 500;
+    constexpr uint32_t SCAN_TIME_MS = 2000;
+
+    struct NodeWiFi {
+        bool connecting = false;
+        uint32_t connectStartMs = 0;
+        bool scanning = false;
+        uint32_t scanStartMs = 0;
+        int16_t scanCount = WIFI_SCAN_FAILED;
+    };
+
+    std::mutex wifiMtx;
+    std::map<HostNode*, NodeWiFi> nodes;
+
+    NodeWiFi& self() {
+        return nodes[HostNode::current()];
+    }
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+    return true;
+}
+
+int WiFiClass::begin(const char *ssid, const char *passphrase) {
+    std::lock_guard<std::mutex> lock(wifiMtx);
+    NodeWiFi &w = self();
+    w.connecting = true;
+    w.connectStartMs = HostClock::millis();
+    return 0;
+}
+
+bool WiFiClass::isConnected() {
+    std::lock_guard<std::mutex> lock(wifiMtx);
+    NodeWiFi &w = self();
+    return w.connecting and HostNode::current()->isWiFiAvailable()
+        and (HostClock::millis() - w.connectStartMs) >= CONNECT_TIME_MS;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    std::lock_guard<std::mutex> lock(wifiMtx);
+    self().connecting = false;
+    return true;
+}
+
+bool WiFiClass::persistent(bool persistent) {
+    return true;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden, bool passive, uint32_t maxMsPerChannel) {
+    {
+        std::lock_guard<std::mutex> lock(wifiMtx);
+        NodeWiFi &w = self();
+        w.scanning = true;
+        w.scanStartMs = HostClock::millis();
+    }
+
+    if(async)
+        return WIFI_SCAN_RUNNING;
+
+    HostClock::sleepMs(SCAN_TIME_MS);
+    return scanComplete();
+}
+
+int16_t WiFiClass::scanComplete() {
+    std::lock_guard<std::mutex> lock(wifiMtx);
+    NodeWiFi &w = self();
+    if(w.scanning){
+        if((HostClock::millis() - w.scanStartMs) < SCAN_TIME_MS)
+            return WIFI_SCAN_RUNNING;
+
+        w.scanning = false;
+        w.scanCount = HostNode::current()->isWiFiAvailable() ? 1 : 0;
+    }
+
+    return w.scanCount;
+}
+
+void WiFiClass::scanDelete() {
+    std::lock_guard<std::mutex> lock(wifiMtx);
+    self().scanCount = WIFI_SCAN_FAILED;
+}
+
+String WiFiClass::SSID(uint8_t i) {
+    return String("HostWiFi");
+}
+
+int32_t WiFiClass::RSSI(uint8_t i) {
+    return HostNode::current()->getWiFiRssi();
+}
+
+int8_t WiFiClass::RSSI() {
+    // Of the current connection, 0 when not connected
+    return isConnected() ? HostNode::current()->getWiFiRssi() : 0;
+}
+
+int WiFiClass::hostByName(const char *host, IPAddress &ip) {
+    if(!isConnected())
+        return 0;
+
+    vTaskDelay(pdMS_TO_TICKS(HostHttp::getDnsMs()));
+    ip = IPAddress(10, 0, 0, 1);
+    return 1;
+}
+
+uint8_t *WiFiClass::macAddress(uint8_t *mac) {
+    memcpy(mac, HostNode::current()->getMac(), 6);
+    return mac;
+}
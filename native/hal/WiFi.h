@@ -0,0 +1,93 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_WIFI_H
+#define MGLIGHTFW_HOST_WIFI_H
+
+/**
+ * Host replacement of ESP32 WiFi. Link state is kept per HostNode - node connects only when
+ * HostNode::isWiFiAvailable() is set.
+ */
+
+#include "Arduino.h"
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+#define WIFI_SCAN_RUNNING   (-1)
+#define WIFI_SCAN_FAILED    (-2)
+
+class IPAddress {
+public:
+    IPAddress() = default;
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    operator uint32_t() const { return addr; }
+
+private:
+    uint32_t addr = 0;
+};
+
+class WiFiClass {
+public:
+    static bool mode(wifi_mode_t m);
+
+    int begin(const char *ssid, const char *passphrase = nullptr);
+    bool isConnected();
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool persistent(bool persistent);
+
+    int16_t scanNetworks(bool async = false, bool showHidden = false, bool passive = false,
+                         uint32_t maxMsPerChannel = 300);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t i);
+    int32_t RSSI(uint8_t i);
+    int8_t RSSI();
+    // Takes HostHttp DNS time, fails without WiFi
+    int hostByName(const char *host, IPAddress &ip);
+
+    uint8_t* macAddress(uint8_t *mac);
+};
+
+extern WiFiClass WiFi;
+
+/**
+ * Connection to API host. Connecting takes HostHttp DNS and handshake time, the host closes it
+ * after HostHttp keep-alive time without requests (or when WiFi is lost).
+ */
+class WiFiClient {
+public:
+    virtual ~WiFiClient() = default;
+    virtual int connect(const char *host, uint16_t port);
+    virtual int connect(IPAddress ip, uint16_t port);
+    virtual uint8_t connected();
+    virtual void stop();
+
+private:
+    friend class HTTPClient;
+    bool open = false;
+    uint32_t lastUseMs = 0;
+};
+
+#endif //MGLIGHTFW_HOST_WIFI_H
@@ -0,0 +1,39 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_WIFICLIENTSECURE_H
+#define MGLIGHTFW_HOST_WIFICLIENTSECURE_H
+
+#include "WiFi.h"
+
+/**
+ * TLS is not emulated - HTTPClient hands requests to HostHttp handler.
+ */
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setCACertBundle(const uint8_t *bundle) {}
+    void setInsecure() {}
+    using WiFiClient::connect;
+    int connect(IPAddress ip, uint16_t port, const char *host, const char *caCert, const char *cert, const char *privateKey) {
+        return connect(ip, port);
+    }
+};
+
+#endif //MGLIGHTFW_HOST_WIFICLIENTSECURE_H
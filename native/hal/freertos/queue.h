@@ -0,0 +1,44 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_QUEUE_H
+#define MGLIGHTFW_HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+/**
+ * Copy-by-value queue with FreeRTOS semantics. Item size 0 is used for semaphores.
+ * Unlike real FreeRTOS, calls on a nullptr handle fail instead of asserting.
+ */
+struct HostQueue;
+typedef HostQueue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t q, void *buffer, TickType_t ticksToWait);
+BaseType_t xQueuePeek(QueueHandle_t q, void *buffer, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q);
+BaseType_t xQueueReset(QueueHandle_t q);
+void vQueueDelete(QueueHandle_t q);
+
+#endif //MGLIGHTFW_HOST_QUEUE_H
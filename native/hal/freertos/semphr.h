@@ -0,0 +1,45 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_HOST_SEMPHR_H
+#define MGLIGHTFW_HOST_SEMPHR_H
+
+#include "queue.h"
+
+// As in FreeRTOS, semaphores are queues of zero sized items. Mutexes have no priority inheritance.
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticksToWait) {
+    return xQueueReceive(s, nullptr, ticksToWait);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    return xQueueSend(s, nullptr, 0);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t s) {
+    vQueueDelete(s);
+}
+
+#endif //MGLIGHTFW_HOST_SEMPHR_H
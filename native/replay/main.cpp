@@ -0,0 +1,362 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+/*
+ * Light control replay - runs LightControl (the normal mode loop of main.cpp) on a virtual clock, so months of
+ * sunrises and sunsets, API refreshes and NTP resyncs pass in seconds.
+ *
+ * The clock of the device drifts (--drift-ppm) and is corrected by NTP resync every --ntp-interval minutes, like
+ * ConnectivityClient time sync does. API talks are answered after --api-latency ms with day configuration computed
+ * for the current date and place (sunrise/sunset at --lat/--lon).
+ *
+ * Reported: CPU cost of the loop per simulated hour and intensity steps bigger than --max-jump percent
+ * (after first API response - boot is not a discontinuity).
+ *
+ *   pio run -e native_replay && .pio/build/native_replay/program [--days N] [--start YYYY-MM-DD] [--step-ms MS]
+ *          [--tz TZ] [--lat DEG] [--lon DEG] [--drift-ppm PPM] [--ntp-interval MIN] [--api-latency MS]
+ *          [--max-jump PCT] [--strict] [--out FILE]
+ */
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+
+#include "TimeSource.h"
+#include "LightControl.h"
+#include "PWMLed.h"
+#include "Day.h"
+
+struct ReplayOptions {
+    uint32_t days = 365;
+    std::string start = "2026-01-01";
+    uint32_t stepMs = 1000;
+    std::string tz = "CET-1CEST,M3.5.0,M10.5.0/3";
+    double lat = 52.23;
+    double lon = 21.01;
+    double driftPpm = 40.0;
+    uint32_t ntpIntervalMin = 10;
+    uint32_t apiLatencyMs = 1500;
+    double maxJump = 5.0;
+    bool strict = false;
+    std::string out;
+};
+
+/**
+ * Virtual device clock. Monotonic milliseconds follow simulated time exactly, wall clock runs off by driftPpm
+ * and is unset (1970) until the first setNow().
+ */
+class VirtualClock : public TimeSource::Clock {
+public:
+    VirtualClock(time_t start, double driftPpm) : trueStart(start), drift(driftPpm / 1e6) {}
+
+    void advance(uint32_t ms) {
+        mono += ms;
+    }
+
+    time_t trueNow() const {
+        return trueStart + (time_t)(mono / 1000);
+    }
+
+    // Difference between device and true wall clock [ms]
+    int64_t errorMs() const {
+        return deviceMs() - ((int64_t)trueStart * 1000 + (int64_t)mono);
+    }
+
+    uint32_t millis() override {
+        return (uint32_t)mono;
+    }
+
+    time_t now() override {
+        return (time_t)(deviceMs() / 1000);
+    }
+
+    void setNow(time_t t) override {
+        offsetMs = (int64_t)t * 1000 - (int64_t)((double)mono * (1.0 + drift));
+    }
+
+private:
+    time_t trueStart;
+    double drift;
+    uint64_t mono = 0;
+    int64_t offsetMs = 0;
+
+    int64_t deviceMs() const {
+        return offsetMs + (int64_t)((double)mono * (1.0 + drift));
+    }
+};
+
+/**
+ * MG Light API stand-in - day configuration for a date: sunrise and sunset (minutes since local midnight),
+ * 30 minutes ramps, full intensity.
+ */
+class DayModel {
+public:
+    DayModel(double latitude, double longitude) : lat(latitude), lon(longitude) {}
+
+    std::string response(time_t at) const {
+        struct tm lt{};
+        localtime_r(&at, &lt);
+
+        int n = lt.tm_yday + 1;
+        double decl = 23.44 * sin(2.0 * M_PI * (284.0 + n) / 365.0) * M_PI / 180.0;
+        double cosW = -tan(lat * M_PI / 180.0) * tan(decl);
+        cosW = std::max(-1.0, std::min(1.0, cosW));
+        double halfDayMin = 4.0 * acos(cosW) * 180.0 / M_PI;
+
+        double b = 2.0 * M_PI * (n - 81) / 364.0;
+        double eot = 9.87 * sin(2.0 * b) - 7.53 * cos(b) - 1.5 * sin(b);
+        double noonMin = 720.0 - 4.0 * lon - eot + (double)lt.tm_gmtoff / 60.0;
+
+        int ds = (int)lround(noonMin - halfDayMin);
+        int de = (int)lround(noonMin + halfDayMin);
+
+        char buf[96];
+        snprintf(buf, sizeof(buf), "{\"DLI\":1000,\"DS\":%d,\"DE\":%d,\"SSD\":30,\"SRD\":30}", ds, de);
+        return buf;
+    }
+
+private:
+    double lat;
+    double lon;
+};
+
+struct Jump {
+    time_t at;
+    float from;
+    float to;
+};
+
+static std::string fmtTime(time_t t) {
+    struct tm lt{};
+    localtime_r(&t, &lt);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &lt);
+    return buf;
+}
+
+static bool parseDate(const std::string &s, time_t &out) {
+    struct tm lt{};
+    if(sscanf(s.c_str(), "%d-%d-%d", &lt.tm_year, &lt.tm_mon, &lt.tm_mday) != 3)
+        return false;
+
+    lt.tm_year -= 1900;
+    lt.tm_mon -= 1;
+    lt.tm_isdst = -1;
+    out = mktime(&lt);
+    return out != (time_t)-1;
+}
+
+int main(int argc, char **argv) {
+    ReplayOptions opt;
+
+    for(int i=1; i<argc; i++){
+        std::string a = argv[i];
+        bool hasVal = i+1 < argc;
+        if(a == "--days" and hasVal)
+            opt.days = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--start" and hasVal)
+            opt.start = argv[++i];
+        else if(a == "--step-ms" and hasVal)
+            opt.stepMs = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if(a == "--tz" and hasVal)
+            opt.tz = argv[++i];
+        else if(a == "--lat" and hasVal)
+            opt.lat = atof(argv[++i]);
+        else if(a == "--lon" and hasVal)
+            opt.lon = atof(argv[++i]);
+        else if(a == "--drift-ppm" and hasVal)
+            opt.driftPpm = atof(argv[++i]);
+        else if(a == "--ntp-interval" and hasVal)
+            opt.ntpIntervalMin = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if(a == "--api-latency" and hasVal)
+            opt.apiLatencyMs = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--max-jump" and hasVal)
+            opt.maxJump = atof(argv[++i]);
+        else if(a == "--strict")
+            opt.strict = true;
+        else if(a == "--out" and hasVal)
+            opt.out = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--days N] [--start YYYY-MM-DD] [--step-ms MS] [--tz TZ] [--lat DEG] [--lon DEG]\n"
+                            "          [--drift-ppm PPM] [--ntp-interval MIN] [--api-latency MS] [--max-jump PCT]\n"
+                            "          [--strict] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    setenv("TZ", opt.tz.c_str(), 1);
+    tzset();
+
+    time_t start;
+    if(!parseDate(opt.start, start)){
+        fprintf(stderr, "replay - bad start date %s\n", opt.start.c_str());
+        return 1;
+    }
+
+    VirtualClock clock(start, opt.driftPpm);
+    TimeSource::setClock(&clock);
+
+    DayModel model(opt.lat, opt.lon);
+    PWMLed light(0, 0, 200);
+    Day day;
+    LightControl control(&light, &day, 0);
+
+    // Same as main.cpp setup(): day configuration from NVS, light starts at 100%
+    control.applyApiResponse(model.response(start));
+    light.start();
+
+    const uint64_t totalMs = (uint64_t)opt.days * 24 * 3600 * 1000;
+    const uint64_t ntpIntervalMs = (uint64_t)opt.ntpIntervalMin * 60 * 1000;
+    const uint64_t firstNtpMs = 8000;   // ConnectivityClient - first time sync 8 s after start
+    const uint64_t stepsPerHour = 3600000ull / opt.stepMs;
+
+    uint64_t nextNtpMs = firstNtpMs;
+    uint64_t apiResponseDueMs = UINT64_MAX;
+    bool responded = false;
+    float lastIntensity = light.getIntensity();
+
+    uint32_t ntpSyncs = 0, apiTalks = 0, apiResponses = 0;
+    int64_t maxNtpCorrectionMs = 0;
+    uint64_t jumps = 0;
+    float maxStep = 0.0f;
+    time_t maxStepAt = 0;
+    std::vector<Jump> firstJumps;
+    double lightOnHours = 0.0;
+
+    // CPU cost of every simulated hour of LightControl work
+    std::vector<double> hourCostUs;
+    double hourNs = 0.0;
+    uint64_t stepInHour = 0;
+
+    auto realStart = std::chrono::steady_clock::now();
+
+    for(uint64_t t = 0; t < totalMs; t += opt.stepMs){
+        clock.advance(opt.stepMs);
+        uint64_t mono = t + opt.stepMs;
+
+        if(mono >= nextNtpMs){
+            // First sync sets clock from 1970 - that is not a correction
+            if(ntpSyncs > 0)
+                maxNtpCorrectionMs = std::max(maxNtpCorrectionMs, std::abs(clock.errorMs()));
+            TimeSource::setNow(clock.trueNow());
+            ntpSyncs++;
+            nextNtpMs = mono + ntpIntervalMs;
+        }
+
+        if(mono >= apiResponseDueMs){
+            control.applyApiResponse(model.response(clock.trueNow()));
+            apiResponses++;
+            responded = true;
+            apiResponseDueMs = UINT64_MAX;
+        }
+
+        auto c0 = std::chrono::steady_clock::now();
+        control.update();
+        bool talk = control.isApiTalkDue();
+        auto c1 = std::chrono::steady_clock::now();
+        hourNs += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(c1 - c0).count();
+
+        if(talk){
+            apiTalks++;
+            if(apiResponseDueMs == UINT64_MAX)
+                apiResponseDueMs = mono + opt.apiLatencyMs;
+        }
+
+        float intensity = light.getIntensity();
+        float step = std::fabs(intensity - lastIntensity);
+        if(responded){
+            if(step > maxStep){
+                maxStep = step;
+                maxStepAt = clock.trueNow();
+            }
+            if(step > opt.maxJump){
+                jumps++;
+                if(firstJumps.size() < 10)
+                    firstJumps.push_back({clock.trueNow(), lastIntensity, intensity});
+            }
+        }
+        lastIntensity = intensity;
+
+        if(intensity > 0.0f)
+            lightOnHours += (double)opt.stepMs / 3600000.0;
+
+        if(++stepInHour == stepsPerHour){
+            hourCostUs.push_back(hourNs / 1000.0);
+            hourNs = 0.0;
+            stepInHour = 0;
+        }
+    }
+
+    double realS = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+    TimeSource::setClock(nullptr);
+
+    std::sort(hourCostUs.begin(), hourCostUs.end());
+    double costSum = 0.0;
+    for(double c: hourCostUs)
+        costSum += c;
+    double costMean = hourCostUs.empty() ? 0.0 : costSum / (double)hourCostUs.size();
+    double costP99 = hourCostUs.empty() ? 0.0 : hourCostUs[(size_t)(0.99 * (double)(hourCostUs.size() - 1))];
+    double costMax = hourCostUs.empty() ? 0.0 : hourCostUs.back();
+
+    fprintf(stderr, "replay - %u days in %.1f s (%.0fx), %llu steps of %u ms\n", opt.days, realS,
+            (double)totalMs / 1000.0 / realS, (unsigned long long)(totalMs / opt.stepMs), opt.stepMs);
+    fprintf(stderr, "replay - loop CPU per simulated hour: mean %.1f us, p99 %.1f us, max %.1f us (%llu steps/h)\n",
+            costMean, costP99, costMax, (unsigned long long)stepsPerHour);
+    fprintf(stderr, "replay - API talks %u, responses %u, NTP syncs %u, max NTP correction %lld ms\n",
+            apiTalks, apiResponses, ntpSyncs, (long long)maxNtpCorrectionMs);
+    fprintf(stderr, "replay - max intensity step %.2f%% at %s, steps over %.2f%%: %llu\n", maxStep,
+            fmtTime(maxStepAt).c_str(), opt.maxJump, (unsigned long long)jumps);
+    for(auto &j: firstJumps)
+        fprintf(stderr, "replay -   %s  %.2f%% -> %.2f%%\n", fmtTime(j.at).c_str(), j.from, j.to);
+
+    std::ostringstream o;
+    o << "{\"suite\": \"light_replay\", \"days\": " << opt.days << ", \"start\": \"" << opt.start << "\""
+      << ", \"step_ms\": " << opt.stepMs << ", \"real_s\": " << realS
+      << ", \"cpu_us_per_sim_hour\": {\"mean\": " << costMean << ", \"p99\": " << costP99 << ", \"max\": " << costMax
+      << ", \"steps\": " << stepsPerHour << "}"
+      << ", \"api\": {\"talks\": " << apiTalks << ", \"responses\": " << apiResponses << "}"
+      << ", \"ntp\": {\"syncs\": " << ntpSyncs << ", \"max_correction_ms\": " << maxNtpCorrectionMs << "}"
+      << ", \"light_on_hours\": " << lightOnHours
+      << ", \"intensity\": {\"max_step_pct\": " << maxStep << ", \"max_step_at\": \"" << fmtTime(maxStepAt) << "\""
+      << ", \"max_jump_pct\": " << opt.maxJump << ", \"jumps\": " << jumps << ", \"first_jumps\": [";
+    for(size_t i=0; i<firstJumps.size(); i++){
+        o << (i ? ", " : "") << "{\"at\": \"" << fmtTime(firstJumps[i].at) << "\", \"from\": " << firstJumps[i].from
+          << ", \"to\": " << firstJumps[i].to << "}";
+    }
+    o << "]}}\n";
+
+    if(opt.out.empty()){
+        fputs(o.str().c_str(), stdout);
+    } else {
+        FILE *f = fopen(opt.out.c_str(), "w");
+        if(f == nullptr){
+            fprintf(stderr, "replay - cannot open %s\n", opt.out.c_str());
+            return 1;
+        }
+        fputs(o.str().c_str(), f);
+        fclose(f);
+    }
+
+    return (opt.strict and jumps > 0) ? 1 : 0;
+}
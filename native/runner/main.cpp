@@ -0,0 +1,137 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+/*
+ * Host runner - boots one server and a number of client light devices in a single process.
+ * Every device runs unmodified firmware from src/ on top of native/hal shims and talks to the others
+ * over the simulated BLE radio.
+ *
+ *   pio run -e native && .pio/build/native/program [--clients N] [--duration S] [--scale X] [--quiet]
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <memory>
+#include <vector>
+#include <atomic>
+
+#include "HostNode.h"
+#include "HostClock.h"
+#include "HostProvisioning.h"
+#include "config.h"
+#include "ConfigManager.h"
+#include "connectivity/Connectivity.h"
+
+#define RUNNER_API_TALK_INTERVAL_MS     (60*1000)
+
+struct HostDevice {
+    explicit HostDevice(const std::string &name) : node(name) {}
+
+    HostNode node;
+    Preferences prefs;
+    DeviceConfig config;
+    Connectivity connectivity;
+    std::atomic<uint32_t> apiResponses{0};
+};
+
+static void startDevice(HostDevice *dev) {
+    HostNode::setCurrent(&dev->node);
+
+    Serial.println("Device: Normal mode");
+    dev->prefs.begin("mgld", false);
+    ConfigManager::readDeviceConfig(&dev->prefs, &dev->config);
+
+    dev->connectivity.start(DEVICE_MODE_NORMAL, &dev->config, &dev->prefs,
+                            [dev](int id, int errc, int httpCode, const std::string &msg){
+        dev->apiResponses++;
+        Serial.printf("runner - API response id: %d, errc: %d, http: %d, msg: %s\r\n", id, errc, httpCode, msg.c_str());
+    });
+
+    xTaskCreatePinnedToCore([](void *arg){
+        auto *d = static_cast<HostDevice*>(arg);
+        uint32_t lastTalk = millis();
+
+        while(true){
+            d->connectivity.loop();
+
+            if(millis() - lastTalk >= RUNNER_API_TALK_INTERVAL_MS){
+                uint8_t mac[6];
+                memcpy(mac, d->node.getMac(), 6);
+                d->connectivity.startAPITalk("light/get.php", 'P', mac, d->config.getPicklock(), "fv=0&t=0");
+                lastTalk = millis();
+            }
+        }
+    }, "conlp", 3000, dev, 5, nullptr, 1);
+}
+
+int main(int argc, char **argv) {
+    int clients = 2;
+    uint32_t durationS = 120;
+    double scale = 1.0;
+    bool quiet = false;
+
+    for(int i=1; i<argc; i++){
+        std::string a = argv[i];
+        if(a == "--clients" and i+1 < argc)
+            clients = atoi(argv[++i]);
+        else if(a == "--duration" and i+1 < argc)
+            durationS = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--scale" and i+1 < argc)
+            scale = atof(argv[++i]);
+        else if(a == "--quiet")
+            quiet = true;
+        else {
+            printf("Usage: %s [--clients N] [--duration S] [--scale X] [--quiet]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    HostClock::setTimeScale(scale);
+
+    HostProvisioning::ManufacturerKey manuKey{};
+    if(!HostProvisioning::makeManufacturerKey(manuKey)){
+        printf("runner - manufacturer key generation failed\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<HostDevice>> devices;
+    for(int i=0; i<=clients; i++){
+        auto *d = new HostDevice(i == 0 ? "srv" : "cli" + std::to_string(i));
+        d->node.setWiFiAvailable(i == 0);
+        d->node.setLogEnabled(!quiet);
+        HostProvisioning::provisionCert(&d->node, manuKey);
+        HostProvisioning::provisionConfig(&d->node, i == 0 ? DEVICE_CONFIG_ROLE_SERVER : DEVICE_CONFIG_ROLE_CLIENT);
+        devices.emplace_back(d);
+    }
+
+    for(auto &d: devices)
+        startDevice(d.get());
+
+    HostNode::setCurrent(nullptr);
+    HostClock::sleepMs(durationS * 1000);
+
+    printf("runner - finished after %u s\n", durationS);
+    for(auto &d: devices)
+        printf("runner - %s: API responses: %u\n", d->node.getName().c_str(), d->apiResponses.load());
+
+    fflush(stdout);
+    // Firmware tasks never end - leave without running destructors under them
+    std::_Exit(0);
+}
@@ -0,0 +1,560 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+/*
+ * BLELN mesh simulator - runs N light devices in one process over the simulated radio (native/hal/HostRadio).
+ * Every device runs unmodified Connectivity, ConnectivityClient and ConnectivityServer state machines from src/.
+ * Each node count of the sweep runs in its own child process, because firmware keeps global state.
+ *
+ * Reported per node count:
+ *  - server election - time until exactly one node is a server and all others found it as clients,
+ *    and clients connected to every server at the end (fixed roles - first --servers N nodes start as servers),
+ *  - round trip of BLELN requests (client time sync: search unless the server is known, connect and handshake unless
+ *    the client is still attached to its server, $NTP request and response),
+ *  - BLELN handshake time on clients, from connection to authorised, full and resumed with ticket,
+ *  - server connect time on clients, request start to handshake end - direct to known server and after scan,
+ *  - round trip of API talks (request to response callback, on servers and clients),
+ *  - HTTP requests made by servers (single and batched API talks), connections they took and request time split
+ *    into DNS, handshake (TCP + TLS) and transfer,
+ *  - radio airtime of connections and advertising,
+ *  - ephemeral key pool and certificate cache hits and misses (both are process wide, so shared by all nodes of a run).
+ *
+ *   pio run -e native_sim && .pio/build/native_sim/program [--nodes 2,5,10,20,35,50] [--duration S] [--scale X]
+ *          [--latency MS] [--jitter MS] [--loss P] [--max-conn N] [--data-len B] [--conn-interval MS]
+ *          [--roles auto|fixed] [--servers N] [--api-interval S] [--api-spread MS] [--no-batch-api]
+ *          [--api-keepalive MS] [--seed S] [--out FILE] [--verbose]
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <memory>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <sstream>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "HostNode.h"
+#include "HostClock.h"
+#include "HostRadio.h"
+#include "HostProvisioning.h"
+#include "HTTPClient.h"
+#include "config.h"
+#include "ConfigManager.h"
+#include "connectivity/Connectivity.h"
+#include "bleln/BLELNKeyPool.h"
+#include "bleln/BLELNCertCache.h"
+
+struct SimOptions {
+    std::vector<int> nodeCounts{2, 5, 10, 20, 35, 50};
+    uint32_t durationS = 300;
+    double scale = 10.0;
+    HostRadio::LinkModel link;
+    bool autoRoles = true;
+    int servers = 1;                // Fixed roles - first nodes are servers
+    uint32_t apiIntervalS = 60;
+    uint32_t apiSpreadMs = 0;       // First API talks of devices within this time, 0 - whole interval
+    bool batchApi = true;           // API answers batch endpoint, 404 otherwise
+    uint32_t apiKeepAliveMs = 0;    // API host keep-alive timeout, 0 - HostHttp default
+    uint32_t seed = 1;
+    std::string out;
+    bool verbose = false;
+};
+
+class SimRun;
+
+struct SimDevice {
+    explicit SimDevice(const std::string &name) : node(name) {}
+
+    SimRun *sim = nullptr;
+    HostNode node;
+    Preferences prefs;
+    DeviceConfig config;
+    Connectivity connectivity;
+    uint32_t apiIntervalMs = 0;
+    uint32_t apiSpreadMs = 0;
+
+    // Metrics - guarded by SimRun::mtx
+    enum class Mode {Unknown, Client, Server} mode = Mode::Unknown;
+    bool settled = false;       // Server, or client which found a server
+    bool syncPending = false;
+    uint32_t syncStartMs = 0;
+    bool apiPending = false;
+    uint32_t apiStartMs = 0;
+    bool authResumed = false;
+};
+
+/**
+ * One simulation run. Metrics are taken from firmware console lines, so firmware needs no hooks.
+ */
+class SimRun {
+public:
+    explicit SimRun(const SimOptions &options) : opt(options) {}
+
+    std::string run(int nodes);
+    void onApiRequest(SimDevice *d);
+
+private:
+    const SimOptions &opt;
+    std::vector<std::unique_ptr<SimDevice>> devices;
+    std::map<HostNode*, SimDevice*> byNode;
+
+    std::mutex mtx;
+    uint32_t startMs = 0;
+    int64_t convergedAtMs = -1;
+    uint32_t modeChanges = 0;
+    uint32_t syncStarted = 0, syncFailed = 0, apiRequested = 0;
+    std::vector<uint32_t> syncRtts, apiRtts, handshakeFull, handshakeResumed;
+    std::vector<uint32_t> connectKnown, connectScanned;
+    uint32_t httpsReused = 0;
+    std::vector<uint32_t> httpsDns, httpsHandshake, httpsTransfer;   // New connections only for dns and handshake
+
+    uint32_t now();
+    void onLine(SimDevice *d, const std::string &line);
+    void onApiResponse(SimDevice *d, int errc, int httpCode);
+    void updateConvergence();
+    void startDevice(SimDevice *d);
+    static std::string percentiles(std::vector<uint32_t> v);
+};
+
+uint32_t SimRun::now() {
+    return HostClock::millis() - startMs;
+}
+
+void SimRun::onLine(SimDevice *d, const std::string &line) {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if(line.rfind("Client mode - Init", 0) == 0){
+        if(d->mode != SimDevice::Mode::Unknown)
+            modeChanges++;
+        d->mode = SimDevice::Mode::Client;
+        d->settled = false;
+        d->syncPending = false;
+    } else if(line.rfind("Server mode - Init", 0) == 0){
+        if(d->mode != SimDevice::Mode::Unknown)
+            modeChanges++;
+        d->mode = SimDevice::Mode::Server;
+        d->settled = true;
+        d->syncPending = false;
+    } else if(line.rfind("Client mode - BLELN server found. Continuing as client", 0) == 0){
+        d->settled = true;
+    } else if(line.rfind("Client mode - Start time sync", 0) == 0){
+        syncStarted++;
+        d->syncPending = true;
+        d->syncStartMs = now();
+    } else if(line.rfind("Client mode: Time synced", 0) == 0){
+        d->settled = true;
+        if(d->syncPending)
+            syncRtts.push_back(now() - d->syncStartMs);
+        d->syncPending = false;
+    } else if(line.rfind("[D] BLELNClient - auth success", 0) == 0){
+        d->authResumed = line.find("(resumed)") != std::string::npos;
+        return;
+    } else if(line.rfind("[D] BLELNClient - client ", 0) == 0 and line.find(" live for ") != std::string::npos){
+        uint32_t ms = strtoul(line.c_str() + line.find(" live for ") + 10, nullptr, 10);
+        (d->authResumed ? handshakeResumed : handshakeFull).push_back(ms);
+        return;
+    } else if(line.rfind("Client mode - Server connected in ", 0) == 0){
+        uint32_t ms = strtoul(line.c_str() + 34, nullptr, 10);
+        (line.find(" (known)") != std::string::npos ? connectKnown : connectScanned).push_back(ms);
+        return;
+    } else if(line.rfind("Server mode - API HTTPS request (", 0) == 0){
+        unsigned long dns = 0, handshake = 0, transfer = 0;
+        sscanf(line.c_str() + line.find("): ") + 3, "dns %lu ms, handshake %lu ms, transfer %lu ms", &dns, &handshake, &transfer);
+        if(line.find("(reused)") != std::string::npos){
+            httpsReused++;
+        } else {
+            httpsDns.push_back(dns);
+            httpsHandshake.push_back(handshake);
+        }
+        httpsTransfer.push_back(transfer);
+        return;
+    } else if(line.rfind("Client mode - BLELN server not found. API talk failed.", 0) == 0
+              or line.rfind("Failed connecting", 0) == 0){
+        if(d->syncPending)
+            syncFailed++;
+        d->syncPending = false;
+    } else {
+        return;
+    }
+
+    updateConvergence();
+}
+
+void SimRun::onApiRequest(SimDevice *d) {
+    std::lock_guard<std::mutex> lock(mtx);
+    apiRequested++;
+    // Request not answered before the next one is not counted
+    d->apiPending = true;
+    d->apiStartMs = now();
+}
+
+void SimRun::onApiResponse(SimDevice *d, int errc, int httpCode) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if(d->apiPending and errc == 0 and httpCode == 200)
+        apiRtts.push_back(now() - d->apiStartMs);
+    d->apiPending = false;
+}
+
+// Caller holds mtx
+void SimRun::updateConvergence() {
+    int servers = 0;
+    bool allSettled = true;
+    for(auto &d: devices){
+        if(d->mode == SimDevice::Mode::Server)
+            servers++;
+        allSettled = allSettled and d->settled;
+    }
+
+    if(servers == 1 and allSettled){
+        if(convergedAtMs < 0)
+            convergedAtMs = now();
+    } else {
+        convergedAtMs = -1;
+    }
+}
+
+void SimRun::startDevice(SimDevice *d) {
+    HostNode::setCurrent(&d->node);
+
+    d->prefs.begin("mgld", false);
+    ConfigManager::readDeviceConfig(&d->prefs, &d->config);
+
+    d->connectivity.start(DEVICE_MODE_NORMAL, &d->config, &d->prefs,
+                          [this, d](int id, int errc, int httpCode, const std::string &msg){
+        onApiResponse(d, errc, httpCode);
+    });
+
+    xTaskCreatePinnedToCore([](void *arg){
+        auto *dev = static_cast<SimDevice*>(arg);
+        // Devices are not powered on in the same millisecond
+        uint32_t lastTalk = millis() - dev->apiIntervalMs + esp_random() % dev->apiSpreadMs;
+
+        while(true){
+            dev->connectivity.loop();
+
+            if(millis() - lastTalk >= dev->apiIntervalMs){
+                uint8_t mac[6];
+                memcpy(mac, dev->node.getMac(), 6);
+                dev->sim->onApiRequest(dev);
+                dev->connectivity.startAPITalk("light/get.php", 'P', mac, dev->config.getPicklock(), "fv=0&t=0");
+                lastTalk = millis();
+            }
+        }
+    }, "conlp", 3000, d, 5, nullptr, 1);
+}
+
+std::string SimRun::percentiles(std::vector<uint32_t> v) {
+    std::ostringstream o;
+    if(v.empty()){
+        o << "null";
+        return o.str();
+    }
+
+    std::sort(v.begin(), v.end());
+    auto at = [&v](double p){
+        size_t i = (size_t)(p * (double)(v.size() - 1) + 0.5);
+        return v[i];
+    };
+    o << "{\"p50\": " << at(0.5) << ", \"p90\": " << at(0.9) << ", \"p99\": " << at(0.99)
+      << ", \"max\": " << v.back() << ", \"samples\": " << v.size() << "}";
+    return o.str();
+}
+
+std::string SimRun::run(int nodes) {
+    HostClock::setTimeScale(opt.scale);
+    HostRadio::get().setLinkModel(opt.link);
+    HostRadio::get().setSeed(opt.seed);
+
+    if(opt.apiKeepAliveMs > 0)
+        HostHttp::setConnectTimes(HostHttp::getDnsMs(), HostHttp::getHandshakeMs(), opt.apiKeepAliveMs);
+
+    if(!opt.batchApi){
+        HostHttp::setHandler([](const HostHttpRequest &req, std::string &response){
+            if(req.url.find("batch.php") != std::string::npos)
+                return (int)HTTP_CODE_NOT_FOUND;
+            return HostHttp::apiHandler(req, response);
+        });
+    }
+
+    HostProvisioning::ManufacturerKey manuKey{};
+    if(!HostProvisioning::makeManufacturerKey(manuKey))
+        return "";
+
+    for(int i=0; i<nodes; i++){
+        auto *d = new SimDevice("n" + std::to_string(i));
+        char role = DEVICE_CONFIG_ROLE_AUTO;
+        if(!opt.autoRoles)
+            role = (i < opt.servers) ? DEVICE_CONFIG_ROLE_SERVER : DEVICE_CONFIG_ROLE_CLIENT;
+
+        d->node.setWiFiAvailable(opt.autoRoles or i < opt.servers);
+        d->node.setLogEnabled(opt.verbose);
+        d->apiIntervalMs = opt.apiIntervalS * 1000;
+        d->apiSpreadMs = (opt.apiSpreadMs == 0 or opt.apiSpreadMs > d->apiIntervalMs) ? d->apiIntervalMs : opt.apiSpreadMs;
+        d->sim = this;
+        HostProvisioning::provisionCert(&d->node, manuKey);
+        HostProvisioning::provisionConfig(&d->node, role);
+        byNode[&d->node] = d;
+        devices.emplace_back(d);
+    }
+
+    HostNode::setLogObserver([this](HostNode *node, const std::string &line){
+        auto it = byNode.find(node);
+        if(it != byNode.end())
+            onLine(it->second, line);
+    });
+
+    startMs = HostClock::millis();
+    for(auto &d: devices)
+        startDevice(d.get());
+    HostNode::setCurrent(nullptr);
+
+    HostClock::sleepMs(opt.durationS * 1000);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    int servers = 0;
+    std::string clientsPerServer;
+    for(auto &d: devices){
+        if(d->mode == SimDevice::Mode::Server){
+            clientsPerServer += (servers ? ", " : "") + std::to_string(d->node.ble().connectionsCount());
+            servers++;
+        }
+    }
+
+    uint64_t airSum = 0, airMax = 0, pdus = 0, lostPdus = 0, advEvents = 0, connEvents = 0;
+    for(auto &d: devices){
+        HostRadio::AirStats s = HostRadio::get().getStats(&d->node);
+        airSum += s.airtimeUs;
+        airMax = std::max(airMax, s.airtimeUs);
+        pdus += s.txPdus;
+        lostPdus += s.lostPdus;
+        advEvents += s.advEvents;
+        connEvents += s.connEvents;
+    }
+
+    // Requests still waiting at the end are counted neither as answered nor failed
+    uint32_t apiAnswered = apiRtts.size();
+    std::ostringstream o;
+    o << "{\"nodes\": " << nodes << ", \"duration_s\": " << opt.durationS
+      << ", \"election\": {\"converged\": " << (convergedAtMs >= 0 ? "true" : "false")
+      << ", \"convergence_ms\": " << (convergedAtMs >= 0 ? std::to_string(convergedAtMs) : "null")
+      << ", \"servers\": " << servers << ", \"clients_per_server\": [" << clientsPerServer << "]"
+      << ", \"mode_changes\": " << modeChanges << "}"
+      << ", \"time_sync\": {\"started\": " << syncStarted << ", \"ok\": " << syncRtts.size()
+      << ", \"failed\": " << syncFailed << ", \"rtt_ms\": " << percentiles(syncRtts) << "}"
+      << ", \"handshake_ms\": {\"full\": " << percentiles(handshakeFull) << ", \"resumed\": " << percentiles(handshakeResumed) << "}"
+      << ", \"server_connect_ms\": {\"known\": " << percentiles(connectKnown) << ", \"scanned\": " << percentiles(connectScanned) << "}"
+      << ", \"api_talk\": {\"requested\": " << apiRequested << ", \"answered\": " << apiAnswered << ", \"rtt_ms\": " << percentiles(apiRtts) << "}"
+      << ", \"http\": {\"requests\": " << HostHttp::getRequestCount() << ", \"connections\": " << HostHttp::getConnectionCount()
+      << ", \"reused\": " << httpsReused << ", \"dns_ms\": " << percentiles(httpsDns)
+      << ", \"handshake_ms\": " << percentiles(httpsHandshake) << ", \"transfer_ms\": " << percentiles(httpsTransfer) << "}"
+      << ", \"airtime\": {\"total_ms\": " << airSum / 1000.0
+      << ", \"per_node_mean_ms\": " << (double)airSum / 1000.0 / nodes
+      << ", \"per_node_max_ms\": " << airMax / 1000.0
+      << ", \"max_duty_pct\": " << (double)airMax / 10.0 / opt.durationS / 1000.0
+      << ", \"pdus\": " << pdus << ", \"lost_pdus\": " << lostPdus << ", \"adv_events\": " << advEvents
+      << ", \"conn_events\": " << connEvents << "}"
+      << ", \"key_pool\": {\"hits\": " << BLELNKeyPool::getHits() << ", \"misses\": " << BLELNKeyPool::getMisses() << "}"
+      << ", \"cert_cache\": {\"hits\": " << BLELNCertCache::getHits() << ", \"misses\": " << BLELNCertCache::getMisses() << "}}";
+    return o.str();
+}
+
+// Runs one node count in child process and returns its JSON result, empty on failure
+static std::string runIsolated(const SimOptions &opt, int nodes) {
+    int fds[2];
+    if(pipe(fds) != 0)
+        return "";
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if(pid < 0)
+        return "";
+
+    if(pid == 0){
+        close(fds[0]);
+        SimRun r(opt);
+        std::string res = r.run(nodes);
+        size_t off = 0;
+        while(off < res.size()){
+            ssize_t w = write(fds[1], res.data() + off, res.size() - off);
+            if(w <= 0)
+                break;
+            off += w;
+        }
+        fflush(stdout);
+        // Firmware tasks never end - leave without running destructors under them
+        std::_Exit(res.empty() ? 1 : 0);
+    }
+
+    close(fds[1]);
+    std::string res;
+    char buf[512];
+    ssize_t n;
+    while((n = read(fds[0], buf, sizeof(buf))) > 0)
+        res.append(buf, n);
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(!WIFEXITED(status) or WEXITSTATUS(status) != 0)
+        return "";
+
+    return res;
+}
+
+static std::vector<int> parseList(const std::string &s) {
+    std::vector<int> v;
+    std::stringstream ss(s);
+    std::string item;
+    while(std::getline(ss, item, ',')){
+        int n = atoi(item.c_str());
+        if(n >= 2)
+            v.push_back(n);
+    }
+    return v;
+}
+
+// Pulls a number out of flat result JSON for summary table
+static std::string field(const std::string &json, const std::string &path) {
+    size_t pos = 0;
+    std::stringstream ss(path);
+    std::string key;
+    while(std::getline(ss, key, '.')){
+        pos = json.find("\"" + key + "\": ", pos);
+        if(pos == std::string::npos)
+            return "-";
+        pos += key.size() + 4;
+        if(json.compare(pos, 4, "null") == 0)
+            return "-";
+    }
+
+    size_t end = json.find_first_of(",}", pos);
+    return json.substr(pos, end - pos);
+}
+
+int main(int argc, char **argv) {
+    SimOptions opt;
+    opt.link.latencyMs = 15;
+    opt.link.jitterMs = 15;
+    opt.link.lossRate = 0.01f;
+    opt.link.retransmitMs = 30;
+    opt.link.connIntervalMs = 30;
+
+    for(int i=1; i<argc; i++){
+        std::string a = argv[i];
+        bool hasVal = i+1 < argc;
+        if(a == "--nodes" and hasVal)
+            opt.nodeCounts = parseList(argv[++i]);
+        else if(a == "--duration" and hasVal)
+            opt.durationS = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--scale" and hasVal)
+            opt.scale = atof(argv[++i]);
+        else if(a == "--latency" and hasVal)
+            opt.link.latencyMs = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--jitter" and hasVal)
+            opt.link.jitterMs = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--loss" and hasVal)
+            opt.link.lossRate = (float)atof(argv[++i]);
+        else if(a == "--max-conn" and hasVal)
+            opt.link.maxConnections = (uint8_t)atoi(argv[++i]);
+        else if(a == "--data-len" and hasVal)
+            opt.link.dataLen = (uint16_t)atoi(argv[++i]);
+        else if(a == "--conn-interval" and hasVal)
+            opt.link.connIntervalMs = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--roles" and hasVal)
+            opt.autoRoles = std::string(argv[++i]) != "fixed";
+        else if(a == "--servers" and hasVal)
+            opt.servers = std::max(1l, strtol(argv[++i], nullptr, 10));
+        else if(a == "--api-interval" and hasVal)
+            opt.apiIntervalS = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if(a == "--api-spread" and hasVal)
+            opt.apiSpreadMs = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--no-batch-api")
+            opt.batchApi = false;
+        else if(a == "--api-keepalive" and hasVal)
+            opt.apiKeepAliveMs = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--seed" and hasVal)
+            opt.seed = strtoul(argv[++i], nullptr, 10);
+        else if(a == "--out" and hasVal)
+            opt.out = argv[++i];
+        else if(a == "--verbose")
+            opt.verbose = true;
+        else {
+            printf("Usage: %s [--nodes 2,5,10] [--duration S] [--scale X] [--latency MS] [--jitter MS] [--loss P]\n"
+                   "          [--max-conn N] [--data-len B] [--conn-interval MS] [--roles auto|fixed] [--servers N]\n"
+                   "          [--api-interval S] [--api-spread MS] [--no-batch-api] [--api-keepalive MS]\n"
+                   "          [--seed S] [--out FILE] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(opt.nodeCounts.empty()){
+        printf("sim - no node counts given\n");
+        return 1;
+    }
+
+    std::ostringstream json;
+    json << "{\"suite\": \"bleln_sim\", \"roles\": \"" << (opt.autoRoles ? "auto" : "fixed") << "\""
+         << ", \"start_servers\": " << (opt.autoRoles ? 0 : opt.servers)
+         << ", \"link\": {\"latency_ms\": " << opt.link.latencyMs << ", \"jitter_ms\": " << opt.link.jitterMs
+         << ", \"loss\": " << opt.link.lossRate << ", \"max_conn\": " << (int)opt.link.maxConnections
+         << ", \"data_len\": " << opt.link.dataLen << ", \"conn_interval_ms\": " << opt.link.connIntervalMs
+         << "}, \"runs\": [";
+
+    fprintf(stderr, "%6s %10s %8s %12s %12s %14s %14s\n", "nodes", "conv[ms]", "servers",
+            "sync p50", "sync p90", "api p50", "air max[ms]");
+
+    bool first = true;
+    int failed = 0;
+    for(int n: opt.nodeCounts){
+        std::string r = runIsolated(opt, n);
+        if(r.empty()){
+            fprintf(stderr, "%6d  run failed\n", n);
+            failed++;
+            continue;
+        }
+
+        fprintf(stderr, "%6d %10s %8s %12s %12s %14s %14s\n", n,
+                field(r, "election.convergence_ms").c_str(), field(r, "election.servers").c_str(),
+                field(r, "time_sync.rtt_ms.p50").c_str(), field(r, "time_sync.rtt_ms.p90").c_str(),
+                field(r, "api_talk.rtt_ms.p50").c_str(), field(r, "airtime.per_node_max_ms").c_str());
+
+        json << (first ? "" : ", ") << r;
+        first = false;
+    }
+    json << "]}\n";
+
+    if(opt.out.empty()){
+        fputs(json.str().c_str(), stdout);
+    } else {
+        FILE *f = fopen(opt.out.c_str(), "w");
+        if(f == nullptr){
+            fprintf(stderr, "sim - cannot open %s\n", opt.out.c_str());
+            return 1;
+        }
+        fputs(json.str().c_str(), f);
+        fclose(f);
+    }
+
+    return failed == 0 ? 0 : 1;
+}
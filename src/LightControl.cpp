@@ -0,0 +1,109 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "LightControl.h"
+#include "TimeSource.h"
+
+LightControl::LightControl(PWMLed *pwmLed, Day *lightDay, uint8_t fanPin) {
+    light= pwmLed;
+    day= lightDay;
+    pinFan= fanPin;
+}
+
+void LightControl::update() {
+    // Set pwm infill
+    float intensity= day->getSunIntensity(TimeSource::dayTime(), light->getIntensity());
+    light->setIntensity(intensity);
+    if(intensity>LIGHT_CONTROL_FAN_ON_INTENSITY) {
+        digitalWrite(pinFan, HIGH);
+    } else {
+        digitalWrite(pinFan, LOW);
+    }
+}
+
+bool LightControl::isApiTalkDue() {
+    auto nowsse= static_cast<uint32_t>(TimeSource::now());    // [seconds] since epoch
+
+    if(lastServerTalk+LIGHT_CONTROL_API_TALK_INTERVAL < nowsse){
+        lastServerTalk= nowsse;
+        return true;
+    }
+
+    return false;
+}
+
+bool LightControl::applyApiResponse(const std::string &msg) {
+    int val;
+    bool any= false;
+
+    //Read DLI value
+    val = getUIntValue(msg, "\"DLI\":");
+    if (val >= 0) {
+        day->setDli(val);
+        any= true;
+    }
+
+    //Read DS value
+    val = getUIntValue(msg, "\"DS\":");
+    if (val >= 0) {
+        day->setDs(val);
+        any= true;
+    }
+
+    //Read DE value
+    val = getUIntValue(msg, "\"DE\":");
+    if (val >= 0) {
+        day->setDe(val);
+        any= true;
+    }
+
+    //Read SSD value
+    val = getUIntValue(msg, "\"SSD\":");
+    if (val >= 0) {
+        day->setSsd(val);
+        any= true;
+    }
+
+    //Read SRD value
+    val = getUIntValue(msg, "\"SRD\":");
+    if (val >= 0) {
+        day->setSrd(val);
+        any= true;
+    }
+
+    return any;
+}
+
+int LightControl::getUIntValue(const std::string &text, const std::string &key){
+    size_t kpos= text.find(key);
+    unsigned int klen= key.length();
+
+    if(kpos != std::string::npos){
+        try {
+            return std::stoi(text.substr(kpos + klen));
+        } catch (std::invalid_argument &e){
+            return -2;
+        } catch (std::out_of_range &e) {
+            return -3;
+        }
+    } else {
+        return -1;
+    }
+}
@@ -0,0 +1,54 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_LIGHTCONTROL_H
+#define MGLIGHTFW_LIGHTCONTROL_H
+
+#include <Arduino.h>
+#include <string>
+#include "PWMLed.h"
+#include "Day.h"
+
+#define LIGHT_CONTROL_API_TALK_INTERVAL     60      // [s]
+#define LIGHT_CONTROL_FAN_ON_INTENSITY      30.0    // [%]
+
+/**
+ * Light control loop of normal mode - sets light intensity for current time of day, drives the fan and decides
+ * when to ask MG Light API for new day configuration. Time comes from TimeSource only.
+ */
+class LightControl {
+public:
+    LightControl(PWMLed *pwmLed, Day *lightDay, uint8_t fanPin);
+
+    void update(); // NEVER BLOCKS
+    bool isApiTalkDue();
+    bool applyApiResponse(const std::string &msg);
+
+private:
+    PWMLed *light;
+    Day *day;
+    uint8_t pinFan;
+    uint32_t lastServerTalk= 0;
+
+    static int getUIntValue(const std::string &text, const std::string &key);
+};
+
+
+#endif //MGLIGHTFW_LIGHTCONTROL_H
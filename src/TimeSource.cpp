@@ -0,0 +1,75 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "TimeSource.h"
+#include <sys/time.h>
+
+class DeviceClock : public TimeSource::Clock {
+public:
+    uint32_t millis() override {
+        return ::millis();
+    }
+
+    time_t now() override {
+        return time(nullptr);
+    }
+
+    void setNow(time_t t) override {
+        struct timeval tv{};
+        tv.tv_sec = t;
+        tv.tv_usec = 0;
+        settimeofday(&tv, nullptr);
+    }
+};
+
+static DeviceClock deviceClock;
+TimeSource::Clock *TimeSource::clock= &deviceClock;
+
+void TimeSource::setClock(TimeSource::Clock *c) {
+    clock= (c != nullptr) ? c : &deviceClock;
+}
+
+uint32_t TimeSource::millis() {
+    return clock->millis();
+}
+
+time_t TimeSource::now() {
+    return clock->now();
+}
+
+void TimeSource::setNow(time_t t) {
+    clock->setNow(t);
+}
+
+bool TimeSource::localTime(struct tm *info) {
+    // Same validity check as getLocalTime(), but without waiting for time to be set
+    time_t t= clock->now();
+    localtime_r(&t, info);
+    return info->tm_year > (2016 - 1900);
+}
+
+int TimeSource::dayTime() {
+    struct tm timeinfo{};
+    if(!localTime(&timeinfo)){
+        return 0;
+    }
+
+    return timeinfo.tm_hour*3600 + timeinfo.tm_min*60 + timeinfo.tm_sec;
+}
@@ -0,0 +1,55 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_TIMESOURCE_H
+#define MGLIGHTFW_TIMESOURCE_H
+
+#include <Arduino.h>
+#include <ctime>
+
+/**
+ * Single source of time for firmware logic: monotonic milliseconds, wall clock (seconds since epoch) and local time.
+ * By default it reads device clocks. Host harnesses install their own clock (e.g. virtual, accelerated one) with
+ * setClock() before any task is started.
+ */
+class TimeSource {
+public:
+    class Clock {
+    public:
+        virtual ~Clock() = default;
+        virtual uint32_t millis() = 0;
+        virtual time_t now() = 0;
+        virtual void setNow(time_t t) = 0;
+    };
+
+    static void setClock(Clock *c);     // nullptr - device clock
+
+    static uint32_t millis();
+    static time_t now();
+    static void setNow(time_t t);
+    static bool localTime(struct tm *info);     // false while wall clock is not set. Never blocks
+    static int dayTime();                       // [s] since local midnight, 0 while wall clock is not set
+
+private:
+    static Clock *clock;
+};
+
+
+#endif //MGLIGHTFW_TIMESOURCE_H
@@ -0,0 +1,128 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNActionPool.h"
+
+
+BLELNActionPool::~BLELNActionPool() {
+    end();
+}
+
+bool BLELNActionPool::begin(uint8_t slabCount) {
+    end();
+
+    slabs= (uint8_t*)malloc((size_t)slabCount * BLELN_ACTION_SLAB_LEN);
+    freeSlabs= xQueueCreate(slabCount, sizeof(uint8_t));
+    if(slabs == nullptr or freeSlabs == nullptr){
+        end();
+        return false;
+    }
+
+    for(uint8_t i=0; i<slabCount; i++){
+        xQueueSend(freeSlabs, &i, 0);
+    }
+
+    slabCnt= slabCount;
+    highWater= 0;
+    exhausted= 0;
+    oversized= 0;
+    return true;
+}
+
+void BLELNActionPool::end() {
+    if(freeSlabs != nullptr){
+        vQueueDelete(freeSlabs);
+        freeSlabs= nullptr;
+    }
+
+    free(slabs);
+    slabs= nullptr;
+    slabCnt= 0;
+}
+
+bool BLELNActionPool::put(BLELNWorkerAction &action, const uint8_t *data, size_t len) {
+    action.dlen= len;
+    if(len <= BLELN_ACTION_INLINE_LEN){
+        action.d= nullptr;
+        if(len > 0) memcpy(action.inl, data, len);
+        return true;
+    }
+
+    action.d= take(data, len);
+    return action.d != nullptr;
+}
+
+uint8_t *BLELNActionPool::take(const uint8_t *data, size_t len) {
+    uint8_t *buf= nullptr;
+    uint8_t idx;
+
+    if(len > BLELN_ACTION_SLAB_LEN){
+        oversized++;
+    } else if(freeSlabs != nullptr and xQueueReceive(freeSlabs, &idx, 0) == pdTRUE){
+        buf= slabs + (size_t)idx * BLELN_ACTION_SLAB_LEN;
+
+        uint8_t used= slabCnt - uxQueueMessagesWaiting(freeSlabs);
+        uint8_t hw= highWater.load();
+        while(used > hw and !highWater.compare_exchange_weak(hw, used)) {}
+    } else {
+        exhausted++;
+    }
+
+    if(buf == nullptr){
+        buf= (uint8_t*)malloc(len > 0 ? len : 1);
+        if(buf == nullptr) return nullptr;
+    }
+
+    memcpy(buf, data, len);
+    return buf;
+}
+
+void BLELNActionPool::give(uint8_t *buf) {
+    if(buf == nullptr){
+        return;
+    }
+
+    if(isSlab(buf)){
+        uint8_t idx= (buf - slabs) / BLELN_ACTION_SLAB_LEN;
+        xQueueSend(freeSlabs, &idx, 0);
+    } else {
+        free(buf);
+    }
+}
+
+uint8_t BLELNActionPool::getSlabCount() const {
+    return slabCnt;
+}
+
+uint8_t BLELNActionPool::getHighWater() const {
+    return highWater;
+}
+
+uint32_t BLELNActionPool::getExhausted() const {
+    return exhausted;
+}
+
+uint32_t BLELNActionPool::getOversized() const {
+    return oversized;
+}
+
+bool BLELNActionPool::isSlab(const uint8_t *buf) const {
+    return slabs != nullptr and buf >= slabs and buf < slabs + (size_t)slabCnt * BLELN_ACTION_SLAB_LEN;
+}
@@ -0,0 +1,74 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNACTIONPOOL_H
+#define MGLIGHTFW_BLELNACTIONPOOL_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "BLELNBase.h"
+
+#define BLELN_ACTION_SLAB_LEN       256     // One data fragment or write without response at ATT MTU up to 259
+#define BLELN_SERVER_ACTION_SLABS   16
+#define BLELN_CLIENT_ACTION_SLABS   8
+
+/**
+ * Preallocated payload buffers of worker actions. Payloads up to BLELN_ACTION_INLINE_LEN go inline in the
+ * action, longer ones get a slab taken in BLE host callbacks and given back by the worker, so the receive
+ * path does no heap allocation. Payloads longer than a slab (handshake key packets, long messages queued
+ * by application) and payloads queued while all slabs are taken fall back to heap - both are counted.
+ */
+class BLELNActionPool {
+public:
+    ~BLELNActionPool();
+
+    // Allocates all slabs, once per start of the owner
+    bool begin(uint8_t slabCount);
+    // Every taken buffer must be given back before
+    void end();
+
+    // Copies data into action - inline or to taken buffer. False when even heap fallback failed.
+    /*** Multithreading safe */
+    bool put(BLELNWorkerAction &action, const uint8_t *data, size_t len);
+    // Returns copy of data, nullptr when even heap fallback failed
+    /*** Multithreading safe */
+    uint8_t* take(const uint8_t *data, size_t len);
+    /*** Multithreading safe */
+    void give(uint8_t *buf);
+
+    uint8_t getSlabCount() const;
+    uint8_t getHighWater() const;
+    uint32_t getExhausted() const;
+    uint32_t getOversized() const;
+
+private:
+    bool isSlab(const uint8_t *buf) const;
+
+    uint8_t *slabs= nullptr;
+    QueueHandle_t freeSlabs= nullptr;   // Indexes of free slabs
+    uint8_t slabCnt= 0;
+    // Updated from BLE host, application and worker tasks
+    std::atomic<uint8_t> highWater{0};
+    std::atomic<uint32_t> exhausted{0};
+    std::atomic<uint32_t> oversized{0};
+};
+
+
+#endif //MGLIGHTFW_BLELNACTIONPOOL_H
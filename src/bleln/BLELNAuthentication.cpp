@@ -21,84 +21,117 @@
 
 #include "BLELNAuthentication.h"
 #include "Encryption.h"
+#include "BLELNCertCache.h"
 #include "SuperString.h"
+#include <mbedtls/sha256.h>
+
+BLELNAuthentication::BLELNAuthentication() {
+    mbedtls_ecp_point_init(&manuPubKey);
+}
+
+BLELNAuthentication::~BLELNAuthentication() {
+    mbedtls_ecp_point_free(&manuPubKey);
+}
 
 bool BLELNAuthentication::loadCert() {
     Preferences prefs;
 
     if(prefs.begin("cert", true)) {
-        size_t r= prefs.getBytes("pc_sign", certSign, BLELN_MANU_SIGN_LEN);
-        prefs.getBytes("manu_pub", manuPubKey, BLELN_MANU_PUB_KEY_LEN);
+        size_t signLen= prefs.getBytes("pc_sign", myCert.sign, BLELN_MANU_SIGN_LEN);
+        prefs.getBytes("manu_pub", manuPubKeyRaw, BLELN_MANU_PUB_KEY_LEN);
         prefs.getBytes("dev_priv", myPrivateKey, BLELN_DEV_PRIV_KEY_LEN);
         prefs.getBytes("dev_pub", myPublicKey, BLELN_DEV_PUB_KEY_LEN);
         prefs.end();
+
+        // Not provisioned (or damaged) - certificate without manufacturer sign is rejected by every peer
+        if(signLen != BLELN_MANU_SIGN_LEN){
+            Serial.println("BLELNAuthentication - loadCert() - no certificate sign");
+            return false;
+        }
     } else {
         Serial.println("BLELNAuthentication - loadCert() - failed");
         return false;
     }
 
+    // My certificate never changes - prepare it once for every handshake
+    uint64_t mac= ESP.getEfuseMac();
+    myCert.gen= 2;
+    memcpy(myCert.mac, &mac, 6);
+    memcpy(myCert.pubKey, myPublicKey, BLELN_DEV_PUB_KEY_LEN);
+    myCert.text= makeCertText(myCert);
+
+    // Parse and check manufacturer key once - every certificate verification uses it
+    manuPubKeyValid= Encryption::readPubKey_P256(manuPubKeyRaw, BLELN_MANU_PUB_KEY_LEN, manuPubKey);
+    if(!manuPubKeyValid){
+        Serial.println("BLELNAuthentication - loadCert() - bad manufacturer key");
+    }
+    BLELNCertCache::begin();
+
     return true;
 }
 
-std::string BLELNAuthentication::getSignedCert() {
-    // # Cert:
+const BLELNCert &BLELNAuthentication::getCert() const {
+    return myCert;
+}
+
+std::string BLELNAuthentication::makeCertText(const BLELNCert &cert) {
+    // # Cert (signed by manufacturer):
     // product generation - as text
     // ;
     // devices mac 6 bytes  - base64
     // ;
     // devices public key 64 bytes - base64
-    // # Sign:
-    // ,
-    // certSign - base64
-
     std::string out;
-    uint64_t mac= ESP.getEfuseMac();
 
-    out.append("2;");
-    out.append(Encryption::base64Encode((uint8_t*)&mac, 6));
+    out.append(std::to_string(cert.gen)).append(";");
+    out.append(Encryption::base64Encode((uint8_t*)cert.mac, 6));
     out.append(";");
-    out.append(Encryption::base64Encode(myPublicKey, BLELN_DEV_PUB_KEY_LEN));
-    out.append(",");
-    out.append(Encryption::base64Encode(certSign, BLELN_MANU_SIGN_LEN));
+    out.append(Encryption::base64Encode((uint8_t*)cert.pubKey, BLELN_DEV_PUB_KEY_LEN));
 
     return out;
 }
 
 
-bool BLELNAuthentication::verifyCert(const std::string &cert, const std::string &sign, uint8_t *genOut, uint8_t *macOut,
-                                     int macOutLen, uint8_t *pubKeyOut, int pubKeyOutLen) {
-    uint8_t signRaw[BLELN_MANU_SIGN_LEN];
-    Encryption::base64Decode(sign, signRaw, BLELN_MANU_SIGN_LEN);
-
-    bool r= Encryption::verifySign_ECDSA_P256(reinterpret_cast<const uint8_t *>(cert.data()), cert.length(),
-                                              signRaw, BLELN_MANU_SIGN_LEN, manuPubKey, BLELN_MANU_PUB_KEY_LEN);
+bool BLELNAuthentication::verifyCert(const BLELNCert &cert) {
+    // Certificate already verified once - skip ECDSA
+    uint8_t hash[32];
+    uint8_t gen, mac[6], pubKey[BLELN_DEV_PUB_KEY_LEN];
+    certHash(cert, hash);
+    if(BLELNCertCache::find(hash, &gen, mac, pubKey)){
+        return true;
+    }
 
-    if((macOutLen < 6) or (pubKeyOutLen < BLELN_DEV_PUB_KEY_LEN)){
+    if(!manuPubKeyValid){
         return false;
     }
 
-    if(r){
-        StringList certSplit= splitCsvRespectingQuotes(cert, ';');
-        try {
-            *genOut = std::stoi(certSplit[0], nullptr, 10);
-        } catch (std::invalid_argument &e){
-            return false;
-        } catch (std::out_of_range &e) {
-            return false;
-        }
+    // Manufacturer signed text form of certificate, TLV messages carry only its fields
+    std::string text= cert.text.empty() ? makeCertText(cert) : cert.text;
+    bool r= Encryption::verifySign_ECDSA_P256(reinterpret_cast<const uint8_t *>(text.data()), text.length(),
+                                              cert.sign, BLELN_MANU_SIGN_LEN, manuPubKey);
 
-        if(Encryption::base64Decode(certSplit[1], macOut, macOutLen)==6){
-            if(Encryption::base64Decode(certSplit[2], pubKeyOut, pubKeyOutLen)!=BLELN_DEV_PUB_KEY_LEN){
-                return false;
-            }
-        } else {
-            return false;
-        }
+    if(r){
+        BLELNCertCache::add(hash, cert.gen, cert.mac, cert.pubKey);
     }
 
     return r;
 }
 
+void BLELNAuthentication::certHash(const BLELNCert &cert, uint8_t *out32) {
+    // Manufacturer key is hashed too, so cache is void after provisioning with other key.
+    // Raw fields only - the same certificate hits cache whatever encoding it came in.
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts_ret(&ctx, 0);
+    mbedtls_sha256_update_ret(&ctx, manuPubKeyRaw, BLELN_MANU_PUB_KEY_LEN);
+    mbedtls_sha256_update_ret(&ctx, &cert.gen, 1);
+    mbedtls_sha256_update_ret(&ctx, cert.mac, 6);
+    mbedtls_sha256_update_ret(&ctx, cert.pubKey, BLELN_DEV_PUB_KEY_LEN);
+    mbedtls_sha256_update_ret(&ctx, cert.sign, BLELN_MANU_SIGN_LEN);
+    mbedtls_sha256_finish_ret(&ctx, out32);
+    mbedtls_sha256_free(&ctx);
+}
+
 void BLELNAuthentication::signData(const uint8_t *d, size_t dlen, uint8_t *out) {
     Encryption::signData_ECDSA_P256(d, dlen,
                                     myPrivateKey, BLELN_DEV_PRIV_KEY_LEN, out, BLELN_DEV_SIGN_LEN);
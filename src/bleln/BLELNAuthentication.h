@@ -24,19 +24,30 @@
 #include "Arduino.h"
 #include "Preferences.h"
 #include "mbedtls/base64.h"
+#include "mbedtls/ecp.h"
 #include "BLELNBase.h"
 
 class BLELNAuthentication {
 public:
+    BLELNAuthentication();
+    ~BLELNAuthentication();
+    BLELNAuthentication(const BLELNAuthentication&) = delete;
+    BLELNAuthentication& operator=(const BLELNAuthentication&) = delete;
+
     bool loadCert();
-    std::string getSignedCert();
-    bool verifyCert(const std::string &cert, const std::string &sign, uint8_t *genOut, uint8_t *macOut,
-                    int macOutLen, uint8_t *pubKeyOut, int pubKeyOutLen);
+    const BLELNCert& getCert() const;
+    bool verifyCert(const BLELNCert &cert);
     void signData(const uint8_t *d, size_t dlen, uint8_t *out);
 
 private:
-    uint8_t certSign[BLELN_MANU_SIGN_LEN];
-    uint8_t manuPubKey[BLELN_MANU_PUB_KEY_LEN];
+    static std::string makeCertText(const BLELNCert &cert);
+    void certHash(const BLELNCert &cert, uint8_t *out32);
+
+private:
+    BLELNCert myCert{};
+    uint8_t manuPubKeyRaw[BLELN_MANU_PUB_KEY_LEN];
+    mbedtls_ecp_point manuPubKey{};    // Parsed and checked once in loadCert()
+    bool manuPubKeyValid= false;
     uint8_t myPrivateKey[BLELN_DEV_PRIV_KEY_LEN];
     uint8_t myPublicKey[BLELN_DEV_PUB_KEY_LEN];
 };
@@ -25,6 +25,8 @@ const char* BLELNBase::KEY_TO_CLI_UUID  = "ef7cb0fc-53a4-4062-bb0e-25443e3a1f5d"
 const char* BLELNBase::KEY_TO_SER_UUID  = "345ac506-c96e-45c6-a418-56a2ef2d6072";
 const char* BLELNBase::DATA_TO_CLI_UUID   = "b675ddff-679e-458d-9960-939d8bb03572";
 const char* BLELNBase::DATA_TO_SER_UUID   = "566f9eb0-a95e-4c18-bc45-79bd396389af";
+const char* BLELNBase::GROUP_TO_CLI_UUID  = "0b3e5f0a-6c1d-4c52-9a63-2f8e1d7b4c90";
+const char* BLELNBase::CAPS_UUID          = "5d8a3c21-7e4b-4f69-b0d2-93c6a1e7f458";
 
 void BLELNBase::bytes_to_hex(const uint8_t *src, size_t src_len) {
     const char hex_map[] = "0123456789ABCDEF";
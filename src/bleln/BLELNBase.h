@@ -29,11 +29,40 @@
 #define BLELN_MANU_SIGN_LEN         64
 #define BLELN_NONCE_SIGN_LEN        64
 
+// Data frame formats, negotiated with the version byte of key exchange messages. KEYEX version byte stays
+// BLELN_FRAME_V1, as first firmware clients drop any other KEYEX - server offers the newest version and flags
+// in its capabilities characteristic instead, which these clients never discover.
+#define BLELN_FRAME_V1              1   // [ctr:4][iv:12][ct][tag:16]
+#define BLELN_FRAME_V2              2   // [ctr:4][ct][tag:16], nonce derived from sid, direction and ctr
+#define BLELN_FRAME_V3              3   // v2 frame sent in fragments of ATT MTU size (see BLELNFragment.h)
+#define BLELN_FRAME_VERSION_MAX     BLELN_FRAME_V3
+
+#define BLELN_MESSAGE_MAX_LEN       4096    // Plain data message, bounds reassembly buffer of every connection
+
 #define BLELN_MSG_TITLE_CERT                                "$CERT"
 #define BLELN_MSG_TITLE_CHALLENGE_RESPONSE_NONCE            "$CHRN"
 #define BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW_AND_NONCE   "$CHRAN"
 #define BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW             "$CHRA"
 #define BLELN_MSG_TITLE_AUTH_OK                             "$AUOK"
+#define BLELN_MSG_TITLE_TICKET                              "$TICK"
+#define BLELN_MSG_TITLE_RESUME_OK                           "$RSOK"
+#define BLELN_MSG_TITLE_RESUME_REJECT                       "$RSNO"     // Sent as plain text
+
+// Session resumption - client key packet with this flag in version byte is [ver|flag][cliNonce:12][ticket]
+#define BLELN_KEY_PACKET_RESUME_FLAG        0x80
+#define BLELN_RESUME_SECRET_LEN             32
+#define BLELN_RESUME_TICKET_LEN             (12 + 6 + BLELN_DEV_PUB_KEY_LEN + BLELN_RESUME_SECRET_LEN + 4 + 16)
+#define BLELN_RESUME_TICKET_LIFETIME_S      (6*3600)
+#define BLELN_RESUME_TICKETS_MAX            2       // Tickets kept by client, one per server
+
+// Handshake messages encoding - server offers binary TLV with this flag in capabilities byte,
+// client confirms it with the same flag in its key packet. Without it handshake messages are CSV.
+#define BLELN_KEY_PACKET_TLV_FLAG           0x40
+// 1.5-RTT mutual authentication (TLV only) - offered and confirmed like TLV. Client key packet is then
+// [ver|flags][cliPub:65][cliNonce:12][encrypted cert and answer], server answers with its encrypted cert and answer.
+// Answers are signs of test nonces derived from session secret, so no nonce has to be sent.
+#define BLELN_KEY_PACKET_FAST_AUTH_FLAG     0x20
+#define BLELN_KEY_PACKET_VERSION_MASK       0x1F
 
 
 #include "Arduino.h"
@@ -45,14 +74,34 @@ enum blen_wroker_actions {
     BLELN_WORKER_ACTION_PROCESS_SUBSCRIPTION,
     BLELN_WORKER_ACTION_PROCESS_DATA_RX,
     BLELN_WORKER_ACTION_PROCESS_KEY_RX,
-    BLELN_WORKER_ACTION_SEND_MESSAGE
+    BLELN_WORKER_ACTION_SEND_MESSAGE,
+    BLELN_WORKER_ACTION_PROCESS_GROUP_SUBSCRIPTION,
+    BLELN_WORKER_ACTION_PROCESS_GROUP_RX,
+    BLELN_WORKER_ACTION_WAKE_LINK,      // Only makes link fast, ahead of a request
+    BLELN_WORKER_ACTION_STOP            // Only wakes worker up, so it sees stop request without waiting for timeout
 };
 
+// Workers block on their action queue - with no actions they wake up only this often (housekeeping, stop check)
+#define BLELN_WORKER_IDLE_WAKE_MS   1000
+
+#define BLELN_ACTION_INLINE_LEN     20      // One fragment at default ATT MTU - carried in queue item itself
+
 struct BLELNWorkerAction {
     uint16_t connH;
     uint8_t type;
     size_t dlen;
-    uint8_t *d;
+    uint8_t *d;                             // Pool buffer (BLELNActionPool), nullptr when payload is inline
+    uint8_t inl[BLELN_ACTION_INLINE_LEN];
+
+    uint8_t* data() { return (d != nullptr) ? d : inl; }
+};
+
+struct BLELNCert {
+    uint8_t gen;
+    uint8_t mac[6];
+    uint8_t pubKey[BLELN_DEV_PUB_KEY_LEN];
+    uint8_t sign[BLELN_MANU_SIGN_LEN];
+    std::string text;   // Signed part exactly as received in CSV, empty if received as TLV
 };
 
 
@@ -64,6 +113,8 @@ public:
     static const char* KEY_TO_SER_UUID;
     static const char* DATA_TO_CLI_UUID;
     static const char* DATA_TO_SER_UUID;
+    static const char* GROUP_TO_CLI_UUID;     // Broadcasts encrypted with group key (see BLELNGroupKey.h)
+    static const char* CAPS_UUID;             // Read only, server's protocol offer (see BLELN_KEY_PACKET_VERSION_MASK)
 
     static void bytes_to_hex(const uint8_t *src, size_t src_len);
 };
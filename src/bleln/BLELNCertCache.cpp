@@ -0,0 +1,133 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNCertCache.h"
+#include <Preferences.h>
+
+SemaphoreHandle_t BLELNCertCache::mtx= nullptr;
+BLELNCertCache::Entry BLELNCertCache::entries[BLELN_CERT_CACHE_SIZE];
+uint32_t BLELNCertCache::useCounter= 0;
+uint32_t BLELNCertCache::hits= 0;
+uint32_t BLELNCertCache::misses= 0;
+bool BLELNCertCache::dirty= false;
+unsigned long BLELNCertCache::lastFlush= 0;
+
+void BLELNCertCache::begin() {
+    if(mtx!= nullptr){
+        return;
+    }
+
+    memset(entries, 0, sizeof(entries));
+
+#if BLELN_CERT_CACHE_PERSIST
+    Preferences prefs;
+    if(prefs.begin(BLELN_CERT_CACHE_NVS_NAMESPACE, true)) {
+        if(prefs.getBytesLength(BLELN_CERT_CACHE_NVS_KEY) == sizeof(entries)) {
+            prefs.getBytes(BLELN_CERT_CACHE_NVS_KEY, entries, sizeof(entries));
+        }
+        prefs.end();
+    }
+
+    for(auto &e: entries){
+        if(e.lastUse > useCounter)
+            useCounter= e.lastUse;
+    }
+#endif
+
+    mtx= xSemaphoreCreateMutex();
+}
+
+bool BLELNCertCache::find(const uint8_t *hash32, uint8_t *genOut, uint8_t *macOut, uint8_t *pubKeyOut) {
+    bool found= false;
+
+    if(mtx!= nullptr and xSemaphoreTake(mtx, portMAX_DELAY)==pdTRUE){
+        for(auto &e: entries){
+            if(e.lastUse != 0 and memcmp(e.hash, hash32, 32)==0){
+                *genOut= e.gen;
+                memcpy(macOut, e.mac, 6);
+                memcpy(pubKeyOut, e.pubKey, BLELN_DEV_PUB_KEY_LEN);
+                // Order of use is kept in RAM only, NVS is written on new certificates
+                e.lastUse= ++useCounter;
+                found= true;
+                break;
+            }
+        }
+
+        if(found)
+            hits++;
+        else
+            misses++;
+
+        xSemaphoreGive(mtx);
+    }
+
+    return found;
+}
+
+void BLELNCertCache::add(const uint8_t *hash32, uint8_t gen, const uint8_t *mac, const uint8_t *pubKey) {
+    if(mtx!= nullptr and xSemaphoreTake(mtx, portMAX_DELAY)==pdTRUE){
+        // Replace free or least recently used entry
+        Entry *slot= &entries[0];
+        for(auto &e: entries){
+            if(e.lastUse < slot->lastUse)
+                slot= &e;
+        }
+
+        memcpy(slot->hash, hash32, 32);
+        slot->gen= gen;
+        memcpy(slot->mac, mac, 6);
+        memcpy(slot->pubKey, pubKey, BLELN_DEV_PUB_KEY_LEN);
+        slot->lastUse= ++useCounter;
+
+        // Written later by flush() - peers rotating through a full cache would make every handshake a flash write
+        dirty= true;
+        xSemaphoreGive(mtx);
+    }
+}
+
+void BLELNCertCache::flush(bool force) {
+    if(mtx!= nullptr and xSemaphoreTake(mtx, portMAX_DELAY)==pdTRUE){
+        if(dirty and (force or (millis() - lastFlush) >= BLELN_CERT_CACHE_FLUSH_MS)){
+            save();
+            dirty= false;
+            lastFlush= millis();
+        }
+        xSemaphoreGive(mtx);
+    }
+}
+
+uint32_t BLELNCertCache::getHits() {
+    return hits;
+}
+
+uint32_t BLELNCertCache::getMisses() {
+    return misses;
+}
+
+/*** Call with mtx taken */
+void BLELNCertCache::save() {
+#if BLELN_CERT_CACHE_PERSIST
+    Preferences prefs;
+    if(prefs.begin(BLELN_CERT_CACHE_NVS_NAMESPACE, false)) {
+        prefs.putBytes(BLELN_CERT_CACHE_NVS_KEY, entries, sizeof(entries));
+        prefs.end();
+    }
+#endif
+}
@@ -0,0 +1,79 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNCERTCACHE_H
+#define MGLIGHTFW_BLELNCERTCACHE_H
+
+#include <Arduino.h>
+#include "BLELNBase.h"
+
+#define BLELN_CERT_CACHE_SIZE       8
+#ifndef BLELN_CERT_CACHE_PERSIST
+#define BLELN_CERT_CACHE_PERSIST    1   // Keep verified certificates in NVS over reboots
+#endif
+#define BLELN_CERT_CACHE_FLUSH_MS   (10*60000ul)    // New certificates are written to NVS at most this often
+
+#define BLELN_CERT_CACHE_NVS_NAMESPACE  "certc"
+#define BLELN_CERT_CACHE_NVS_KEY        "e"
+
+/**
+ * Certificates that already passed ECDSA verification against manufacturer key, with their decoded fields.
+ * Peers reconnect every few minutes - a known certificate is accepted after one hash comparison.
+ */
+class BLELNCertCache {
+public:
+    /*** Multithreading safe */
+    static void begin();
+
+    // hash32 - SHA-256 of manufacturer key, certificate and its sign
+    /*** Multithreading safe */
+    static bool find(const uint8_t *hash32, uint8_t *genOut, uint8_t *macOut, uint8_t *pubKeyOut);
+    /*** Multithreading safe */
+    static void add(const uint8_t *hash32, uint8_t gen, const uint8_t *mac, const uint8_t *pubKey);
+    // Writes changed cache to NVS - when BLELN_CERT_CACHE_FLUSH_MS passed from the last write, or now with force.
+    // Called periodically outside BLELN workers and when BLELN stops, so handshakes never wait for flash.
+    /*** Multithreading safe */
+    static void flush(bool force= false);
+
+    static uint32_t getHits();
+    static uint32_t getMisses();
+
+private:
+    struct Entry {
+        uint8_t hash[32];
+        uint32_t lastUse;       // 0 - free slot
+        uint8_t gen;
+        uint8_t mac[6];
+        uint8_t pubKey[BLELN_DEV_PUB_KEY_LEN];
+    };
+
+    static void save();
+
+    static SemaphoreHandle_t mtx;
+    static Entry entries[BLELN_CERT_CACHE_SIZE];
+    static uint32_t useCounter;
+    static uint32_t hits;
+    static uint32_t misses;
+    static bool dirty;
+    static unsigned long lastFlush;
+};
+
+
+#endif //MGLIGHTFW_BLELNCERTCACHE_H
@@ -22,7 +22,10 @@
 
 #include <utility>
 #include "BLELNBase.h"
-#include "SuperString.h"
+#include "BLELNKeyPool.h"
+#include "BLELNHandshakeMsg.h"
+#include "BLELNCertCache.h"
+#include <mbedtls/platform_util.h>
 
 void BLELNClient::start(const std::string &name, std::function<void(const std::string&)> onServerResponse) {
     NimBLEDevice::init(name);
@@ -31,18 +34,22 @@ void BLELNClient::start(const std::string &name, std::function<void(const std::s
     NimBLEDevice::setMTU(247);
 
     Encryption::randomizer_init();
+    BLELNKeyPool::start();
     authStore.loadCert();
 
     delete connCtx;
     connCtx= nullptr;
 
     workerActionQueue= xQueueCreate(30, sizeof(BLELNWorkerAction));
+    actionPool.begin(BLELN_CLIENT_ACTION_SLABS);
     onMsgRx= std::move(onServerResponse);
     runWorker= true;
 
     xTaskCreatePinnedToCore(
             [](void* arg){
-                static_cast<BLELNClient *>(arg)->worker();
+                auto *self= static_cast<BLELNClient *>(arg);
+                self->worker();
+                self->workerTaskHandle= nullptr;
                 vTaskDelete(nullptr);
             },
             "BLELNrx", 4096, this, 5, &workerTaskHandle, 1);
@@ -58,6 +65,8 @@ void BLELNClient::stop() {
 
     runWorker = false;
     if (workerTaskHandle != nullptr) {
+        BLELNWorkerAction wake{0, BLELN_WORKER_ACTION_STOP, 0, nullptr};
+        xQueueSend(workerActionQueue, &wake, pdMS_TO_TICKS(100));
         while (workerTaskHandle != nullptr) {
             vTaskDelay(pdMS_TO_TICKS(10));
         }
@@ -72,19 +81,23 @@ void BLELNClient::stop() {
     if(workerActionQueue) {
         BLELNWorkerAction pkt{};
         while (xQueueReceive(workerActionQueue, &pkt, 0) == pdPASS) {
-            free(pkt.d);
+            actionPool.give(pkt.d);
         }
         vQueueDelete(workerActionQueue); // Usuń kolejkę
         workerActionQueue = nullptr;
     }
+    actionPool.end();
+    BLELNCertCache::flush(true);
 
     if(chKeyToCli) chKeyToCli->unsubscribe();
     if(chDataToCli) chDataToCli->unsubscribe();
+    if(chGroupToCli) chGroupToCli->unsubscribe();
 
     chKeyToCli   = nullptr;
     chKeyToSer   = nullptr;
     chDataToCli  = nullptr;
     chDataToSer  = nullptr;
+    chGroupToCli = nullptr;
     svc          = nullptr;
 
     if(connCtx) {
@@ -96,25 +109,71 @@ void BLELNClient::stop() {
     NimBLEDevice::deinit(true);
 }
 
-void BLELNClient::startServerSearch(uint32_t durationMs, const std::string &serverUUID, const std::function<void(const NimBLEAdvertisedDevice *advertisedDevice)>& onResult) {
+void BLELNClient::startServerSearch(uint32_t durationMs, const std::string &serverUUID, const std::function<void(const NimBLEAdvertisedDevice *advertisedDevice)>& onResult,
+                                    bool firstOnly) {
     scanning = true;
     onScanResult= onResult;
     searchedUUID= serverUUID;
+    searchFirstOnly= firstOnly;
     auto* scan=NimBLEDevice::getScan();
     scan->setScanCallbacks(this, false);
     scan->setActiveScan(true);
     scan->start(durationMs, false, false);
 }
 
+void BLELNClient::stopServerSearch() {
+    // Caller has what it searched for - no scan end report
+    onScanResult= nullptr;
+    if(scanning)
+        NimBLEDevice::getScan()->stop();
+    scanning = false;
+}
+
 void BLELNClient::beginConnect(const NimBLEAdvertisedDevice *advertisedDevice, const std::function<void(bool, int)> &onConnectResult) {
+    beginConnect(advertisedDevice->getAddress(), onConnectResult);
+}
+
+void BLELNClient::beginConnect(const NimBLEAddress &address, const std::function<void(bool, int)> &onConnectResult) {
     if(scanning)
         NimBLEDevice::getScan()->stop();
     scanning = false;
 
+    knownServerConnect= false;
+    connectTo(address, BLELN_CONNECT_TIMEOUT_MS, onConnectResult);
+}
+
+bool BLELNClient::beginConnectKnown(const std::function<void(bool, int)> &onConnectResult) {
+    if(knownServer.isNull())
+        return false;
+
+    knownServerConnect= true;
+    connectTo(knownServer, BLELN_KNOWN_SERVER_CONNECT_MS, onConnectResult);
+    return true;
+}
+
+bool BLELNClient::hasKnownServer() const {
+    return !knownServer.isNull();
+}
+
+void BLELNClient::connectTo(const NimBLEAddress &address, uint32_t timeoutMs, const std::function<void(bool, int)> &onConnectResult) {
     onConRes= onConnectResult;
-    client = NimBLEDevice::createClient();
+    // NimBLE gives only CONFIG_BT_NIMBLE_MAX_CONNECTIONS clients - reuse ours
+    if(client== nullptr)
+        client = NimBLEDevice::createClient();
+    if(client== nullptr){
+        if(onConRes)
+            onConRes(false, BLE_HS_ENOMEM);
+        return;
+    }
     client->setClientCallbacks(this, false);
-    client->connect(advertisedDevice, true, true, true);
+    client->setConnectTimeout(timeoutMs);
+    // Link starts fast - update procedure would take effect only in the middle of handshake
+    const BLELNLinkParams &p= BLELNLinkPolicy::paramsOf(BLELNLinkPolicy::Mode::Fast);
+    client->setConnectionParams(p.itvlMin, p.itvlMax, p.latency, p.timeout);
+    if(!client->connect(address, true, true, true)){
+        if(onConRes)
+            onConRes(false, BLE_HS_EBUSY);
+    }
 }
 
 
@@ -124,8 +183,10 @@ void BLELNClient::onDiscovered(const NimBLEAdvertisedDevice *advertisedDevice) {
 
 void BLELNClient::onResult(const NimBLEAdvertisedDevice *advertisedDevice) {
     if (advertisedDevice->isAdvertisingService(NimBLEUUID(searchedUUID))) {
-        NimBLEDevice::getScan()->stop();
-        scanning = false;
+        if(searchFirstOnly){
+            NimBLEDevice::getScan()->stop();
+            scanning = false;
+        }
         if(onScanResult){
             onScanResult(advertisedDevice);
         }
@@ -148,6 +209,16 @@ bool BLELNClient::discover() {
     chKeyToSer = s->getCharacteristic(BLELNBase::KEY_TO_SER_UUID);
     chDataToCli  = s->getCharacteristic(BLELNBase::DATA_TO_CLI_UUID);
     chDataToSer  = s->getCharacteristic(BLELNBase::DATA_TO_SER_UUID);
+    chGroupToCli = s->getCharacteristic(BLELNBase::GROUP_TO_CLI_UUID);
+
+    // Read before key subscription - server sends KEYEX right after it
+    serverCaps= 0;
+    NimBLERemoteCharacteristic *chCaps= s->getCharacteristic(BLELNBase::CAPS_UUID);
+    if(chCaps){
+        NimBLEAttValue caps= chCaps->readValue();
+        if(caps.size() >= 1)
+            serverCaps= caps.data()[0];
+    }
 
     if(chKeyToCli && chKeyToSer && chDataToCli && chDataToSer) {
         chKeyToCli->subscribe(true,
@@ -160,48 +231,187 @@ bool BLELNClient::discover() {
                                    bool isNotify) {
                                 this->onDataTxNotify(pBLERemoteCharacteristic, pData, length, isNotify);
                             });
+        // Subscription tells server I can take group key and broadcasts
+        if(chGroupToCli) {
+            chGroupToCli->subscribe(true,
+                                    [this](NimBLERemoteCharacteristic *pBLERemoteCharacteristic, uint8_t *pData,
+                                           size_t length, bool isNotify) {
+                                        this->onGroupTxNotify(pBLERemoteCharacteristic, pData, length, isNotify);
+                                    });
+        }
     }
 
     return chKeyToCli && chKeyToSer && chDataToCli && chDataToSer;
 }
 
 
-/*** Connection context not protected! */
-bool BLELNClient::handshake(uint8_t *v, size_t vlen) {
-    if (vlen!=1+4+32+65+12 || (uint8_t)v[0]!=1) {
+bool BLELNClient::parseKeyEx(const uint8_t *v, size_t vlen, uint8_t *frameVer, uint8_t *flags, uint32_t *epoch,
+                             uint8_t *salt, uint8_t *srvPub, uint8_t *srvNonce) {
+    // KEYEX of every server says v1 - newer ones offer the newest frame version they know and handshake flags
+    // in capabilities characteristic. Use the newest version we both know.
+    uint8_t offer= (serverCaps != 0) ? serverCaps : ((vlen > 0) ? v[0] : 0);
+    uint8_t ver= offer & BLELN_KEY_PACKET_VERSION_MASK;
+    if (vlen!=1+4+32+65+12 || ver<BLELN_FRAME_V1) {
         return false;
     }
+    *frameVer= (ver > BLELN_FRAME_VERSION_MAX) ? BLELN_FRAME_VERSION_MAX : ver;
+    *flags= offer & ~BLELN_KEY_PACKET_VERSION_MASK;
+
+    memcpy(epoch,  &v[1], 4);
+    memcpy(salt,    &v[1+4], 32);
+    memcpy(srvPub,  &v[1+4+32], 65);
+    memcpy(srvNonce,&v[1+4+32+65], 12);
+
+    return true;
+}
 
+/*** Connection context not protected! */
+bool BLELNClient::handshake(uint8_t *v, size_t vlen) {
+    uint8_t frameVer, flags;
     uint32_t s_epoch = 0;
     uint8_t  s_salt[32], s_srvPub[65], s_srvNonce[12];
 
-    memcpy(&s_epoch,  &v[1], 4);
-    memcpy(s_salt,    &v[1+4], 32);
-    memcpy(s_srvPub,  &v[1+4+32], 65);
-    memcpy(s_srvNonce,&v[1+4+32+65], 12);
+    if(!parseKeyEx(v, vlen, &frameVer, &flags, &s_epoch, s_salt, s_srvPub, s_srvNonce)){
+        return false;
+    }
+
+    bool tlv= flags & BLELN_KEY_PACKET_TLV_FLAG;
+    bool fastAuth= tlv and (flags & BLELN_KEY_PACKET_FAST_AUTH_FLAG);
 
     connCtx->getSessionEnc()->makeMyKeys();
+    connCtx->setTlvHandshake(tlv);
 
-    // [ver=1][cliPub:65][cliNonce:12]
+    // [ver][cliPub:65][cliNonce:12]
     std::string tx;
-    tx.push_back(1);
+    tx.push_back((char)(frameVer | (tlv ? BLELN_KEY_PACKET_TLV_FLAG : 0)
+                        | (fastAuth ? BLELN_KEY_PACKET_FAST_AUTH_FLAG : 0)));
     tx.append((const char*)connCtx->getSessionEnc()->getMyPub(),65);
     tx.append((const char*)connCtx->getSessionEnc()->getMyNonce(),12);
 
+    if(fastAuth){
+        // 1.5-RTT authentication - my cert and answer go with my key, so session key is needed first
+        if(!connCtx->getSessionEnc()->deriveFriendsKey(s_srvPub, s_srvNonce, s_salt, s_epoch, frameVer)){
+            return false;
+        }
+
+        uint8_t testNonce[BLELN_TEST_NONCE_LEN];
+        uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
+        connCtx->getSessionEnc()->makeAuthTestNonce(true, testNonce);
+        authStore.signData(testNonce, BLELN_TEST_NONCE_LEN, nonceSign);
+
+        std::string encMsg;
+        if(!connCtx->getSessionEnc()->encryptMessage(BLELNHandshakeMsg::makeCertAndAnswer(authStore.getCert(), nonceSign),
+                                                     encMsg)){
+            return false;
+        }
+        tx.append(encMsg);
+
+        if(!chKeyToSer->writeValue(tx, true)){
+            return false;
+        }
+        connCtx->setState(BLELNConnCtx::State::WaitingForAuth);
+        return true;
+    }
+
     if(!chKeyToSer->writeValue(tx, true)){
         return false;
     }
 
-    connCtx->getSessionEnc()->deriveFriendsKey(s_srvPub, s_srvNonce, s_salt, s_epoch);
+    connCtx->getSessionEnc()->deriveFriendsKey(s_srvPub, s_srvNonce, s_salt, s_epoch, frameVer);
+    connCtx->setState(BLELNConnCtx::State::WaitingForCert);
 
     return true;
 }
 
+/*** Connection context not protected! */
+bool BLELNClient::resume(uint8_t *v, size_t vlen) {
+    ResumeTicket *t= findTicket(client->getPeerAddress().getVal());
+    if(t == nullptr){
+        return false;
+    }
+
+    uint8_t frameVer, flags;
+    uint32_t s_epoch = 0;
+    uint8_t  s_salt[32], s_srvPub[65], s_srvNonce[12];
+
+    if(!parseKeyEx(v, vlen, &frameVer, &flags, &s_epoch, s_salt, s_srvPub, s_srvNonce)){
+        return false;
+    }
+    bool tlv= flags & BLELN_KEY_PACKET_TLV_FLAG;
+    connCtx->setTlvHandshake(tlv);
+
+    // No ECDH - fresh keys from resumption secret and both nonces
+    connCtx->getSessionEnc()->makeMyNonce();
+    if(!connCtx->getSessionEnc()->deriveResumedKey(t->secret, s_srvNonce, s_salt, s_epoch, frameVer)){
+        return false;
+    }
+
+    // [ver|flag][cliNonce:12][ticket]
+    std::string tx;
+    tx.push_back((char)(frameVer | BLELN_KEY_PACKET_RESUME_FLAG | (tlv ? BLELN_KEY_PACKET_TLV_FLAG : 0)));
+    tx.append((const char*)connCtx->getSessionEnc()->getMyNonce(),12);
+    tx.append((const char*)t->ticket, BLELN_RESUME_TICKET_LEN);
+
+    return chKeyToSer->writeValue(tx, true);
+}
+
+/*** Connection context not protected! */
+void BLELNClient::storeTicket(const uint8_t *ticket, uint32_t lifetimeS) {
+    ResumeTicket t{};
+    memcpy(t.ticket, ticket, BLELN_RESUME_TICKET_LEN);
+
+    if(lifetimeS > BLELN_RESUME_TICKET_LIFETIME_S)
+        lifetimeS= BLELN_RESUME_TICKET_LIFETIME_S;
+
+    memcpy(t.server, client->getPeerAddress().getVal(), 6);
+    memcpy(t.secret, connCtx->getSessionEnc()->getResumeSecret(), BLELN_RESUME_SECRET_LEN);
+    t.expiresAt= millis() + lifetimeS*1000;
+
+    dropTicket(t.server);
+    if(tickets.size() >= BLELN_RESUME_TICKETS_MAX){
+        dropTicket(tickets.front().server);
+    }
+    tickets.push_back(t);
+    mbedtls_platform_zeroize(t.secret, sizeof(t.secret));
+}
+
+BLELNClient::ResumeTicket *BLELNClient::findTicket(const uint8_t *server) {
+    for(auto &t: tickets){
+        if(memcmp(t.server, server, 6)==0){
+            if((long)(millis() - t.expiresAt) >= 0){
+                dropTicket(server);
+                return nullptr;
+            }
+            return &t;
+        }
+    }
+
+    return nullptr;
+}
+
+void BLELNClient::dropTicket(const uint8_t *server) {
+    // server may point into ticket being removed
+    uint8_t s[6];
+    memcpy(s, server, 6);
+
+    tickets.remove_if([&s](ResumeTicket &t){
+        if(memcmp(t.server, s, 6)==0){
+            mbedtls_platform_zeroize(t.secret, sizeof(t.secret));
+            return true;
+        }
+        return false;
+    });
+}
+
 void BLELNClient::sendEncrypted(const std::string &msg) {
     appendActionToQueue(BLELN_WORKER_ACTION_SEND_MESSAGE, 0,
                         reinterpret_cast<const uint8_t *>(msg.data()), msg.size());
 }
 
+void BLELNClient::wakeLink() {
+    appendActionToQueue(BLELN_WORKER_ACTION_WAKE_LINK, 0, nullptr, 0);
+}
+
 bool BLELNClient::isConnected() {
     return (client!= nullptr) && (client->isConnected());
 }
@@ -210,29 +420,31 @@ void BLELNClient::onPassKeyEntry(NimBLEConnInfo &connInfo) {
     NimBLEDevice::injectPassKey(connInfo, 123456);
 }
 
-void BLELNClient::onKeyTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic *ch,
-                                __attribute__((unused)) uint8_t *pData,
-                                __attribute__((unused)) size_t length,
-                                __attribute__((unused)) bool isNotify) {
-    NimBLEAttValue v= ch->getValue();
-
-    if(v.size()==0){
+void BLELNClient::onKeyTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic *ch, uint8_t *pData,
+                                size_t length, __attribute__((unused)) bool isNotify) {
+    if(length==0){
         return;
     }
 
-    appendActionToQueue(BLELN_WORKER_ACTION_PROCESS_KEY_RX, 0, v.data(), v.size());
+    appendActionToQueue(BLELN_WORKER_ACTION_PROCESS_KEY_RX, 0, pData, length);
 }
 
-void BLELNClient::onDataTxNotify(NimBLERemoteCharacteristic *ch, __attribute__((unused)) uint8_t *pData,
-                                 __attribute__((unused)) size_t length,
-                                 __attribute__((unused)) bool isNotify) {
-    NimBLEAttValue v =ch->getValue();
+void BLELNClient::onDataTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic *ch, uint8_t *pData,
+                                 size_t length, __attribute__((unused)) bool isNotify) {
+    if (length==0) {
+        return;
+    }
+
+    appendActionToQueue(BLELN_WORKER_ACTION_PROCESS_DATA_RX, 0, pData, length);
+}
 
-    if (v.size()==0) {
+void BLELNClient::onGroupTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic *ch, uint8_t *pData,
+                                  size_t length, __attribute__((unused)) bool isNotify) {
+    if (length==0) {
         return;
     }
 
-    appendActionToQueue(BLELN_WORKER_ACTION_PROCESS_DATA_RX, 0, v.data(), v.size());
+    appendActionToQueue(BLELN_WORKER_ACTION_PROCESS_GROUP_RX, 0, pData, length);
 }
 
 bool BLELNClient::isScanning() const {
@@ -240,19 +452,14 @@ bool BLELNClient::isScanning() const {
 }
 
 void BLELNClient::appendActionToQueue(uint8_t type, uint16_t conH, const uint8_t *data, size_t dataLen) {
-    uint8_t *heapBuf= nullptr;
+    BLELNWorkerAction pkt{conH, type};
 
     if(data!= nullptr) {
-        heapBuf = (uint8_t *) malloc(dataLen);
-        if (!heapBuf) return;
-        memcpy(heapBuf, data, dataLen);
-    } else {
-        dataLen=0;
+        if (!actionPool.put(pkt, data, dataLen)) return;
     }
 
-    BLELNWorkerAction pkt{conH, type, dataLen, heapBuf};
     if (xQueueSend(workerActionQueue, &pkt, pdMS_TO_TICKS(100)) != pdPASS) {
-        free(heapBuf);
+        actionPool.give(pkt.d);
     }
 
 }
@@ -260,28 +467,29 @@ void BLELNClient::appendActionToQueue(uint8_t type, uint16_t conH, const uint8_t
 void BLELNClient::worker() {
     while(runWorker){
         BLELNWorkerAction action{};
-        if(xQueueReceive(workerActionQueue, &action, 0)==pdTRUE) {
+        if(xQueueReceive(workerActionQueue, &action, pdMS_TO_TICKS(BLELN_WORKER_IDLE_WAKE_MS))==pdTRUE) {
+            // Link is made fast before the message which woke worker up goes on air
+            if (connCtx != nullptr and action.type != BLELN_WORKER_ACTION_DELETE_CONNECTION) {
+                worker_linkActivity();
+            }
+
             if (action.type == BLELN_WORKER_ACTION_REGISTER_CONNECTION) {
                 worker_registerConnection(action.connH);
             } else if (action.type == BLELN_WORKER_ACTION_DELETE_CONNECTION) {
                 worker_deleteConnection();
             } else if(action.type==BLELN_WORKER_ACTION_SEND_MESSAGE){
-                worker_sendMessage(action.d, action.dlen);
+                worker_sendMessage(action.data(), action.dlen);
             } else if(action.type==BLELN_WORKER_ACTION_PROCESS_KEY_RX){
-                worker_processKeyRx(action.d, action.dlen);
+                worker_processKeyRx(action.data(), action.dlen);
             } else if(action.type==BLELN_WORKER_ACTION_PROCESS_DATA_RX){
-                worker_processDataRx(action.d, action.dlen);
+                worker_processDataRx(action.data(), action.dlen);
+            } else if(action.type==BLELN_WORKER_ACTION_PROCESS_GROUP_RX){
+                worker_processGroupRx(action.data(), action.dlen);
             }
 
-            free(action.d);
-        }
-
-
-        // Pause task
-        if(uxQueueMessagesWaiting(workerActionQueue) > 0){
-            vTaskDelay(pdMS_TO_TICKS(5));
-        } else {
-            vTaskDelay(pdMS_TO_TICKS(50));
+            actionPool.give(action.d);
+        } else if (connCtx != nullptr and connCtx->getLinkPolicy()->isIdle(millis())) {
+            applyLinkMode(BLELNLinkPolicy::Mode::Idle);
         }
     }
 }
@@ -292,11 +500,34 @@ void BLELNClient::worker_registerConnection(uint16_t h) {
     }
     Serial.println("[D] BLELNClient - Client connected");
     connCtx = new BLELNConnCtx(h);
+    // Connected with fast parameters already (beginConnect), data length and PHY are left
+    connCtx->getLinkPolicy()->onActivity(millis());
+    applyLinkMode(BLELNLinkPolicy::Mode::Fast, false);
 
     if(discover()){
+        knownServer= client->getPeerAddress();
         connCtx->setState(BLELNConnCtx::State::WaitingForKey);
     } else {
         Serial.println("[E] BLELNClient - discover failed");
+        knownServer= NimBLEAddress();
+    }
+}
+
+void BLELNClient::worker_linkActivity() {
+    if (connCtx->getLinkPolicy()->onActivity(millis())) {
+        applyLinkMode(BLELNLinkPolicy::Mode::Fast);
+    }
+}
+
+void BLELNClient::applyLinkMode(BLELNLinkPolicy::Mode mode, bool updateParams) {
+    const BLELNLinkParams &p= BLELNLinkPolicy::paramsOf(mode);
+
+    if (updateParams) {
+        client->updateConnParams(p.itvlMin, p.itvlMax, p.latency, p.timeout);
+    }
+    if (connCtx->getLinkPolicy()->enter(mode)) {
+        client->setDataLen(BLELN_LINK_DATA_LEN);
+        client->updatePhy(BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, 0);
     }
 }
 
@@ -305,14 +536,46 @@ void BLELNClient::worker_deleteConnection() {
         delete connCtx;
         connCtx = nullptr; // Ważne!
     }
+    groupKey.clear();
+    groupFrags.reset();
 }
 
 void BLELNClient::worker_sendMessage(uint8_t *data, size_t dataLen) {
     std::string msg(reinterpret_cast<char*>(data), dataLen);
     std::string encMsg;
 
-    if(connCtx!= nullptr and connCtx->getSessionEnc()->encryptMessage(msg, encMsg)){
+    if(connCtx== nullptr or msg.size() > BLELN_MESSAGE_MAX_LEN){
+        return;
+    }
+
+    uint16_t mtu= client->getMTU();
+    size_t fragMaxLen= (mtu > 23) ? mtu - 3 : 20;
+    bool fragmented= connCtx->getSessionEnc()->getFrameVersion() >= BLELN_FRAME_V3;
+    if(fragmented and msg.size() + connCtx->getSessionEnc()->getFrameOverhead() > BLELNFragmenter::maxFrameLen(fragMaxLen)){
+        Serial.printf("[E] BLELNClient - Message too long for MTU %u\r\n", mtu);
+        return;
+    }
+
+    if(!connCtx->getSessionEnc()->encryptMessage(msg, encMsg)){
+        return;
+    }
+
+    if(!fragmented){
         chDataToSer->writeValue(encMsg, false);
+        return;
+    }
+
+    bool ok= BLELNFragmenter::send(encMsg, fragMaxLen, connCtx->nextTxMsgSeq(), [this](const std::string &frag){
+        for(int i=0; i<BLELN_FRAG_SEND_RETRIES; i++){
+            if(chDataToSer->writeValue(frag, false))
+                return true;
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        return false;
+    });
+
+    if(!ok){
+        Serial.println("[E] BLELNClient - Fragmented send failed");
     }
 }
 
@@ -320,25 +583,84 @@ void BLELNClient::worker_processKeyRx(uint8_t *data, size_t dataLen) {
     if(connCtx!= nullptr){
         if(connCtx->getState()==BLELNConnCtx::State::WaitingForKey){
             Serial.println("Received servers key");
-            if(handshake(data, dataLen)){
-                connCtx->setState(BLELNConnCtx::State::WaitingForCert);
-            } else {
+            if(resume(data, dataLen)){
+                pendingKeyEx.assign((const char*)data, dataLen);
+                connCtx->setState(BLELNConnCtx::State::WaitingForResume);
+            } else if(!handshake(data, dataLen)){
                 Serial.println("[E] BLELNClient - handshake failed");
                 disconnect(BLE_ERR_AUTH_FAIL);
                 connCtx->setState(BLELNConnCtx::State::AuthFailed);
             }
+        } else if(connCtx->getState()==BLELNConnCtx::State::WaitingForResume){
+            std::string plainKeyMsg;
+            std::string keyEx;
+            keyEx.swap(pendingKeyEx);
+
+            if(dataLen==strlen(BLELN_MSG_TITLE_RESUME_REJECT)
+               and memcmp(data, BLELN_MSG_TITLE_RESUME_REJECT, dataLen)==0){
+                // Server does not know my ticket anymore - full handshake with the same server key
+                Serial.println("[D] BLELNClient - ticket rejected");
+                dropTicket(client->getPeerAddress().getVal());
+                if(!handshake((uint8_t*)&keyEx[0], keyEx.size())){
+                    Serial.println("[E] BLELNClient - handshake failed");
+                    disconnect(BLE_ERR_AUTH_FAIL);
+                    connCtx->setState(BLELNConnCtx::State::AuthFailed);
+                }
+            } else if (connCtx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)
+                       and plainKeyMsg==BLELN_MSG_TITLE_RESUME_OK) {
+                connCtx->setState(BLELNConnCtx::State::Authorised);
+                Serial.println("[D] BLELNClient - auth success (resumed)");
+                Serial.printf("[D] BLELNClient - client %d live for %lu ms\r\n", connCtx->getHandle(), connCtx->getTimeOfLife());
+            } else {
+                dropTicket(client->getPeerAddress().getVal());
+                disconnect(BLE_ERR_AUTH_FAIL);
+                connCtx->setState(BLELNConnCtx::State::AuthFailed);
+            }
+        } else if(connCtx->getState()==BLELNConnCtx::State::WaitingForAuth){
+            // 1.5-RTT authentication - servers cert and answer
+            std::string plainKeyMsg;
+            BLELNCert cert;
+            uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
+            if(connCtx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)
+               and BLELNHandshakeMsg::readCertAndAnswer(plainKeyMsg, cert, nonceSign)){
+                if(authStore.verifyCert(cert)){
+                    connCtx->setCertData(cert.mac, cert.pubKey);
+                    connCtx->deriveTestNonce(false);
+                    if(connCtx->verifyChallengeResponseAnswer(nonceSign)){
+                        connCtx->setState(BLELNConnCtx::State::Authorised);
+                        Serial.println("[D] BLELNClient - auth success");
+                        Serial.printf("[D] BLELNClient - client %d live for %lu ms\r\n", connCtx->getHandle(), connCtx->getTimeOfLife());
+                    } else {
+                        Serial.println("[E] BLELNClient - WaitingForAuth - invalid sign");
+                        disconnect(BLE_ERR_AUTH_FAIL);
+                        connCtx->setState(BLELNConnCtx::State::AuthFailed);
+                    }
+                } else {
+                    Serial.println("[E] BLELNClient - WaitingForAuth - invalid cert");
+                    disconnect(BLE_ERR_AUTH_FAIL);
+                    connCtx->setState(BLELNConnCtx::State::AuthFailed);
+                }
+            } else {
+                Serial.println("[E] BLELNClient - WaitingForAuth - wrong message");
+                disconnect(BLE_ERR_AUTH_FAIL);
+                connCtx->setState(BLELNConnCtx::State::AuthFailed);
+            }
+        } else if(connCtx->getState()==BLELNConnCtx::State::Authorised){
+            std::string plainKeyMsg;
+            if (connCtx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
+                uint8_t ticket[BLELN_RESUME_TICKET_LEN];
+                uint32_t lifetimeS;
+                if (BLELNHandshakeMsg::readTicket(connCtx->isTlvHandshake(), plainKeyMsg, ticket, &lifetimeS)) {
+                    storeTicket(ticket, lifetimeS);
+                }
+            }
         } else if(connCtx->getState()==BLELNConnCtx::State::WaitingForCert){
             std::string plainKeyMsg;
             if (connCtx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
-                StringList parts= splitCsvRespectingQuotes(plainKeyMsg);
-                if(parts[0]==BLELN_MSG_TITLE_CERT and parts.size()==3){
-
-                    uint8_t gen;
-                    uint8_t fMac[6];
-                    uint8_t fPubKey[BLELN_DEV_PUB_KEY_LEN];
-
-                    if(authStore.verifyCert(parts[1], parts[2], &gen, fMac, 6, fPubKey, 64)){
-                        connCtx->setCertData(fMac, fPubKey);
+                BLELNCert cert;
+                if(BLELNHandshakeMsg::readCert(connCtx->isTlvHandshake(), plainKeyMsg, cert)){
+                    if(authStore.verifyCert(cert)){
+                        connCtx->setCertData(cert.mac, cert.pubKey);
                         sendCertToServer(connCtx);
                         connCtx->setState(BLELNConnCtx::State::ChallengeResponseCli);
                     } else {
@@ -358,9 +680,9 @@ void BLELNClient::worker_processKeyRx(uint8_t *data, size_t dataLen) {
         } else if(connCtx->getState()==BLELNConnCtx::State::ChallengeResponseCli) {
             std::string plainKeyMsg;
             if (connCtx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
-                StringList parts = splitCsvRespectingQuotes(plainKeyMsg);
-                if (parts[0] == BLELN_MSG_TITLE_CHALLENGE_RESPONSE_NONCE and parts.size() == 2) {
-                    sendChallengeNonceSign(connCtx, parts[1]);
+                uint8_t nonce[BLELN_TEST_NONCE_LEN];
+                if (BLELNHandshakeMsg::readChallengeNonce(connCtx->isTlvHandshake(), plainKeyMsg, nonce)) {
+                    sendChallengeNonceSign(connCtx, nonce);
                     connCtx->setState(BLELNConnCtx::State::ChallengeResponseSer);
                 } else {
                     disconnect(BLE_ERR_AUTH_FAIL);
@@ -373,18 +695,15 @@ void BLELNClient::worker_processKeyRx(uint8_t *data, size_t dataLen) {
         } else if(connCtx->getState()==BLELNConnCtx::State::ChallengeResponseSer) {
             std::string plainKeyMsg;
             if (connCtx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
-                StringList parts = splitCsvRespectingQuotes(plainKeyMsg);
-                if (parts[0] == BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW and parts.size() == 2) {
-                    uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
-                    Encryption::base64Decode(parts[1], nonceSign, BLELN_NONCE_SIGN_LEN);
+                uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
+                if (BLELNHandshakeMsg::readChallengeAnswer(connCtx->isTlvHandshake(), plainKeyMsg, nonceSign)) {
                     if(connCtx->verifyChallengeResponseAnswer(nonceSign)){
-                        std::string msg=BLELN_MSG_TITLE_AUTH_OK;
-                        msg.append(",1");
+                        std::string msg= BLELNHandshakeMsg::makeAuthOk(connCtx->isTlvHandshake());
                         std::string encMsg;
                         if(connCtx->getSessionEnc()->encryptMessage(msg, encMsg)) {
                             connCtx->setState(BLELNConnCtx::State::Authorised);
                             Serial.println("[D] BLELNClient - auth success");
-                            Serial.printf("[D] BLELNClient - client %d live for %d ms\r\n", connCtx->getHandle(), connCtx->getTimeOfLife());
+                            Serial.printf("[D] BLELNClient - client %d live for %lu ms\r\n", connCtx->getHandle(), connCtx->getTimeOfLife());
                             chKeyToSer->writeValue(encMsg, true);
                         } else {
                             Serial.println("[E] BLELNClient - failed encrypting cert msg");
@@ -409,10 +728,22 @@ void BLELNClient::worker_processKeyRx(uint8_t *data, size_t dataLen) {
 void BLELNClient::worker_processDataRx(uint8_t *data, size_t dataLen) {
     if(connCtx!= nullptr and connCtx->getSessionEnc()->getSessionId() != 0) {
         if(connCtx->getState()==BLELNConnCtx::State::Authorised) {
-            if (dataLen >= 4 + 12 + 16) {
+            std::string frame;
+            if (connCtx->getSessionEnc()->getFrameVersion() >= BLELN_FRAME_V3) {
+                if (connCtx->getReassembler()->push(data, dataLen, frame) != BLELNReassembler::Result::Complete)
+                    return;
+                data= (uint8_t*)frame.data();
+                dataLen= frame.size();
+            }
+
+            if (dataLen >= connCtx->getSessionEnc()->getFrameOverhead()) {
                 std::string plain;
                 if (connCtx->getSessionEnc()->decryptMessage(data, dataLen, plain)) {
-                    if (onMsgRx) {
+                    if (plain.rfind(BLELN_MSG_TITLE_GROUP_KEY ",", 0) == 0) {
+                        if (!groupKey.installFromMessage(plain))
+                            Serial.println("[E] BLELNClient - bad group key");
+                        groupFrags.reset();
+                    } else if (onMsgRx) {
                         onMsgRx(plain);
                     }
                 }
@@ -423,6 +754,22 @@ void BLELNClient::worker_processDataRx(uint8_t *data, size_t dataLen) {
     }
 }
 
+void BLELNClient::worker_processGroupRx(uint8_t *data, size_t dataLen) {
+    // Broadcasts come before group key only when server has not sent it yet - the same message comes in session then
+    if(connCtx== nullptr or connCtx->getState()!=BLELNConnCtx::State::Authorised or !groupKey.isReady()) {
+        return;
+    }
+
+    std::string frame;
+    if (groupFrags.push(data, dataLen, frame) != BLELNReassembler::Result::Complete)
+        return;
+
+    std::string plain;
+    if (groupKey.decrypt((const uint8_t*)frame.data(), frame.size(), plain) and onMsgRx) {
+        onMsgRx(plain);
+    }
+}
+
 void BLELNClient::onDisconnect(NimBLEClient *pClient, int reason) {
     appendActionToQueue(BLELN_WORKER_ACTION_DELETE_CONNECTION, pClient->getConnHandle(), nullptr, 0);
 }
@@ -433,6 +780,9 @@ void BLELNClient::onConnect(NimBLEClient *pClient) {
 
 void BLELNClient::onConnectFail(NimBLEClient *pClient, int reason) {
     appendActionToQueue(BLELN_WORKER_ACTION_DELETE_CONNECTION, pClient->getConnHandle(), nullptr, 0);
+    // Known server is gone (changed role, powered off) - next connection starts with scan
+    if(knownServerConnect)
+        knownServer= NimBLEAddress();
 
     if(onConRes)
         onConRes(false, reason);
@@ -443,12 +793,14 @@ void BLELNClient::disconnect(uint8_t reason) {
     Serial.printf("[D] BLELNClient - disconnected, reason: %d\r\n", reason);
     if(chKeyToCli) chKeyToCli->unsubscribe();
     if(chDataToCli) chDataToCli->unsubscribe();
+    if(chGroupToCli) chGroupToCli->unsubscribe();
 
     svc= nullptr;
     chKeyToCli = nullptr;
     chKeyToSer = nullptr;
     chDataToCli  = nullptr;
     chDataToSer  = nullptr;
+    chGroupToCli = nullptr;
 
     if(client) {
         client->disconnect();
@@ -456,23 +808,18 @@ void BLELNClient::disconnect(uint8_t reason) {
 }
 
 /*** Connection context not protected! */
-void BLELNClient::sendChallengeNonceSign(BLELNConnCtx *cx, const std::string &nonceB64) {
-    uint8_t nonceRaw[BLELN_TEST_NONCE_LEN];             // Servers nonce raw bytes
+void BLELNClient::sendChallengeNonceSign(BLELNConnCtx *cx, const uint8_t *nonce) {
     uint8_t friendsNonceSign[BLELN_NONCE_SIGN_LEN];     // Servers nonce sing I have created
 
     // Sign nonce
-    Encryption::base64Decode(nonceB64, nonceRaw, BLELN_TEST_NONCE_LEN);
-    authStore.signData(nonceRaw, BLELN_TEST_NONCE_LEN, friendsNonceSign);
+    authStore.signData(nonce, BLELN_TEST_NONCE_LEN, friendsNonceSign);
 
     // Create clients nonce
     cx->generateTestNonce();
-    std::string myNonceB64= cx->getTestNonceBase64();
 
     // Create BLE message
-    std::string msg= BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW_AND_NONCE;
-    std::string friendsNonceSignB64= Encryption::base64Encode(friendsNonceSign, BLELN_NONCE_SIGN_LEN);
-    msg.append(",").append(friendsNonceSignB64);
-    msg.append(",").append(myNonceB64);
+    std::string msg= BLELNHandshakeMsg::makeChallengeAnswerAndNonce(cx->isTlvHandshake(), friendsNonceSign,
+                                                                    cx->getTestNonce());
 
     std::string encMsg;
     if(cx->getSessionEnc()->encryptMessage(msg, encMsg)) {
@@ -484,8 +831,7 @@ void BLELNClient::sendChallengeNonceSign(BLELNConnCtx *cx, const std::string &no
 
 /*** Connection context not protected! */
 void BLELNClient::sendCertToServer(BLELNConnCtx *cx) {
-    std::string msg=BLELN_MSG_TITLE_CERT;
-    msg.append(",").append(authStore.getSignedCert());
+    std::string msg= BLELNHandshakeMsg::makeCert(cx->isTlvHandshake(), authStore.getCert());
 
     std::string encMsg;
     if(cx->getSessionEnc()->encryptMessage(msg, encMsg)) {
@@ -26,15 +26,31 @@
 #include "BLELNSessionEnc.h"
 #include "BLELNConnCtx.h"
 #include "BLELNAuthentication.h"
+#include "BLELNActionPool.h"
+#include "BLELNGroupKey.h"
+
+#include <list>
+
+#define BLELN_CONNECT_TIMEOUT_MS            30000   // Server just seen in scan
+#define BLELN_KNOWN_SERVER_CONNECT_MS       1000    // Direct connect to last server - several advertising intervals
 
 
 class BLELNClient : public NimBLEScanCallbacks, public NimBLEClientCallbacks{
 public:
     void start(const std::string &name, std::function<void(const std::string&)> onServerResponse);
     void stop();
-    void startServerSearch(uint32_t durationMs, const std::string &serverUUID, const std::function<void(const NimBLEAdvertisedDevice *advertisedDevice)>& onResult);
+    // onResult gets the first server found, or every server found (once) when firstOnly is not set. nullptr - scan ended.
+    void startServerSearch(uint32_t durationMs, const std::string &serverUUID, const std::function<void(const NimBLEAdvertisedDevice *advertisedDevice)>& onResult,
+                           bool firstOnly=true);
+    void stopServerSearch();
     void beginConnect(const NimBLEAdvertisedDevice *advertisedDevice, const std::function<void(bool, int)> &onConnectResult);
+    void beginConnect(const NimBLEAddress &address, const std::function<void(bool, int)> &onConnectResult);
+    // Connects to the last server that had BLELN service, without scan. Fails fast when it does not answer.
+    bool beginConnectKnown(const std::function<void(bool, int)> &onConnectResult);
+    bool hasKnownServer() const;
     void sendEncrypted(const std::string& msg);
+    // Makes idle link fast - parameters update takes a few idle connection events, so it is asked ahead of requests
+    void wakeLink();
     void disconnect(uint8_t reason=BLE_ERR_REM_USER_CONN_TERM);
 
     bool isScanning() const;
@@ -57,33 +73,64 @@ private:
     void worker_sendMessage(uint8_t *data, size_t dataLen);
     void worker_processKeyRx(uint8_t *data, size_t dataLen);
     void worker_processDataRx(uint8_t *data, size_t dataLen);
+    void worker_processGroupRx(uint8_t *data, size_t dataLen);
+    void worker_linkActivity();
+    void applyLinkMode(BLELNLinkPolicy::Mode mode, bool updateParams=true);
+    void connectTo(const NimBLEAddress &address, uint32_t timeoutMs, const std::function<void(bool, int)> &onConnectResult);
 
     void sendCertToServer(BLELNConnCtx *cx);
-    void sendChallengeNonceSign(BLELNConnCtx *cx, const std::string &nonceB64);
+    void sendChallengeNonceSign(BLELNConnCtx *cx, const uint8_t *nonce);
     bool discover();
+    bool parseKeyEx(const uint8_t *v, size_t vlen, uint8_t *frameVer, uint8_t *flags, uint32_t *epoch, uint8_t *salt,
+                    uint8_t *srvPub, uint8_t *srvNonce);
     bool handshake(uint8_t *v, size_t vlen);
+    bool resume(uint8_t *v, size_t vlen);
+    void storeTicket(const uint8_t *ticket, uint32_t lifetimeS);
 
     void onKeyTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
-                       __attribute__((unused)) uint8_t* pData, __attribute__((unused)) __attribute__((unused)) size_t length,
-                       __attribute__((unused)) bool isNotify);
-    void onDataTxNotify(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, __attribute__((unused)) uint8_t* pData,
-                        __attribute__((unused)) size_t length, __attribute__((unused)) bool isNotify);
+                       uint8_t* pData, size_t length, __attribute__((unused)) bool isNotify);
+    void onDataTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
+                        uint8_t* pData, size_t length, __attribute__((unused)) bool isNotify);
+    void onGroupTxNotify(__attribute__((unused)) NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
+                         uint8_t* pData, size_t length, __attribute__((unused)) bool isNotify);
 
     NimBLEClient* client=nullptr;
     NimBLERemoteService* svc=nullptr;
     NimBLERemoteCharacteristic *chKeyToCli=nullptr,*chKeyToSer=nullptr,*chDataToCli=nullptr,*chDataToSer=nullptr;
+    NimBLERemoteCharacteristic *chGroupToCli=nullptr;     // Optional - older servers have no broadcasts
+    uint8_t serverCaps= 0;                                // Capabilities characteristic value, 0 - older server
 
     bool scanning = false;
     std::function<void(const NimBLEAdvertisedDevice *advertisedDevice)> onScanResult;
     std::string searchedUUID;
+    bool searchFirstOnly= true;
 
     std::function<void(const std::string&)> onMsgRx;
     std::function<void(bool, int)> onConRes;
 
+    NimBLEAddress knownServer;      // Null - next connection needs scan
+    bool knownServerConnect= false; // Current connection attempt is direct one
+
     QueueHandle_t workerActionQueue;
+    BLELNActionPool actionPool;
 
     BLELNConnCtx *connCtx= nullptr;
     BLELNAuthentication authStore;
+    BLELNGroupKey groupKey;         // Servers broadcasts key, of current connection
+    BLELNReassembler groupFrags;
+
+    // Session resumption tickets from servers I was connected with
+    struct ResumeTicket {
+        uint8_t server[6];
+        uint8_t ticket[BLELN_RESUME_TICKET_LEN];
+        uint8_t secret[BLELN_RESUME_SECRET_LEN];
+        unsigned long expiresAt;
+    };
+    std::list<ResumeTicket> tickets;
+    std::string pendingKeyEx;  // Servers key exchange message, kept for full handshake if ticket is rejected
+
+    ResumeTicket* findTicket(const uint8_t *server);
+    void dropTicket(const uint8_t *server);
 
     bool runWorker=false;
     TaskHandle_t workerTaskHandle = nullptr;
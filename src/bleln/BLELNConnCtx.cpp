@@ -58,15 +58,59 @@ BLELNSessionEnc *BLELNConnCtx::getSessionEnc() {
     return &bse;
 }
 
+BLELNReassembler *BLELNConnCtx::getReassembler() {
+    return &rxFrags;
+}
+
+uint8_t BLELNConnCtx::nextTxMsgSeq() {
+    return txMsgSeq++;
+}
+
+BLELNTxQueue *BLELNConnCtx::getTxQueue() {
+    return &txQueue;
+}
+
+BLELNLinkPolicy *BLELNConnCtx::getLinkPolicy() {
+    return &linkPolicy;
+}
+
+void BLELNConnCtx::setGroupSubscribed(bool subscribed) {
+    groupSubscribed= subscribed;
+}
+
+bool BLELNConnCtx::isGroupSubscribed() const {
+    return groupSubscribed;
+}
+
+void BLELNConnCtx::setGroupKeyId(uint8_t keyId) {
+    groupKeyId= keyId;
+}
+
+uint8_t BLELNConnCtx::getGroupKeyId() const {
+    return groupKeyId;
+}
+
 void BLELNConnCtx::setCertData(uint8_t *macAddress, uint8_t *publicKey) {
     memcpy(mac6, macAddress, 6);
     memcpy(pubKey64, publicKey, BLELN_DEV_PUB_KEY_LEN);
 }
 
+const uint8_t *BLELNConnCtx::getMac() const {
+    return mac6;
+}
+
+const uint8_t *BLELNConnCtx::getPubKey() const {
+    return pubKey64;
+}
+
 void BLELNConnCtx::generateTestNonce() {
     Encryption::random_bytes(testNonce48, BLELN_TEST_NONCE_LEN);
 }
 
+void BLELNConnCtx::deriveTestNonce(bool friendIsClient) {
+    bse.makeAuthTestNonce(friendIsClient, testNonce48);
+}
+
 
 bool BLELNConnCtx::verifyChallengeResponseAnswer(uint8_t *nonceSign) {
     return Encryption::verifySign_ECDSA_P256(testNonce48, BLELN_TEST_NONCE_LEN, nonceSign,
@@ -77,8 +121,12 @@ uint8_t *BLELNConnCtx::getTestNonce() {
     return testNonce48;
 }
 
-std::string BLELNConnCtx::getTestNonceBase64() {
-    return Encryption::base64Encode(testNonce48, BLELN_TEST_NONCE_LEN);
+void BLELNConnCtx::setTlvHandshake(bool tlv) {
+    tlvHandshake= tlv;
+}
+
+bool BLELNConnCtx::isTlvHandshake() const {
+    return tlvHandshake;
 }
 
 unsigned long BLELNConnCtx::getTimeOfLife() const {
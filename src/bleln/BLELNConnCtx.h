@@ -23,13 +23,16 @@
 
 #include <Arduino.h>
 #include "BLELNSessionEnc.h"
+#include "BLELNFragment.h"
+#include "BLELNTxQueue.h"
+#include "BLELNLinkPolicy.h"
 #include "BLELNBase.h"
 #include "Encryption.h"
 
 
 class BLELNConnCtx {
 public:
-    enum class State {New, Initialised, WaitingForKey, WaitingForCert, ChallengeResponseCli ,ChallengeResponseSer, Authorised, AuthFailed};
+    enum class State {New, Initialised, WaitingForKey, WaitingForResume, WaitingForAuth, WaitingForCert, ChallengeResponseCli ,ChallengeResponseSer, Authorised, AuthFailed};
     explicit BLELNConnCtx(uint16_t handle);
     ~BLELNConnCtx();
 
@@ -38,14 +41,26 @@ public:
     State getState();
 
     void setCertData(uint8_t *macAddress, uint8_t *publicKey);
+    const uint8_t* getMac() const;
+    const uint8_t* getPubKey() const;
     void generateTestNonce();
+    void deriveTestNonce(bool friendIsClient);  // 1.5-RTT authentication - nonce from session secret
     uint8_t* getTestNonce();
-    std::string getTestNonceBase64();
     bool verifyChallengeResponseAnswer(uint8_t *nonceSign);
 
     bool makeSessionKey();
 
     BLELNSessionEnc* getSessionEnc();
+    BLELNReassembler* getReassembler();
+    uint8_t nextTxMsgSeq();
+    BLELNTxQueue* getTxQueue();
+    BLELNLinkPolicy* getLinkPolicy();
+    void setTlvHandshake(bool tlv);
+    bool isTlvHandshake() const;
+    void setGroupSubscribed(bool subscribed);
+    bool isGroupSubscribed() const;
+    void setGroupKeyId(uint8_t keyId);
+    uint8_t getGroupKeyId() const;      // 0 - client has no group key
 
     unsigned long getTimeOfLife() const;
 private:
@@ -57,8 +72,15 @@ private:
     uint8_t pubKey64[BLELN_DEV_PUB_KEY_LEN]; // Public key of this other device i'm connecting with
     uint8_t mac6[6]; // and its mac address
     uint8_t testNonce48[BLELN_TEST_NONCE_LEN];
+    bool tlvHandshake= false;   // Handshake messages encoding negotiated in key exchange
 
     BLELNSessionEnc bse;
+    BLELNReassembler rxFrags;   // Data messages of frame v3 come in fragments
+    uint8_t txMsgSeq= 0;
+    BLELNTxQueue txQueue;       // Server - notifications waiting for stack buffers
+    BLELNLinkPolicy linkPolicy;
+    bool groupSubscribed= false;
+    uint8_t groupKeyId= 0;
 };
 
 
@@ -0,0 +1,103 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNConnTable.h"
+
+
+BLELNConnTable::BLELNConnTable() {
+    for(auto &h: handles){
+        h= BLE_HS_CONN_HANDLE_NONE;
+    }
+}
+
+BLELNConnTable::~BLELNConnTable() {
+    clear();
+}
+
+BLELNConnCtx *BLELNConnTable::find(uint16_t h) {
+    int slot= findSlot(h);
+    return (slot >= 0) ? ctxAt(slot) : nullptr;
+}
+
+BLELNConnCtx *BLELNConnTable::add(uint16_t h) {
+    if(h == BLE_HS_CONN_HANDLE_NONE){
+        return nullptr;
+    }
+
+    int slot= findSlot(h);
+    if(slot >= 0){
+        return ctxAt(slot);
+    }
+
+    for(uint8_t i=0; i<BLELN_CONN_TABLE_SIZE; i++){
+        uint8_t s= (h + i) % BLELN_CONN_TABLE_SIZE;
+        if(handles[s] == BLE_HS_CONN_HANDLE_NONE){
+            auto *c= new (mem[s]) BLELNConnCtx(h);
+            handles[s]= h;
+            cnt.fetch_add(1);
+            return c;
+        }
+    }
+
+    return nullptr;
+}
+
+void BLELNConnTable::remove(uint16_t h) {
+    int slot= findSlot(h);
+    if(slot < 0){
+        return;
+    }
+
+    ctxAt(slot)->~BLELNConnCtx();
+    handles[slot]= BLE_HS_CONN_HANDLE_NONE;
+    cnt.fetch_sub(1);
+}
+
+void BLELNConnTable::clear() {
+    for(uint8_t i=0; i<BLELN_CONN_TABLE_SIZE; i++){
+        if(handles[i] != BLE_HS_CONN_HANDLE_NONE){
+            ctxAt(i)->~BLELNConnCtx();
+            handles[i]= BLE_HS_CONN_HANDLE_NONE;
+        }
+    }
+    cnt.store(0);
+}
+
+uint8_t BLELNConnTable::count() const {
+    return cnt.load();
+}
+
+BLELNConnCtx *BLELNConnTable::ctxAt(uint8_t slot) {
+    return reinterpret_cast<BLELNConnCtx*>(mem[slot]);
+}
+
+int BLELNConnTable::findSlot(uint16_t h) const {
+    if(h == BLE_HS_CONN_HANDLE_NONE){
+        return -1;
+    }
+
+    for(uint8_t i=0; i<BLELN_CONN_TABLE_SIZE; i++){
+        uint8_t s= (h + i) % BLELN_CONN_TABLE_SIZE;
+        if(handles[s] == h)
+            return s;
+    }
+
+    return -1;
+}
@@ -0,0 +1,74 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNCONNTABLE_H
+#define MGLIGHTFW_BLELNCONNTABLE_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include <atomic>
+#include <new>
+#include "BLELNConnCtx.h"
+
+#define BLELN_CONN_TABLE_SIZE   CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define BLELN_EVICT_MIN_IDLE_MS 5000    // Client quiet for less is never dropped to free a slot
+
+
+/**
+ * Fixed capacity table of connection contexts, stored in place (no heap node per connection).
+ * Context of handle h lives in slot h % size when free - the rest of slots is checked only on collision.
+ * Only one thread (server worker) may add and remove, count can be read from any thread.
+ */
+class BLELNConnTable {
+public:
+    BLELNConnTable();
+    ~BLELNConnTable();
+
+    BLELNConnTable(const BLELNConnTable&) = delete;
+    BLELNConnTable& operator=(const BLELNConnTable&) = delete;
+
+    BLELNConnCtx* find(uint16_t h);
+    // Returns nullptr when table is full
+    BLELNConnCtx* add(uint16_t h);
+    void remove(uint16_t h);
+    void clear();
+
+    /*** Multithreading safe */
+    uint8_t count() const;
+
+    template<typename Fn>
+    void forEach(Fn fn) {
+        for(uint8_t i=0; i<BLELN_CONN_TABLE_SIZE; i++){
+            if(handles[i] != BLE_HS_CONN_HANDLE_NONE)
+                fn(*ctxAt(i));
+        }
+    }
+
+private:
+    BLELNConnCtx* ctxAt(uint8_t slot);
+    int findSlot(uint16_t h) const;
+
+    alignas(BLELNConnCtx) uint8_t mem[BLELN_CONN_TABLE_SIZE][sizeof(BLELNConnCtx)];
+    uint16_t handles[BLELN_CONN_TABLE_SIZE];
+    std::atomic<uint8_t> cnt{0};
+};
+
+
+#endif //MGLIGHTFW_BLELNCONNTABLE_H
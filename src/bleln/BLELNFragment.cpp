@@ -0,0 +1,107 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNFragment.h"
+
+
+bool BLELNFragmenter::send(const std::string &frame, size_t fragMaxLen, uint8_t msgSeq,
+                           const std::function<bool(const std::string &)> &sendFragment) {
+    if(fragMaxLen <= BLELN_FRAG_HDR_LEN or frame.size() > BLELN_FRAG_FRAME_MAX_LEN){
+        return false;
+    }
+
+    size_t chunkMax= fragMaxLen - BLELN_FRAG_HDR_LEN;
+    size_t fragCnt= (frame.size() + chunkMax - 1) / chunkMax;
+    if(fragCnt == 0 or fragCnt > BLELN_FRAG_IDX_MASK + 1){
+        return false;
+    }
+
+    std::string frag;
+    frag.reserve(fragMaxLen);
+    for(size_t i=0; i<fragCnt; i++){
+        size_t off= i*chunkMax;
+        size_t len= (frame.size()-off < chunkMax) ? frame.size()-off : chunkMax;
+
+        frag.clear();
+        frag.push_back((char)msgSeq);
+        frag.push_back((char)(i | ((i+1 == fragCnt) ? BLELN_FRAG_LAST_FLAG : 0)));
+        frag.append(frame, off, len);
+
+        if(!sendFragment(frag)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t BLELNFragmenter::maxFrameLen(size_t fragMaxLen) {
+    if(fragMaxLen <= BLELN_FRAG_HDR_LEN){
+        return 0;
+    }
+
+    size_t l= (BLELN_FRAG_IDX_MASK + 1) * (fragMaxLen - BLELN_FRAG_HDR_LEN);
+    return (l < BLELN_FRAG_FRAME_MAX_LEN) ? l : BLELN_FRAG_FRAME_MAX_LEN;
+}
+
+
+BLELNReassembler::Result BLELNReassembler::push(const uint8_t *frag, size_t fragLen, std::string &frameOut) {
+    if(fragLen <= BLELN_FRAG_HDR_LEN){
+        reset();
+        return Result::Dropped;
+    }
+
+    uint8_t fSeq= frag[0];
+    uint8_t idx= frag[1] & BLELN_FRAG_IDX_MASK;
+    bool last= frag[1] & BLELN_FRAG_LAST_FLAG;
+
+    if(idx == 0){
+        // New message - unfinished one (if any) is lost
+        buf.clear();
+        seq= fSeq;
+    } else if(nextIdx == 0 or idx != nextIdx or fSeq != seq){
+        reset();
+        return Result::Dropped;
+    }
+
+    if(buf.size() + fragLen - BLELN_FRAG_HDR_LEN > BLELN_FRAG_FRAME_MAX_LEN){
+        reset();
+        return Result::Dropped;
+    }
+    buf.append((const char*)frag + BLELN_FRAG_HDR_LEN, fragLen - BLELN_FRAG_HDR_LEN);
+
+    if(last){
+        // Copied out, so buffer keeps its capacity for the next message
+        frameOut.assign(buf);
+        reset();
+        return Result::Complete;
+    }
+
+    nextIdx= idx + 1;
+    return Result::Pending;
+}
+
+void BLELNReassembler::reset() {
+    buf.clear();
+    // Only after unusually long message - usual ones reuse the buffer without heap traffic
+    if(buf.capacity() > BLELN_FRAG_KEEP_CAPACITY)
+        buf.shrink_to_fit();
+    nextIdx= 0;
+}
@@ -0,0 +1,66 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNFRAGMENT_H
+#define MGLIGHTFW_BLELNFRAGMENT_H
+
+#include <Arduino.h>
+#include <functional>
+#include "BLELNBase.h"
+
+// Fragment: [msgSeq:1][last:1b|idx:7b][chunk], chunks of all fragments of one message make its encrypted frame
+#define BLELN_FRAG_HDR_LEN          2
+#define BLELN_FRAG_LAST_FLAG        0x80
+#define BLELN_FRAG_IDX_MASK         0x7F
+#define BLELN_FRAG_FRAME_MAX_LEN    (BLELN_MESSAGE_MAX_LEN + 4 + 12 + 16)   // v1 frame overhead is the biggest
+#define BLELN_FRAG_SEND_RETRIES     5       // Per fragment, 10 ms apart, when stack has no free TX buffers
+#define BLELN_FRAG_KEEP_CAPACITY    512     // Reassembly buffer is kept between messages up to one max ATT MTU
+
+
+class BLELNFragmenter {
+public:
+    // Splits frame into fragments of at most fragMaxLen bytes (ATT MTU - 3) and passes them to send one by one.
+    // Stops on first send failure.
+    static bool send(const std::string &frame, size_t fragMaxLen, uint8_t msgSeq,
+                     const std::function<bool(const std::string&)> &sendFragment);
+    // Longest frame which fits in 128 fragments (7-bit index) - at default ATT MTU it is below BLELN_MESSAGE_MAX_LEN
+    static size_t maxFrameLen(size_t fragMaxLen);
+};
+
+
+/**
+ * Reassembly buffer of one connection direction. Fragments come in order (ATT is reliable), so any gap
+ * means lost message - it is dropped and the next one starts clean.
+ */
+class BLELNReassembler {
+public:
+    enum class Result {Pending, Complete, Dropped};
+
+    Result push(const uint8_t *frag, size_t fragLen, std::string &frameOut);
+    void reset();
+
+private:
+    std::string buf;
+    uint8_t seq= 0;
+    uint8_t nextIdx= 0;     // 0 - waiting for first fragment
+};
+
+
+#endif //MGLIGHTFW_BLELNFRAGMENT_H
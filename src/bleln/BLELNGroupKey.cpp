@@ -0,0 +1,166 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNGroupKey.h"
+#include "Encryption.h"
+#include "SuperString.h"
+#include <mbedtls/platform_util.h>
+
+
+BLELNGroupKey::BLELNGroupKey() {
+    mbedtls_gcm_init(&gcm);
+}
+
+BLELNGroupKey::~BLELNGroupKey() {
+    clear();
+    mbedtls_gcm_free(&gcm);
+}
+
+bool BLELNGroupKey::generate() {
+    uint8_t k[BLELN_GROUP_KEY_LEN];
+    Encryption::random_bytes(k, sizeof(k));
+
+    // Key id 0 means "no key" on the client side
+    uint8_t id= keyId + 1;
+    if(id == 0) id= 1;
+
+    bool r= install(id, 0, k);
+    if(r){
+        memcpy(key, k, sizeof(key));
+    }
+    mbedtls_platform_zeroize(k, sizeof(k));
+    return r;
+}
+
+std::string BLELNGroupKey::makeKeyMessage() const {
+    return std::string(BLELN_MSG_TITLE_GROUP_KEY) + "," + std::to_string(keyId) + "," + std::to_string(lastCtr) + ","
+           + Encryption::base64Encode((uint8_t*)key, sizeof(key));
+}
+
+bool BLELNGroupKey::encrypt(const std::string &in, std::string &out) {
+    if(!keyed or lastCtr == UINT32_MAX){
+        return false;
+    }
+
+    lastCtr++;
+    uint8_t iv[12];
+    uint8_t aad[12];
+    uint8_t tag[16];
+    makeNonce(lastCtr, iv);
+    makeAAD(aad);
+
+    std::string ct;
+    ct.resize(in.length());
+    if(!Encryption::encryptAESGCM(&gcm, &in, iv, tag, aad, &ct)){
+        return false;
+    }
+
+    uint8_t hdr[5]= {keyId, (uint8_t)(lastCtr>>24), (uint8_t)(lastCtr>>16), (uint8_t)(lastCtr>>8), (uint8_t)lastCtr};
+    out.erase();
+    out.reserve(BLELN_GROUP_FRAME_OVERHEAD + ct.size());
+    out.append((char*)hdr, sizeof(hdr));
+    out.append(ct);
+    out.append((char*)tag, 16);
+    return true;
+}
+
+bool BLELNGroupKey::installFromMessage(const std::string &msg) {
+    StringList parts= split(msg, ',');
+    if(parts.size() != 4 or parts[0] != BLELN_MSG_TITLE_GROUP_KEY){
+        return false;
+    }
+
+    long id= strtol(parts[1].c_str(), nullptr, 10);
+    uint32_t ctr= strtoul(parts[2].c_str(), nullptr, 10);
+    uint8_t k[BLELN_GROUP_KEY_LEN];
+    if(id <= 0 or id > 255 or Encryption::base64Decode(parts[3], k, sizeof(k)) != sizeof(k)){
+        return false;
+    }
+
+    bool r= install((uint8_t)id, ctr, k);
+    mbedtls_platform_zeroize(k, sizeof(k));
+    return r;
+}
+
+bool BLELNGroupKey::decrypt(const uint8_t *in, size_t inLen, std::string &out) {
+    if(!keyed or inLen < BLELN_GROUP_FRAME_OVERHEAD or in[0] != keyId){
+        return false;
+    }
+
+    uint32_t ctr= ((uint32_t)in[1]<<24) | ((uint32_t)in[2]<<16) | ((uint32_t)in[3]<<8) | in[4];
+    if(ctr <= lastCtr){
+        return false;
+    }
+
+    uint8_t iv[12];
+    uint8_t aad[12];
+    makeNonce(ctr, iv);
+    makeAAD(aad);
+
+    size_t ctLen= inLen - BLELN_GROUP_FRAME_OVERHEAD;
+    if(!Encryption::decryptAESGCM(&gcm, in + 5, ctLen, iv, in + 5 + ctLen, aad, &out)){
+        return false;
+    }
+
+    lastCtr= ctr;
+    return true;
+}
+
+void BLELNGroupKey::clear() {
+    mbedtls_platform_zeroize(key, sizeof(key));
+    mbedtls_gcm_free(&gcm);
+    mbedtls_gcm_init(&gcm);
+    keyed= false;
+    lastCtr= 0;
+}
+
+bool BLELNGroupKey::isReady() const {
+    return keyed;
+}
+
+uint8_t BLELNGroupKey::getKeyId() const {
+    return keyed ? keyId : 0;
+}
+
+bool BLELNGroupKey::install(uint8_t id, uint32_t ctr, uint8_t *key32) {
+    clear();
+    keyed= mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key32, BLELN_GROUP_KEY_LEN*8) == 0;
+    keyId= id;
+    lastCtr= ctr;
+    return keyed;
+}
+
+void BLELNGroupKey::makeNonce(uint32_t ctr, uint8_t *nonce) const {
+    // nonce = "GRP" | keyId | 0 | ctr(BE), key is random per key id and ctr never repeats within it
+    memcpy(nonce, "GRP", 3);
+    nonce[3]= keyId;
+    memset(nonce + 4, 0, 4);
+    nonce[8]= (uint8_t)(ctr >> 24);
+    nonce[9]= (uint8_t)(ctr >> 16);
+    nonce[10]= (uint8_t)(ctr >> 8);
+    nonce[11]= (uint8_t)ctr;
+}
+
+void BLELNGroupKey::makeAAD(uint8_t *aad) const {
+    // AAD = "GROUPv1" | 0 | keyId | 0 0 0
+    memset(aad, 0, 12);
+    memcpy(aad, "GROUPv1", 7);
+    aad[8]= keyId;
+}
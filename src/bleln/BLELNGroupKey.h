@@ -0,0 +1,70 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNGROUPKEY_H
+#define MGLIGHTFW_BLELNGROUPKEY_H
+
+#include <Arduino.h>
+#include <mbedtls/gcm.h>
+
+#define BLELN_GROUP_KEY_LEN             32
+#define BLELN_GROUP_FRAME_OVERHEAD      (1 + 4 + 16)    // [keyId:1][ctr:4][ct][tag:16]
+#define BLELN_MSG_TITLE_GROUP_KEY       "$GKEY"         // $GKEY,keyId,ctr,key(base64) - sent in client session
+
+
+/**
+ * Server wide key of broadcasts. Server makes it and hands it over to every authorised client that
+ * subscribed to group characteristic, so message for all clients is encrypted once and every client gets
+ * the same frame. Key is replaced after any of its holders disconnects, before the next broadcast.
+ */
+class BLELNGroupKey {
+public:
+    BLELNGroupKey();
+    ~BLELNGroupKey();
+    BLELNGroupKey(const BLELNGroupKey&) = delete;
+    BLELNGroupKey& operator=(const BLELNGroupKey&) = delete;
+
+    // Server - new random key with next key id
+    bool generate();
+    std::string makeKeyMessage() const;
+    bool encrypt(const std::string &in, std::string &out);
+
+    // Client
+    bool installFromMessage(const std::string &msg);
+    bool decrypt(const uint8_t *in, size_t inLen, std::string &out);
+
+    void clear();
+    bool isReady() const;
+    uint8_t getKeyId() const;
+
+private:
+    bool install(uint8_t id, uint32_t ctr, uint8_t *key32);
+    void makeNonce(uint32_t ctr, uint8_t *nonce) const;
+    void makeAAD(uint8_t *aad) const;
+
+    mbedtls_gcm_context gcm{};
+    uint8_t key[BLELN_GROUP_KEY_LEN]{};     // Kept by server only, for key messages
+    uint8_t keyId= 0;
+    uint32_t lastCtr= 0;                    // Server - last sent, client - last received (anti-replay)
+    bool keyed= false;
+};
+
+
+#endif //MGLIGHTFW_BLELNGROUPKEY_H
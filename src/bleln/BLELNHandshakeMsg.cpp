@@ -0,0 +1,264 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNHandshakeMsg.h"
+#include "Encryption.h"
+#include "SuperString.h"
+
+
+std::string BLELNHandshakeMsg::makeCert(bool tlv, const BLELNCert &cert) {
+    std::string out;
+
+    if(tlv){
+        out.push_back(BLELN_TLV_MSG_CERT);
+        tlvAppend(out, BLELN_TLV_TAG_GEN, &cert.gen, 1);
+        tlvAppend(out, BLELN_TLV_TAG_MAC, cert.mac, 6);
+        tlvAppend(out, BLELN_TLV_TAG_PUB_KEY, cert.pubKey, BLELN_DEV_PUB_KEY_LEN);
+        tlvAppend(out, BLELN_TLV_TAG_CERT_SIGN, cert.sign, BLELN_MANU_SIGN_LEN);
+    } else {
+        out= BLELN_MSG_TITLE_CERT;
+        out.append(",").append(cert.text);
+        out.append(",").append(Encryption::base64Encode((uint8_t*)cert.sign, BLELN_MANU_SIGN_LEN));
+    }
+
+    return out;
+}
+
+bool BLELNHandshakeMsg::readCert(bool tlv, const std::string &msg, BLELNCert &out) {
+    if(tlv){
+        out.text.clear();
+        return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_CERT
+               and tlvGet(msg, BLELN_TLV_TAG_GEN, &out.gen, 1)
+               and tlvGet(msg, BLELN_TLV_TAG_MAC, out.mac, 6)
+               and tlvGet(msg, BLELN_TLV_TAG_PUB_KEY, out.pubKey, BLELN_DEV_PUB_KEY_LEN)
+               and tlvGet(msg, BLELN_TLV_TAG_CERT_SIGN, out.sign, BLELN_MANU_SIGN_LEN);
+    }
+
+    // $CERT,gen;mac;pubKey,sign
+    StringList parts= splitCsvRespectingQuotes(msg);
+    if(parts.size()!=3 or parts[0]!=BLELN_MSG_TITLE_CERT){
+        return false;
+    }
+
+    StringList certSplit= splitCsvRespectingQuotes(parts[1], ';');
+    if(certSplit.size()!=3){
+        return false;
+    }
+
+    try {
+        out.gen= std::stoi(certSplit[0], nullptr, 10);
+    } catch (std::invalid_argument &e){
+        return false;
+    } catch (std::out_of_range &e) {
+        return false;
+    }
+
+    if(!b64Get(certSplit[1], out.mac, 6) or !b64Get(certSplit[2], out.pubKey, BLELN_DEV_PUB_KEY_LEN)
+       or !b64Get(parts[2], out.sign, BLELN_MANU_SIGN_LEN)){
+        return false;
+    }
+
+    out.text= parts[1];
+    return true;
+}
+
+std::string BLELNHandshakeMsg::makeChallengeNonce(bool tlv, const uint8_t *nonce) {
+    std::string out;
+
+    if(tlv){
+        out.push_back(BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE);
+        tlvAppend(out, BLELN_TLV_TAG_NONCE, nonce, BLELN_TEST_NONCE_LEN);
+    } else {
+        out= BLELN_MSG_TITLE_CHALLENGE_RESPONSE_NONCE;
+        out.append(",").append(Encryption::base64Encode((uint8_t*)nonce, BLELN_TEST_NONCE_LEN));
+    }
+
+    return out;
+}
+
+bool BLELNHandshakeMsg::readChallengeNonce(bool tlv, const std::string &msg, uint8_t *nonceOut) {
+    if(tlv){
+        return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE
+               and tlvGet(msg, BLELN_TLV_TAG_NONCE, nonceOut, BLELN_TEST_NONCE_LEN);
+    }
+
+    StringList parts= splitCsvRespectingQuotes(msg);
+    return parts.size()==2 and parts[0]==BLELN_MSG_TITLE_CHALLENGE_RESPONSE_NONCE
+           and b64Get(parts[1], nonceOut, BLELN_TEST_NONCE_LEN);
+}
+
+std::string BLELNHandshakeMsg::makeChallengeAnswerAndNonce(bool tlv, const uint8_t *nonceSign, const uint8_t *nonce) {
+    std::string out;
+
+    if(tlv){
+        out.push_back(BLELN_TLV_MSG_CHALLENGE_RESPONSE_ANSW_AND_NONCE);
+        tlvAppend(out, BLELN_TLV_TAG_NONCE_SIGN, nonceSign, BLELN_NONCE_SIGN_LEN);
+        tlvAppend(out, BLELN_TLV_TAG_NONCE, nonce, BLELN_TEST_NONCE_LEN);
+    } else {
+        out= BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW_AND_NONCE;
+        out.append(",").append(Encryption::base64Encode((uint8_t*)nonceSign, BLELN_NONCE_SIGN_LEN));
+        out.append(",").append(Encryption::base64Encode((uint8_t*)nonce, BLELN_TEST_NONCE_LEN));
+    }
+
+    return out;
+}
+
+bool BLELNHandshakeMsg::readChallengeAnswerAndNonce(bool tlv, const std::string &msg, uint8_t *nonceSignOut,
+                                                    uint8_t *nonceOut) {
+    if(tlv){
+        return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_CHALLENGE_RESPONSE_ANSW_AND_NONCE
+               and tlvGet(msg, BLELN_TLV_TAG_NONCE_SIGN, nonceSignOut, BLELN_NONCE_SIGN_LEN)
+               and tlvGet(msg, BLELN_TLV_TAG_NONCE, nonceOut, BLELN_TEST_NONCE_LEN);
+    }
+
+    StringList parts= splitCsvRespectingQuotes(msg);
+    return parts.size()==3 and parts[0]==BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW_AND_NONCE
+           and b64Get(parts[1], nonceSignOut, BLELN_NONCE_SIGN_LEN)
+           and b64Get(parts[2], nonceOut, BLELN_TEST_NONCE_LEN);
+}
+
+std::string BLELNHandshakeMsg::makeChallengeAnswer(bool tlv, const uint8_t *nonceSign) {
+    std::string out;
+
+    if(tlv){
+        out.push_back(BLELN_TLV_MSG_CHALLENGE_RESPONSE_ANSW);
+        tlvAppend(out, BLELN_TLV_TAG_NONCE_SIGN, nonceSign, BLELN_NONCE_SIGN_LEN);
+    } else {
+        out= BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW;
+        out.append(",").append(Encryption::base64Encode((uint8_t*)nonceSign, BLELN_NONCE_SIGN_LEN));
+    }
+
+    return out;
+}
+
+bool BLELNHandshakeMsg::readChallengeAnswer(bool tlv, const std::string &msg, uint8_t *nonceSignOut) {
+    if(tlv){
+        return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_CHALLENGE_RESPONSE_ANSW
+               and tlvGet(msg, BLELN_TLV_TAG_NONCE_SIGN, nonceSignOut, BLELN_NONCE_SIGN_LEN);
+    }
+
+    StringList parts= splitCsvRespectingQuotes(msg);
+    return parts.size()==2 and parts[0]==BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW
+           and b64Get(parts[1], nonceSignOut, BLELN_NONCE_SIGN_LEN);
+}
+
+std::string BLELNHandshakeMsg::makeAuthOk(bool tlv) {
+    if(tlv){
+        return std::string(1, (char)BLELN_TLV_MSG_AUTH_OK);
+    }
+
+    std::string out= BLELN_MSG_TITLE_AUTH_OK;
+    out.append(",1");
+    return out;
+}
+
+bool BLELNHandshakeMsg::readAuthOk(bool tlv, const std::string &msg) {
+    if(tlv){
+        return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_AUTH_OK;
+    }
+
+    StringList parts= splitCsvRespectingQuotes(msg);
+    return parts.size()==2 and parts[0]==BLELN_MSG_TITLE_AUTH_OK;
+}
+
+std::string BLELNHandshakeMsg::makeCertAndAnswer(const BLELNCert &cert, const uint8_t *nonceSign) {
+    std::string out= makeCert(true, cert);
+    out[0]= BLELN_TLV_MSG_CERT_AND_ANSW;
+    tlvAppend(out, BLELN_TLV_TAG_NONCE_SIGN, nonceSign, BLELN_NONCE_SIGN_LEN);
+
+    return out;
+}
+
+bool BLELNHandshakeMsg::readCertAndAnswer(const std::string &msg, BLELNCert &out, uint8_t *nonceSignOut) {
+    out.text.clear();
+    return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_CERT_AND_ANSW
+           and tlvGet(msg, BLELN_TLV_TAG_GEN, &out.gen, 1)
+           and tlvGet(msg, BLELN_TLV_TAG_MAC, out.mac, 6)
+           and tlvGet(msg, BLELN_TLV_TAG_PUB_KEY, out.pubKey, BLELN_DEV_PUB_KEY_LEN)
+           and tlvGet(msg, BLELN_TLV_TAG_CERT_SIGN, out.sign, BLELN_MANU_SIGN_LEN)
+           and tlvGet(msg, BLELN_TLV_TAG_NONCE_SIGN, nonceSignOut, BLELN_NONCE_SIGN_LEN);
+}
+
+std::string BLELNHandshakeMsg::makeTicket(bool tlv, const uint8_t *ticket, uint32_t lifetimeS) {
+    std::string out;
+
+    if(tlv){
+        out.push_back(BLELN_TLV_MSG_TICKET);
+        tlvAppend(out, BLELN_TLV_TAG_TICKET, ticket, BLELN_RESUME_TICKET_LEN);
+        tlvAppend(out, BLELN_TLV_TAG_LIFETIME, (const uint8_t*)&lifetimeS, 4); // LE
+    } else {
+        out= BLELN_MSG_TITLE_TICKET;
+        out.append(",").append(Encryption::base64Encode((uint8_t*)ticket, BLELN_RESUME_TICKET_LEN));
+        out.append(",").append(std::to_string(lifetimeS));
+    }
+
+    return out;
+}
+
+bool BLELNHandshakeMsg::readTicket(bool tlv, const std::string &msg, uint8_t *ticketOut, uint32_t *lifetimeSOut) {
+    if(tlv){
+        return !msg.empty() and (uint8_t)msg[0]==BLELN_TLV_MSG_TICKET
+               and tlvGet(msg, BLELN_TLV_TAG_TICKET, ticketOut, BLELN_RESUME_TICKET_LEN)
+               and tlvGet(msg, BLELN_TLV_TAG_LIFETIME, (uint8_t*)lifetimeSOut, 4);
+    }
+
+    StringList parts= splitCsvRespectingQuotes(msg);
+    if(parts.size()!=3 or parts[0]!=BLELN_MSG_TITLE_TICKET
+       or !b64Get(parts[1], ticketOut, BLELN_RESUME_TICKET_LEN)){
+        return false;
+    }
+
+    *lifetimeSOut= strtoul(parts[2].c_str(), nullptr, 10);
+    return true;
+}
+
+void BLELNHandshakeMsg::tlvAppend(std::string &out, uint8_t tag, const uint8_t *v, size_t len) {
+    out.push_back((char)tag);
+    out.push_back((char)len);
+    out.append((const char*)v, len);
+}
+
+bool BLELNHandshakeMsg::tlvGet(const std::string &msg, uint8_t tag, uint8_t *out, size_t len) {
+    // Skip message type, walk records. Unknown tags are skipped so new fields can be added later.
+    size_t i= 1;
+    while(i+2 <= msg.size()){
+        uint8_t t= msg[i];
+        size_t l= (uint8_t)msg[i+1];
+        if(i+2+l > msg.size()){
+            return false;
+        }
+
+        if(t==tag){
+            if(l!=len){
+                return false;
+            }
+            memcpy(out, msg.data()+i+2, len);
+            return true;
+        }
+
+        i+= 2+l;
+    }
+
+    return false;
+}
+
+bool BLELNHandshakeMsg::b64Get(const std::string &in, uint8_t *out, size_t len) {
+    return Encryption::base64Decode(in, out, len)==len;
+}
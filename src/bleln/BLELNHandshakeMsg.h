@@ -0,0 +1,84 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNHANDSHAKEMSG_H
+#define MGLIGHTFW_BLELNHANDSHAKEMSG_H
+
+#include "Arduino.h"
+#include "BLELNBase.h"
+
+// TLV message types - first byte of binary handshake message
+#define BLELN_TLV_MSG_CERT                                  0x01
+#define BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE              0x02
+#define BLELN_TLV_MSG_CHALLENGE_RESPONSE_ANSW_AND_NONCE     0x03
+#define BLELN_TLV_MSG_CHALLENGE_RESPONSE_ANSW               0x04
+#define BLELN_TLV_MSG_AUTH_OK                               0x05
+#define BLELN_TLV_MSG_TICKET                                0x06
+#define BLELN_TLV_MSG_CERT_AND_ANSW                         0x07    // 1.5-RTT authentication only
+
+// TLV record tags - records are [tag:1][len:1][value:len]
+#define BLELN_TLV_TAG_GEN           0x01
+#define BLELN_TLV_TAG_MAC           0x02
+#define BLELN_TLV_TAG_PUB_KEY       0x03
+#define BLELN_TLV_TAG_CERT_SIGN     0x04
+#define BLELN_TLV_TAG_NONCE         0x05
+#define BLELN_TLV_TAG_NONCE_SIGN    0x06
+#define BLELN_TLV_TAG_TICKET        0x07
+#define BLELN_TLV_TAG_LIFETIME      0x08
+
+
+/**
+ * Builds and parses plain (before encryption) handshake messages in both encodings:
+ *  - CSV:  "$TITLE,field,field" with base64 binary fields
+ *  - TLV:  [msgType:1] followed by records with raw bytes
+ * Encoding is chosen per connection in key exchange (BLELN_KEY_PACKET_TLV_FLAG).
+ */
+class BLELNHandshakeMsg {
+public:
+    static std::string makeCert(bool tlv, const BLELNCert &cert);
+    static bool readCert(bool tlv, const std::string &msg, BLELNCert &out);
+
+    static std::string makeChallengeNonce(bool tlv, const uint8_t *nonce);
+    static bool readChallengeNonce(bool tlv, const std::string &msg, uint8_t *nonceOut);
+
+    static std::string makeChallengeAnswerAndNonce(bool tlv, const uint8_t *nonceSign, const uint8_t *nonce);
+    static bool readChallengeAnswerAndNonce(bool tlv, const std::string &msg, uint8_t *nonceSignOut, uint8_t *nonceOut);
+
+    static std::string makeChallengeAnswer(bool tlv, const uint8_t *nonceSign);
+    static bool readChallengeAnswer(bool tlv, const std::string &msg, uint8_t *nonceSignOut);
+
+    static std::string makeAuthOk(bool tlv);
+    static bool readAuthOk(bool tlv, const std::string &msg);
+
+    // 1.5-RTT authentication - certificate and sign of test nonce derived from session secret, TLV only
+    static std::string makeCertAndAnswer(const BLELNCert &cert, const uint8_t *nonceSign);
+    static bool readCertAndAnswer(const std::string &msg, BLELNCert &out, uint8_t *nonceSignOut);
+
+    static std::string makeTicket(bool tlv, const uint8_t *ticket, uint32_t lifetimeS);
+    static bool readTicket(bool tlv, const std::string &msg, uint8_t *ticketOut, uint32_t *lifetimeSOut);
+
+private:
+    static void tlvAppend(std::string &out, uint8_t tag, const uint8_t *v, size_t len);
+    static bool tlvGet(const std::string &msg, uint8_t tag, uint8_t *out, size_t len);
+    static bool b64Get(const std::string &in, uint8_t *out, size_t len);
+};
+
+
+#endif //MGLIGHTFW_BLELNHANDSHAKEMSG_H
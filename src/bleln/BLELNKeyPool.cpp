@@ -0,0 +1,130 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNKeyPool.h"
+#include "Encryption.h"
+#include <mbedtls/platform_util.h>
+
+SemaphoreHandle_t BLELNKeyPool::mtx= nullptr;
+SemaphoreHandle_t BLELNKeyPool::refill= nullptr;
+BLELNKeyPool::Key BLELNKeyPool::keys[BLELN_KEY_POOL_SIZE];
+uint8_t BLELNKeyPool::ready= 0;
+uint32_t BLELNKeyPool::hits= 0;
+uint32_t BLELNKeyPool::misses= 0;
+
+void BLELNKeyPool::start() {
+    if(mtx!= nullptr){
+        return;
+    }
+
+    refill= xSemaphoreCreateBinary();
+    mtx= xSemaphoreCreateMutex();
+
+    xTaskCreatePinnedToCore(
+            [](void* arg){
+                BLELNKeyPool::worker();
+                vTaskDelete(nullptr);
+            }, "BLELNKeyPool", 4096, nullptr, BLELN_KEY_POOL_TASK_PRIORITY, nullptr, 1);
+}
+
+bool BLELNKeyPool::take(uint8_t *pub65, mbedtls_mpi &d) {
+    Key k{};
+    bool hit= false;
+
+    if(mtx!= nullptr and xSemaphoreTake(mtx, portMAX_DELAY)==pdTRUE){
+        if(ready > 0){
+            ready--;
+            k= keys[ready];
+            mbedtls_platform_zeroize(&keys[ready], sizeof(Key));
+            hits++;
+            hit= true;
+        } else {
+            misses++;
+        }
+        xSemaphoreGive(mtx);
+        xSemaphoreGive(refill);
+    }
+
+    if(!hit){
+        return Encryption::ecdh_gen(pub65, d);
+    }
+
+    mbedtls_mpi_init(&d);
+    bool r= (mbedtls_mpi_read_binary(&d, k.d, sizeof(k.d))==0);
+    memcpy(pub65, k.pub, 65);
+    mbedtls_platform_zeroize(&k, sizeof(k));
+
+    return r;
+}
+
+uint32_t BLELNKeyPool::getHits() {
+    return hits;
+}
+
+uint32_t BLELNKeyPool::getMisses() {
+    return misses;
+}
+
+uint8_t BLELNKeyPool::getReadyCount() {
+    return ready;
+}
+
+void BLELNKeyPool::worker() {
+    while(true){
+        bool full= true;
+        if(xSemaphoreTake(mtx, portMAX_DELAY)==pdTRUE){
+            full= (ready >= BLELN_KEY_POOL_SIZE);
+            xSemaphoreGive(mtx);
+        }
+
+        if(full){
+            // Wait until someone takes a key
+            xSemaphoreTake(refill, portMAX_DELAY);
+            continue;
+        }
+
+        // Generate without holding the lock, take() must never wait for keygen
+        Key k{};
+        if(!generate(&k)){
+            Serial.println("[E] BLELNKeyPool - keygen fail");
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        if(xSemaphoreTake(mtx, portMAX_DELAY)==pdTRUE){
+            if(ready < BLELN_KEY_POOL_SIZE){
+                keys[ready]= k;
+                ready++;
+            }
+            xSemaphoreGive(mtx);
+        }
+        mbedtls_platform_zeroize(&k, sizeof(k));
+    }
+}
+
+bool BLELNKeyPool::generate(BLELNKeyPool::Key *k) {
+    mbedtls_mpi d;
+
+    bool r= Encryption::ecdh_gen(k->pub, d) and (mbedtls_mpi_write_binary(&d, k->d, sizeof(k->d))==0);
+
+    mbedtls_mpi_free(&d);
+
+    return r;
+}
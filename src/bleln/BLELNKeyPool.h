@@ -0,0 +1,65 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNKEYPOOL_H
+#define MGLIGHTFW_BLELNKEYPOOL_H
+
+#include <Arduino.h>
+#include <mbedtls/ecp.h>
+
+#define BLELN_KEY_POOL_SIZE             3
+#define BLELN_KEY_POOL_TASK_PRIORITY    1   // Below BLELN workers - fills only in idle time
+
+/**
+ * Ephemeral P-256 keypairs generated ahead of time by a low priority task, so a new connection
+ * does not wait for scalar multiplication on the BLELN worker thread.
+ */
+class BLELNKeyPool {
+public:
+    /*** Multithreading safe */
+    static void start();
+
+    // Same contract as Encryption::ecdh_gen - initialises d. Generates a key in place when the pool is empty.
+    /*** Multithreading safe */
+    static bool take(uint8_t *pub65, mbedtls_mpi &d);
+
+    static uint32_t getHits();
+    static uint32_t getMisses();
+    static uint8_t getReadyCount();
+
+private:
+    struct Key {
+        uint8_t d[32];
+        uint8_t pub[65];
+    };
+
+    static void worker();
+    static bool generate(Key *k);
+
+    static SemaphoreHandle_t mtx;
+    static SemaphoreHandle_t refill;
+    static Key keys[BLELN_KEY_POOL_SIZE];
+    static uint8_t ready;
+    static uint32_t hits;
+    static uint32_t misses;
+};
+
+
+#endif //MGLIGHTFW_BLELNKEYPOOL_H
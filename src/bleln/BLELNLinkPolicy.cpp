@@ -0,0 +1,58 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNLinkPolicy.h"
+
+static const BLELNLinkParams fastParams{BLELN_LINK_FAST_ITVL_MIN, BLELN_LINK_FAST_ITVL_MAX, 0, BLELN_LINK_TIMEOUT};
+static const BLELNLinkParams idleParams{BLELN_LINK_IDLE_ITVL_MIN, BLELN_LINK_IDLE_ITVL_MAX, BLELN_LINK_IDLE_LATENCY,
+                                        BLELN_LINK_TIMEOUT};
+
+
+bool BLELNLinkPolicy::onActivity(unsigned long now) {
+    lastActivity= now;
+    return m != Mode::Fast;
+}
+
+bool BLELNLinkPolicy::isIdle(unsigned long now) const {
+    return m == Mode::Fast and (now - lastActivity) >= BLELN_LINK_IDLE_AFTER_MS;
+}
+
+bool BLELNLinkPolicy::enter(Mode mode) {
+    m= mode;
+    if(mode == Mode::Fast and !dataLenAndPhySet){
+        // Both stay for the whole connection - longer PDUs at double rate cost less airtime in any mode
+        dataLenAndPhySet= true;
+        return true;
+    }
+
+    return false;
+}
+
+BLELNLinkPolicy::Mode BLELNLinkPolicy::getMode() const {
+    return m;
+}
+
+unsigned long BLELNLinkPolicy::getLastActivity() const {
+    return lastActivity;
+}
+
+const BLELNLinkParams &BLELNLinkPolicy::paramsOf(Mode mode) {
+    return (mode == Mode::Idle) ? idleParams : fastParams;
+}
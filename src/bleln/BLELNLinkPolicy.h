@@ -0,0 +1,73 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNLINKPOLICY_H
+#define MGLIGHTFW_BLELNLINKPOLICY_H
+
+#include <Arduino.h>
+
+// Connection intervals in 1.25 ms units, supervision timeout in 10 ms units
+#define BLELN_LINK_FAST_ITVL_MIN        6       // 7.5 ms
+#define BLELN_LINK_FAST_ITVL_MAX        12      // 15 ms
+#define BLELN_LINK_IDLE_ITVL_MIN        80      // 100 ms
+#define BLELN_LINK_IDLE_ITVL_MAX        160     // 200 ms - attached client makes link Fast before its next request
+#define BLELN_LINK_IDLE_LATENCY         4       // Connection events server may skip when it has nothing to send
+#define BLELN_LINK_TIMEOUT              400     // 4 s, longer than (1 + latency) * 2 idle intervals
+#define BLELN_LINK_DATA_LEN             251     // LL payload of one data PDU (data length extension)
+#define BLELN_LINK_IDLE_AFTER_MS        2000    // Without traffic, before link is relaxed
+
+
+struct BLELNLinkParams {
+    uint16_t itvlMin;
+    uint16_t itvlMax;
+    uint16_t latency;
+    uint16_t timeout;
+};
+
+
+/**
+ * Connection parameters of one link, chosen by its workload. Handshake and messages want short interval,
+ * long LL PDUs and 2M PHY, link without traffic - long interval and peripheral latency, so both radios
+ * sleep through most connection events. Policy only decides - owner of the link applies returned mode with
+ * NimBLE, so requests go out only on mode changes.
+ */
+class BLELNLinkPolicy {
+public:
+    enum class Mode : uint8_t {Default, Fast, Idle};
+
+    // Link has traffic now - true when it has to be switched to Fast
+    bool onActivity(unsigned long now);
+    // True when Fast link had no traffic for BLELN_LINK_IDLE_AFTER_MS and has to be switched to Idle
+    bool isIdle(unsigned long now) const;
+    // Mode requested from stack. True when data length and PHY have to be requested with it (first Fast only).
+    bool enter(Mode mode);
+    Mode getMode() const;
+    unsigned long getLastActivity() const;
+
+    static const BLELNLinkParams& paramsOf(Mode mode);
+
+private:
+    Mode m= Mode::Default;
+    unsigned long lastActivity= 0;
+    bool dataLenAndPhySet= false;
+};
+
+
+#endif //MGLIGHTFW_BLELNLINKPOLICY_H
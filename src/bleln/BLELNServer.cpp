@@ -21,25 +21,32 @@
 #include "BLELNServer.h"
 #include <utility>
 #include "Encryption.h"
-#include "SuperString.h"
+#include "BLELNKeyPool.h"
+#include "BLELNHandshakeMsg.h"
+#include "BLELNCertCache.h"
+#include <mbedtls/platform_util.h>
 
 /// *************** PUBLIC ***************
 
 void BLELNServer::start(Preferences *prefs, const std::string &name, const std::string &uuid) {
     serviceUUID= uuid;
+    advName= name;
 
     // Initialize mutexes
     clisMtx= xSemaphoreCreateMutex();
 
     // Initialize queues
     workerActionQueue = xQueueCreate(50, sizeof(BLELNWorkerAction));
+    actionPool.begin(BLELN_SERVER_ACTION_SLABS);
 
     // Start worker thread
     runWorker= true;
     xTaskCreatePinnedToCore(
             [](void* arg){
-                static_cast<BLELNServer*>(arg)->worker();
+                auto *self= static_cast<BLELNServer*>(arg);
+                self->worker();
                 Serial.println("[D] BLELNServer -  rx worker stopped");
+                self->workerTaskHandle= nullptr;
                 vTaskDelete(nullptr);
             }, "BLELNWorker", 4096, this, 5, &workerTaskHandle, 1);
 
@@ -56,8 +63,16 @@ void BLELNServer::start(Preferences *prefs, const std::string &name, const std::
         if (g_epoch == 0) g_epoch = 1;
     }
     Encryption::randomizer_init();
+    BLELNKeyPool::start();
     authStore.loadCert();
 
+    // New tickets key on every start - older tickets are rejected and clients do full handshake
+    uint8_t ticketKey[32];
+    Encryption::random_bytes(ticketKey, 32);
+    mbedtls_gcm_init(&ticketGcm);
+    ticketKeyReady= (mbedtls_gcm_setkey(&ticketGcm, MBEDTLS_CIPHER_ID_AES, ticketKey, 256)==0);
+    mbedtls_platform_zeroize(ticketKey, 32);
+
     // Init NimBLE
     NimBLEDevice::init(name);
     NimBLEDevice::setMTU(247);
@@ -67,7 +82,7 @@ void BLELNServer::start(Preferences *prefs, const std::string &name, const std::
 
     // Start BLE server and set callbacks
     srv = NimBLEDevice::createServer();
-    srv->setCallbacks(this);
+    srv->setCallbacks(this, false); // Server must not delete us on deinit
 
     // Create BLELN service and characteristics
     auto* svc = srv->createService(serviceUUID);
@@ -75,65 +90,99 @@ void BLELNServer::start(Preferences *prefs, const std::string &name, const std::
     chKeyToSer = svc->createCharacteristic(BLELNBase::KEY_TO_SER_UUID, NIMBLE_PROPERTY::WRITE);// | NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN);
     chDataToCli  = svc->createCharacteristic(BLELNBase::DATA_TO_CLI_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);// | NIMBLE_PROPERTY::READ_ENC);
     chDataToSer  = svc->createCharacteristic(BLELNBase::DATA_TO_SER_UUID, NIMBLE_PROPERTY::WRITE);// | NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN);
+    chGroupToCli = svc->createCharacteristic(BLELNBase::GROUP_TO_CLI_UUID, NIMBLE_PROPERTY::NOTIFY);
+    chCaps = svc->createCharacteristic(BLELNBase::CAPS_UUID, NIMBLE_PROPERTY::READ);
+
+    // Offer for clients which know capabilities characteristic - older ones take v1 from KEYEX
+    uint8_t caps= BLELN_FRAME_VERSION_MAX | BLELN_KEY_PACKET_TLV_FLAG | BLELN_KEY_PACKET_FAST_AUTH_FLAG;
+    chCaps->setValue(&caps, 1);
 
     // Set characteristics callbacks
     keyTxClb = new KeyTxClb(this);
     keyRxClb = new KeyRxClb(this);
     dataRxClb = new DataRxClb(this);
+    dataTxClb = new DataTxClb(this);
+    groupTxClb = new GroupTxClb(this);
 
     chKeyToCli->setCallbacks(keyTxClb);
     chKeyToSer->setCallbacks(keyRxClb);
     chDataToSer->setCallbacks(dataRxClb);
+    chDataToCli->setCallbacks(dataTxClb);
+    chGroupToCli->setCallbacks(groupTxClb);
+
+    // Broadcasts key - lives only in RAM, like tickets key
+    if(!groupKey.generate()){
+        Serial.println("[E] BLELNServer - group key init failed");
+    }
+    groupKeyStale= false;
 
     // Start BLELN service
     svc->start();
 
-    // Publish/Advertise BLE server
+    // Publish/Advertise BLE server - service UUID fills advertising data, load and name go to scan response
     auto* adv = NimBLEDevice::getAdvertising();
-    adv->setName(name);
     adv->addServiceUUID(serviceUUID);
     adv->enableScanResponse(true);
+    BLELNServerLoad load;
+    load.freeSlots= BLELN_CONN_TABLE_SIZE;
+    setScanResponse(load.encode());
+    startedAt= millis();
+    advertisingReady= true;
 
     NimBLEDevice::startAdvertising();
 }
 
 void BLELNServer::stop() {
     NimBLEDevice::stopAdvertising();
+    advertisingReady= false;
 
     // Stop rx worker
     runWorker= false;
 
     if (workerTaskHandle != nullptr) {
+        BLELNWorkerAction wake{UINT16_MAX, BLELN_WORKER_ACTION_STOP, 0, nullptr};
+        xQueueSend(workerActionQueue, &wake, pdMS_TO_TICKS(100));
+
         while (workerTaskHandle != nullptr) {
             vTaskDelay(pdMS_TO_TICKS(10));
         }
     }
+    advLoad.clear();
 
     // Disconnect every client
     if (srv!=nullptr) {
         if(xSemaphoreTake(clisMtx, pdMS_TO_TICKS(1000))==pdTRUE) {
-            for (auto &c: connCtxs) {
+            connCtxs.forEach([this](BLELNConnCtx &c){
                 srv->disconnect(c.getHandle());
-            }
+            });
             xSemaphoreGive(clisMtx);
         }
     }
 
     if(workerActionQueue) {
-        xQueueReset(workerActionQueue);
+        BLELNWorkerAction pkt{};
+        while (xQueueReceive(workerActionQueue, &pkt, 0) == pdPASS) {
+            actionPool.give(pkt.d);
+        }
         vQueueDelete(workerActionQueue);
         workerActionQueue = nullptr;
     }
+    actionPool.end();
+    BLELNCertCache::flush(true);
 
 
     // Remove callbacks
     if (chKeyToCli) chKeyToCli->setCallbacks(nullptr);
     if (chKeyToSer) chKeyToSer->setCallbacks(nullptr);
     if (chDataToSer) chDataToSer->setCallbacks(nullptr);
+    if (chDataToCli) chDataToCli->setCallbacks(nullptr);
+    if (chGroupToCli) chGroupToCli->setCallbacks(nullptr);
 
     if (keyTxClb) { delete keyTxClb; keyTxClb = nullptr; }
     if (keyRxClb) { delete keyRxClb; keyRxClb = nullptr; }
     if (dataRxClb) { delete dataRxClb; dataRxClb = nullptr; }
+    if (dataTxClb) { delete dataTxClb; dataTxClb = nullptr; }
+    if (groupTxClb) { delete groupTxClb; groupTxClb = nullptr; }
 
     // Clear context list
     if(xSemaphoreTake(clisMtx, pdMS_TO_TICKS(1000))==pdTRUE) {
@@ -152,10 +201,16 @@ void BLELNServer::stop() {
     chKeyToSer = nullptr;
     chDataToCli  = nullptr;
     chDataToSer  = nullptr;
+    chGroupToCli = nullptr;
+    chCaps    = nullptr;
     srv       = nullptr;
 
     onMsgReceived = nullptr;
 
+    mbedtls_gcm_free(&ticketGcm);
+    ticketKeyReady= false;
+    groupKey.clear();
+
     NimBLEDevice::deinit(true);
 }
 
@@ -171,53 +226,271 @@ void BLELNServer::startOtherServerSearch(uint32_t durationMs, const std::string
 
 /*** Not multithreading safe */
 bool BLELNServer::getConnContext(uint16_t h, BLELNConnCtx** ctx) {
-    *ctx = nullptr;
-
-    auto it= std::find_if(connCtxs.begin(), connCtxs.end(),[h](const BLELNConnCtx &c){
-       return c.getHandle()==h;
-    });
-
-    if(it!=connCtxs.end()){
-        *ctx= &(*it);
-    }
-
+    *ctx = connCtxs.find(h);
     return *ctx!= nullptr;
 }
 
 /*** Multithreading safe */
 bool BLELNServer::noClientsConnected() {
-    uint8_t clisCnt=1;
+    return connCtxs.count()==0;
+}
 
-    if(xSemaphoreTake(clisMtx, pdMS_TO_TICKS(50))==pdTRUE){
-        clisCnt= connCtxs.size();
-        xSemaphoreGive(clisMtx);
-    }
+/*** Multithreading safe */
+void BLELNServer::setLoad(uint8_t queueDepth, int8_t wifiRssi) {
+    // Single bytes - worker reads them when it refreshes advertising
+    loadQueueDepth= queueDepth;
+    loadWifiRssi= wifiRssi;
+}
 
-    return clisCnt==0;
+/*** Not multithreading safe */
+void BLELNServer::updateAdvertisedLoad() {
+    if(!advertisingReady)
+        return;
+
+    BLELNServerLoad load;
+    size_t used= connCtxs.count();
+    load.freeSlots= (used < BLELN_CONN_TABLE_SIZE) ? BLELN_CONN_TABLE_SIZE - used : 0;
+    load.queueDepth= loadQueueDepth;
+    load.wifiRssi= loadWifiRssi;
+    unsigned long upMin= (millis() - startedAt) / 60000;
+    load.uptimeMin= (upMin > UINT16_MAX) ? UINT16_MAX : upMin;
+
+    // Advertising data is rebuilt only when something changed
+    std::string data= load.encode();
+    if(data == advLoad)
+        return;
+
+    advLoad= data;
+    setScanResponse(data);
+}
+
+void BLELNServer::setScanResponse(const std::string &loadData) {
+    NimBLEAdvertisementData scanData;
+    scanData.setServiceData(NimBLEUUID(serviceUUID), loadData);
+
+    // Name gets what is left of 31 bytes, shortened when it does not fit - full name is in GAP device name
+    size_t room= 31 - (2 + 16 + loadData.size()) - 2;
+    scanData.setName(advName.substr(0, room), advName.size() <= room);
+    NimBLEDevice::getAdvertising()->setScanResponseData(scanData);
 }
 
 /*** Not multithreading safe */
 bool BLELNServer::_sendEncrypted(BLELNConnCtx *cx, const std::string &msg) {
+    if(msg.size() > BLELN_MESSAGE_MAX_LEN){
+        Serial.println("[E] BLELNServer - Message too long");
+        return false;
+    }
+
+    size_t fragMaxLen= 0;
+    if(cx->getSessionEnc()->getFrameVersion() >= BLELN_FRAME_V3){
+        uint16_t mtu= srv->getPeerMTU(cx->getHandle());
+        fragMaxLen= (mtu > 23) ? mtu - 3 : 20;
+        if(msg.size() + cx->getSessionEnc()->getFrameOverhead() > BLELNFragmenter::maxFrameLen(fragMaxLen)){
+            Serial.printf("[E] BLELNServer - Message too long for MTU %u\r\n", mtu);
+            return false;
+        }
+    }
+
     std::string encrypted;
     if(!cx->getSessionEnc()->encryptMessage(msg, encrypted)){
         Serial.println("[E] BLELNServer - Encrypt failed");
         return false;
     }
 
-    chDataToCli->setValue(encrypted);
-    chDataToCli->notify(cx->getHandle());
-    return true;
+    // Sent by worker_pumpTx(), as stack buffers allow
+    bool ok;
+    if(cx->getSessionEnc()->getFrameVersion() < BLELN_FRAME_V3){
+        ok= cx->getTxQueue()->push(encrypted, BLELNTxChannel::Data);
+    } else {
+        ok= cx->getTxQueue()->pushFragmented(encrypted, fragMaxLen, cx->nextTxMsgSeq(), BLELNTxChannel::Data);
+    }
+
+    if(!ok){
+        txStats.dropped++;
+        Serial.println("[E] BLELNServer - TX queue full, message dropped");
+    }
+    return ok;
+}
+
+/*** Not multithreading safe */
+void BLELNServer::queueKeyPacket(BLELNConnCtx *cx, const std::string &pkt) {
+    // Through the same queue as data - packets encrypted in session leave in order of their counters
+    if(!cx->getTxQueue()->push(pkt, BLELNTxChannel::Key)){
+        txStats.dropped++;
+        Serial.println("[E] BLELNServer - TX queue full, key packet dropped");
+    }
+}
+
+/*** Not multithreading safe */
+int BLELNServer::notifyClient(uint16_t h, const std::string &pdu, BLELNTxChannel channel) {
+    NimBLECharacteristic *ch= chDataToCli;
+    if(channel == BLELNTxChannel::Key)
+        ch= chKeyToCli;
+    else if(channel == BLELNTxChannel::Group)
+        ch= chGroupToCli;
+
+    // Value is passed with notify - characteristic value is shared by all connections
+    txStatus= 0;
+    bool ok= ch->notify(pdu, h);
+    if(txStatus != 0)
+        return txStatus;
+
+    return ok ? 0 : BLE_HS_ENOMEM;
+}
+
+/*** Not multithreading safe */
+TickType_t BLELNServer::worker_pumpTx() {
+    unsigned long now= millis();
+    bool ready= false;
+    bool backingOff= false;
+
+    // One round - every connection sends up to its credits, so one long message does not hold others back
+    connCtxs.forEach([this, now, &ready, &backingOff](BLELNConnCtx &c){
+        BLELNTxQueue *q= c.getTxQueue();
+        if(q->depth() > txStats.depthMax)
+            txStats.depthMax= q->depth();
+
+        if(q->empty())
+            return;
+        if(q->isBackingOff(now)){
+            backingOff= true;
+            return;
+        }
+
+        worker_linkActivity(&c);
+        q->refillCredits();
+        while(!q->empty() and q->takeCredit()){
+            int rc= notifyClient(c.getHandle(), q->front(), q->getFrontChannel());
+            if(rc == 0){
+                txStats.sent++;
+                q->pop();
+            } else if(rc == BLE_HS_ENOMEM and q->failFront(now)){
+                // Stack is out of buffers - they free up as notifications go on air
+                txStats.retries++;
+                break;
+            } else {
+                Serial.printf("[E] BLELNServer - notify failed: %d, message dropped\r\n", rc);
+                txStats.dropped++;
+                q->dropMessage();
+            }
+        }
+
+        if(q->empty())
+            return;
+        if(q->isBackingOff(now))
+            backingOff= true;
+        else
+            ready= true;
+    });
+
+    if(ready)
+        return 0;
+    return pdMS_TO_TICKS(backingOff ? BLELN_TX_RETRY_MS : BLELN_WORKER_IDLE_WAKE_MS);
+}
+
+/*** Not multithreading safe */
+void BLELNServer::worker_linkActivity(BLELNConnCtx *cx) {
+    if(cx->getLinkPolicy()->onActivity(millis()))
+        applyLinkMode(cx, BLELNLinkPolicy::Mode::Fast);
+}
+
+/*** Not multithreading safe */
+void BLELNServer::worker_relaxIdleLinks() {
+    unsigned long now= millis();
+    connCtxs.forEach([this, now](BLELNConnCtx &c){
+        if(c.getLinkPolicy()->isIdle(now) and c.getTxQueue()->empty())
+            applyLinkMode(&c, BLELNLinkPolicy::Mode::Idle);
+    });
+}
+
+/*** Not multithreading safe */
+void BLELNServer::applyLinkMode(BLELNConnCtx *cx, BLELNLinkPolicy::Mode mode) {
+    uint16_t h= cx->getHandle();
+    const BLELNLinkParams &p= BLELNLinkPolicy::paramsOf(mode);
+
+    // Only requests - client (central) has the last word, both sides run the same policy anyway
+    srv->updateConnParams(h, p.itvlMin, p.itvlMax, p.latency, p.timeout);
+    if(cx->getLinkPolicy()->enter(mode)){
+        srv->setDataLen(h, BLELN_LINK_DATA_LEN);
+        srv->updatePhy(h, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, 0);
+    }
+}
+
+/*** Not multithreading safe */
+void BLELNServer::_sendToAll(const std::string &msg) {
+    if (msg.size() > BLELN_MESSAGE_MAX_LEN) {
+        Serial.println("[E] BLELNServer - Message too long");
+        return;
+    }
+
+    if (groupKeyStale) {
+        // Client which left must not read next broadcasts
+        groupKey.generate();
+        groupKeyStale= false;
+        connCtxs.forEach([this](BLELNConnCtx &c){
+            if (c.getGroupKeyId() != 0)
+                sendGroupKey(&c);
+        });
+    }
+
+    // Clients with current group key get one frame encrypted once. It goes through their TX queues, so it keeps
+    // order with messages queued before and a refused notification is repeated only to the client which missed it.
+    uint8_t keyId= groupKey.getKeyId();
+    uint8_t groupCnt= 0;
+    connCtxs.forEach([keyId, &groupCnt](BLELNConnCtx &c){
+        if (keyId != 0 and c.getGroupKeyId() == keyId)
+            groupCnt++;
+    });
+
+    std::string frame;
+    bool grouped= (groupCnt > 0) and groupKey.encrypt(msg, frame);
+    uint8_t msgSeq= groupTxMsgSeq++;
+
+    connCtxs.forEach([this, &msg, &frame, keyId, grouped, msgSeq](BLELNConnCtx &c){
+        if (!grouped or keyId == 0 or c.getGroupKeyId() != keyId) {
+            // Older clients and clients still without key - one by one
+            _sendEncrypted(&c, msg);
+            return;
+        }
+
+        uint16_t mtu= srv->getPeerMTU(c.getHandle());
+        size_t fragMaxLen= (mtu > 23) ? mtu - 3 : 20;
+        if (frame.size() > BLELNFragmenter::maxFrameLen(fragMaxLen)) {
+            Serial.printf("[E] BLELNServer - Broadcast too long for MTU %u\r\n", mtu);
+            return;
+        }
+        if (!c.getTxQueue()->pushFragmented(frame, fragMaxLen, msgSeq, BLELNTxChannel::Group)) {
+            txStats.dropped++;
+            Serial.println("[E] BLELNServer - TX queue full, broadcast dropped");
+        }
+    });
+}
+
+/*** Not multithreading safe */
+void BLELNServer::sendGroupKey(BLELNConnCtx *cx) {
+    if (!cx->isGroupSubscribed() or !groupKey.isReady()) {
+        return;
+    }
+
+    if (_sendEncrypted(cx, groupKey.makeKeyMessage())) {
+        cx->setGroupKeyId(groupKey.getKeyId());
+    }
+}
+
+/*** Not multithreading safe */
+void BLELNServer::onClientAuthorised(BLELNConnCtx *cx) {
+    cx->setState(BLELNConnCtx::State::Authorised);
+    _sendEncrypted(cx, "$HDSH,OK");
+    sendGroupKey(cx);
 }
 
 /*** Multithreading safe */
 bool BLELNServer::sendEncrypted(uint16_t h, const std::string &msg) {
-    auto* heapBuf = (uint8_t*)malloc(msg.size());
-    if (!heapBuf) return false;
-    memcpy(heapBuf, msg.data(), msg.size());
+    BLELNWorkerAction pkt{h, BLELN_WORKER_ACTION_SEND_MESSAGE};
+    if (!actionPool.put(pkt, (const uint8_t*)msg.data(), msg.size())) return false;
 
-    BLELNWorkerAction pkt{h, BLELN_WORKER_ACTION_SEND_MESSAGE, msg.size(), heapBuf };
     if (xQueueSend(workerActionQueue, &pkt, pdMS_TO_TICKS(10)) != pdPASS) {
-        free(heapBuf);
+        actionPool.give(pkt.d);
         return false;
     }
 
@@ -226,14 +499,11 @@ bool BLELNServer::sendEncrypted(uint16_t h, const std::string &msg) {
 
 /*** Multithreading safe */
 bool BLELNServer::sendEncryptedToAll(const std::string &msg) {
-    auto* heapBuf = (uint8_t*)malloc(msg.size());
-    if (!heapBuf) return false;
-    memcpy(heapBuf, msg.data(), msg.size());
-
+    BLELNWorkerAction pkt{UINT16_MAX, BLELN_WORKER_ACTION_SEND_MESSAGE};
+    if (!actionPool.put(pkt, (const uint8_t*)msg.data(), msg.size())) return false;
 
-    BLELNWorkerAction pkt{UINT16_MAX, BLELN_WORKER_ACTION_SEND_MESSAGE, msg.size(), heapBuf };
     if (xQueueSend(workerActionQueue, &pkt, pdMS_TO_TICKS(10)) != pdPASS) {
-        free(heapBuf);
+        actionPool.give(pkt.d);
         return false;
     }
 
@@ -241,49 +511,61 @@ bool BLELNServer::sendEncryptedToAll(const std::string &msg) {
 }
 
 void BLELNServer::worker() {
+    TickType_t txWait= pdMS_TO_TICKS(BLELN_WORKER_IDLE_WAKE_MS);
+
     while(runWorker){
         if((millis() - lastWaterMarkPrint) >= 10000) {
             UBaseType_t freeWords = uxTaskGetStackHighWaterMark(nullptr);
-            Serial.printf("[D] BLELNServer - stack free: %u\n\r",
-                          freeWords);
+            Serial.printf("[D] BLELNServer - stack free: %u, action slabs used max: %u/%u, exhausted: %u, oversized: %u\n\r",
+                          freeWords, actionPool.getHighWater(), actionPool.getSlabCount(),
+                          actionPool.getExhausted(), actionPool.getOversized());
+            Serial.printf("[D] BLELNServer - tx sent: %u, retries: %u, dropped: %u, queue depth max: %u\n\r",
+                          txStats.sent, txStats.retries, txStats.dropped, txStats.depthMax);
             lastWaterMarkPrint= millis();
         }
 
         BLELNWorkerAction action{};
-        if(xSemaphoreTake(clisMtx, 0)==pdTRUE){
-            if(xQueueReceive(workerActionQueue, &action, 0)==pdTRUE){
-                if(action.type == BLELN_WORKER_ACTION_REGISTER_CONNECTION){
+        if(xQueueReceive(workerActionQueue, &action, txWait)!=pdTRUE){
+            // Table got full while every client was busy - one of them is idle long enough by now
+            if(connCtxs.count() >= BLELN_CONN_TABLE_SIZE)
+                worker_evictIdleClient(BLE_HS_CONN_HANDLE_NONE);
+            worker_relaxIdleLinks();
+            updateAdvertisedLoad();
+            txWait= worker_pumpTx();
+            continue;
+        }
+
+        if(action.type == BLELN_WORKER_ACTION_REGISTER_CONNECTION
+           or action.type == BLELN_WORKER_ACTION_DELETE_CONNECTION){
+            // Contexts table is changed only here, under mutex - other threads only read it
+            if(xSemaphoreTake(clisMtx, portMAX_DELAY)==pdTRUE){
+                if(action.type == BLELN_WORKER_ACTION_REGISTER_CONNECTION)
                     worker_registerClient(action.connH);
-                    xSemaphoreGive(clisMtx);
-                } else if(action.type == BLELN_WORKER_ACTION_DELETE_CONNECTION){
+                else
                     worker_deleteClient(action.connH);
-                    xSemaphoreGive(clisMtx);
-                } else if(action.type==BLELN_WORKER_ACTION_PROCESS_SUBSCRIPTION){
-                    xSemaphoreGive(clisMtx);
-                    worker_processSubscription(action.connH);
-                } else if(action.type==BLELN_WORKER_ACTION_SEND_MESSAGE){
-                    xSemaphoreGive(clisMtx);
-                    worker_sendMessage(action.connH, action.d, action.dlen);
-                } else if(action.type==BLELN_WORKER_ACTION_PROCESS_KEY_RX){
-                    xSemaphoreGive(clisMtx);
-                    worker_processKeyRx(action.connH, action.d, action.dlen);
-                } else if(action.type==BLELN_WORKER_ACTION_PROCESS_DATA_RX){
-                    xSemaphoreGive(clisMtx);
-                    worker_processDataRx(action.connH, action.d, action.dlen);
-                }
-
-                free(action.d);
-            } else {
                 xSemaphoreGive(clisMtx);
             }
+        } else if(action.type==BLELN_WORKER_ACTION_PROCESS_SUBSCRIPTION){
+            worker_processSubscription(action.connH);
+        } else if(action.type==BLELN_WORKER_ACTION_PROCESS_GROUP_SUBSCRIPTION){
+            worker_processGroupSubscription(action.connH);
+        } else if(action.type==BLELN_WORKER_ACTION_SEND_MESSAGE){
+            worker_sendMessage(action.connH, action.data(), action.dlen);
+        } else if(action.type==BLELN_WORKER_ACTION_PROCESS_KEY_RX){
+            worker_processKeyRx(action.connH, action.data(), action.dlen);
+        } else if(action.type==BLELN_WORKER_ACTION_PROCESS_DATA_RX){
+            worker_processDataRx(action.connH, action.data(), action.dlen);
         }
 
-        // Pause task
-        if((uxQueueMessagesWaiting(workerActionQueue) > 0)){
-            vTaskDelay(pdMS_TO_TICKS(5));
-        } else {
-            vTaskDelay(pdMS_TO_TICKS(50));
-        }
+        // Traffic of a connection (its handshake included) keeps it fast, broadcasts are seen by worker_pumpTx()
+        BLELNConnCtx *cx;
+        if(action.type != BLELN_WORKER_ACTION_DELETE_CONNECTION and getConnContext(action.connH, &cx))
+            worker_linkActivity(cx);
+
+        actionPool.give(action.d);
+        worker_relaxIdleLinks();
+        updateAdvertisedLoad();
+        txWait= worker_pumpTx();
     }
 
     worker_cleanup();
@@ -296,20 +578,60 @@ void BLELNServer::worker_registerClient(uint16_t h) {
     BLELNConnCtx *c = nullptr;
 
     if (!getConnContext(h, &c)) {
-
-        connCtxs.emplace_back(h);
-        c = &connCtxs.back();
+        c = connCtxs.add(h);
+        if (c == nullptr) {
+            Serial.println("[E] BLELNServer - connections table full");
+            return;
+        }
 
         if (!c->makeSessionKey()) {
             Serial.println("[E] BLELNServer - ECDH keygen fail");
         }
+        Serial.printf("[D] BLELNServer - key pool hits: %u, misses: %u\r\n",
+                      BLELNKeyPool::getHits(), BLELNKeyPool::getMisses());
+
+        if (connCtxs.count() >= BLELN_CONN_TABLE_SIZE) {
+            worker_evictIdleClient(h);
+        }
     }
 }
 
-void BLELNServer::worker_deleteClient(uint16_t h) {
-    connCtxs.remove_if([h](const BLELNConnCtx& c){
-        return c.getHandle()==h;
+void BLELNServer::worker_evictIdleClient(uint16_t newH) {
+    // Clients stay connected between their requests - last free slot is made free again at cost of the client
+    // quiet for the longest time, so new clients can still connect. It reconnects on its next request.
+    unsigned long now= millis();
+    if (lastEviction != 0 and (now - lastEviction) < BLELN_EVICT_MIN_IDLE_MS) {
+        return;     // Previous one may be still disconnecting
+    }
+
+    BLELNConnCtx *victim= nullptr;
+    unsigned long victimIdle= 0;
+
+    connCtxs.forEach([newH, now, &victim, &victimIdle](BLELNConnCtx &c){
+        if (c.getHandle() == newH or c.getState() != BLELNConnCtx::State::Authorised or !c.getTxQueue()->empty())
+            return;
+
+        unsigned long idle= now - c.getLinkPolicy()->getLastActivity();
+        if (idle >= BLELN_EVICT_MIN_IDLE_MS and idle > victimIdle) {
+            victim= &c;
+            victimIdle= idle;
+        }
     });
+
+    if (victim != nullptr) {
+        Serial.printf("[D] BLELNServer - slots full, evicting client %u idle for %lu ms\r\n", victim->getHandle(), victimIdle);
+        srv->disconnect(victim->getHandle(), BLE_ERR_RD_CONN_TERM_RESRCS);
+        lastEviction= now;
+    }
+}
+
+void BLELNServer::worker_deleteClient(uint16_t h) {
+    BLELNConnCtx *cx= connCtxs.find(h);
+    if (cx != nullptr and cx->getGroupKeyId() != 0) {
+        groupKeyStale= true;
+    }
+
+    connCtxs.remove(h);
 }
 
 void BLELNServer::worker_processSubscription(uint16_t h) {
@@ -323,12 +645,20 @@ void BLELNServer::worker_processSubscription(uint16_t h) {
     }
 }
 
+void BLELNServer::worker_processGroupSubscription(uint16_t h) {
+    BLELNConnCtx *cx;
+    if (getConnContext(h, &cx)) {
+        cx->setGroupSubscribed(true);
+        if (cx->getState() == BLELNConnCtx::State::Authorised) {
+            sendGroupKey(cx);
+        }
+    }
+}
+
 void BLELNServer::worker_sendMessage(uint16_t h, uint8_t *data, size_t dataLen) {
     if(h==UINT16_MAX){
         std::string m(reinterpret_cast<char*>(data), dataLen);
-        for(auto & connCtx : connCtxs){
-            _sendEncrypted(&connCtx,m);
-        }
+        _sendToAll(m);
     } else {
         BLELNConnCtx *cx;
         if(getConnContext(h, &cx)){
@@ -343,19 +673,33 @@ void BLELNServer::worker_processKeyRx(uint16_t h, uint8_t *data, size_t dataLen)
     BLELNConnCtx *cx;
     // Find context for client who sent message
     if (getConnContext(h, &cx)) {
-        if (cx->getState() == BLELNConnCtx::State::WaitingForKey) {
+        if (cx->getState() == BLELNConnCtx::State::WaitingForKey and dataLen > 0
+            and (data[0] & BLELN_KEY_PACKET_RESUME_FLAG)) {
+            // Returning client with ticket
+            resumeSession(cx, data, dataLen);
+        } else if (cx->getState() == BLELNConnCtx::State::WaitingForKey) {
             // If I'm waiting for clients session key
-            // [ver=1][cliPub:65][cliNonce:12]
-            if (dataLen != 1 + 65 + 12 || data[0] != 1) {
+            // [ver][cliPub:65][cliNonce:12], ver is the frame version chosen by client (with handshake flags)
+            // 1.5-RTT authentication: [ver][cliPub:65][cliNonce:12][encrypted cert and answer]
+            uint8_t ver= (dataLen > 0) ? (data[0] & BLELN_KEY_PACKET_VERSION_MASK) : 0;
+            bool fastAuth= (dataLen > 0) and (data[0] & BLELN_KEY_PACKET_FAST_AUTH_FLAG)
+                           and (data[0] & BLELN_KEY_PACKET_TLV_FLAG);
+            if ((fastAuth ? dataLen <= 1 + 65 + 12 : dataLen != 1 + 65 + 12)
+                || ver < BLELN_FRAME_V1 || ver > BLELN_FRAME_VERSION_MAX) {
                 Serial.println("[E] BLELNServer - bad key packet");
             } else {
                 // Read clients session key
                 bool r = cx->getSessionEnc()->deriveFriendsKey(data + 1,
                                                                data + 1 + 65, g_psk_salt,
-                                                               g_epoch);
+                                                               g_epoch, ver);
                 if (r) {
-                    cx->setState(BLELNConnCtx::State::WaitingForCert);
-                    sendCertToClient(cx);
+                    cx->setTlvHandshake(data[0] & BLELN_KEY_PACKET_TLV_FLAG);
+                    if (fastAuth) {
+                        processCertAndAnswer(cx, data + 1 + 65 + 12, dataLen - (1 + 65 + 12));
+                    } else {
+                        cx->setState(BLELNConnCtx::State::WaitingForCert);
+                        sendCertToClient(cx);
+                    }
                 } else {
                     Serial.println("[E] BLELNServer - derive failed");
                 }
@@ -364,14 +708,10 @@ void BLELNServer::worker_processKeyRx(uint16_t h, uint8_t *data, size_t dataLen)
             // If I'm waiting for clients certificate
             std::string plainKeyMsg;
             if (cx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
-                StringList parts = splitCsvRespectingQuotes(plainKeyMsg);
-                if (parts[0] == BLELN_MSG_TITLE_CERT and parts.size() == 3) {
-                    uint8_t gen;
-                    uint8_t fMac[6];
-                    uint8_t fPubKey[BLELN_DEV_PUB_KEY_LEN];
-
-                    if (authStore.verifyCert(parts[1], parts[2], &gen, fMac, 6, fPubKey, 64)) {
-                        cx->setCertData(fMac, fPubKey);
+                BLELNCert cert;
+                if (BLELNHandshakeMsg::readCert(cx->isTlvHandshake(), plainKeyMsg, cert)) {
+                    if (authStore.verifyCert(cert)) {
+                        cx->setCertData(cert.mac, cert.pubKey);
                         sendChallengeNonce(cx);
                         cx->setState(BLELNConnCtx::State::ChallengeResponseCli);
                     } else {
@@ -392,14 +732,11 @@ void BLELNServer::worker_processKeyRx(uint16_t h, uint8_t *data, size_t dataLen)
             // If I'm waiting for clients challenge response
             std::string plainKeyMsg;
             if (cx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
-                StringList parts = splitCsvRespectingQuotes(plainKeyMsg);
-                if (parts[0] == BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW_AND_NONCE and parts.size() == 3) {
-                    uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
-                    Encryption::base64Decode(parts[1], nonceSign, BLELN_NONCE_SIGN_LEN);
+                uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
+                uint8_t nonce[BLELN_TEST_NONCE_LEN];            // Clients nonce
+                if (BLELNHandshakeMsg::readChallengeAnswerAndNonce(cx->isTlvHandshake(), plainKeyMsg, nonceSign, nonce)) {
                     if (cx->verifyChallengeResponseAnswer(nonceSign)) {
-                        uint8_t nonce[BLELN_TEST_NONCE_LEN];            // Clients nonce
                         uint8_t friendsNonceSign[BLELN_NONCE_SIGN_LEN]; // Clients nonce I have signed
-                        Encryption::base64Decode(parts[2], nonce, BLELN_TEST_NONCE_LEN);
                         authStore.signData(nonce, BLELN_TEST_NONCE_LEN, friendsNonceSign);
                         sendChallengeNonceSign(cx, friendsNonceSign);
                         cx->setState(BLELNConnCtx::State::ChallengeResponseSer);
@@ -417,10 +754,10 @@ void BLELNServer::worker_processKeyRx(uint16_t h, uint8_t *data, size_t dataLen)
         } else if (cx->getState() == BLELNConnCtx::State::ChallengeResponseSer) {
             std::string plainKeyMsg;
             if (cx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)) {
-                StringList parts = splitCsvRespectingQuotes(plainKeyMsg);
-                if (parts[0] == BLELN_MSG_TITLE_AUTH_OK and parts.size() == 2) {
+                if (BLELNHandshakeMsg::readAuthOk(cx->isTlvHandshake(), plainKeyMsg)) {
                     Serial.printf("[I] BLELNServer - client %d authorised\r\n", cx->getHandle());
-                    cx->setState(BLELNConnCtx::State::Authorised);
+                    onClientAuthorised(cx);
+                    sendTicketToClient(cx);
                 }
             }
         }
@@ -433,11 +770,20 @@ void BLELNServer::worker_processDataRx(uint16_t h, uint8_t *data, size_t dataLen
     // Find context for client who sent data message
     if (getConnContext(h, &cx) and (cx != nullptr)) {
         if (cx->getState() == BLELNConnCtx::State::Authorised) {
-            std::string v(reinterpret_cast<char *>(data), dataLen);
+            std::string v;
+            if (cx->getSessionEnc()->getFrameVersion() >= BLELN_FRAME_V3) {
+                BLELNReassembler::Result r= cx->getReassembler()->push(data, dataLen, v);
+                if (r == BLELNReassembler::Result::Dropped) {
+                    Serial.println("[E] BLELNServer - fragment out of order, message dropped");
+                }
+                if (r != BLELNReassembler::Result::Complete)
+                    return;
+            } else {
+                v.assign(reinterpret_cast<char *>(data), dataLen);
+            }
 
             std::string plain;
             if (cx->getSessionEnc()->decryptMessage((const uint8_t *) v.data(), v.size(), plain)) {
-                if (plain.size() > 200) plain.resize(200);
                 for (auto &ch: plain) if (ch == '\0') ch = ' ';
 
                 if (onMsgReceived)
@@ -456,14 +802,15 @@ void BLELNServer::worker_cleanup() {
     BLELNWorkerAction pkt{};
     while (xQueueReceive(workerActionQueue, &pkt, 0) == pdPASS) {
         vTaskDelay(pdMS_TO_TICKS(10));
-        free(pkt.d);
+        actionPool.give(pkt.d);
     }
 }
 
 void BLELNServer::sendKeyToClient(BLELNConnCtx *cx) {
-    // KEYEX_TX: [ver=1][epoch:4B][salt:32B][srvPub:65B][srvNonce:12B]
+    // KEYEX_TX: [ver=1][epoch:4B][salt:32B][srvPub:65B][srvNonce:12B] - unchanged since first firmware, so its clients
+    // still connect. Newer frame versions and handshake flags are offered in capabilities characteristic.
     std::string keyex;
-    keyex.push_back(1);
+    keyex.push_back(BLELN_FRAME_V1);
     keyex.append((const char*)&g_epoch, 4); // LE
     keyex.append((const char*)g_psk_salt, 32);
     keyex.append((const char*)cx->getSessionEnc()->getMyPub(),65);
@@ -471,20 +818,17 @@ void BLELNServer::sendKeyToClient(BLELNConnCtx *cx) {
 
     Serial.println("Sending key to client");
 
-    chKeyToCli->setValue(keyex);
-    chKeyToCli->notify(cx->getHandle());
+    queueKeyPacket(cx, keyex);
     cx->setState(BLELNConnCtx::State::WaitingForKey);
 
 }
 
 void BLELNServer::sendCertToClient(BLELNConnCtx *cx) {
-    std::string msg=BLELN_MSG_TITLE_CERT;
-    msg.append(",").append(authStore.getSignedCert());
+    std::string msg= BLELNHandshakeMsg::makeCert(cx->isTlvHandshake(), authStore.getCert());
 
     std::string encMsg;
     if(cx->getSessionEnc()->encryptMessage(msg, encMsg)) {
-        chKeyToCli->setValue(encMsg);
-        chKeyToCli->notify(cx->getHandle());
+        queueKeyPacket(cx, encMsg);
     } else {
         Serial.println("[E] BLELNServer - BLELNServer - failed encrypting cert msg");
     }
@@ -492,59 +836,194 @@ void BLELNServer::sendCertToClient(BLELNConnCtx *cx) {
 
 void BLELNServer::sendChallengeNonce(BLELNConnCtx *cx) {
     cx->generateTestNonce();
-    std::string base64Nonce= cx->getTestNonceBase64();
-
-    std::string msg= BLELN_MSG_TITLE_CHALLENGE_RESPONSE_NONCE;
-    msg.append(",").append(base64Nonce);
+    std::string msg= BLELNHandshakeMsg::makeChallengeNonce(cx->isTlvHandshake(), cx->getTestNonce());
 
     std::string encMsg;
     if(cx->getSessionEnc()->encryptMessage(msg, encMsg)) {
-        chKeyToCli->setValue(encMsg);
-        chKeyToCli->notify(cx->getHandle());
+        queueKeyPacket(cx, encMsg);
     } else {
         Serial.println("[E] BLELNServer - failed encrypting cert msg");
     }
 }
 
 void BLELNServer::sendChallengeNonceSign(BLELNConnCtx *cx, uint8_t *sign) {
-    std::string msg= BLELN_MSG_TITLE_CHALLENGE_RESPONSE_ANSW;
-    std::string base64Sign= Encryption::base64Encode(sign, BLELN_NONCE_SIGN_LEN);
-    msg.append(",").append(base64Sign);
+    std::string msg= BLELNHandshakeMsg::makeChallengeAnswer(cx->isTlvHandshake(), sign);
 
     std::string encMsg;
     if(cx->getSessionEnc()->encryptMessage(msg, encMsg)) {
-        chKeyToCli->setValue(encMsg);
-        chKeyToCli->notify(cx->getHandle());
+        queueKeyPacket(cx, encMsg);
     } else {
         Serial.println("[E] BLELNServer - failed encrypting cert msg");
     }
 }
 
+void BLELNServer::processCertAndAnswer(BLELNConnCtx *cx, const uint8_t *data, size_t dataLen) {
+    // 1.5-RTT authentication - clients cert and answer came with its key
+    std::string plainKeyMsg;
+    BLELNCert cert;
+    uint8_t nonceSign[BLELN_NONCE_SIGN_LEN];
+
+    if (!cx->getSessionEnc()->decryptMessage(data, dataLen, plainKeyMsg)
+        or !BLELNHandshakeMsg::readCertAndAnswer(plainKeyMsg, cert, nonceSign)) {
+        Serial.println("[E] BLELNServer - fast auth - wrong message");
+        disconnectClient(cx, BLE_ERR_AUTH_FAIL);
+        cx->setState(BLELNConnCtx::State::AuthFailed);
+        return;
+    }
+
+    if (!authStore.verifyCert(cert)) {
+        Serial.println("[E] BLELNServer - fast auth - invalid cert");
+        disconnectClient(cx, BLE_ERR_AUTH_FAIL);
+        cx->setState(BLELNConnCtx::State::AuthFailed);
+        return;
+    }
+
+    cx->setCertData(cert.mac, cert.pubKey);
+    cx->deriveTestNonce(true);
+    if (!cx->verifyChallengeResponseAnswer(nonceSign)) {
+        Serial.println("[E] BLELNServer - fast auth - invalid sign");
+        disconnectClient(cx, BLE_ERR_AUTH_FAIL);
+        cx->setState(BLELNConnCtx::State::AuthFailed);
+        return;
+    }
+
+    // My cert and answer - client checks them and we are done, no more round trips
+    uint8_t myTestNonce[BLELN_TEST_NONCE_LEN];
+    uint8_t myNonceSign[BLELN_NONCE_SIGN_LEN];
+    cx->getSessionEnc()->makeAuthTestNonce(false, myTestNonce);
+    authStore.signData(myTestNonce, BLELN_TEST_NONCE_LEN, myNonceSign);
+
+    std::string encMsg;
+    if (!cx->getSessionEnc()->encryptMessage(BLELNHandshakeMsg::makeCertAndAnswer(authStore.getCert(), myNonceSign),
+                                             encMsg)) {
+        Serial.println("[E] BLELNServer - failed encrypting cert msg");
+        return;
+    }
+    queueKeyPacket(cx, encMsg);
+
+    Serial.printf("[I] BLELNServer - client %d authorised\r\n", cx->getHandle());
+    onClientAuthorised(cx);
+    sendTicketToClient(cx);
+}
+
+void BLELNServer::sendTicketToClient(BLELNConnCtx *cx) {
+    if(!ticketKeyReady){
+        return;
+    }
+
+    // Ticket plain: [cliMac:6][cliPub:64][resumeSecret:32][expiresAt:4 LE, seconds of my uptime]
+    std::string plain;
+    uint32_t expiresAt= millis()/1000 + BLELN_RESUME_TICKET_LIFETIME_S;
+    plain.append((const char*)cx->getMac(), 6);
+    plain.append((const char*)cx->getPubKey(), BLELN_DEV_PUB_KEY_LEN);
+    plain.append((const char*)cx->getSessionEnc()->getResumeSecret(), BLELN_RESUME_SECRET_LEN);
+    plain.append((const char*)&expiresAt, 4);
+
+    // Ticket: [iv:12][ct][tag:16]
+    uint8_t aad[12];
+    memcpy(aad, "BLELNticket1", 12);
+    uint8_t iv[12], tag[16];
+    Encryption::random_bytes(iv, 12);
+    std::string ct(plain.size(), '\0');
+    bool r= Encryption::encryptAESGCM(&ticketGcm, &plain, iv, tag, aad, &ct);
+    mbedtls_platform_zeroize(&plain[0], plain.size());
+    if(!r){
+        Serial.println("[E] BLELNServer - failed sealing ticket");
+        return;
+    }
+
+    std::string ticket;
+    ticket.append((const char*)iv, 12).append(ct).append((const char*)tag, 16);
+
+    std::string msg= BLELNHandshakeMsg::makeTicket(cx->isTlvHandshake(), (const uint8_t*)ticket.data(),
+                                                   BLELN_RESUME_TICKET_LIFETIME_S);
+
+    std::string encMsg;
+    if(cx->getSessionEnc()->encryptMessage(msg, encMsg)) {
+        queueKeyPacket(cx, encMsg);
+    } else {
+        Serial.println("[E] BLELNServer - failed encrypting ticket msg");
+    }
+}
+
+bool BLELNServer::openTicket(const uint8_t *ticket, uint8_t *macOut, uint8_t *pubKeyOut, uint8_t *secretOut) {
+    if(!ticketKeyReady){
+        return false;
+    }
+
+    uint8_t aad[12];
+    memcpy(aad, "BLELNticket1", 12);
+    const size_t ctLen= BLELN_RESUME_TICKET_LEN - 12 - 16;
+
+    std::string plain;
+    if(!Encryption::decryptAESGCM(&ticketGcm, ticket + 12, ctLen, ticket, ticket + 12 + ctLen, aad, &plain)){
+        return false;
+    }
+
+    auto *p= (const uint8_t*)plain.data();
+    uint32_t expiresAt;
+    memcpy(macOut, p, 6);
+    memcpy(pubKeyOut, p + 6, BLELN_DEV_PUB_KEY_LEN);
+    memcpy(secretOut, p + 6 + BLELN_DEV_PUB_KEY_LEN, BLELN_RESUME_SECRET_LEN);
+    memcpy(&expiresAt, p + 6 + BLELN_DEV_PUB_KEY_LEN + BLELN_RESUME_SECRET_LEN, 4);
+    mbedtls_platform_zeroize(&plain[0], plain.size());
+
+    return (millis()/1000) < expiresAt;
+}
+
+void BLELNServer::resumeSession(BLELNConnCtx *cx, uint8_t *data, size_t dataLen) {
+    // [ver|flag][cliNonce:12][ticket]
+    uint8_t ver= data[0] & BLELN_KEY_PACKET_VERSION_MASK;
+    uint8_t mac[6];
+    uint8_t pubKey[BLELN_DEV_PUB_KEY_LEN];
+    uint8_t secret[BLELN_RESUME_SECRET_LEN];
+
+    bool r= (dataLen == 1 + 12 + BLELN_RESUME_TICKET_LEN) and
+            openTicket(data + 1 + 12, mac, pubKey, secret) and
+            cx->getSessionEnc()->deriveResumedKey(secret, data + 1, g_psk_salt, g_epoch, ver);
+    mbedtls_platform_zeroize(secret, sizeof(secret));
+
+    if(!r){
+        // Client falls back to full handshake, stay in WaitingForKey
+        Serial.println("[I] BLELNServer - ticket rejected");
+        queueKeyPacket(cx, std::string(BLELN_MSG_TITLE_RESUME_REJECT));
+        return;
+    }
+
+    cx->setCertData(mac, pubKey);
+    cx->setTlvHandshake(data[0] & BLELN_KEY_PACKET_TLV_FLAG);
+
+    std::string encMsg;
+    if(cx->getSessionEnc()->encryptMessage(BLELN_MSG_TITLE_RESUME_OK, encMsg)) {
+        queueKeyPacket(cx, encMsg);
+        Serial.printf("[I] BLELNServer - client %d resumed\r\n", cx->getHandle());
+        onClientAuthorised(cx);
+    } else {
+        Serial.println("[E] BLELNServer - failed encrypting resume msg");
+    }
+}
+
 void BLELNServer::disconnectClient(BLELNConnCtx *cx, uint8_t reason){
     if (srv!=nullptr) {
         srv->disconnect(cx->getHandle(), reason);
     }
 }
 
-void BLELNServer::appendToDataQueue(uint16_t h, const std::string &m) {
-    auto* heapBuf = (uint8_t*)malloc(m.size());
-    if (!heapBuf) return;
-    memcpy(heapBuf, m.data(), m.size());
+void BLELNServer::appendToDataQueue(uint16_t h, const uint8_t *d, size_t dlen) {
+    BLELNWorkerAction pkt{h, BLELN_WORKER_ACTION_PROCESS_DATA_RX};
+    if (!actionPool.put(pkt, d, dlen)) return;
 
-    BLELNWorkerAction pkt{h, BLELN_WORKER_ACTION_PROCESS_DATA_RX, m.size(), heapBuf };
     if (xQueueSend(workerActionQueue, &pkt, pdMS_TO_TICKS(10)) != pdPASS) {
-        free(heapBuf);
+        actionPool.give(pkt.d);
     }
 }
 
-void BLELNServer::appendToKeyQueue(uint16_t h, const std::string &m) {
-    auto* heapBuf = (uint8_t*)malloc(m.size());
-    if (!heapBuf) return;
-    memcpy(heapBuf, m.data(), m.size());
+void BLELNServer::appendToKeyQueue(uint16_t h, const uint8_t *d, size_t dlen) {
+    BLELNWorkerAction pkt{h, BLELN_WORKER_ACTION_PROCESS_KEY_RX};
+    if (!actionPool.put(pkt, d, dlen)) return;
 
-    BLELNWorkerAction pkt{h, BLELN_WORKER_ACTION_PROCESS_KEY_RX, m.size(), heapBuf };
     if (xQueueSend(workerActionQueue, &pkt, pdMS_TO_TICKS(10)) != pdPASS) {
-        free(heapBuf);
+        actionPool.give(pkt.d);
     }
 }
 
@@ -585,19 +1064,20 @@ void BLELNServer::onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo,
 }
 
 void BLELNServer::onDataWrite(NimBLECharacteristic *c, NimBLEConnInfo &info) {
-    const std::string &v = c->getValue();
+    // Reference - copied only once, into worker action
+    const NimBLEAttValue &v = c->getValue();
 
-    if (!v.empty()) {
-        appendToDataQueue(info.getConnHandle(), v);
+    if (v.size() > 0) {
+        appendToDataQueue(info.getConnHandle(), v.data(), v.size());
     }
 }
 
 
 void BLELNServer::onKeyToSerWrite(NimBLECharacteristic *c, NimBLEConnInfo &info) {
-    const std::string &v = c->getValue();
+    const NimBLEAttValue &v = c->getValue();
 
-    if (!v.empty()) {
-        appendToKeyQueue(info.getConnHandle(), v);
+    if (v.size() > 0) {
+        appendToKeyQueue(info.getConnHandle(), v.data(), v.size());
     }
 }
 
@@ -615,6 +1095,21 @@ void BLELNServer::onKeyToCliSubscribe(__attribute__((unused)) NimBLECharacterist
 }
 
 
+void BLELNServer::onNotifyStatus(int code) {
+    // Called from inside notify() of worker_pumpTx(), on worker thread
+    txStatus= code;
+}
+
+
+void BLELNServer::onGroupToCliSubscribe(__attribute__((unused)) NimBLECharacteristic *pCharacteristic,
+                                        NimBLEConnInfo &connInfo, uint16_t subValue) {
+    if(subValue>0) {
+        BLELNWorkerAction pkt{connInfo.getConnHandle(), BLELN_WORKER_ACTION_PROCESS_GROUP_SUBSCRIPTION, 0, nullptr};
+        xQueueSend(workerActionQueue, &pkt, pdMS_TO_TICKS(100));
+    }
+}
+
+
 void BLELNServer::setOnMessageReceivedCallback(std::function<void(uint16_t cliH, const std::string& msg)> cb) {
     onMsgReceived= std::move(cb);
 }
@@ -25,11 +25,13 @@
 #include "BLELNConnCtx.h"
 #include "BLELNBase.h"
 #include "BLELNAuthentication.h"
+#include "BLELNActionPool.h"
+#include "BLELNConnTable.h"
+#include "BLELNGroupKey.h"
+#include "BLELNServerLoad.h"
 #include <NimBLEDevice.h>
 #include <Preferences.h>
 
-#include <list>
-
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
@@ -54,6 +56,8 @@ public:
     bool sendEncryptedToAll(const std::string& msg);
 
     void setOnMessageReceivedCallback(std::function<void(uint16_t cliH, const std::string& msg)> cb);
+    // Load behind this server (API talks waiting, WiFi link), advertised with free slots and uptime
+    void setLoad(uint8_t queueDepth, int8_t wifiRssi);
 
     void worker();
 
@@ -64,23 +68,35 @@ private:
     // NimBLE
     NimBLEServer* srv = nullptr;
     NimBLECharacteristic *chKeyToCli=nullptr, *chKeyToSer=nullptr, *chDataToCli=nullptr, *chDataToSer=nullptr;
+    NimBLECharacteristic *chCaps=nullptr;
+    NimBLECharacteristic *chGroupToCli=nullptr;
     NimBLECharacteristicCallbacks* keyTxClb = nullptr;
     NimBLECharacteristicCallbacks* keyRxClb = nullptr;
     NimBLECharacteristicCallbacks* dataRxClb = nullptr;
+    NimBLECharacteristicCallbacks* dataTxClb = nullptr;
+    NimBLECharacteristicCallbacks* groupTxClb = nullptr;
 
     // Multithreading
     TaskHandle_t workerTaskHandle = nullptr;
     SemaphoreHandle_t clisMtx = nullptr;
     QueueHandle_t workerActionQueue;
+    BLELNActionPool actionPool;
     bool runWorker;
 
     // Encryption
     uint8_t g_psk_salt[32];
     uint32_t g_epoch = 0;
+    mbedtls_gcm_context ticketGcm{};    // Session resumption tickets key, lives only in RAM
+    bool ticketKeyReady = false;
+    BLELNGroupKey groupKey;
+    bool groupKeyStale = false;     // One of key holders left - replace it before next broadcast
+    uint8_t groupTxMsgSeq = 0;
 
     // BLELN
     BLELNAuthentication authStore;
-    std::list<BLELNConnCtx> connCtxs;
+    BLELNConnTable connCtxs;
+    BLELNTxStats txStats;
+    int txStatus = 0;           // Status of notification being sent, reported by NimBLE from inside notify()
 
     std::string serviceUUID;
     bool scanning = false;
@@ -88,24 +104,50 @@ private:
     std::string searchedUUID;
 
     unsigned long lastWaterMarkPrint=0;
+    unsigned long lastEviction=0;
+
+    // Advertised load
+    volatile uint8_t loadQueueDepth= 0;
+    volatile int8_t loadWifiRssi= 0;
+    unsigned long startedAt= 0;
+    volatile bool advertisingReady= false;  // Worker runs before advertising is set up in start()
+    std::string advName;
+    std::string advLoad;            // Service data in scan response now, worker only
 
     // Private methods
     void worker_registerClient(uint16_t h);
     void worker_deleteClient(uint16_t h);
+    void worker_evictIdleClient(uint16_t newH);
     void worker_processSubscription(uint16_t h);
+    void worker_processGroupSubscription(uint16_t h);
     void worker_sendMessage(uint16_t h, uint8_t *data, size_t dataLen);
     void worker_processKeyRx(uint16_t h, uint8_t *data, size_t dataLen);
     void worker_processDataRx(uint16_t h, uint8_t *data, size_t dataLen);
     void worker_cleanup();
+    TickType_t worker_pumpTx();
+    void worker_linkActivity(BLELNConnCtx *cx);
+    void worker_relaxIdleLinks();
+    void applyLinkMode(BLELNConnCtx *cx, BLELNLinkPolicy::Mode mode);
+    void updateAdvertisedLoad();
+    void setScanResponse(const std::string &loadData);
 
     bool _sendEncrypted(BLELNConnCtx *cx, const std::string& msg);
+    void queueKeyPacket(BLELNConnCtx *cx, const std::string &pkt);
+    int notifyClient(uint16_t h, const std::string &pdu, BLELNTxChannel channel);
+    void _sendToAll(const std::string& msg);
+    void sendGroupKey(BLELNConnCtx *cx);
+    void onClientAuthorised(BLELNConnCtx *cx);
     void sendKeyToClient(BLELNConnCtx *cx);
     void sendCertToClient(BLELNConnCtx *cx);
     void sendChallengeNonce(BLELNConnCtx *cx);
     void sendChallengeNonceSign(BLELNConnCtx *cx, uint8_t *sign);
+    void processCertAndAnswer(BLELNConnCtx *cx, const uint8_t *data, size_t dataLen);
+    void sendTicketToClient(BLELNConnCtx *cx);
+    void resumeSession(BLELNConnCtx *cx, uint8_t *data, size_t dataLen);
+    bool openTicket(const uint8_t *ticket, uint8_t *macOut, uint8_t *pubKeyOut, uint8_t *secretOut);
     void disconnectClient(BLELNConnCtx *cx, uint8_t reason=BLE_ERR_REM_USER_CONN_TERM);
-    void appendToDataQueue(uint16_t h, const std::string &m);
-    void appendToKeyQueue(uint16_t h, const std::string &m);
+    void appendToDataQueue(uint16_t h, const uint8_t *d, size_t dlen);
+    void appendToKeyQueue(uint16_t h, const uint8_t *d, size_t dlen);
 
     // Callbacks
     void onResult(const NimBLEAdvertisedDevice* advertisedDevice) override;
@@ -115,6 +157,8 @@ private:
     void onDataWrite(NimBLECharacteristic* c, NimBLEConnInfo& info);
     void onKeyToSerWrite(NimBLECharacteristic* c, NimBLEConnInfo& info);
     void onKeyToCliSubscribe(__attribute__((unused)) NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue);
+    void onGroupToCliSubscribe(__attribute__((unused)) NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue);
+    void onNotifyStatus(int code);
 
     // Callback classes
     class DataRxClb : public NimBLECharacteristicCallbacks{
@@ -127,6 +171,16 @@ private:
         }
     };
 
+    class DataTxClb : public NimBLECharacteristicCallbacks{
+    public:
+        explicit DataTxClb(BLELNServer *parent): parentServer(parent){}
+    private:
+        BLELNServer *parentServer;
+        void onStatus(NimBLECharacteristic *pCharacteristic, int code) override{
+            parentServer->onNotifyStatus(code);
+        }
+    };
+
     class KeyRxClb : public NimBLECharacteristicCallbacks {
     public:
         explicit KeyRxClb(BLELNServer *parent): parentServer(parent){}
@@ -145,6 +199,22 @@ private:
         void onSubscribe(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue) override{
             parentServer->onKeyToCliSubscribe(pCharacteristic, connInfo, subValue);
         }
+        void onStatus(NimBLECharacteristic *pCharacteristic, int code) override{
+            parentServer->onNotifyStatus(code);
+        }
+    };
+
+    class GroupTxClb : public NimBLECharacteristicCallbacks {
+    public:
+        explicit GroupTxClb(BLELNServer *parent): parentServer(parent){}
+    private:
+        BLELNServer *parentServer;
+        void onSubscribe(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue) override{
+            parentServer->onGroupToCliSubscribe(pCharacteristic, connInfo, subValue);
+        }
+        void onStatus(NimBLECharacteristic *pCharacteristic, int code) override{
+            parentServer->onNotifyStatus(code);
+        }
     };
 };
 
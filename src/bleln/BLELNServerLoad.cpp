@@ -0,0 +1,62 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNServerLoad.h"
+
+
+std::string BLELNServerLoad::encode() const {
+    std::string out(BLELN_ADV_LOAD_LEN, '\0');
+    out[0]= (char)freeSlots;
+    out[1]= (char)queueDepth;
+    out[2]= (char)wifiRssi;
+    out[3]= (char)(uptimeMin & 0xFF);
+    out[4]= (char)(uptimeMin >> 8);
+    return out;
+}
+
+bool BLELNServerLoad::decode(const std::string &serviceData) {
+    // Longer data is accepted - later firmware may append fields
+    if(serviceData.size() < BLELN_ADV_LOAD_LEN)
+        return false;
+
+    auto *d= (const uint8_t*)serviceData.data();
+    freeSlots= d[0];
+    queueDepth= d[1];
+    wifiRssi= (int8_t)d[2];
+    uptimeMin= d[3] | (d[4] << 8);
+    return true;
+}
+
+int BLELNServerLoad::score(int bleRssi) const {
+    if(freeSlots == 0)
+        return INT16_MIN;   // Would refuse us
+
+    // Free slot is worth 20 dB, waiting request 10 dB. Link quality of both hops (BLE to us, WiFi to API)
+    // decides between equally loaded servers, uptime (max 10 min) prefers servers past election.
+    int wifi= (wifiRssi == 0) ? -100 : wifiRssi;
+    return freeSlots*20 - queueDepth*10 + wifi + bleRssi + (uptimeMin < 10 ? uptimeMin : 10);
+}
+
+int BLELNServerLoad::scoreUnknown(int bleRssi) {
+    BLELNServerLoad l;
+    l.freeSlots= 1;
+    l.wifiRssi= -80;
+    return l.score(bleRssi);
+}
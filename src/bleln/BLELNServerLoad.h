@@ -0,0 +1,50 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNSERVERLOAD_H
+#define MGLIGHTFW_BLELNSERVERLOAD_H
+
+#include <Arduino.h>
+
+// Service data under BLELN service UUID: [freeSlots:1][queueDepth:1][wifiRssi:1][uptimeMin:2 LE]
+// Advertising data is full with flags and 128-bit service UUID, so load goes to scan response (23 of 31 bytes)
+#define BLELN_ADV_LOAD_LEN          5
+
+
+/**
+ * Load of BLELN server, as it is advertised. Clients scan for a while and connect to the server with the
+ * best score, so clients spread across servers instead of filling the first one found.
+ */
+struct BLELNServerLoad {
+    uint8_t freeSlots= 0;       // Connection table slots left
+    uint8_t queueDepth= 0;      // API talks waiting for HTTP
+    int8_t wifiRssi= 0;         // dBm, 0 - no WiFi
+    uint16_t uptimeMin= 0;      // Server mode time
+
+    std::string encode() const;
+    bool decode(const std::string &serviceData);
+
+    // Higher is better. Server without load data (older firmware) gets score of one free slot and weak WiFi.
+    int score(int bleRssi) const;
+    static int scoreUnknown(int bleRssi);
+};
+
+
+#endif //MGLIGHTFW_BLELNSERVERLOAD_H
@@ -21,9 +21,24 @@
 #include "BLELNSessionEnc.h"
 #include "Encryption.h"
 #include "BLELNBase.h"
+#include "BLELNKeyPool.h"
+#include <mbedtls/platform_util.h>
+
+BLELNSessionEnc::BLELNSessionEnc() {
+    mbedtls_gcm_init(&gcm_m2f);
+    mbedtls_gcm_init(&gcm_f2m);
+}
+
+BLELNSessionEnc::~BLELNSessionEnc() {
+    mbedtls_gcm_free(&gcm_m2f);
+    mbedtls_gcm_free(&gcm_f2m);
+    mbedtls_mpi_free(&d);
+    mbedtls_platform_zeroize(resumeSecret, sizeof(resumeSecret));
+    mbedtls_platform_zeroize(authBinder, sizeof(authBinder));
+}
 
 bool BLELNSessionEnc::makeMyKeys() {
-    if(!Encryption::ecdh_gen(myPub,grp,d)){
+    if(!BLELNKeyPool::take(myPub,d)){
         Serial.println("[HX] ecdh_gen fail");
         return false;
     }
@@ -33,13 +48,21 @@ bool BLELNSessionEnc::makeMyKeys() {
 }
 
 bool BLELNSessionEnc::deriveFriendsKey(const uint8_t *friendsPub65,
-                                       const uint8_t *friendsNonce12, uint8_t *psk_salt, uint32_t sessionEpoch) {
+                                       const uint8_t *friendsNonce12, uint8_t *psk_salt, uint32_t sessionEpoch,
+                                       uint8_t frameVersion) {
+    if(frameVersion < BLELN_FRAME_V1 or frameVersion > BLELN_FRAME_VERSION_MAX){
+        return false;
+    }
+
     // ECDH -> shared
     uint8_t ss[32];
-    if(!Encryption::ecdh_shared(grp, d, friendsPub65, ss)){
+    if(!Encryption::ecdh_shared(d, friendsPub65, ss)){
         return false;
     }
 
+    uint8_t sessKey_f2m[32];
+    uint8_t sessKey_m2f[32];
+
     // HKDF: salt = PSK_SALT || epoch (LE)
     uint8_t salt[32+4];
     memcpy(salt, psk_salt, 32);
@@ -82,24 +105,157 @@ bool BLELNSessionEnc::deriveFriendsKey(const uint8_t *friendsPub65,
                             sidBuf, sizeof(sidBuf));
     sid = ((uint16_t)sidBuf[0] << 8) | sidBuf[1];
 
+    const char rmsInfo[] = "BLEv1|rms";
+    Encryption::hkdf_sha256(salt, sizeof(salt),
+                            ss, sizeof(ss),
+                            (const uint8_t*)rmsInfo, sizeof(rmsInfo)-1,
+                            resumeSecret, sizeof(resumeSecret));
+
+    const char authInfo[] = "BLEv1|auth";
+    Encryption::hkdf_sha256(salt, sizeof(salt),
+                            ss, sizeof(ss),
+                            (const uint8_t*)authInfo, sizeof(authInfo)-1,
+                            authBinder, sizeof(authBinder));
+    mbedtls_platform_zeroize(ss, sizeof(ss));
+
+    // Both ends must agree on who uses which direction byte - public keys order decides, no role needed
+    return installKeys(sessKey_f2m, sessKey_m2f, sessionEpoch, frameVersion,
+                       (memcmp(myPub, friendsPub65, 65) < 0) ? 0 : 1);
+}
+
+void BLELNSessionEnc::makeMyNonce() {
+    Encryption::random_bytes(myNonce,12);
+}
+
+bool BLELNSessionEnc::deriveResumedKey(const uint8_t *resumeSecret32, const uint8_t *friendsNonce12, uint8_t *psk_salt,
+                                       uint32_t sessionEpoch, uint8_t frameVersion) {
+    if(frameVersion < BLELN_FRAME_V1 or frameVersion > BLELN_FRAME_VERSION_MAX){
+        return false;
+    }
+
+    uint8_t sessKey_f2m[32];
+    uint8_t sessKey_m2f[32];
+
+    // HKDF: salt = PSK_SALT || epoch (LE), ikm = resumption secret
+    uint8_t salt[32+4];
+    memcpy(salt, psk_salt, 32);
+    salt[32] = (uint8_t)(sessionEpoch & 0xFF);
+    salt[33] = (uint8_t)((sessionEpoch >> 8) & 0xFF);
+    salt[34] = (uint8_t)((sessionEpoch >> 16) & 0xFF);
+    salt[35] = (uint8_t)((sessionEpoch >> 24) & 0xFF);
+
+    // info = "BLEv1|resume" + myNonce + friendsNonce, nonces swapped for the other direction
+    const char infoHdr[] = "BLEv1|resume";
+    uint8_t info[sizeof(infoHdr)-1 + 12 + 12];
+    memcpy(info, infoHdr, sizeof(infoHdr)-1);
+
+    memcpy(info + sizeof(infoHdr)-1, myNonce, 12);
+    memcpy(info + sizeof(infoHdr)-1 + 12, friendsNonce12, 12);
+    Encryption::hkdf_sha256(salt, sizeof(salt), resumeSecret32, BLELN_RESUME_SECRET_LEN, info, sizeof(info),
+                            sessKey_f2m, 32);
+
+    memcpy(info + sizeof(infoHdr)-1, friendsNonce12, 12);
+    memcpy(info + sizeof(infoHdr)-1 + 12, myNonce, 12);
+    Encryption::hkdf_sha256(salt, sizeof(salt), resumeSecret32, BLELN_RESUME_SECRET_LEN, info, sizeof(info),
+                            sessKey_m2f, 32);
+
+    // Nonces order decides direction byte, and makes sid the same on both ends
+    uint8_t dir = (memcmp(myNonce, friendsNonce12, 12) < 0) ? 0 : 1;
+    const char sidHdr[] = "BLEv1|rsid";
+    uint8_t sidInfo[sizeof(sidHdr)-1 + 12 + 12];
+    memcpy(sidInfo, sidHdr, sizeof(sidHdr)-1);
+    memcpy(sidInfo + sizeof(sidHdr)-1, dir == 0 ? myNonce : friendsNonce12, 12);
+    memcpy(sidInfo + sizeof(sidHdr)-1 + 12, dir == 0 ? friendsNonce12 : myNonce, 12);
+    uint8_t sidBuf[2];
+    Encryption::hkdf_sha256(salt, sizeof(salt), resumeSecret32, BLELN_RESUME_SECRET_LEN, sidInfo, sizeof(sidInfo),
+                            sidBuf, sizeof(sidBuf));
+    sid = ((uint16_t)sidBuf[0] << 8) | sidBuf[1];
+
+    // Resumed session can be resumed again with the same ticket
+    if(resumeSecret32 != resumeSecret)
+        memcpy(resumeSecret, resumeSecret32, BLELN_RESUME_SECRET_LEN);
+
+    return installKeys(sessKey_f2m, sessKey_m2f, sessionEpoch, frameVersion, dir);
+}
+
+const uint8_t *BLELNSessionEnc::getResumeSecret() const {
+    return resumeSecret;
+}
+
+void BLELNSessionEnc::makeAuthTestNonce(bool forClient, uint8_t *out) const {
+    // [role label:16][authBinder:32] - signing it proves identity for this ECDH exchange only,
+    // role label keeps clients sign from being reflected as servers one
+    memset(out, 0, BLELN_TEST_NONCE_LEN);
+    memcpy(out, forClient ? "BLEv1|auth|cli" : "BLEv1|auth|srv", 14);
+    memcpy(out + 16, authBinder, sizeof(authBinder));
+}
+
+bool BLELNSessionEnc::installKeys(uint8_t *sessKey_f2m, uint8_t *sessKey_m2f, uint32_t sessionEpoch,
+                                  uint8_t frameVersion, uint8_t dir) {
+    // Key schedule and GHASH tables are made once here, not for every message
+    keyed = (mbedtls_gcm_setkey(&gcm_f2m, MBEDTLS_CIPHER_ID_AES, sessKey_f2m, 256) == 0) and
+            (mbedtls_gcm_setkey(&gcm_m2f, MBEDTLS_CIPHER_ID_AES, sessKey_m2f, 256) == 0);
+    mbedtls_platform_zeroize(sessKey_f2m, 32);
+    mbedtls_platform_zeroize(sessKey_m2f, 32);
+
     myLastCtr = 0;
     friendsLastCtr = 0;
     myEpoch = sessionEpoch;
+    frameVer = frameVersion;
+    myDir = dir;
 
-    return true;
+    return keyed;
+}
+
+void BLELNSessionEnc::makeAAD(uint8_t *aad) const {
+    // AAD = "DATAv1" | sid(BE) | epoch(LE), "DATAv2" for v2 frames
+    const char *aadhdr = (frameVer == BLELN_FRAME_V1) ? "DATAv1" : "DATAv2";
+    uint8_t* a = aad;
+    memcpy(a, aadhdr, 6); a += 6;
+    *a++ = (uint8_t)(sid >> 8);
+    *a++ = (uint8_t)(sid & 0xFF);
+    *a++ = (uint8_t)(myEpoch & 0xFF);
+    *a++ = (uint8_t)((myEpoch >> 8) & 0xFF);
+    *a++ = (uint8_t)((myEpoch >> 16) & 0xFF);
+    *a = (uint8_t)((myEpoch >> 24) & 0xFF);
+}
+
+void BLELNSessionEnc::makeNonce(uint8_t dir, uint32_t ctr, uint8_t *nonce) const {
+    // nonce = dir | 0 | sid(BE) | epoch(LE) | ctr(BE)
+    // Key is unique per session and direction, and ctr never repeats within it
+    nonce[0] = dir;
+    nonce[1] = 0;
+    nonce[2] = (uint8_t)(sid >> 8);
+    nonce[3] = (uint8_t)(sid & 0xFF);
+    nonce[4] = (uint8_t)(myEpoch & 0xFF);
+    nonce[5] = (uint8_t)((myEpoch >> 8) & 0xFF);
+    nonce[6] = (uint8_t)((myEpoch >> 16) & 0xFF);
+    nonce[7] = (uint8_t)((myEpoch >> 24) & 0xFF);
+    nonce[8] = (uint8_t)((ctr >> 24) & 0xFF);
+    nonce[9] = (uint8_t)((ctr >> 16) & 0xFF);
+    nonce[10] = (uint8_t)((ctr >> 8) & 0xFF);
+    nonce[11] = (uint8_t)(ctr & 0xFF);
 }
 
 bool BLELNSessionEnc::decryptMessage(const uint8_t *in, size_t inLen, std::string &out) {
-    if (inLen < 4 + 12 + 16) {
+    size_t overhead = getFrameOverhead();
+    if (!keyed or inLen < overhead) {
         return false;
     }
 
     const uint8_t* p = in;
     uint32_t r_ctr = (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3]; // Received CTR
     p += 4;
-    const uint8_t* iv = p;
-    p += 12;
-    size_t ctLen = inLen - (4 + 12 + 16);
+
+    uint8_t iv[12];
+    if(frameVer == BLELN_FRAME_V1) {
+        memcpy(iv, p, 12);
+        p += 12;
+    } else {
+        makeNonce(myDir ^ 1, r_ctr, iv);
+    }
+
+    size_t ctLen = inLen - overhead;
     const uint8_t* ct = p;
     p += ctLen;
     const uint8_t* tag = p;
@@ -108,19 +264,10 @@ bool BLELNSessionEnc::decryptMessage(const uint8_t *in, size_t inLen, std::strin
         return false;
     }
 
-    // AAD = "DATAv1" + handle(LE) + epochUsed(LE)
-    const char aadhdr[] = "DATAv1";
-    uint8_t aad[ sizeof(aadhdr)-1 + 2 + 4 ];
-    uint8_t* a = aad;
-    memcpy(a, aadhdr, sizeof(aadhdr)-1); a += sizeof(aadhdr)-1;
-    *a++ = (uint8_t)(sid >> 8);
-    *a++ = (uint8_t)(sid & 0xFF);
-    *a++ = (uint8_t)(myEpoch & 0xFF);
-    *a++ = (uint8_t)((myEpoch >> 8) & 0xFF);
-    *a++ = (uint8_t)((myEpoch >> 16) & 0xFF);
-    *a = (uint8_t)((myEpoch >> 24) & 0xFF);
+    uint8_t aad[12];
+    makeAAD(aad);
 
-    if(!Encryption::decryptAESGCM(ct, ctLen, iv, tag, aad, &out, sessKey_f2m)){
+    if(!Encryption::decryptAESGCM(&gcm_f2m, ct, ctLen, iv, tag, aad, &out)){
         return false;
     }
 
@@ -129,19 +276,13 @@ bool BLELNSessionEnc::decryptMessage(const uint8_t *in, size_t inLen, std::strin
 }
 
 bool BLELNSessionEnc::encryptMessage(const std::string &in, std::string &out) {
-    // AAD = "DATAv1" | sid(BE) | epoch(LE)
-    const char aadhdr[] = "DATAv1";
-    uint8_t aad[sizeof(aadhdr)-1 + 2 + 4], *a=aad;
-    memcpy(a,aadhdr,sizeof(aadhdr)-1);
-    a+=sizeof(aadhdr)-1;
-    *a++ = (uint8_t)(sid >> 8);
-    *a++ = (uint8_t)(sid & 0xFF);
-    *a++ = (uint8_t)(myEpoch & 0xFF);
-    *a++ = (uint8_t)((myEpoch >> 8) & 0xFF);
-    *a++ = (uint8_t)((myEpoch >> 16) & 0xFF);
-    *a   = (uint8_t)((myEpoch >> 24) & 0xFF);
-
+    // Counter is also the nonce of v2 frames, it must not wrap within a session
+    if(!keyed or myLastCtr == UINT32_MAX){
+        return false;
+    }
 
+    uint8_t aad[12];
+    makeAAD(aad);
 
     myLastCtr++;
     uint8_t ctrBE[4] = {
@@ -149,21 +290,26 @@ bool BLELNSessionEnc::encryptMessage(const std::string &in, std::string &out) {
             (uint8_t)((myLastCtr>>8)&0xFF),  (uint8_t)( myLastCtr&0xFF)
     };
     uint8_t iv[12];
-    Encryption::random_bytes(iv, 12);
+    if(frameVer == BLELN_FRAME_V1) {
+        Encryption::random_bytes(iv, 12);
+    } else {
+        makeNonce(myDir, myLastCtr, iv);
+    }
 
     std::string ct;
     ct.resize(in.length());
     uint8_t tag[16];
 
-
-
-    if(!Encryption::encryptAESGCM(&in, iv, tag, aad, &ct, sessKey_m2f)){
+    if(!Encryption::encryptAESGCM(&gcm_m2f, &in, iv, tag, aad, &ct)){
         return false;
     }
-    // Pakiet: [ctr:4][nonce:12][cipher...][tag:16]
+    // Packet v1: [ctr:4][nonce:12][cipher...][tag:16]
+    // Packet v2: [ctr:4][cipher...][tag:16]
     out.erase();
     out.append((char*)ctrBE,4);
-    out.append((char*)iv,12);
+    if(frameVer == BLELN_FRAME_V1) {
+        out.append((char *) iv, 12);
+    }
     out.append(ct);
     out.append((char*)tag,16);
 
@@ -181,3 +327,11 @@ uint8_t *BLELNSessionEnc::getMyNonce() {
 uint16_t BLELNSessionEnc::getSessionId() const {
     return sid;
 }
+
+uint8_t BLELNSessionEnc::getFrameVersion() const {
+    return frameVer;
+}
+
+size_t BLELNSessionEnc::getFrameOverhead() const {
+    return (frameVer == BLELN_FRAME_V1) ? (4 + 12 + 16) : (4 + 16);
+}
@@ -24,15 +24,32 @@
 #include <Arduino.h>
 #include <mbedtls/ecp.h>
 #include <mbedtls/ctr_drbg.h>
+#include <mbedtls/gcm.h>
+#include "BLELNBase.h"
 
 class BLELNSessionEnc {
 public:
+    BLELNSessionEnc();
+    ~BLELNSessionEnc();
+    BLELNSessionEnc(const BLELNSessionEnc&) = delete;
+    BLELNSessionEnc& operator=(const BLELNSessionEnc&) = delete;
+
     bool makeMyKeys(); // Initialize with new server keys
-    bool deriveFriendsKey(const uint8_t* friendsPub65, const uint8_t* friendsNonce12, uint8_t *psk_salt, uint32_t sessionEpoch);
+    bool deriveFriendsKey(const uint8_t* friendsPub65, const uint8_t* friendsNonce12, uint8_t *psk_salt, uint32_t sessionEpoch,
+                          uint8_t frameVersion);
+    // Session resumption - fresh keys from resumption secret of earlier session and fresh nonces, no ECDH
+    void makeMyNonce();
+    bool deriveResumedKey(const uint8_t* resumeSecret32, const uint8_t* friendsNonce12, uint8_t *psk_salt, uint32_t sessionEpoch,
+                          uint8_t frameVersion);
+    const uint8_t* getResumeSecret() const;
+    // Test nonce (BLELN_TEST_NONCE_LEN) for 1.5-RTT authentication, bound to this session secret
+    void makeAuthTestNonce(bool forClient, uint8_t *out) const;
     bool decryptMessage(const uint8_t* in, size_t inLen, std::string &out);
     bool encryptMessage(const std::string &in, std::string &out);
 
     uint16_t getSessionId() const;
+    uint8_t getFrameVersion() const;
+    size_t getFrameOverhead() const;
 
     uint8_t* getMyPub();
     uint8_t* getMyNonce();
@@ -40,19 +57,29 @@ private:
     // Connection encryption
     uint16_t sid = 0;
     uint32_t myEpoch = 0;
+    uint8_t frameVer = BLELN_FRAME_V1;
+    uint8_t myDir = 0;          // Nonce direction byte, friend uses the other one
 
-    // My data
-    mbedtls_ecp_group grp{};
+    // My data - curve is the shared Encryption::p256() group
     mbedtls_mpi d{};             // my private key
 
-    uint8_t sessKey_m2f[32]{};   // AES-256-GCM key
+    mbedtls_gcm_context gcm_m2f{};   // AES-256-GCM, keyed once per session
     uint32_t myLastCtr = 0;     // anty-replay
     uint8_t myNonce[12]{};
     uint8_t myPub[65]{};           // my public key
 
     // Friend data
-    uint8_t sessKey_f2m[32]{};   // AES-256-GCM key
+    mbedtls_gcm_context gcm_f2m{};   // AES-256-GCM, keyed once per session
     uint32_t friendsLastCtr = 0;    // anty-replay
+
+    bool keyed = false;
+    uint8_t resumeSecret[BLELN_RESUME_SECRET_LEN]{};
+    uint8_t authBinder[32]{};
+
+    bool installKeys(uint8_t *sessKey_f2m, uint8_t *sessKey_m2f, uint32_t sessionEpoch, uint8_t frameVersion,
+                     uint8_t dir);
+    void makeAAD(uint8_t *aad) const;
+    void makeNonce(uint8_t dir, uint32_t ctr, uint8_t *nonce) const;
 };
 
 
@@ -0,0 +1,119 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include "BLELNTxQueue.h"
+
+
+bool BLELNTxQueue::pushFragmented(const std::string &frame, size_t fragMaxLen, uint8_t msgSeq,
+                                  BLELNTxChannel channel) {
+    if(bytes + frame.size() > BLELN_TX_QUEUE_MAX_BYTES){
+        return false;
+    }
+
+    size_t before= pdus.size();
+    bool ok= BLELNFragmenter::send(frame, fragMaxLen, msgSeq, [this, channel](const std::string &frag){
+        pdus.push_back({frag, false, channel});
+        bytes+= frag.size();
+        return true;
+    });
+
+    if(!ok){
+        while(pdus.size() > before){
+            bytes-= pdus.back().data.size();
+            pdus.pop_back();
+        }
+        return false;
+    }
+
+    pdus.back().last= true;
+    return true;
+}
+
+bool BLELNTxQueue::push(const std::string &frame, BLELNTxChannel channel) {
+    if(bytes + frame.size() > BLELN_TX_QUEUE_MAX_BYTES){
+        return false;
+    }
+
+    pdus.push_back({frame, true, channel});
+    bytes+= frame.size();
+    return true;
+}
+
+bool BLELNTxQueue::empty() const {
+    return pdus.empty();
+}
+
+uint16_t BLELNTxQueue::depth() const {
+    return pdus.size();
+}
+
+const std::string &BLELNTxQueue::front() const {
+    return pdus.front().data;
+}
+
+BLELNTxChannel BLELNTxQueue::getFrontChannel() const {
+    return pdus.front().channel;
+}
+
+void BLELNTxQueue::pop() {
+    if(pdus.empty())
+        return;
+
+    bytes-= pdus.front().data.size();
+    pdus.pop_front();
+    frontRetries= 0;
+}
+
+void BLELNTxQueue::dropMessage() {
+    while(!pdus.empty()){
+        bool last= pdus.front().last;
+        pop();
+        if(last)
+            break;
+    }
+}
+
+void BLELNTxQueue::clear() {
+    pdus.clear();
+    bytes= 0;
+    frontRetries= 0;
+    retryAt= 0;
+}
+
+void BLELNTxQueue::refillCredits() {
+    credits= BLELN_TX_CREDITS;
+}
+
+bool BLELNTxQueue::takeCredit() {
+    if(credits == 0)
+        return false;
+
+    credits--;
+    return true;
+}
+
+bool BLELNTxQueue::failFront(unsigned long now) {
+    retryAt= now + BLELN_TX_RETRY_MS;
+    return ++frontRetries <= BLELN_TX_MAX_RETRIES;
+}
+
+bool BLELNTxQueue::isBackingOff(unsigned long now) const {
+    return frontRetries > 0 and (long)(now - retryAt) < 0;
+}
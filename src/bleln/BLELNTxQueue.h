@@ -0,0 +1,90 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#ifndef MGLIGHTFW_BLELNTXQUEUE_H
+#define MGLIGHTFW_BLELNTXQUEUE_H
+
+#include <Arduino.h>
+#include <deque>
+#include "BLELNFragment.h"
+
+#define BLELN_TX_QUEUE_MAX_BYTES    (2 * BLELN_FRAG_FRAME_MAX_LEN)  // Two longest messages waiting per connection
+#define BLELN_TX_CREDITS            4       // Notifications of one connection per worker round - others wait their turn
+#define BLELN_TX_RETRY_MS           10      // Back off after stack had no free buffers
+#define BLELN_TX_MAX_RETRIES        50      // Of one notification, rest of its message is dropped after
+
+
+// Characteristic which notification goes through
+enum class BLELNTxChannel : uint8_t {Data, Key, Group};
+
+// Transmit counters of server, since start
+struct BLELNTxStats {
+    uint32_t sent= 0;           // Notifications accepted by stack
+    uint32_t retries= 0;        // Notifications refused by stack and repeated later
+    uint32_t dropped= 0;        // Messages lost - queue full or too many retries
+    uint16_t depthMax= 0;       // Most notifications waiting in one connection queue
+};
+
+
+/**
+ * Notifications waiting for one connection, of all its characteristics. Message is queued whole (all its
+ * fragments) or not at all, and notifications leave in order, so the client never gets a gap other than
+ * a dropped message end.
+ */
+class BLELNTxQueue {
+public:
+    // Frame v3 and broadcasts - splits frame into fragments of fragMaxLen bytes
+    bool pushFragmented(const std::string &frame, size_t fragMaxLen, uint8_t msgSeq, BLELNTxChannel channel);
+    // Frame v1/v2 and key packets - one notification
+    bool push(const std::string &frame, BLELNTxChannel channel);
+
+    bool empty() const;
+    uint16_t depth() const;
+    const std::string& front() const;
+    BLELNTxChannel getFrontChannel() const;
+    void pop();
+    // Drops notifications up to the end of message at front
+    void dropMessage();
+    void clear();
+
+    // Worker round: credits are refilled every round, taken by every notification stack accepted
+    void refillCredits();
+    bool takeCredit();
+
+    // Failed notification at front - true when it may be repeated, after backoff
+    bool failFront(unsigned long now);
+    bool isBackingOff(unsigned long now) const;
+
+private:
+    struct Pdu {
+        std::string data;
+        bool last;          // Last fragment of message
+        BLELNTxChannel channel;
+    };
+
+    std::deque<Pdu> pdus;
+    size_t bytes= 0;
+    uint8_t credits= BLELN_TX_CREDITS;
+    uint8_t frontRetries= 0;
+    unsigned long retryAt= 0;
+};
+
+
+#endif //MGLIGHTFW_BLELNTXQUEUE_H
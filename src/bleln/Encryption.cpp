@@ -28,6 +28,8 @@
 #include <mbedtls/base64.h>
 
 bool Encryption::rngInitialised=false;
+bool Encryption::p256Loaded=false;
+mbedtls_ecp_group Encryption::p256Group;
 mbedtls_entropy_context Encryption::entropy;
 mbedtls_ctr_drbg_context Encryption::ctr_drbg;
 
@@ -40,6 +42,32 @@ void Encryption::randomizer_init() {
                               (const unsigned char *) pers, strlen(pers));
         rngInitialised = true;
     }
+
+    p256();
+}
+
+mbedtls_ecp_group *Encryption::p256() {
+    if(!p256Loaded) {
+        mbedtls_ecp_group_init(&p256Group);
+        if(mbedtls_ecp_group_load(&p256Group, MBEDTLS_ECP_DP_SECP256R1)!=0) {
+            mbedtls_ecp_group_free(&p256Group);
+            return nullptr;
+        }
+
+        // First multiplication by G builds its comb table inside the group. Do it here, while still
+        // single threaded, so concurrent users later only read the table.
+        mbedtls_mpi d;
+        mbedtls_ecp_point Q;
+        mbedtls_mpi_init(&d);
+        mbedtls_ecp_point_init(&Q);
+        mbedtls_ecp_gen_keypair(&p256Group, &d, &Q, hw_random, nullptr);
+        mbedtls_mpi_free(&d);
+        mbedtls_ecp_point_free(&Q);
+
+        p256Loaded= true;
+    }
+
+    return &p256Group;
 }
 
 void Encryption::random_bytes(uint8_t *out, size_t len) {
@@ -47,6 +75,11 @@ void Encryption::random_bytes(uint8_t *out, size_t len) {
     esp_fill_random(out, len);
 }
 
+int Encryption::hw_random(void *ctx, unsigned char *out, size_t len) {
+    esp_fill_random(out, len);
+    return 0;
+}
+
 void
 Encryption::hkdf_sha256(const uint8_t *salt, size_t salt_len, const uint8_t *ikm, size_t ikm_len, const uint8_t *info,
                         size_t info_len, uint8_t *okm, size_t okm_len) {
@@ -71,35 +104,43 @@ Encryption::hkdf_sha256(const uint8_t *salt, size_t salt_len, const uint8_t *ikm
     mbedtls_md_free(&ctx);
 }
 
-bool Encryption::ecdh_gen(uint8_t *pub65, mbedtls_ecp_group &g, mbedtls_mpi &d) {
+bool Encryption::ecdh_gen(uint8_t *pub65, mbedtls_mpi &d) {
     mbedtls_ecp_point Q{};
 
-    mbedtls_ecp_group_init(&g);
     mbedtls_mpi_init(&d);
     mbedtls_ecp_point_init(&Q);
-    if(mbedtls_ecp_group_load(&g, MBEDTLS_ECP_DP_SECP256R1)!=0)
+    mbedtls_ecp_group *g= p256();
+    if(g== nullptr)
         return false;
 
-    if(mbedtls_ecp_gen_keypair(&g,&d,&Q,mbedtls_ctr_drbg_random,&ctr_drbg)!=0)
+    // Hardware RNG - keys are generated by BLELNKeyPool task and BLELN workers at the same time
+    if(mbedtls_ecp_gen_keypair(g,&d,&Q,hw_random,nullptr)!=0) {
+        mbedtls_ecp_point_free(&Q);
         return false;
+    }
 
     size_t olen=0;
-    if(mbedtls_ecp_point_write_binary(&g,&Q,MBEDTLS_ECP_PF_UNCOMPRESSED,&olen,pub65,65)!=0)
-        return false;
+    int r= mbedtls_ecp_point_write_binary(g,&Q,MBEDTLS_ECP_PF_UNCOMPRESSED,&olen,pub65,65);
+    mbedtls_ecp_point_free(&Q);
 
-    return (olen==65 && pub65[0]==0x04);
+    return (r==0 && olen==65 && pub65[0]==0x04);
 }
 
-bool Encryption::ecdh_shared(const mbedtls_ecp_group &g, const mbedtls_mpi &d, const uint8_t *pub65, uint8_t *out) {
+bool Encryption::ecdh_shared(const mbedtls_mpi &d, const uint8_t *pub65, uint8_t *out) {
+    mbedtls_ecp_group *g= p256();
+    if(g== nullptr)
+        return false;
+
     mbedtls_ecp_point P;
     mbedtls_ecp_point_init(&P);
-    if(mbedtls_ecp_point_read_binary(&g,&P,pub65,65)!=0){
+    if(mbedtls_ecp_point_read_binary(g,&P,pub65,65)!=0){
         mbedtls_ecp_point_free(&P);
         return false;
     }
     mbedtls_mpi sh;
     mbedtls_mpi_init(&sh);
-    if(mbedtls_ecdh_compute_shared((mbedtls_ecp_group*)&g,&sh,&P,(mbedtls_mpi*)&d,mbedtls_ctr_drbg_random,&ctr_drbg)!=0){
+    // Blinding from hardware RNG too - shared secrets are computed by both BLELN workers at the same time
+    if(mbedtls_ecdh_compute_shared(g,&sh,&P,(mbedtls_mpi*)&d,hw_random,nullptr)!=0){
         mbedtls_ecp_point_free(&P); mbedtls_mpi_free(&sh);
         return false;
     }
@@ -120,18 +161,10 @@ bool Encryption::decryptAESGCM(const uint8_t *ct, size_t ctLen, const uint8_t *i
         return false;
     }
 
-    out->resize(ctLen);
-    int rc = mbedtls_gcm_auth_decrypt(&gcm, ctLen,
-                                      iv, 12,
-                                      aad, 12,
-                                      tag, 16,
-                                      ct, (unsigned char*)out->data());
+    bool r= decryptAESGCM(&gcm, ct, ctLen, iv, tag, aad, out);
     mbedtls_gcm_free(&gcm);
-    if (rc != 0) {
-        return false;
-    }
 
-    return true;
+    return r;
 }
 
 bool Encryption::encryptAESGCM(const std::string *in, uint8_t *iv, uint8_t *tag,
@@ -143,63 +176,57 @@ bool Encryption::encryptAESGCM(const std::string *in, uint8_t *iv, uint8_t *tag,
         mbedtls_gcm_free(&g); return false;
     }
 
-    if (mbedtls_gcm_crypt_and_tag(&g, MBEDTLS_GCM_ENCRYPT, in->length(),
+    bool r= encryptAESGCM(&g, in, iv, tag, aad, out);
+    mbedtls_gcm_free(&g);
+
+    return r;
+}
+
+bool Encryption::decryptAESGCM(mbedtls_gcm_context *gcm, const uint8_t *ct, size_t ctLen, const uint8_t *iv,
+                               const uint8_t *tag, uint8_t *aad, std::string *out) {
+    out->resize(ctLen);
+    int rc = mbedtls_gcm_auth_decrypt(gcm, ctLen,
+                                      iv, 12,
+                                      aad, 12,
+                                      tag, 16,
+                                      ct, (unsigned char*)out->data());
+    if (rc != 0) {
+        return false;
+    }
+
+    return true;
+}
+
+bool Encryption::encryptAESGCM(mbedtls_gcm_context *gcm, const std::string *in, uint8_t *iv, uint8_t *tag,
+                               uint8_t *aad, std::string *out) {
+    if (mbedtls_gcm_crypt_and_tag(gcm, MBEDTLS_GCM_ENCRYPT, in->length(),
                                   iv, 12, aad, 12,
                                   reinterpret_cast<const unsigned char *>(in->c_str()), (uint8_t*)out->data(), 16, tag) != 0) {
-        mbedtls_gcm_free(&g);
         return false;
     }
-    mbedtls_gcm_free(&g);
 
     return true;
 }
 
 
-bool Encryption::verifySign_ECDSA_P256(const uint8_t* data, size_t dataLen,
-                                       const uint8_t* signature, size_t sigLen,
-                                       const uint8_t* pubKeyRaw, size_t pubKeyLen){
-    // Przyjmujemy: ECDSA P-256, surowy podpis R||S (64 bajty) i klucz publiczny w formacie
+bool Encryption::readPubKey_P256(const uint8_t *pubKeyRaw, size_t pubKeyLen, mbedtls_ecp_point &pubKey) {
+    // Przyjmujemy klucz publiczny w formacie
     //  - 65 bajtów: [0x04 | X(32) | Y(32)]  (nieskompresowany)
     //  - 64 bajty:  [X(32) | Y(32)]         (bez prefiksu – dodamy sami)
 
-    constexpr size_t P256_RS_SIG_LEN        = 64;
     constexpr size_t P256_UNCOMP_PUBKEY_LEN = 65;
     constexpr size_t P256_COORD_LEN         = 32;
 
-    int ret = 0;
-
-    if (data == nullptr || dataLen == 0 ||
-        signature == nullptr || sigLen != P256_RS_SIG_LEN ||
-        pubKeyRaw == nullptr ||
+    mbedtls_ecp_group *g= p256();
+    if (g == nullptr || pubKeyRaw == nullptr ||
         (pubKeyLen != P256_UNCOMP_PUBKEY_LEN && pubKeyLen != 2 * P256_COORD_LEN)) {
         return false;
     }
 
-    mbedtls_ecp_group group;
-    mbedtls_ecp_point Q;
-    mbedtls_mpi r, s;
-    unsigned char hash[32] = {0};
     unsigned char pubKeyBuf[P256_UNCOMP_PUBKEY_LEN];
-
-    mbedtls_ecp_group_init(&group);
-    mbedtls_ecp_point_init(&Q);
-    mbedtls_mpi_init(&r);
-    mbedtls_mpi_init(&s);
-
-    ret = mbedtls_sha256_ret(data, dataLen, hash, 0 /* is224 = 0 => SHA-256 */);
-    if (ret != 0) {
-        goto cleanup;
-    }
-
-    ret = mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1);
-    if (ret != 0) {
-        goto cleanup;
-    }
-
     if (pubKeyLen == P256_UNCOMP_PUBKEY_LEN) {
         if (pubKeyRaw[0] != 0x04) {
-            ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
-            goto cleanup;
+            return false;
         }
         memcpy(pubKeyBuf, pubKeyRaw, P256_UNCOMP_PUBKEY_LEN);
     } else {
@@ -207,12 +234,50 @@ bool Encryption::verifySign_ECDSA_P256(const uint8_t* data, size_t dataLen,
         memcpy(pubKeyBuf + 1, pubKeyRaw, 2 * P256_COORD_LEN);
     }
 
-    ret = mbedtls_ecp_point_read_binary(&group, &Q, pubKeyBuf, P256_UNCOMP_PUBKEY_LEN);
-    if (ret != 0) {
-        goto cleanup;
+    if (mbedtls_ecp_point_read_binary(g, &pubKey, pubKeyBuf, P256_UNCOMP_PUBKEY_LEN) != 0) {
+        return false;
     }
 
-    ret = mbedtls_ecp_check_pubkey(&group, &Q);
+    return mbedtls_ecp_check_pubkey(g, &pubKey) == 0;
+}
+
+bool Encryption::verifySign_ECDSA_P256(const uint8_t* data, size_t dataLen,
+                                       const uint8_t* signature, size_t sigLen,
+                                       const uint8_t* pubKeyRaw, size_t pubKeyLen){
+    mbedtls_ecp_point Q;
+    mbedtls_ecp_point_init(&Q);
+
+    bool r= readPubKey_P256(pubKeyRaw, pubKeyLen, Q) and
+            verifySign_ECDSA_P256(data, dataLen, signature, sigLen, Q);
+
+    mbedtls_ecp_point_free(&Q);
+    return r;
+}
+
+bool Encryption::verifySign_ECDSA_P256(const uint8_t *data, size_t dataLen,
+                                       const uint8_t *signature, size_t sigLen,
+                                       const mbedtls_ecp_point &pubKey) {
+    // Przyjmujemy: ECDSA P-256, surowy podpis R||S (64 bajty)
+
+    constexpr size_t P256_RS_SIG_LEN        = 64;
+    constexpr size_t P256_COORD_LEN         = 32;
+
+    int ret = 0;
+
+    mbedtls_ecp_group *group= p256();
+    if (group == nullptr ||
+        data == nullptr || dataLen == 0 ||
+        signature == nullptr || sigLen != P256_RS_SIG_LEN) {
+        return false;
+    }
+
+    mbedtls_mpi r, s;
+    unsigned char hash[32] = {0};
+
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    ret = mbedtls_sha256_ret(data, dataLen, hash, 0 /* is224 = 0 => SHA-256 */);
     if (ret != 0) {
         goto cleanup;
     }
@@ -227,12 +292,10 @@ bool Encryption::verifySign_ECDSA_P256(const uint8_t* data, size_t dataLen,
         goto cleanup;
     }
 
-    ret = mbedtls_ecdsa_verify(&group, hash, sizeof(hash), &Q, &r, &s);
+    ret = mbedtls_ecdsa_verify(group, hash, sizeof(hash), &pubKey, &r, &s);
 
     cleanup:
     mbedtls_platform_zeroize(hash, sizeof(hash));
-    mbedtls_ecp_group_free(&group);
-    mbedtls_ecp_point_free(&Q);
     mbedtls_mpi_free(&r);
     mbedtls_mpi_free(&s);
 
@@ -263,10 +326,12 @@ bool Encryption::signData_ECDSA_P256(const uint8_t* data, size_t dataLen,
 
     unsigned char hash[32] = {0};
 
-    mbedtls_ecp_group group;
+    mbedtls_ecp_group *group= p256();
+    if (group == nullptr) {
+        return false;
+    }
     mbedtls_mpi d, r, s;
 
-    mbedtls_ecp_group_init(&group);
     mbedtls_mpi_init(&d);
     mbedtls_mpi_init(&r);
     mbedtls_mpi_init(&s);
@@ -276,22 +341,17 @@ bool Encryption::signData_ECDSA_P256(const uint8_t* data, size_t dataLen,
         goto cleanup;
     }
 
-    ret = mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1);
-    if (ret != 0) {
-        goto cleanup;
-    }
-
     ret = mbedtls_mpi_read_binary(&d, privKeyD, P256_D_LEN);
     if (ret != 0) {
         goto cleanup;
     }
 
-    if (mbedtls_mpi_cmp_int(&d, 0) == 0 || mbedtls_mpi_cmp_mpi(&d, &group.N) >= 0) {
+    if (mbedtls_mpi_cmp_int(&d, 0) == 0 || mbedtls_mpi_cmp_mpi(&d, &group->N) >= 0) {
         ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
         goto cleanup;
     }
 
-    ret = mbedtls_ecdsa_sign_det(&group, &r, &s, &d, hash, sizeof(hash), MBEDTLS_MD_SHA256);
+    ret = mbedtls_ecdsa_sign_det(group, &r, &s, &d, hash, sizeof(hash), MBEDTLS_MD_SHA256);
     if (ret != 0) {
         goto cleanup;
     }
@@ -308,7 +368,6 @@ bool Encryption::signData_ECDSA_P256(const uint8_t* data, size_t dataLen,
 
     cleanup:
     mbedtls_platform_zeroize(hash, sizeof(hash));
-    mbedtls_ecp_group_free(&group);
     mbedtls_mpi_free(&d);
     mbedtls_mpi_free(&r);
     mbedtls_mpi_free(&s);
@@ -331,10 +390,11 @@ std::string Encryption::base64Encode(uint8_t *data, size_t dlen) {
 }
 
 size_t Encryption::base64Decode(const std::string &in, uint8_t *out, size_t outLen) {
-    size_t rlen;
+    size_t rlen= 0;
     if(mbedtls_base64_decode(out, outLen, &rlen,
                           reinterpret_cast<const unsigned char *>(in.c_str()), in.size())){
         Serial.println("Encryption - base64Decode - failed decoding!");
+        return 0;
     }
 
     return rlen;
@@ -25,6 +25,7 @@
 #include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/ecp.h>
+#include <mbedtls/gcm.h>
 
 class Encryption {
 public:
@@ -36,8 +37,11 @@ public:
                             const uint8_t* info, size_t info_len,
                             uint8_t* okm, size_t okm_len);
 
-    static bool ecdh_gen(uint8_t *pub65, mbedtls_ecp_group &g, mbedtls_mpi &d);
-    static bool ecdh_shared(const mbedtls_ecp_group &g, const mbedtls_mpi &d, const uint8_t *pub65, uint8_t *out);
+    // Process wide P-256 group. Loaded once, with comb table for G precomputed before anyone shares it.
+    static mbedtls_ecp_group* p256();
+
+    static bool ecdh_gen(uint8_t *pub65, mbedtls_mpi &d);
+    static bool ecdh_shared(const mbedtls_mpi &d, const uint8_t *pub65, uint8_t *out);
 
     static std::string base64Encode(uint8_t *data, size_t dlen);
     static size_t base64Decode(const std::string &in, uint8_t *out, size_t outLen);
@@ -46,15 +50,29 @@ public:
                               uint8_t *aad, std::string *out, uint8_t *key);
     static bool encryptAESGCM(const std::string *in, uint8_t *iv, uint8_t *tag,
                               uint8_t *aad, std::string *out, uint8_t *key);
+    // Same as above, with context already keyed by mbedtls_gcm_setkey() - no key schedule per message
+    static bool decryptAESGCM(mbedtls_gcm_context *gcm, const uint8_t* ct, size_t ctLen, const uint8_t *iv,
+                              const uint8_t *tag, uint8_t *aad, std::string *out);
+    static bool encryptAESGCM(mbedtls_gcm_context *gcm, const std::string *in, uint8_t *iv, uint8_t *tag,
+                              uint8_t *aad, std::string *out);
 
     static bool signData_ECDSA_P256(const uint8_t* data, size_t dataLen,
                                     const uint8_t* privKeyD, size_t privKeyDLen,
                                     uint8_t* signatureOut, size_t sigOutLen);
     static bool verifySign_ECDSA_P256(const uint8_t* data, size_t dataLen, const uint8_t* signature, size_t sigLen,
                                       const uint8_t* pubKeyRaw, size_t pubKeyLen);
+    // Same as above, with public key already parsed and checked by readPubKey_P256()
+    static bool verifySign_ECDSA_P256(const uint8_t* data, size_t dataLen, const uint8_t* signature, size_t sigLen,
+                                      const mbedtls_ecp_point &pubKey);
+    // Public key 65B [0x04|X|Y] or 64B [X|Y] -> point on P-256
+    static bool readPubKey_P256(const uint8_t* pubKeyRaw, size_t pubKeyLen, mbedtls_ecp_point &pubKey);
 
 private:
+    static int hw_random(void *ctx, unsigned char *out, size_t len);
+
     static bool rngInitialised;
+    static bool p256Loaded;
+    static mbedtls_ecp_group p256Group;
     static mbedtls_entropy_context entropy;
     static mbedtls_ctr_drbg_context ctr_drbg;
 };
@@ -74,13 +74,14 @@ void Connectivity::loop() {
 }
 
 void Connectivity::startAPITalk(const std::string& apiPoint, char method, uint8_t *mac, char* picklock, const std::string& data) {
+    char macBuf[13];
+    sprintf(macBuf, "%02X%02X%02X%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
     if(conMode==ConnectivityMode::ClientMode) {
         prefs->putBool(RECENTLY_HAS_BEEN_SERVER_PREFS_TAG, false);
-        //conClient->startAPITalk(apiPoint, method, data);
+        conClient->startAPITalk(apiPoint, method, macBuf, picklock, data);
     } else if(conMode==ConnectivityMode::ServerMode) {
         prefs->putBool(RECENTLY_HAS_BEEN_SERVER_PREFS_TAG, true);
-        char macBuf[13];
-        sprintf(macBuf, "%02X%02X%02X%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
         conServer->requestApiTalk(method, macBuf, picklock, apiPoint, data);
     }
 }
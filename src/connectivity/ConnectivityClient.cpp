@@ -19,6 +19,8 @@
 */
 
 #include "ConnectivityClient.h"
+#include "TimeSource.h"
+#include "../bleln/BLELNServerLoad.h"
 
 #include <utility>
 
@@ -30,9 +32,9 @@ ConnectivityClient::ConnectivityClient(DeviceConfig *deviceConfig, WiFiManager *
     rmc= std::move(requestModeChange);
     state= State::Init;
     connectedFor= ConnectedFor::None;
-    meApiTalkRequested= false;
     wm= wifiManager;
     meApiTalkMutex= xSemaphoreCreateMutex();
+    serverRankMutex= xSemaphoreCreateMutex();
 }
 
 
@@ -42,35 +44,28 @@ void ConnectivityClient::loop() {
         blelnClient.start(BLE_NAME, [this](const std::string& msg){
             this->onServerResponse(msg);
         });
-        lastTimeSync = (millis() - CLIENT_TIME_SYNC_INTERVAL) + 8000; // First time sync in 4 seconds
+        lastTimeSync = (TimeSource::millis() - CLIENT_TIME_SYNC_INTERVAL) + 8000; // First time sync in 4 seconds
         firstServerCheckMade= false;
         uint32_t r= (esp_random() / (UINT32_MAX/5))+1;
         Serial.printf("Client mode - First server check in %d seconds\r\n", r*1);
-        lastServerCheck = (millis() - CLIENT_SERVER_CHECK_INTERVAL) + 1000ul*r; // Instant server check + x seconds random
+        lastServerCheck = (TimeSource::millis() - CLIENT_SERVER_CHECK_INTERVAL) + 1000ul*r; // Instant server check + x seconds random
         state = State::Idle;
-    } else if(state == State::Idle){
-        if(firstServerCheckMade and meApiTalkRequested){
-            if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(5))==pdTRUE) {
-                Serial.println("Client mode - Start API Talk");
-                state = State::ServerSearching;
-                blelnClient.startServerSearch(5000, BLELN_HTTP_REQUESTER_UUID,
-                                              [this](const NimBLEAdvertisedDevice *dev) {
-                                                  this->onServerSearchResult(dev);
-                                              });
-                connectedFor= ConnectedFor::APITalk;
-                meApiTalkRequested = false;
-                xSemaphoreGive(meApiTalkMutex);
-            }
-        } else if(firstServerCheckMade and ((millis() - lastTimeSync) >= (CLIENT_TIME_SYNC_INTERVAL)) ){
+        return;
+    }
+
+    expireApiTalks();
+
+    if(state == State::Idle){
+        if(firstServerCheckMade and hasApiTalksQueued()){
+            Serial.println("Client mode - Start API Talk");
+            startServerConnect();
+            connectedFor= ConnectedFor::APITalk;
+        } else if(firstServerCheckMade and ((TimeSource::millis() - lastTimeSync) >= (CLIENT_TIME_SYNC_INTERVAL)) ){
             Serial.println("Client mode - Start time sync");
-            state = State::ServerSearching;
-            blelnClient.startServerSearch(5000, BLELN_HTTP_REQUESTER_UUID,
-                                          [this](const NimBLEAdvertisedDevice *dev) {
-                                              this->onServerSearchResult(dev);
-                                          });
+            startServerConnect();
             connectedFor= ConnectedFor::TimeSync;
-            lastTimeSync = (millis() - CLIENT_TIME_SYNC_INTERVAL) + 8000ul;
-        } else if((millis() - lastServerCheck) >= CLIENT_SERVER_CHECK_INTERVAL){
+            lastTimeSync = (TimeSource::millis() - CLIENT_TIME_SYNC_INTERVAL) + 8000ul;
+        } else if((TimeSource::millis() - lastServerCheck) >= CLIENT_SERVER_CHECK_INTERVAL){
             Serial.println("Client mode - Start server check");
             state= State::ServerChecking;
             blelnClient.startServerSearch(5000, BLELN_HTTP_REQUESTER_UUID,
@@ -78,33 +73,83 @@ void ConnectivityClient::loop() {
                                               this->onServerSearchResult(dev);
                                           });
             firstServerCheckMade= true;
-            lastServerCheck= millis();
+            lastServerCheck= TimeSource::millis();
         }
+    } else if(state == State::ServerSearching) {
+        connectBestServer();
     } else if(state == State::ServerConnecting) {
 
+    } else if(state == State::ServerAttached){
+        // Session is kept open - requests go out without server search, connection and handshake
+        lastServerCheck= TimeSource::millis();
+
+        if(!blelnClient.isConnected()){
+            Serial.println("Client mode - Server connection lost");
+            state= State::Idle;
+        } else if(hasApiTalksQueued()){
+            Serial.println("Client mode - Start API Talk");
+            connectedFor= ConnectedFor::APITalk;
+            state= State::ServerConnected;
+        } else if((TimeSource::millis() - lastTimeSync) >= CLIENT_TIME_SYNC_INTERVAL){
+            Serial.println("Client mode - Start time sync");
+            connectedFor= ConnectedFor::TimeSync;
+            lastTimeSync = (TimeSource::millis() - CLIENT_TIME_SYNC_INTERVAL) + 8000ul;
+            linkWoken= false;
+            state= State::ServerConnected;
+        } else if(!linkWoken and (TimeSource::millis() - lastTimeSync) + CLIENT_LINK_WAKE_LEAD_MS >= CLIENT_TIME_SYNC_INTERVAL){
+            // Round trip of $NTP should not wait for connection events skipped by idle link. API talks go out
+            // right away - their first message makes the link fast sooner than waking it would.
+            blelnClient.wakeLink();
+            linkWoken= true;
+        } else if(keepalivePending and (TimeSource::millis() - lastServerMessage) >= CLIENT_KEEPALIVE_INTERVAL + CLIENT_KEEPALIVE_TIMEOUT){
+            Serial.println("Client mode - Server keepalive timeout");
+            blelnClient.disconnect();
+            state= State::Idle;
+        } else if(!keepalivePending and (TimeSource::millis() - lastServerMessage) >= CLIENT_KEEPALIVE_INTERVAL){
+            blelnClient.sendEncrypted("$PING");
+            keepalivePending= true;
+        }
     } else if(state == State::ServerConnected){
-        if(connectedFor == ConnectedFor::APITalk){
-            char buf[128];
-            if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(50))==pdTRUE){
-                sprintf(buf, "$ATRQ,1,%s,%c,%s,%s,%s",meApiTalkPoint.c_str(),meApiTalkMethod,meApiTalkMAC.c_str(),meApiTalkPicklock.c_str(),meApiTalkData.c_str());
-                xSemaphoreGive(meApiTalkMutex);
-
-                blelnClient.sendEncrypted(buf);
-                state=State::WaitingForHTTPResponse;
-            }
-        } else if(connectedFor == ConnectedFor::TimeSync){
+        if(connectedFor == ConnectedFor::TimeSync){
             blelnClient.sendEncrypted("$NTP");
-            state=State::WaitingForHTTPResponse;
+            ntpPending= true;
+            ntpSentAt= TimeSource::millis();
         }
-
-        // TODO: Add max semaphore take tries
+        // API talks queued so far go out in this session, whatever it was started for
+        sendApiTalks();
+        state=State::WaitingForHTTPResponse;
     } else if(state == State::WaitingForHTTPResponse){
-        // TODO: Add timeout
+        if(!blelnClient.isConnected()){
+            Serial.println("Client mode - Server connection lost");
+            dropApiTalks(false);
+            ntpPending= false;
+            state= State::Idle;
+        } else {
+            // Requests queued meanwhile are pipelined behind the ones in flight
+            sendApiTalks();
+            if(ntpPending and (TimeSource::millis() - ntpSentAt) >= CLIENT_API_TALK_TIMEOUT_MS){
+                Serial.println("Client mode - Time sync timeout");
+                ntpPending= false;
+            }
+            if(!ntpPending and !hasApiTalksPending()){
+                state= State::HTTPResponseReceived;
+            }
+        }
     } else if(state == State::HTTPResponseReceived){
-        blelnClient.disconnect();
-        state= State::Idle;
+        if(CLIENT_PERSISTENT_CONNECTION and blelnClient.isConnected()){
+            linkWoken= false;
+            state= State::ServerAttached;
+        } else {
+            blelnClient.disconnect();
+            state= State::Idle;
+        }
+    } else if(state == State::KnownServerConnectFailed){
+        Serial.println("Client mode - Known server not answering. Searching...");
+        knownServerConnect= false;
+        startServerSearch();
     } else if(state == State::ServerConnectFailed){
         // TODO: Handle BLELN server connect failed - possibly server had max clients
+        state= State::Idle;
     } else if(state == State::ServerNotFound){
         // Start WiFi check
         Serial.println("Client mode - No server, checking WiFi...");
@@ -125,23 +170,48 @@ void ConnectivityClient::loop() {
 
 
 void ConnectivityClient::onServerResponse(const std::string &msg) {
+    // Any message proves server alive - keepalive waits for next quiet period
+    lastServerMessage= TimeSource::millis();
+    keepalivePending= false;
+
     StringList parts= splitCsvRespectingQuotes(msg);
-    if(parts[0]=="$ATRS" and parts.size()==5){
+    if(parts[0]=="$PONG"){
+        return;
+    } else if(parts[0]=="$ATRS" and parts.size()==5){
         int rid= strtol(parts[1].c_str(), nullptr, 10);
         int errc= strtol(parts[2].c_str(), nullptr, 10);
         int httpCode= strtol(parts[3].c_str(), nullptr, 10);
-        if(rid!=0){
-            if(oar)
-                oar(rid, errc, httpCode, parts[4]);
-        }
 
-        if(state == State::WaitingForHTTPResponse){
-            state= State::HTTPResponseReceived;
+        // Response to request which already timed out was reported as failed - it is dropped
+        bool mine= false;
+        if(xSemaphoreTake(meApiTalkMutex, portMAX_DELAY)==pdTRUE) {
+            for(auto it= meApiTalksInFlight.begin(); it != meApiTalksInFlight.end(); ++it){
+                if(it->id == rid){
+                    meApiTalksInFlight.erase(it);
+                    mine= true;
+                    break;
+                }
+            }
+            xSemaphoreGive(meApiTalkMutex);
         }
+
+        if(mine and oar)
+            oar(rid, errc, httpCode, parts[4]);
     } else if(parts[0]=="$HDSH" and parts.size()==2 and parts[1]=="OK"){
-        if(state == State::ServerConnecting)
+        if(state == State::ServerConnecting) {
+            unsigned long ms= TimeSource::millis() - connectStart;
+            if(knownServerConnect){
+                connectStats.knownHits++;
+                connectStats.knownMsSum+= ms;
+            } else {
+                connectStats.scanned++;
+                connectStats.scannedMsSum+= ms;
+            }
+            Serial.printf("Client mode - Server connected in %lu ms%s, known server hits: %u/%u, saved per request: %ld ms\r\n",
+                          ms, knownServerConnect ? " (known)" : "", connectStats.knownHits, connectStats.knownTries,
+                          connectStats.savedMsPerRequest());
             state= State::ServerConnected;
-        else{
+        } else {
             // TODO: Why HDSH received?? Error?
         }
     } else if(parts[0]=="$NTP" and parts.size()==2){
@@ -149,22 +219,82 @@ void ConnectivityClient::onServerResponse(const std::string &msg) {
         setenv("TZ", config->getTimezone(), 1);
         tzset();
 
-        struct timeval tv{};
-        tv.tv_sec = nows;
-        tv.tv_usec = 0;
-        settimeofday(&tv, nullptr);
+        TimeSource::setNow(nows);
 
         struct tm timeinfo{};
-        getLocalTime(&timeinfo);
+        TimeSource::localTime(&timeinfo);
         Serial.print(F("Client mode: Time synced - "));
         Serial.println(asctime(&timeinfo));
 
-        if(state == State::WaitingForHTTPResponse){
-            state= State::HTTPResponseReceived;
-        }
+        ntpPending= false;
+        lastTimeSync= TimeSource::millis();
+    }
+}
+
+
+void ConnectivityClient::startServerConnect() {
+    connectStart= TimeSource::millis();
+
+    if(blelnClient.hasKnownServer()){
+        knownServerConnect= true;
+        connectStats.knownTries++;
+        state= State::ServerConnecting;
+        blelnClient.beginConnectKnown([this](bool success, int errc) {
+            if(!success)
+                this->state= State::KnownServerConnectFailed;
+        });
+    } else {
+        knownServerConnect= false;
+        startServerSearch();
+    }
+}
+
+void ConnectivityClient::startServerSearch() {
+    if(xSemaphoreTake(serverRankMutex, portMAX_DELAY)==pdTRUE) {
+        bestServerFound= false;
+        xSemaphoreGive(serverRankMutex);
+    }
+
+    state= State::ServerSearching;
+    blelnClient.startServerSearch(5000, BLELN_HTTP_REQUESTER_UUID,
+                                  [this](const NimBLEAdvertisedDevice *dev) {
+                                      this->onServerSearchResult(dev);
+                                  }, false);
+}
 
-        lastTimeSync= millis();
+void ConnectivityClient::connectBestServer() {
+    // Servers found in rank window compete - the least loaded one gets this client
+    bool pick= false;
+    NimBLEAddress addr;
+    int score= 0;
+    if(xSemaphoreTake(serverRankMutex, pdMS_TO_TICKS(5))==pdTRUE) {
+        if(bestServerFound and ((TimeSource::millis() - firstServerFoundAt) >= CLIENT_SERVER_RANK_WINDOW_MS
+                                or !blelnClient.isScanning())){
+            pick= true;
+            addr= bestServer;
+            score= bestServerScore;
+            bestServerFound= false;
+        }
+        xSemaphoreGive(serverRankMutex);
     }
+    if(!pick)
+        return;
+
+    blelnClient.stopServerSearch();
+    Serial.printf("Client mode - BLELN server found. Connecting... (%s, score: %d)\r\n", addr.toString().c_str(), score);
+    state = State::ServerConnecting;
+    blelnClient.beginConnect(addr, [this](bool success, int errc) {
+        if (!success) {
+            this->state= State::ServerConnectFailed;
+            Serial.print("BLELN server connect error: ");
+            Serial.println(errc);
+            if (errc == BLE_REASON_MAX_CLIENTS) {
+                // TODO: If failed due to max clients connected - retry
+            }
+            Serial.print("Failed connecting, reason: ");
+            Serial.println(errc);
+        }
+    });
 }
 
 
@@ -172,19 +302,25 @@ void ConnectivityClient::onServerSearchResult(const NimBLEAdvertisedDevice* dev)
     Serial.println("Client mode - onServerSearchResult");
     if (dev!= nullptr) {
         if(state == State::ServerSearching) {
-            Serial.println("Client mode - BLELN server found. Connecting...");
-            blelnClient.beginConnect(dev, [](bool success, int errc) {
-                if (!success) {
-                    Serial.print("BLELN server connect error: ");
-                    Serial.println(errc);
-                    if (errc == BLE_REASON_MAX_CLIENTS) {
-                        // TODO: If failed due to max clients connected - retry
-                    }
-                    Serial.print("Failed connecting, reason: ");
-                    Serial.println(errc);
+            BLELNServerLoad load;
+            int score= load.decode(dev->getServiceData(NimBLEUUID(BLELN_HTTP_REQUESTER_UUID)))
+                       ? load.score(dev->getRSSI()) : BLELNServerLoad::scoreUnknown(dev->getRSSI());
+            // Random part, less than one waiting request - clients scanning together see the same load
+            // and would all pick the same server
+            score+= (int)(esp_random() % 10);
+            Serial.printf("Client mode - BLELN server candidate %s, score: %d\r\n", dev->getAddress().toString().c_str(), score);
+
+            if(xSemaphoreTake(serverRankMutex, portMAX_DELAY)==pdTRUE) {
+                if(!bestServerFound){
+                    firstServerFoundAt= TimeSource::millis();
+                }
+                if(!bestServerFound or score > bestServerScore){
+                    bestServer= dev->getAddress();
+                    bestServerScore= score;
                 }
-            });
-            state = State::ServerConnecting;
+                bestServerFound= true;
+                xSemaphoreGive(serverRankMutex);
+            }
         } else if(state == State::ServerChecking){
             Serial.println("Client mode - BLELN server found. Continuing as client");
             state= State::Idle;
@@ -194,17 +330,24 @@ void ConnectivityClient::onServerSearchResult(const NimBLEAdvertisedDevice* dev)
             Serial.println("Client mode - BLELN server not found");
             state = State::ServerNotFound;
         } else if(state == State::ServerSearching){
-            Serial.println("Client mode - BLELN server not found. API talk failed.");
-            state = State::Idle;
+            // Scan ended - with a candidate loop connects to it
+            bool found= false;
+            if(xSemaphoreTake(serverRankMutex, portMAX_DELAY)==pdTRUE) {
+                found= bestServerFound;
+                xSemaphoreGive(serverRankMutex);
+            }
+            if(!found){
+                Serial.println("Client mode - BLELN server not found. API talk failed.");
+                state = State::Idle;
+            }
         }
     }
 }
 
 void ConnectivityClient::finish() {
-    if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(100))==pdTRUE) {
-        meApiTalkRequested= false;
-        xSemaphoreGive(meApiTalkMutex);
-    }
+    // Server mode takes API talks from now - ones not answered yet are reported as failed
+    dropApiTalks(true);
+    ntpPending= false;
     blelnClient.stop();
     state= State::Init;
 }
@@ -215,14 +358,95 @@ void ConnectivityClient::switchToServer() {
 }
 
 
-void ConnectivityClient::startAPITalk(const std::string& apiPoint, char method, const std::string &mac, const std::string &picklock, const std::string& data) {
+uint16_t ConnectivityClient::startAPITalk(const std::string& apiPoint, char method, const std::string &mac, const std::string &picklock, const std::string& data) {
+    uint16_t id= 0;
     if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(100))==pdTRUE) {
-        meApiTalkPoint = apiPoint;
-        meApiTalkMethod = method;
-        meApiTalkMAC= mac;
-        meApiTalkPicklock= picklock;
-        meApiTalkData = data;
-        meApiTalkRequested = true;
+        if(meApiTalksQueued.size() + meApiTalksInFlight.size() < CLIENT_API_TALKS_MAX){
+            id= meApiTalkNextId;
+            // 0 - no id, UINT16_MAX - servers own requests
+            meApiTalkNextId= (meApiTalkNextId >= UINT16_MAX-1) ? 1 : meApiTalkNextId+1;
+            meApiTalksQueued.push_back({id, method, apiPoint, mac, picklock, data, TimeSource::millis()});
+        }
+        xSemaphoreGive(meApiTalkMutex);
+    }
+
+    if(id == 0)
+        Serial.println("Client mode - API talks queue full, request refused");
+    return id;
+}
+
+bool ConnectivityClient::hasApiTalksQueued() {
+    bool r= false;
+    if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(5))==pdTRUE) {
+        r= !meApiTalksQueued.empty();
         xSemaphoreGive(meApiTalkMutex);
     }
+    return r;
+}
+
+bool ConnectivityClient::hasApiTalksPending() {
+    bool r= true;
+    if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(5))==pdTRUE) {
+        r= !meApiTalksQueued.empty() or !meApiTalksInFlight.empty();
+        xSemaphoreGive(meApiTalkMutex);
+    }
+    return r;
+}
+
+void ConnectivityClient::sendApiTalks() {
+    std::list<std::string> msgs;
+    if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(50))==pdTRUE) {
+        while(!meApiTalksQueued.empty() and meApiTalksInFlight.size() < CLIENT_API_TALKS_IN_FLIGHT_MAX){
+            const ApiTalk &t= meApiTalksQueued.front();
+            msgs.push_back("$ATRQ," + std::to_string(t.id) + "," + t.point + "," + t.method + "," + t.mac + ","
+                           + t.picklock + "," + t.data);
+            meApiTalksInFlight.splice(meApiTalksInFlight.end(), meApiTalksQueued, meApiTalksQueued.begin());
+        }
+        xSemaphoreGive(meApiTalkMutex);
+    }
+
+    // Outside of mutex - BLELN worker takes it for responses
+    for(auto &m: msgs)
+        blelnClient.sendEncrypted(m);
+}
+
+void ConnectivityClient::expireApiTalks() {
+    std::list<ApiTalk> expired;
+    if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(5))==pdTRUE) {
+        unsigned long now= TimeSource::millis();
+        for(auto *l: {&meApiTalksQueued, &meApiTalksInFlight}){
+            for(auto it= l->begin(); it != l->end();){
+                auto next= std::next(it);
+                if((now - it->createdAt) >= CLIENT_API_TALK_TIMEOUT_MS)
+                    expired.splice(expired.end(), *l, it);
+                it= next;
+            }
+        }
+        xSemaphoreGive(meApiTalkMutex);
+    }
+
+    for(auto &t: expired){
+        Serial.printf("Client mode - API talk %u timeout\r\n", t.id);
+        if(oar)
+            oar(t.id, API_TALK_ERRC_NOT_DELIVERED, 0, "");
+    }
+}
+
+void ConnectivityClient::dropApiTalks(bool queuedToo) {
+    std::list<ApiTalk> dropped;
+    if(xSemaphoreTake(meApiTalkMutex, pdMS_TO_TICKS(100))==pdTRUE) {
+        dropped.splice(dropped.end(), meApiTalksInFlight);
+        if(queuedToo)
+            dropped.splice(dropped.end(), meApiTalksQueued);
+        xSemaphoreGive(meApiTalkMutex);
+    }
+
+    for(auto &t: dropped){
+        if(oar)
+            oar(t.id, API_TALK_ERRC_NOT_DELIVERED, 0, "");
+    }
+}
+
+const ConnectivityClient::ConnectStats &ConnectivityClient::getConnectStats() const {
+    return connectStats;
 }
@@ -28,8 +28,19 @@
 #include "SuperString.h"
 #include "Connectivity.h"
 
+#include <list>
+
 #define CLIENT_SERVER_CHECK_INTERVAL        ((5*60)*1000ul)       // 5 min
 #define CLIENT_TIME_SYNC_INTERVAL           ((600)*1000ul)        // 10 min
+#define CLIENT_PERSISTENT_CONNECTION        true                  // Stay connected to server between requests
+#define CLIENT_KEEPALIVE_INTERVAL           ((60)*1000ul)         // 1 min without server messages
+#define CLIENT_KEEPALIVE_TIMEOUT            ((10)*1000ul)         // 10 s for $PONG
+#define CLIENT_LINK_WAKE_LEAD_MS            1500                  // Idle link is made fast this long before time sync
+#define CLIENT_SERVER_RANK_WINDOW_MS        400                   // Scan goes on after first server, the best one is picked
+#define CLIENT_API_TALKS_MAX                8                     // Queued and in flight - more are refused
+#define CLIENT_API_TALKS_IN_FLIGHT_MAX      4                     // $ATRQ sent and not answered yet, pipelined in one session
+#define CLIENT_API_TALK_TIMEOUT_MS          ((30)*1000ul)         // From startAPITalk to $ATRS
+#define API_TALK_ERRC_NOT_DELIVERED         4                     // No answer from BLELN server - timeout, connection lost
 #define WIFI_NTP_MAX_RETIRES                1
 #define BLE_REASON_MAX_CLIENTS              1 // TODO: Replace with real value
 
@@ -38,13 +49,31 @@ public:
     ConnectivityClient(DeviceConfig *deviceConfig, WiFiManager *wifiManager, Connectivity::OnApiResponseCb onApiResponse,
                        Connectivity::RequestModeChangeCb requestModeChange);
 
-    enum class State {Init, Idle, ServerSearching, ServerChecking, ServerConnecting, ServerConnected,
-        ServerNotFound, ServerConnectFailed, WaitingForHTTPResponse, HTTPResponseReceived, WiFiChecking, WiFiConnected, WiFiConnectFailed};
+    enum class State {Init, Idle, ServerSearching, ServerChecking, ServerConnecting, ServerConnected, ServerAttached,
+        ServerNotFound, ServerConnectFailed, KnownServerConnectFailed, WaitingForHTTPResponse, HTTPResponseReceived, WiFiChecking, WiFiConnected, WiFiConnectFailed};
     enum class ConnectedFor {None, APITalk, TimeSync, Update};
 
+    // How connections to server were made, since start - direct connects to known server save the scan
+    struct ConnectStats {
+        uint32_t knownTries= 0;         // Direct connects to known server
+        uint32_t knownHits= 0;          // ...which ended with handshake
+        uint32_t scanned= 0;            // Connections after scan, also fallbacks of missed direct connects
+        unsigned long knownMsSum= 0;    // Request start to handshake end
+        unsigned long scannedMsSum= 0;
+
+        uint32_t hitRatePct() const { return knownTries ? knownHits*100/knownTries : 0; }
+        long savedMsPerRequest() const {
+            if(knownHits == 0 or scanned == 0)
+                return 0;
+            return (long)(scannedMsSum/scanned) - (long)(knownMsSum/knownHits);
+        }
+    };
+
 
     void loop();
-    void startAPITalk(const std::string& apiPoint, char method, const std::string &mac, const std::string &picklock, const std::string& data); // Talk with API about me
+    // Talk with API about me. Returns request id passed to API response callback, 0 when queue is full.
+    uint16_t startAPITalk(const std::string& apiPoint, char method, const std::string &mac, const std::string &picklock, const std::string& data);
+    const ConnectStats& getConnectStats() const;
 private:
     DeviceConfig *config;
 
@@ -57,23 +86,52 @@ private:
 
     void onServerResponse(const std::string &msg);
     void onServerSearchResult(const NimBLEAdvertisedDevice* dev);
+    void startServerConnect();
+    void startServerSearch();
+    void connectBestServer();
+    bool hasApiTalksQueued();
+    bool hasApiTalksPending();
+    void sendApiTalks();
+    void expireApiTalks();
+    void dropApiTalks(bool queuedToo);
     void finish();
     void switchToServer();
     // Client mode variables
     unsigned long lastServerCheck=0;
     unsigned long lastTimeSync=0;
     ConnectedFor connectedFor;
+    unsigned long lastServerMessage=0;      // Persistent connection - keepalive is sent when server is quiet
+    bool keepalivePending= false;
+    bool linkWoken= false;
+    unsigned long connectStart=0;           // Of current request - connection time with scan or without
+    bool knownServerConnect= false;
+    ConnectStats connectStats;
+
+    // Server search - the best server of rank window, written by scan callbacks
+    SemaphoreHandle_t serverRankMutex;
+    bool bestServerFound= false;
+    NimBLEAddress bestServer;
+    int bestServerScore= 0;
+    unsigned long firstServerFoundAt= 0;
 
     WiFiManager *wm;
 
-    // My API Talk variables
+    // My API Talk variables - queued until there is a session, then in flight until their $ATRS
+    struct ApiTalk {
+        uint16_t id;
+        char method;
+        std::string point;
+        std::string mac;
+        std::string picklock;
+        std::string data;
+        unsigned long createdAt;
+    };
     SemaphoreHandle_t meApiTalkMutex;
-    bool meApiTalkRequested= false;
-    std::string meApiTalkMAC;
-    std::string meApiTalkPicklock;
-    std::string meApiTalkData;
-    std::string meApiTalkPoint;
-    char meApiTalkMethod='N';
+    std::list<ApiTalk> meApiTalksQueued;
+    std::list<ApiTalk> meApiTalksInFlight;
+    uint16_t meApiTalkNextId= 1;
+    bool ntpPending= false;
+    unsigned long ntpSentAt= 0;
 
     bool firstServerCheckMade= false;
 };
@@ -3,6 +3,7 @@
 //
 
 #include "ConnectivityConfig.h"
+#include "TimeSource.h"
 
 ConnectivityConfig::ConnectivityConfig(BLELNServer *blelnServer, Preferences *preferences, DeviceConfig* deviceConfig) {
     this->blelnServer= blelnServer;
@@ -48,7 +49,7 @@ void ConnectivityConfig::loop() {
         }
 
         if(rebootCalled){
-            if(rebootCalledAt + 2000 < millis()){
+            if(rebootCalledAt + 2000 < TimeSource::millis()){
                 ConfigManager::writeDeviceConfig(prefs, this->config);
                 esp_restart();
             }
@@ -115,7 +116,7 @@ void ConnectivityConfig::onMessageReceived(uint16_t cliH, const std::string &msg
             blelnServer->sendEncrypted(cliH, resp);
         }
     } else if(parts[0]=="$REBOOT"){
-        rebootCalledAt= millis();
+        rebootCalledAt= TimeSource::millis();
         rebootCalled= true;
     }
 }
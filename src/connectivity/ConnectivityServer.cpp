@@ -21,6 +21,8 @@
 #include <memory>
 #include <utility>
 #include "ConnectivityServer.h"
+#include "TimeSource.h"
+#include <ArduinoJson.h>
 
 ConnectivityServer::ConnectivityServer(BLELNServer *blelnServer, DeviceConfig *deviceConfig, Preferences *preferences,
                                        WiFiManager *wifiManager, Connectivity::OnApiResponseCb onApiResponse,
@@ -35,6 +37,11 @@ ConnectivityServer::ConnectivityServer(BLELNServer *blelnServer, DeviceConfig *d
     apiTalksRequestQueue= nullptr;
     apiTalksResponseQueue= nullptr;
     wm= wifiManager;
+
+    // API host of api_url, connected by name for TLS server name and certificate check
+    size_t hostStart= api_url.find("://");
+    hostStart= (hostStart == std::string::npos) ? 0 : hostStart + 3;
+    apiHost= api_url.substr(hostStart, api_url.find('/', hostStart) - hostStart);
 }
 
 void ConnectivityServer::loop() {
@@ -59,19 +66,25 @@ void ConnectivityServer::loop() {
 
 
     } else if(state==ServerModeState::Idle){
+        // Clients pick the least loaded server by its advertising
+        if((TimeSource::millis() - lastLoadUpdate) >= BLELN_SERVER_LOAD_UPDATE_MS){
+            lastLoadUpdate= TimeSource::millis();
+            blelnServer->setLoad(uxQueueMessagesWaiting(apiTalksRequestQueue), wm->getRssi());
+        }
+
         if(wm->isConnected()) {
             handleAPIResponse();
 
             if (blelnServer->noClientsConnected() and
-                ((millis() - lastServerSearch) >= BLELN_SERVER_SEARCH_INTERVAL_MS)) {
-                lastServerSearch = millis();
+                ((TimeSource::millis() - lastServerSearch) >= BLELN_SERVER_SEARCH_INTERVAL_MS)) {
+                lastServerSearch = TimeSource::millis();
                 blelnServer->startOtherServerSearch(5000, BLELN_HTTP_REQUESTER_UUID, [this](bool found) {
                     if (found) {
                         Serial.println("Server mode - Switching to client mode (cleanup)...");
                         this->state = ServerModeState::OtherBLELNServerFound;
                     }
 
-                    this->lastServerSearch = millis();
+                    this->lastServerSearch = TimeSource::millis();
                 });
             }
         } else if (wm->hasFailed()) {
@@ -82,7 +95,7 @@ void ConnectivityServer::loop() {
     } else if(state==ServerModeState::OtherBLELNServerFound){
         handleAPIResponse();
 
-        if(uxQueueMessagesWaiting(apiTalksResponseQueue)==0 and uxQueueMessagesWaiting(apiTalksRequestQueue))
+        if(uxQueueMessagesWaiting(apiTalksResponseQueue)==0 and uxQueueMessagesWaiting(apiTalksRequestQueue)==0)
             switchToClient();
     }
 }
@@ -118,8 +131,11 @@ void ConnectivityServer::onMessageReceived(uint16_t cliH, const std::string &msg
             if (method == 'P' or method == 'G')
                 appendToAPITalksRequestQueue(cliH, id, parts[2], parts[3].c_str()[0], parts[4], parts[5], parts[6]);
         }
+    } else if(parts[0]=="$PING"){
+        // Keepalive of client which stays connected between requests
+        blelnServer->sendEncrypted(cliH, "$PONG");
     } else if(parts[0]=="$NTP"){
-        auto nows= static_cast<uint32_t>(time(nullptr));
+        auto nows= static_cast<uint32_t>(TimeSource::now());
         char buf[22];
         sprintf(buf, "$NTP,%d", nows);
         blelnServer->sendEncrypted(cliH, buf);
@@ -138,8 +154,9 @@ void ConnectivityServer::handleAPIResponse() {
     if (xQueueReceive(apiTalksResponseQueue, &pkt, 0) == pdTRUE) {
         if(pkt.h!=UINT16_MAX) {
             Serial.println("Sending response");
-            char msgBuf[220];
-            sprintf(msgBuf, "$ATRS,%d,%d,%d,\"%s\"", pkt.id, pkt.errc, pkt.respCode, pkt.data);
+            // Response length is bound only by BLELN_MESSAGE_MAX_LEN - longer ones are fragmented by BLELN
+            std::string msgBuf= "$ATRS," + std::to_string(pkt.id) + "," + std::to_string(pkt.errc) + ","
+                                + std::to_string(pkt.respCode) + ",\"" + pkt.data + "\"";
 
             bool r = blelnServer->sendEncrypted(pkt.h, msgBuf);
             Serial.print("Send result: ");
@@ -193,64 +210,28 @@ void ConnectivityServer::appendToAPITalksRequestQueue(uint16_t h, uint16_t id, c
 
 void ConnectivityServer::apiTalksWorker() {
     // TODO: Handle updates
+    std::vector<APITalkRequest> batch;
+    batch.reserve(API_TALKS_BATCH_MAX);
 
     while(runAPITalksWorker){
         APITalkRequest pkt{};
         if ((apiTalksRequestQueue!= nullptr) and
             (xQueueReceive(apiTalksRequestQueue, &pkt, pdMS_TO_TICKS(10)) == pdTRUE)) {
             Serial.println("New request received");
-            std::unique_ptr<WiFiClientSecure> client(new WiFiClientSecure);
-            client->setCACertBundle(rootca_crt_bundle_start);
-
-            HTTPClient https;
-
-            // Create request
-            unsigned int httpReqLen = api_url.size() + strlen(pkt.apiPoint);
-            if (pkt.method == 'G')
-                httpReqLen += strlen(pkt.data);
-
-            std::string httpReq;
-            httpReq.reserve(httpReqLen + 20);
-            httpReq.append(api_url).append(pkt.apiPoint);
-            if (pkt.method == 'G') {
-                httpReq.push_back('?');
-                httpReq.append(pkt.data);
-            }
-
-            Serial.println(httpReq.c_str());
-            Serial.println(pkt.data);
-
-            if (https.begin(*client, httpReq.c_str())) {  // HTTPS
-                int httpCode = 0;
-                if (pkt.method == 'P') {
-                    https.addHeader("x-device-id", pkt.mac);
-                    https.addHeader("x-device-picklock", pkt.picklock);
-                    https.addHeader("Content-Type", "application/json");
-
-                    httpCode = https.POST(pkt.data);
-                } else if (pkt.method == 'G') {
-                    httpCode = https.GET();
-                }
-
-                // httpCode will be negative on error
-                if (httpCode > 0) {
-                    // HTTP header has been send and Server response header has been handled
-                    appendToAPITalksResponseQueue(pkt.h, pkt.id, 0, httpCode, https.getString());
-                } else {
-                    appendToAPITalksResponseQueue(pkt.h, pkt.id, 3, 0, "");
-                    Serial.printf("[HTTPS] POST... failed, error: %s\n", HTTPClient::errorToString(httpCode).c_str());
-                }
-
-                https.end();
+            if(pkt.method == 'P' and apiTalksBatchAvailable()){
+                batch.push_back(pkt);
+                collectAPITalksBatch(batch);
+                sendAPITalksBatch(batch);
+                batch.clear();
             } else {
-                appendToAPITalksResponseQueue(pkt.h, pkt.id, 2, 0, "");
-                Serial.println("Error https begin");
+                sendAPITalk(pkt);
+                freeAPITalkRequest(pkt);
             }
+        }
 
-            free(pkt.apiPoint);
-            free(pkt.data);
-            free(pkt.mac);
-            free(pkt.picklock);
+        if(apiHttpsClient and (TimeSource::millis() - apiHttpsLastUse) >= apiHttpsIdleTimeout){
+            Serial.println("API HTTPS connection idle, closing");
+            closeApiHttps();
         }
 
         if(uxQueueMessagesWaiting(apiTalksRequestQueue)>0){
@@ -259,13 +240,312 @@ void ConnectivityServer::apiTalksWorker() {
             vTaskDelay(pdMS_TO_TICKS(100));
         }
 
-        if((millis() - lastWaterMarkPrint) >= 10000) {
+        if((TimeSource::millis() - lastWaterMarkPrint) >= 10000) {
             UBaseType_t freeWords = uxTaskGetStackHighWaterMark(nullptr);
             Serial.printf("Connectivity API talks stack free: %u\n\r",
                           freeWords);
-            lastWaterMarkPrint= millis();
+            lastWaterMarkPrint= TimeSource::millis();
+        }
+    }
+
+    closeApiHttps();
+}
+
+bool ConnectivityServer::apiTalksBatchAvailable() {
+    if(apiTalksBatchUnsupported and (TimeSource::millis() - apiTalksBatchUnsupportedAt) >= API_TALKS_BATCH_RETRY_MS)
+        apiTalksBatchUnsupported= false;
+
+    return !apiTalksBatchUnsupported;
+}
+
+void ConnectivityServer::collectAPITalksBatch(std::vector<APITalkRequest> &batch) {
+    unsigned long start= TimeSource::millis();
+    while(batch.size() < API_TALKS_BATCH_MAX){
+        unsigned long waited= TimeSource::millis() - start;
+        if(waited >= API_TALKS_BATCH_WINDOW_MS)
+            break;
+
+        APITalkRequest pkt{};
+        if(xQueueReceive(apiTalksRequestQueue, &pkt, pdMS_TO_TICKS(API_TALKS_BATCH_WINDOW_MS - waited)) != pdTRUE)
+            break;
+
+        if(pkt.method == 'P'){
+            batch.push_back(pkt);
+        } else {
+            // GET carries its data in url - not batched
+            sendAPITalk(pkt);
+            freeAPITalkRequest(pkt);
+        }
+    }
+}
+
+/**
+ * Batch API talk
+ * POST API_TALKS_BATCH_POINT {"talks":[{"id":0,"mac":"...","picklock":"...","point":"light/get.php","data":"..."}, ...]}
+ *  * id - index of talk in batch
+ * Response 200 {"talks":[{"id":0,"code":200,"body":"..."}, ...]}
+ *  * code, body - what single request of this talk would get
+ * Response 404 - server without batch endpoint, talks are sent one by one
+ */
+void ConnectivityServer::sendAPITalksBatch(std::vector<APITalkRequest> &batch) {
+    if(batch.size() == 1){
+        sendAPITalk(batch[0]);
+        freeAPITalkRequest(batch[0]);
+        return;
+    }
+
+    std::string body;
+    {
+        DynamicJsonDocument doc(API_TALKS_BATCH_JSON_DOC_SIZE);
+        JsonArray talks= doc.createNestedArray("talks");
+        for(size_t i=0; i<batch.size(); i++){
+            JsonObject t= talks.createNestedObject();
+            t["id"]= i;
+            t["mac"]= (const char*)batch[i].mac;
+            t["picklock"]= (const char*)batch[i].picklock;
+            t["point"]= (const char*)batch[i].apiPoint;
+            t["data"]= (const char*)batch[i].data;
         }
+        serializeJson(doc, body);
     }
+
+    Serial.printf("Sending batch of %u API talks\r\n", (unsigned)batch.size());
+    APIHttpsTiming timing{};
+    HTTPClient https;
+    https.setReuse(true);
+    std::string httpReq= api_url + API_TALKS_BATCH_POINT;
+    bool sendSingle= false;
+    bool begun;
+    int httpCode;
+    String resp;
+
+    do {
+        WiFiClientSecure *client= connectApiHttps(timing);
+        begun= (client != nullptr and https.begin(*client, httpReq.c_str()));
+        if(!begun)
+            break;
+
+        https.addHeader("Content-Type", "application/json");
+        unsigned long transferStart= TimeSource::millis();
+        httpCode = https.POST(body.c_str());
+        if(httpCode > 0)
+            resp= https.getString();
+        timing.transferMs= TimeSource::millis() - transferStart;
+    } while(retryStaleApiHttps(https, httpCode, timing));
+
+    if (begun) {  // HTTPS
+        if(httpCode == HTTP_CODE_NOT_FOUND){
+            Serial.println("Batch API talks not supported by server, sending one by one");
+            apiTalksBatchUnsupported= true;
+            apiTalksBatchUnsupportedAt= TimeSource::millis();
+            sendSingle= true;
+        } else if(httpCode == HTTP_CODE_OK){
+            DynamicJsonDocument doc(API_TALKS_BATCH_JSON_DOC_SIZE);
+            std::vector<bool> answered(batch.size(), false);
+            // Talk missing in answer - server error. Unreadable answer - API has already executed the batch,
+            // so its talks are reported as response lost, not as failed requests.
+            uint8_t unansweredErrc= 3;
+
+            // Mutable input - strings stay in resp, document holds only nodes, so long day configs fit
+            DeserializationError err= deserializeJson(doc, resp.begin(), resp.length());
+            if(err == DeserializationError::Ok){
+                for(JsonObject t: doc["talks"].as<JsonArray>()){
+                    size_t i= t["id"] | batch.size();
+                    if(i >= batch.size() or answered[i])
+                        continue;
+
+                    answered[i]= true;
+                    appendToAPITalksResponseQueue(batch[i].h, batch[i].id, 0, t["code"] | 0,
+                                                  t["body"] | "");
+                }
+            } else {
+                Serial.printf("Batch API talks response parse error: %s\r\n", err.c_str());
+                unansweredErrc= API_TALK_ERRC_RESPONSE_LOST;
+            }
+
+            for(size_t i=0; i<batch.size(); i++){
+                if(!answered[i])
+                    appendToAPITalksResponseQueue(batch[i].h, batch[i].id, unansweredErrc, 0, "");
+            }
+        } else if(httpCode > 0){
+            // Whole batch rejected - every talk gets what server said
+            for(auto &pkt: batch)
+                appendToAPITalksResponseQueue(pkt.h, pkt.id, 0, httpCode, resp);
+        } else {
+            for(auto &pkt: batch)
+                appendToAPITalksResponseQueue(pkt.h, pkt.id, 3, 0, "");
+            Serial.printf("[HTTPS] POST... failed, error: %s\n", HTTPClient::errorToString(httpCode).c_str());
+        }
+
+        finishApiHttps(https, httpCode, timing);
+    } else {
+        for(auto &pkt: batch)
+            appendToAPITalksResponseQueue(pkt.h, pkt.id, 2, 0, "");
+        Serial.println("Error https begin");
+    }
+
+    for(auto &pkt: batch){
+        if(sendSingle)
+            sendAPITalk(pkt);
+        freeAPITalkRequest(pkt);
+    }
+}
+
+void ConnectivityServer::sendAPITalk(const APITalkRequest &pkt) {
+    APIHttpsTiming timing{};
+    HTTPClient https;
+    https.setReuse(true);
+
+    // Create request
+    unsigned int httpReqLen = api_url.size() + strlen(pkt.apiPoint);
+    if (pkt.method == 'G')
+        httpReqLen += strlen(pkt.data);
+
+    std::string httpReq;
+    httpReq.reserve(httpReqLen + 20);
+    httpReq.append(api_url).append(pkt.apiPoint);
+    if (pkt.method == 'G') {
+        httpReq.push_back('?');
+        httpReq.append(pkt.data);
+    }
+
+    Serial.println(httpReq.c_str());
+    Serial.println(pkt.data);
+
+    bool begun;
+    int httpCode;
+    String resp;
+
+    do {
+        WiFiClientSecure *client= connectApiHttps(timing);
+        begun= (client != nullptr and https.begin(*client, httpReq.c_str()));
+        if(!begun)
+            break;
+
+        httpCode = 0;
+        unsigned long transferStart= TimeSource::millis();
+        if (pkt.method == 'P') {
+            https.addHeader("x-device-id", pkt.mac);
+            https.addHeader("x-device-picklock", pkt.picklock);
+            https.addHeader("Content-Type", "application/json");
+
+            httpCode = https.POST(pkt.data);
+        } else if (pkt.method == 'G') {
+            httpCode = https.GET();
+        }
+
+        if (httpCode > 0)
+            resp= https.getString();
+        timing.transferMs= TimeSource::millis() - transferStart;
+    } while(retryStaleApiHttps(https, httpCode, timing));
+
+    if (begun) {  // HTTPS
+        // httpCode will be negative on error
+        if (httpCode > 0) {
+            // HTTP header has been send and Server response header has been handled
+            appendToAPITalksResponseQueue(pkt.h, pkt.id, 0, httpCode, resp);
+        } else {
+            appendToAPITalksResponseQueue(pkt.h, pkt.id, 3, 0, "");
+            Serial.printf("[HTTPS] POST... failed, error: %s\n", HTTPClient::errorToString(httpCode).c_str());
+        }
+
+        finishApiHttps(https, httpCode, timing);
+    } else {
+        appendToAPITalksResponseQueue(pkt.h, pkt.id, 2, 0, "");
+        Serial.println("Error https begin");
+    }
+}
+
+WiFiClientSecure* ConnectivityServer::connectApiHttps(APIHttpsTiming &timing) {
+    timing= APIHttpsTiming{};
+    if(apiHttpsClient and apiHttpsClient->connected()){
+        timing.reused= true;
+        timing.idleMs= TimeSource::millis() - apiHttpsLastUse;
+        return apiHttpsClient.get();
+    }
+
+    if(!apiHttpsClient){
+        apiHttpsClient.reset(new WiFiClientSecure);
+        apiHttpsClient->setCACertBundle(rootca_crt_bundle_start);
+    } else {
+        // Closed by API host or broken
+        apiHttpsClient->stop();
+    }
+
+    // Name resolution is done here, not by connect, to tell its time apart
+    unsigned long start= TimeSource::millis();
+    IPAddress ip;
+    if(!WiFi.hostByName(apiHost.c_str(), ip)){
+        Serial.println("API host name resolution failed");
+        return nullptr;
+    }
+    timing.dnsMs= TimeSource::millis() - start;
+
+    start= TimeSource::millis();
+    if(!apiHttpsClient->connect(ip, API_HTTPS_PORT, apiHost.c_str(), nullptr, nullptr, nullptr)){
+        Serial.println("API host connect failed");
+        return nullptr;
+    }
+    timing.handshakeMs= TimeSource::millis() - start;
+
+    return apiHttpsClient.get();
+}
+
+bool ConnectivityServer::retryStaleApiHttps(HTTPClient &https, int httpCode, const APIHttpsTiming &timing) {
+    // Request surely did not reach the host. Connection lost may come after the host has executed it - POSTs
+    // (whole batches too) must not be applied twice, so such request is not sent again.
+    bool notSent= httpCode == HTTPC_ERROR_SEND_HEADER_FAILED or httpCode == HTTPC_ERROR_NOT_CONNECTED;
+    if(!timing.reused or (!notSent and httpCode != HTTPC_ERROR_CONNECTION_LOST))
+        return false;
+
+    // Reused connection closed by host - it keeps idle connections shorter than we do, next ones are closed sooner
+    unsigned long learned= timing.idleMs / 2;
+    if(learned < API_HTTPS_IDLE_TIMEOUT_MIN_MS)
+        learned= API_HTTPS_IDLE_TIMEOUT_MIN_MS;
+    if(learned < apiHttpsIdleTimeout){
+        apiHttpsIdleTimeout= learned;
+        Serial.printf("Server mode - API HTTPS idle timeout lowered to %lu ms\r\n", apiHttpsIdleTimeout);
+    }
+
+    // Next try is never a reused one
+    if(!notSent)
+        return false;
+
+    Serial.printf("Server mode - API HTTPS connection closed by host (%s), reconnecting\r\n",
+                  HTTPClient::errorToString(httpCode).c_str());
+    https.end();
+    closeApiHttps();
+    return true;
+}
+
+void ConnectivityServer::finishApiHttps(HTTPClient &https, int httpCode, const APIHttpsTiming &timing) {
+    // Connection stays open when API host answered with keep-alive
+    https.end();
+
+    if(httpCode > 0){
+        apiHttpsLastUse= TimeSource::millis();
+    } else {
+        // Broken connection - next request makes a new one
+        closeApiHttps();
+    }
+
+    Serial.printf("Server mode - API HTTPS request (%s): dns %lu ms, handshake %lu ms, transfer %lu ms\r\n",
+                  timing.reused ? "reused" : "new", timing.dnsMs, timing.handshakeMs, timing.transferMs);
+}
+
+void ConnectivityServer::closeApiHttps() {
+    if(apiHttpsClient){
+        apiHttpsClient->stop();
+        apiHttpsClient.reset();
+    }
+}
+
+void ConnectivityServer::freeAPITalkRequest(APITalkRequest &pkt) {
+    free(pkt.apiPoint);
+    free(pkt.data);
+    free(pkt.mac);
+    free(pkt.picklock);
+    pkt= APITalkRequest{};
 }
 
 void ConnectivityServer::requestApiTalk(char method, const char *mac, const char *picklock, const std::string &point, const std::string &data) {
@@ -33,7 +33,24 @@
 #include <HTTPUpdate.h>
 #include "Connectivity.h"
 
+#include <vector>
+#include <memory>
+
 #define BLELN_SERVER_SEARCH_INTERVAL_MS     (5*60000)   // 5 min
+#define BLELN_SERVER_LOAD_UPDATE_MS         1000        // Advertised load refresh
+
+// POST API talks of this server and its clients are coalesced into one multi-device request
+#define API_TALKS_BATCH_POINT               "light/batch.php"
+#define API_TALKS_BATCH_WINDOW_MS           1000        // From first talk of batch - settings fetches are not urgent
+#define API_TALKS_BATCH_MAX                 8
+#define API_TALKS_BATCH_RETRY_MS            (60*60000)  // 1 h - batch endpoint said 404, single requests meanwhile
+#define API_TALKS_BATCH_JSON_DOC_SIZE       4096        // Nodes only - response is parsed in place, strings are not copied
+#define API_TALK_ERRC_RESPONSE_LOST         5
+
+// One keep-alive HTTPS connection to API host is reused by all API talks
+#define API_HTTPS_PORT                      443
+#define API_HTTPS_IDLE_TIMEOUT_MS           70000       // Light control talks every 60 s - connection lives from one to the next
+#define API_HTTPS_IDLE_TIMEOUT_MIN_MS       2000        // Lowest learned timeout, for hosts closing idle connections early
 
 struct APITalkRequest {
     uint16_t h;
@@ -45,10 +62,21 @@ struct APITalkRequest {
     char *data; // malloc/free
 };
 
+// Time of one API HTTPS request - dns and handshake (TCP + TLS) are 0 when connection was reused
+struct APIHttpsTiming {
+    bool reused;
+    unsigned long idleMs;       // Of reused connection, since its previous request
+    unsigned long dnsMs;
+    unsigned long handshakeMs;
+    unsigned long transferMs;
+};
+
 struct APITalkResponse {
     uint16_t h;
     uint16_t id;
-    uint8_t errc;   // Error code: 0 - no error, 1 - WiFi error, 2 - HTTP Connect error, 3 - Server error
+    uint8_t errc;   // Error code: 0 - no error, 1 - WiFi error, 2 - HTTP Connect error, 3 - Server error,
+                    //  4 - Not delivered (client side, no answer from BLELN server),
+                    //  5 - Response lost (batch executed by API, its response unreadable - do not repeat)
     uint16_t respCode;
     char *data;
 };
@@ -81,13 +109,31 @@ private:
     void handleAPIResponse();
     // Server mode variables
     unsigned long lastServerSearch= 0;
+    unsigned long lastLoadUpdate= 0;
 
     // API Talk mathods
     void appendToAPITalksRequestQueue(uint16_t h, uint16_t id, const std::string& apiPoint, char method, const std::string &mac, const std::string &picklock, const std::string &data);
     void appendToAPITalksResponseQueue(uint16_t h, uint16_t id, uint8_t errc, uint16_t respCode, const String& data);
 
+    // API talks worker methods - worker task only
+    void collectAPITalksBatch(std::vector<APITalkRequest> &batch);
+    void sendAPITalksBatch(std::vector<APITalkRequest> &batch);
+    void sendAPITalk(const APITalkRequest &pkt);
+    static void freeAPITalkRequest(APITalkRequest &pkt);
+    bool apiTalksBatchAvailable();
+    WiFiClientSecure* connectApiHttps(APIHttpsTiming &timing);
+    bool retryStaleApiHttps(HTTPClient &https, int httpCode, const APIHttpsTiming &timing);
+    void finishApiHttps(HTTPClient &https, int httpCode, const APIHttpsTiming &timing);
+    void closeApiHttps();
+
     // API Talk variables
     bool runAPITalksWorker;
+    bool apiTalksBatchUnsupported= false;          // Batch endpoint answered 404
+    unsigned long apiTalksBatchUnsupportedAt= 0;
+    std::unique_ptr<WiFiClientSecure> apiHttpsClient;
+    std::string apiHost;
+    unsigned long apiHttpsLastUse= 0;
+    unsigned long apiHttpsIdleTimeout= API_HTTPS_IDLE_TIMEOUT_MS;  // Lowered when API host closes connection sooner
     QueueHandle_t apiTalksRequestQueue;
     QueueHandle_t apiTalksResponseQueue;
 
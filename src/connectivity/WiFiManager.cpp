@@ -19,6 +19,7 @@
 */
 
 #include "WiFiManager.h"
+#include "TimeSource.h"
 
 void WiFiManager::startConnect(const std::string &timezone, const std::string &wifiSSID, const std::string &wifiPsk) {
     if(!runMainLoop and !loopRunning){
@@ -40,7 +41,7 @@ void WiFiManager::stop() {
 }
 
 void WiFiManager::loop() {
-    connectStartMs= millis();
+    connectStartMs= TimeSource::millis();
     WiFiClass::mode(WIFI_STA);
     WiFi.begin(ssid.c_str(), psk.c_str());
     state= WiFiState::Connecting;
@@ -49,23 +50,23 @@ void WiFiManager::loop() {
         if (state == WiFiState::Connecting) {
             if (WiFi.isConnected()) {
                 configTzTime(tz.c_str(), "pool.ntp.org");
-                timeSyncStartMs= millis();
+                timeSyncStartMs= TimeSource::millis();
                 Serial.println("WiFi Manager - Waiting for NTP time sync...");
                 state = WiFiState::NTPSyncing;
-            } else if ((millis() - connectStartMs) >= WIFI_CONNECT_MAX_DURATION_MS) {
+            } else if ((TimeSource::millis() - connectStartMs) >= WIFI_CONNECT_MAX_DURATION_MS) {
                 Serial.println("WiFi Manager - WiFi connectiong timeout");
                 state = WiFiState::ConnectFailed;
             }
         } else if (state == WiFiState::NTPSyncing) { // Wait for time sync with NTP
-            time_t nowSecs = time(nullptr);
+            time_t nowSecs = TimeSource::now();
             if (nowSecs < (60 * 60 * 24 * 365 * 30)) { // 60s * 60m * 24h * 365days * 30years
-                if ((millis() - timeSyncStartMs) >= (15 * 1000)) { // Wait max 15s
+                if ((TimeSource::millis() - timeSyncStartMs) >= (15 * 1000)) { // Wait max 15s
                     Serial.println("WiFi Manager - Time sync failed! (inf loop)");
                     state = WiFiState::NTPSyncFailed;
                 }
             } else {
                 struct tm timeinfo{};
-                getLocalTime(&timeinfo);
+                TimeSource::localTime(&timeinfo);
                 Serial.print(F("WiFi Manager - Time synced - "));
                 Serial.println(asctime(&timeinfo));
 
@@ -75,7 +76,7 @@ void WiFiManager::loop() {
             if (ntpRetriesCnt < WIFI_NTP_MAX_RETIRES) {
                 Serial.println("WiFi Manager - Time sync will be retried!");
                 state = WiFiState::Connecting;
-                connectStartMs = millis();
+                connectStartMs = TimeSource::millis();
                 ntpRetriesCnt++;
             } else {
                 state = WiFiState::ConnectFailed;
@@ -86,7 +87,7 @@ void WiFiManager::loop() {
             overallFails++;
         } else if (state == WiFiState::Ready){
             if(!WiFi.isConnected()){
-                connectStartMs= millis();
+                connectStartMs= TimeSource::millis();
                 state= WiFiState::Connecting;
             }
         }
@@ -108,6 +109,10 @@ bool WiFiManager::hasFailed() {
     return state==WiFiState::ConnectFailed;
 }
 
+int8_t WiFiManager::getRssi() {
+    return isConnected() ? WiFi.RSSI() : 0;
+}
+
 bool WiFiManager::isRunning() {
     return loopRunning;
 }
@@ -36,6 +36,7 @@ public:
     bool isConnected();
     bool isRunning();
     bool hasFailed();
+    int8_t getRssi();    // dBm, 0 when not connected
 
 private:
     WiFiState state= WiFiState::Init;
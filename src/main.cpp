@@ -49,14 +49,17 @@
 #include "DeviceConfig.h"
 #include "ConfigManager.h"
 #include "InternalTempSensor.h"
+#include "LightControl.h"
+#include "TimeSource.h"
 
 #include "config.h"
 #include "connectivity/Connectivity.h"
+#include "bleln/BLELNCertCache.h"
+#include "bleln/BLELNKeyPool.h"
 
 #define WIFI_RUN_INTERVAL       120
 #define API_RUN_INTERVAL        600
 #define DAY_UPDATE_INTERVAL     1
-#define API_TALK_INTERVAL       60
 
 int deviceMode;
 Preferences prefs;
@@ -64,6 +67,7 @@ Connectivity connectivity;
 
 PWMLed light(0, pinout_intensity, 200);
 Day day;
+LightControl lightControl(&light, &day, pinout_fan);
 std::string timezone;
 
 //Read wifi configuration
@@ -77,18 +81,6 @@ void updateTicker(){
 }
 
 
-int nowDayTime(){
-    struct tm timeinfo{};
-    if(!getLocalTime(&timeinfo)){
-        return 0;
-    }
-
-    time_t t;
-    time(&t);
-
-    return timeinfo.tm_hour*3600 + timeinfo.tm_min*60 + timeinfo.tm_sec;
-}
-
 void printHello(){
     uint64_t fmac= ESP.getEfuseMac();
     auto *mac= reinterpret_cast<uint8_t *>(&fmac);
@@ -137,30 +129,20 @@ bool runConnectivity= false;
 void connectivityLoop(){
     while(runConnectivity){
         connectivity.loop();
+        BLELNCertCache::flush();
 
-        if(lastWaterMarkPrint+10000 < millis()) {
+        if(lastWaterMarkPrint+10000 < TimeSource::millis()) {
             UBaseType_t freeWords = uxTaskGetStackHighWaterMark(nullptr);
             Serial.printf("Connectivity loop stack free: %u\n\r",
                           freeWords);
-            lastWaterMarkPrint= millis();
-        }
-    }
-}
 
-int getUIntValue(const std::string &text, const std::string &key){
-    size_t kpos= text.find(key);
-    unsigned int klen= key.length();
-
-    if(kpos != std::string::npos){
-        try {
-            return std::stoi(text.substr(kpos + klen));
-        } catch (std::invalid_argument &e){
-            return -2;
-        } catch (std::out_of_range &e) {
-            return -3;
+            uint32_t certHits= BLELNCertCache::getHits();
+            uint32_t certLookups= certHits + BLELNCertCache::getMisses();
+            Serial.printf("Stats - cert cache hits: %u/%u (%u%%), key pool hits: %u, misses: %u\n\r",
+                          certHits, certLookups, certLookups > 0 ? (certHits*100/certLookups) : 0,
+                          BLELNKeyPool::getHits(), BLELNKeyPool::getMisses());
+            lastWaterMarkPrint= TimeSource::millis();
         }
-    } else {
-        return -1;
     }
 }
 
@@ -200,32 +182,7 @@ void setup() {
     //Setup WiFi
     connectivity.start(deviceMode, &config, &prefs, [](int id, int errc, int httpCode, const std::string &msg){
         if(errc==0 and httpCode==200) {
-            int val;
-
-            //Read DLI value
-            val = getUIntValue(msg, "\"DLI\":");
-            if (val >= 0)
-                day.setDli(val);
-
-            //Read DS value
-            val = getUIntValue(msg, "\"DS\":");
-            if (val >= 0)
-                day.setDs(val);
-
-            //Read DE value
-            val = getUIntValue(msg, "\"DE\":");
-            if (val >= 0)
-                day.setDe(val);
-
-            //Read SSD value
-            val = getUIntValue(msg, "\"SSD\":");
-            if (val >= 0)
-                day.setSsd(val);
-
-            //Read SRD value
-            val = getUIntValue(msg, "\"SRD\":");
-            if (val >= 0)
-                day.setSrd(val);
+            lightControl.applyApiResponse(msg);
 
             Serial.println("main - Day configuration received");
             Serial.printf("main - DS: %d, DE: %d, SSD: %d, SRD: %d, DLI: %d\r\n", day.getDs(), day.getDe(),
@@ -262,7 +219,6 @@ int lastAPI=-(API_RUN_INTERVAL/2);
 uint32_t loopTicks=0;
 uint32_t lastLedChange=0;
 uint8_t ledState=0;
-uint32_t lastServerTalk=0;
 
 
 // NEVER BLOCK INSIDE!
@@ -277,17 +233,9 @@ void loop() {
 
         delay(10);
     } else {
-        // Set pwm infill
-        auto nowsse= static_cast<uint32_t>(time(nullptr));    // [seconds] since epoch
-        float intensity= day.getSunIntensity(nowDayTime(), light.getIntensity());
-        light.setIntensity(intensity);
-        if(intensity>30.0) {
-            digitalWrite(pinout_fan, HIGH);
-        } else {
-            digitalWrite(pinout_fan, LOW);
-        }
+        lightControl.update();
 
-        if(lastServerTalk+API_TALK_INTERVAL < nowsse){
+        if(lightControl.isApiTalkDue()){
             Serial.println("main - Request API Talk");
             float t= InternalTempSensor_read();
             uint8_t mac[6];
@@ -295,7 +243,6 @@ void loop() {
             char buf[100];
             sprintf(buf, "fv=%d&t=%d", fw_version, (int)t);
             connectivity.startAPITalk("light/get.php", 'P', mac, config.getPicklock(), buf);
-            lastServerTalk= nowsse;
         }
     }
 }
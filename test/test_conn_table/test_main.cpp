@@ -0,0 +1,154 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include <unity.h>
+#include <vector>
+#include "bleln/BLELNConnTable.h"
+
+// Handles mapping to the same home slot (h % BLELN_CONN_TABLE_SIZE)
+#define H_A     1
+#define H_B     (1 + BLELN_CONN_TABLE_SIZE)
+#define H_C     (1 + 2*BLELN_CONN_TABLE_SIZE)
+
+static BLELNConnTable *table;
+
+void setUp() {
+    table= new BLELNConnTable();
+}
+
+void tearDown() {
+    delete table;
+    table= nullptr;
+}
+
+
+void test_add_find_remove() {
+    BLELNConnCtx *c= table->add(5);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL_UINT16(5, c->getHandle());
+    TEST_ASSERT_EQUAL_PTR(c, table->find(5));
+    TEST_ASSERT_EQUAL_UINT8(1, table->count());
+
+    table->remove(5);
+    TEST_ASSERT_NULL(table->find(5));
+    TEST_ASSERT_EQUAL_UINT8(0, table->count());
+}
+
+void test_add_existing_returns_same() {
+    BLELNConnCtx *c= table->add(7);
+    TEST_ASSERT_EQUAL_PTR(c, table->add(7));
+    TEST_ASSERT_EQUAL_UINT8(1, table->count());
+}
+
+void test_invalid_handle() {
+    TEST_ASSERT_NULL(table->add(BLE_HS_CONN_HANDLE_NONE));
+    TEST_ASSERT_NULL(table->find(BLE_HS_CONN_HANDLE_NONE));
+    TEST_ASSERT_EQUAL_UINT8(0, table->count());
+}
+
+void test_collision_probes_next_slot() {
+    BLELNConnCtx *a= table->add(H_A);
+    BLELNConnCtx *b= table->add(H_B);
+    BLELNConnCtx *c= table->add(H_C);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_TRUE(a != b and b != c and a != c);
+
+    TEST_ASSERT_EQUAL_PTR(a, table->find(H_A));
+    TEST_ASSERT_EQUAL_PTR(b, table->find(H_B));
+    TEST_ASSERT_EQUAL_PTR(c, table->find(H_C));
+    TEST_ASSERT_EQUAL_UINT16(H_B, table->find(H_B)->getHandle());
+    TEST_ASSERT_EQUAL_UINT8(3, table->count());
+}
+
+void test_collision_remove_keeps_others_reachable() {
+    table->add(H_A);
+    table->add(H_B);
+    BLELNConnCtx *c= table->add(H_C);
+
+    // Home slot freed - handles probed past it must still be found
+    table->remove(H_A);
+    TEST_ASSERT_NULL(table->find(H_A));
+    TEST_ASSERT_NOT_NULL(table->find(H_B));
+    TEST_ASSERT_EQUAL_PTR(c, table->find(H_C));
+
+    // Readding existing handle must not make a second context in the freed home slot
+    TEST_ASSERT_EQUAL_PTR(c, table->add(H_C));
+    TEST_ASSERT_EQUAL_UINT8(2, table->count());
+}
+
+void test_collision_wraps_around_table() {
+    uint16_t last= BLELN_CONN_TABLE_SIZE - 1;
+    table->add(last);
+    BLELNConnCtx *c= table->add(last + BLELN_CONN_TABLE_SIZE);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL_PTR(c, table->find(last + BLELN_CONN_TABLE_SIZE));
+}
+
+void test_full_table() {
+    for(uint16_t i=0; i<BLELN_CONN_TABLE_SIZE; i++){
+        TEST_ASSERT_NOT_NULL(table->add(H_A + i*BLELN_CONN_TABLE_SIZE));
+    }
+    TEST_ASSERT_EQUAL_UINT8(BLELN_CONN_TABLE_SIZE, table->count());
+    TEST_ASSERT_NULL(table->add(2));
+    TEST_ASSERT_EQUAL_UINT8(BLELN_CONN_TABLE_SIZE, table->count());
+
+    table->remove(H_A);
+    TEST_ASSERT_NOT_NULL(table->add(2));
+}
+
+void test_remove_unknown() {
+    table->add(H_A);
+    table->remove(H_B);
+    TEST_ASSERT_EQUAL_UINT8(1, table->count());
+}
+
+void test_clear_and_for_each() {
+    table->add(H_A);
+    table->add(H_B);
+    table->add(3);
+
+    std::vector<uint16_t> seen;
+    table->forEach([&seen](BLELNConnCtx &c){ seen.push_back(c.getHandle()); });
+    TEST_ASSERT_EQUAL_size_t(3, seen.size());
+
+    table->clear();
+    TEST_ASSERT_EQUAL_UINT8(0, table->count());
+    TEST_ASSERT_NULL(table->find(H_B));
+    seen.clear();
+    table->forEach([&seen](BLELNConnCtx &c){ seen.push_back(c.getHandle()); });
+    TEST_ASSERT_EQUAL_size_t(0, seen.size());
+}
+
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_add_find_remove);
+    RUN_TEST(test_add_existing_returns_same);
+    RUN_TEST(test_invalid_handle);
+    RUN_TEST(test_collision_probes_next_slot);
+    RUN_TEST(test_collision_remove_keeps_others_reachable);
+    RUN_TEST(test_collision_wraps_around_table);
+    RUN_TEST(test_full_table);
+    RUN_TEST(test_remove_unknown);
+    RUN_TEST(test_clear_and_for_each);
+    return UNITY_END();
+}
@@ -0,0 +1,235 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include <unity.h>
+#include <vector>
+#include "bleln/BLELNFragment.h"
+
+// Default ATT MTU (23) - 3, the smallest fragments BLELN sends
+#define FRAG_LEN    20
+
+static std::string makeFrame(size_t len) {
+    std::string f;
+    f.reserve(len);
+    for(size_t i=0; i<len; i++){
+        f.push_back((char)(i*7 + 3));
+    }
+    return f;
+}
+
+static std::vector<std::string> fragment(const std::string &frame, size_t fragLen, uint8_t seq) {
+    std::vector<std::string> frags;
+    bool r= BLELNFragmenter::send(frame, fragLen, seq, [&frags](const std::string &f){
+        frags.push_back(f);
+        return true;
+    });
+    TEST_ASSERT_TRUE(r);
+    return frags;
+}
+
+static BLELNReassembler::Result pushFrag(BLELNReassembler &ra, const std::string &frag, std::string &out) {
+    return ra.push((const uint8_t*)frag.data(), frag.size(), out);
+}
+
+void setUp() {}
+void tearDown() {}
+
+
+void test_roundtrip() {
+    std::string frame= makeFrame(100);
+    std::vector<std::string> frags= fragment(frame, FRAG_LEN, 7);
+    TEST_ASSERT_EQUAL_size_t(6, frags.size());
+
+    BLELNReassembler ra;
+    std::string out;
+    for(size_t i=0; i+1<frags.size(); i++){
+        TEST_ASSERT_TRUE(pushFrag(ra, frags[i], out) == BLELNReassembler::Result::Pending);
+    }
+    TEST_ASSERT_TRUE(pushFrag(ra, frags.back(), out) == BLELNReassembler::Result::Complete);
+    TEST_ASSERT_TRUE(out == frame);
+}
+
+void test_header_layout() {
+    std::vector<std::string> frags= fragment(makeFrame(40), FRAG_LEN, 0x42);
+    TEST_ASSERT_EQUAL_size_t(3, frags.size());
+
+    for(size_t i=0; i<frags.size(); i++){
+        TEST_ASSERT_EQUAL_UINT8(0x42, frags[i][0]);
+        TEST_ASSERT_EQUAL_UINT8(i, frags[i][1] & BLELN_FRAG_IDX_MASK);
+        TEST_ASSERT_EQUAL((i+1 == frags.size()), (frags[i][1] & BLELN_FRAG_LAST_FLAG) != 0);
+    }
+    TEST_ASSERT_EQUAL_size_t(FRAG_LEN, frags[0].size());
+    TEST_ASSERT_EQUAL_size_t(40 - 2*(FRAG_LEN - BLELN_FRAG_HDR_LEN) + BLELN_FRAG_HDR_LEN, frags[2].size());
+}
+
+void test_send_stops_on_failure() {
+    int calls= 0;
+    bool r= BLELNFragmenter::send(makeFrame(100), FRAG_LEN, 0, [&calls](const std::string&){
+        return ++calls < 2;
+    });
+    TEST_ASSERT_FALSE(r);
+    TEST_ASSERT_EQUAL_INT(2, calls);
+}
+
+void test_send_rejects_bad_sizes() {
+    auto accept= [](const std::string&){ return true; };
+    TEST_ASSERT_FALSE(BLELNFragmenter::send(makeFrame(10), BLELN_FRAG_HDR_LEN, 0, accept));
+    TEST_ASSERT_FALSE(BLELNFragmenter::send(std::string(), FRAG_LEN, 0, accept));
+    TEST_ASSERT_FALSE(BLELNFragmenter::send(makeFrame(BLELN_FRAG_FRAME_MAX_LEN + 1), 512, 0, accept));
+}
+
+void test_128_fragment_limit() {
+    size_t maxLen= BLELNFragmenter::maxFrameLen(FRAG_LEN);
+    TEST_ASSERT_EQUAL_size_t((BLELN_FRAG_IDX_MASK + 1) * (FRAG_LEN - BLELN_FRAG_HDR_LEN), maxLen);
+
+    // Exactly 128 fragments - last one has index 127
+    std::string frame= makeFrame(maxLen);
+    std::vector<std::string> frags= fragment(frame, FRAG_LEN, 1);
+    TEST_ASSERT_EQUAL_size_t(128, frags.size());
+    TEST_ASSERT_EQUAL_UINT8(BLELN_FRAG_LAST_FLAG | 127, frags.back()[1]);
+
+    BLELNReassembler ra;
+    std::string out;
+    for(auto &f: frags){
+        pushFrag(ra, f, out);
+    }
+    TEST_ASSERT_TRUE(out == frame);
+
+    // One byte more would need index 128, which does not fit in 7 bits
+    int calls= 0;
+    TEST_ASSERT_FALSE(BLELNFragmenter::send(makeFrame(maxLen + 1), FRAG_LEN, 1, [&calls](const std::string&){
+        calls++;
+        return true;
+    }));
+    TEST_ASSERT_EQUAL_INT(0, calls);
+}
+
+void test_max_frame_len_capped() {
+    TEST_ASSERT_EQUAL_size_t(0, BLELNFragmenter::maxFrameLen(BLELN_FRAG_HDR_LEN));
+    TEST_ASSERT_EQUAL_size_t(BLELN_FRAG_FRAME_MAX_LEN, BLELNFragmenter::maxFrameLen(512));
+}
+
+void test_index_gap_drops_message() {
+    std::string frame= makeFrame(100);
+    std::vector<std::string> frags= fragment(frame, FRAG_LEN, 3);
+
+    BLELNReassembler ra;
+    std::string out;
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[0], out) == BLELNReassembler::Result::Pending);
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[2], out) == BLELNReassembler::Result::Dropped);
+    // Rest of the broken message is dropped too, until the next one starts
+    for(size_t i=3; i<frags.size(); i++){
+        TEST_ASSERT_TRUE(pushFrag(ra, frags[i], out) == BLELNReassembler::Result::Dropped);
+    }
+    TEST_ASSERT_TRUE(out.empty());
+
+    std::vector<std::string> next= fragment(frame, FRAG_LEN, 4);
+    for(size_t i=0; i+1<next.size(); i++){
+        pushFrag(ra, next[i], out);
+    }
+    TEST_ASSERT_TRUE(pushFrag(ra, next.back(), out) == BLELNReassembler::Result::Complete);
+    TEST_ASSERT_TRUE(out == frame);
+}
+
+void test_missing_first_fragment() {
+    std::vector<std::string> frags= fragment(makeFrame(60), FRAG_LEN, 5);
+
+    BLELNReassembler ra;
+    std::string out;
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[1], out) == BLELNReassembler::Result::Dropped);
+}
+
+void test_duplicate_fragment() {
+    std::vector<std::string> frags= fragment(makeFrame(60), FRAG_LEN, 6);
+
+    BLELNReassembler ra;
+    std::string out;
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[0], out) == BLELNReassembler::Result::Pending);
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[1], out) == BLELNReassembler::Result::Pending);
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[1], out) == BLELNReassembler::Result::Dropped);
+    TEST_ASSERT_TRUE(pushFrag(ra, frags[2], out) == BLELNReassembler::Result::Dropped);
+}
+
+void test_duplicate_first_fragment_restarts() {
+    std::string frame= makeFrame(60);
+    std::vector<std::string> frags= fragment(frame, FRAG_LEN, 6);
+
+    // Index 0 always starts a new message, so a repeated first fragment does not double its chunk
+    BLELNReassembler ra;
+    std::string out;
+    pushFrag(ra, frags[0], out);
+    pushFrag(ra, frags[0], out);
+    for(size_t i=1; i<frags.size(); i++){
+        pushFrag(ra, frags[i], out);
+    }
+    TEST_ASSERT_TRUE(out == frame);
+}
+
+void test_seq_change_drops_message() {
+    std::vector<std::string> a= fragment(makeFrame(60), FRAG_LEN, 1);
+    std::vector<std::string> b= fragment(makeFrame(60), FRAG_LEN, 2);
+
+    BLELNReassembler ra;
+    std::string out;
+    pushFrag(ra, a[0], out);
+    TEST_ASSERT_TRUE(pushFrag(ra, b[1], out) == BLELNReassembler::Result::Dropped);
+}
+
+void test_short_fragment_dropped() {
+    BLELNReassembler ra;
+    std::string out;
+    uint8_t hdrOnly[BLELN_FRAG_HDR_LEN]= {0, BLELN_FRAG_LAST_FLAG};
+    TEST_ASSERT_TRUE(ra.push(hdrOnly, sizeof(hdrOnly), out) == BLELNReassembler::Result::Dropped);
+}
+
+void test_oversized_message_dropped() {
+    // Big fragments never marked last - buffer must stop at the longest frame, before index runs out
+    BLELNReassembler ra;
+    std::string out;
+    std::string frag(BLELN_FRAG_HDR_LEN + 200, 'x');
+    frag[0]= 9;
+
+    BLELNReassembler::Result r= BLELNReassembler::Result::Pending;
+    for(uint8_t i=0; i<=BLELN_FRAG_IDX_MASK and r == BLELNReassembler::Result::Pending; i++){
+        frag[1]= (char)i;
+        r= pushFrag(ra, frag, out);
+    }
+    TEST_ASSERT_TRUE(r == BLELNReassembler::Result::Dropped);
+    TEST_ASSERT_TRUE(out.empty());
+}
+
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip);
+    RUN_TEST(test_header_layout);
+    RUN_TEST(test_send_stops_on_failure);
+    RUN_TEST(test_send_rejects_bad_sizes);
+    RUN_TEST(test_128_fragment_limit);
+    RUN_TEST(test_max_frame_len_capped);
+    RUN_TEST(test_index_gap_drops_message);
+    RUN_TEST(test_missing_first_fragment);
+    RUN_TEST(test_duplicate_fragment);
+    RUN_TEST(test_duplicate_first_fragment_restarts);
+    RUN_TEST(test_seq_change_drops_message);
+    RUN_TEST(test_short_fragment_dropped);
+    RUN_TEST(test_oversized_message_dropped);
+    return UNITY_END();
+}
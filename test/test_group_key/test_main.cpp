@@ -0,0 +1,169 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include <unity.h>
+#include "bleln/BLELNGroupKey.h"
+#include "bleln/Encryption.h"
+
+static BLELNGroupKey *server;
+static BLELNGroupKey *client;
+
+static bool decryptFrame(BLELNGroupKey &k, const std::string &frame, std::string &out) {
+    return k.decrypt((const uint8_t*)frame.data(), frame.size(), out);
+}
+
+void setUp() {
+    server= new BLELNGroupKey();
+    client= new BLELNGroupKey();
+}
+
+void tearDown() {
+    delete server;
+    delete client;
+}
+
+
+void test_not_ready_before_generate() {
+    std::string out;
+    TEST_ASSERT_FALSE(server->isReady());
+    TEST_ASSERT_EQUAL_UINT8(0, server->getKeyId());
+    TEST_ASSERT_FALSE(server->encrypt("x", out));
+}
+
+void test_key_id_starts_at_one() {
+    TEST_ASSERT_TRUE(server->generate());
+    TEST_ASSERT_EQUAL_UINT8(1, server->getKeyId());
+    TEST_ASSERT_TRUE(server->generate());
+    TEST_ASSERT_EQUAL_UINT8(2, server->getKeyId());
+}
+
+void test_key_id_wraps_past_255_skipping_0() {
+    for(int i=1; i<=255; i++){
+        TEST_ASSERT_TRUE(server->generate());
+        TEST_ASSERT_EQUAL_UINT8(i, server->getKeyId());
+    }
+
+    // 0 means "no key" to clients - id after 255 is 1
+    TEST_ASSERT_TRUE(server->generate());
+    TEST_ASSERT_EQUAL_UINT8(1, server->getKeyId());
+    TEST_ASSERT_TRUE(server->isReady());
+}
+
+void test_key_message_after_wrap() {
+    for(int i=0; i<256; i++){
+        server->generate();
+    }
+
+    TEST_ASSERT_TRUE(client->installFromMessage(server->makeKeyMessage()));
+    TEST_ASSERT_EQUAL_UINT8(1, client->getKeyId());
+
+    std::string frame, out;
+    TEST_ASSERT_TRUE(server->encrypt("after wrap", frame));
+    TEST_ASSERT_EQUAL_UINT8(1, frame[0]);
+    TEST_ASSERT_TRUE(decryptFrame(*client, frame, out));
+    TEST_ASSERT_TRUE(out == "after wrap");
+}
+
+void test_old_key_id_rejected_after_rotation() {
+    for(int i=0; i<255; i++){
+        server->generate();
+    }
+    client->installFromMessage(server->makeKeyMessage());
+    TEST_ASSERT_EQUAL_UINT8(255, client->getKeyId());
+
+    // Server rotates (wraps to 1) - client holding key 255 must not accept frames of the new key
+    server->generate();
+    std::string frame, out;
+    TEST_ASSERT_TRUE(server->encrypt("new key", frame));
+    TEST_ASSERT_FALSE(decryptFrame(*client, frame, out));
+}
+
+void test_roundtrip_and_replay() {
+    server->generate();
+    TEST_ASSERT_TRUE(client->installFromMessage(server->makeKeyMessage()));
+
+    std::string f1, f2, out;
+    TEST_ASSERT_TRUE(server->encrypt("first", f1));
+    TEST_ASSERT_TRUE(server->encrypt("second", f2));
+    TEST_ASSERT_EQUAL_size_t(BLELN_GROUP_FRAME_OVERHEAD + 5, f1.size());
+
+    TEST_ASSERT_TRUE(decryptFrame(*client, f1, out));
+    TEST_ASSERT_TRUE(out == "first");
+    TEST_ASSERT_TRUE(decryptFrame(*client, f2, out));
+    TEST_ASSERT_TRUE(out == "second");
+
+    // Replayed and reordered frames
+    TEST_ASSERT_FALSE(decryptFrame(*client, f2, out));
+    TEST_ASSERT_FALSE(decryptFrame(*client, f1, out));
+}
+
+void test_late_joiner_skips_older_frames() {
+    server->generate();
+    std::string f1, f2, out;
+    server->encrypt("before", f1);
+
+    // Key message carries the last counter - frames sent before it are not accepted
+    TEST_ASSERT_TRUE(client->installFromMessage(server->makeKeyMessage()));
+    server->encrypt("after", f2);
+    TEST_ASSERT_FALSE(decryptFrame(*client, f1, out));
+    TEST_ASSERT_TRUE(decryptFrame(*client, f2, out));
+}
+
+void test_tampered_frame() {
+    server->generate();
+    client->installFromMessage(server->makeKeyMessage());
+
+    std::string frame, out;
+    server->encrypt("payload", frame);
+    frame[6]^= 0x01;
+    TEST_ASSERT_FALSE(decryptFrame(*client, frame, out));
+    TEST_ASSERT_FALSE(decryptFrame(*client, frame.substr(0, BLELN_GROUP_FRAME_OVERHEAD - 1), out));
+}
+
+void test_bad_key_messages() {
+    uint8_t k[BLELN_GROUP_KEY_LEN]= {};
+    std::string key= Encryption::base64Encode(k, sizeof(k));
+
+    TEST_ASSERT_FALSE(client->installFromMessage("$GKEY,0,0," + key));
+    TEST_ASSERT_FALSE(client->installFromMessage("$GKEY,256,0," + key));
+    TEST_ASSERT_FALSE(client->installFromMessage("$GKEY,-1,0," + key));
+    TEST_ASSERT_FALSE(client->installFromMessage("$GKEX,1,0," + key));
+    TEST_ASSERT_FALSE(client->installFromMessage("$GKEY,1,0"));
+    TEST_ASSERT_FALSE(client->installFromMessage("$GKEY,1,0," + Encryption::base64Encode(k, 16)));
+    TEST_ASSERT_FALSE(client->isReady());
+
+    TEST_ASSERT_TRUE(client->installFromMessage("$GKEY,255,0," + key));
+    TEST_ASSERT_EQUAL_UINT8(255, client->getKeyId());
+}
+
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_not_ready_before_generate);
+    RUN_TEST(test_key_id_starts_at_one);
+    RUN_TEST(test_key_id_wraps_past_255_skipping_0);
+    RUN_TEST(test_key_message_after_wrap);
+    RUN_TEST(test_old_key_id_rejected_after_rotation);
+    RUN_TEST(test_roundtrip_and_replay);
+    RUN_TEST(test_late_joiner_skips_older_frames);
+    RUN_TEST(test_tampered_frame);
+    RUN_TEST(test_bad_key_messages);
+    return UNITY_END();
+}
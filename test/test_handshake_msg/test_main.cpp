@@ -0,0 +1,233 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include <unity.h>
+#include "bleln/BLELNHandshakeMsg.h"
+#include "bleln/Encryption.h"
+
+#define TAG_UNKNOWN     0x7E
+
+static BLELNCert cert;
+
+static void fill(uint8_t *b, size_t len, uint8_t seed) {
+    for(size_t i=0; i<len; i++){
+        b[i]= (uint8_t)(seed + i*13);
+    }
+}
+
+static std::string record(uint8_t tag, size_t len, uint8_t seed) {
+    std::string r;
+    r.push_back((char)tag);
+    r.push_back((char)len);
+    for(size_t i=0; i<len; i++){
+        r.push_back((char)(seed + i));
+    }
+    return r;
+}
+
+static bool sameCert(const BLELNCert &a, const BLELNCert &b) {
+    return a.gen == b.gen and memcmp(a.mac, b.mac, 6) == 0
+           and memcmp(a.pubKey, b.pubKey, BLELN_DEV_PUB_KEY_LEN) == 0
+           and memcmp(a.sign, b.sign, BLELN_MANU_SIGN_LEN) == 0;
+}
+
+void setUp() {
+    cert.gen= 2;
+    fill(cert.mac, 6, 0xA0);
+    fill(cert.pubKey, BLELN_DEV_PUB_KEY_LEN, 0x11);
+    fill(cert.sign, BLELN_MANU_SIGN_LEN, 0x55);
+    cert.text= std::to_string(cert.gen) + ";" + Encryption::base64Encode(cert.mac, 6) + ";"
+               + Encryption::base64Encode(cert.pubKey, BLELN_DEV_PUB_KEY_LEN);
+}
+
+void tearDown() {}
+
+
+void test_cert_roundtrip_tlv() {
+    std::string msg= BLELNHandshakeMsg::makeCert(true, cert);
+    TEST_ASSERT_EQUAL_UINT8(BLELN_TLV_MSG_CERT, msg[0]);
+    TEST_ASSERT_EQUAL_size_t(1 + 4*2 + 1 + 6 + BLELN_DEV_PUB_KEY_LEN + BLELN_MANU_SIGN_LEN, msg.size());
+
+    BLELNCert out{};
+    out.text= "stale";
+    TEST_ASSERT_TRUE(BLELNHandshakeMsg::readCert(true, msg, out));
+    TEST_ASSERT_TRUE(sameCert(cert, out));
+    TEST_ASSERT_TRUE(out.text.empty());
+}
+
+void test_cert_roundtrip_csv() {
+    BLELNCert out{};
+    TEST_ASSERT_TRUE(BLELNHandshakeMsg::readCert(false, BLELNHandshakeMsg::makeCert(false, cert), out));
+    TEST_ASSERT_TRUE(sameCert(cert, out));
+    TEST_ASSERT_TRUE(out.text == cert.text);
+}
+
+void test_truncated_message() {
+    std::string msg= BLELNHandshakeMsg::makeCert(true, cert);
+    BLELNCert out{};
+
+    // Every cut - inside a record header or inside its value - must fail
+    for(size_t len=0; len<msg.size(); len++){
+        TEST_ASSERT_FALSE(BLELNHandshakeMsg::readCert(true, msg.substr(0, len), out));
+    }
+}
+
+void test_record_longer_than_message() {
+    std::string msg(1, (char)BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE);
+    msg+= record(BLELN_TLV_TAG_NONCE, BLELN_TEST_NONCE_LEN, 0);
+    msg[2]= (char)0xFF;
+
+    uint8_t nonce[BLELN_TEST_NONCE_LEN];
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readChallengeNonce(true, msg, nonce));
+}
+
+void test_oversized_record_value() {
+    uint8_t nonce[BLELN_TEST_NONCE_LEN + 1]= {};
+    nonce[BLELN_TEST_NONCE_LEN]= 0xEE;
+
+    // Nonce record one byte longer than the field - rejected, nothing written past the field
+    std::string msg(1, (char)BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE);
+    msg+= record(BLELN_TLV_TAG_NONCE, BLELN_TEST_NONCE_LEN + 1, 0);
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readChallengeNonce(true, msg, nonce));
+    TEST_ASSERT_EQUAL_UINT8(0xEE, nonce[BLELN_TEST_NONCE_LEN]);
+
+    // And one byte shorter
+    msg= std::string(1, (char)BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE);
+    msg+= record(BLELN_TLV_TAG_NONCE, BLELN_TEST_NONCE_LEN - 1, 0);
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readChallengeNonce(true, msg, nonce));
+}
+
+void test_unknown_tags_skipped() {
+    uint8_t nonce[BLELN_TEST_NONCE_LEN];
+    fill(nonce, sizeof(nonce), 3);
+
+    std::string msg(1, (char)BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE);
+    msg+= record(TAG_UNKNOWN, 5, 0);
+    msg+= record(TAG_UNKNOWN, 0, 0);
+    msg+= BLELNHandshakeMsg::makeChallengeNonce(true, nonce).substr(1);
+    msg+= record(TAG_UNKNOWN + 1, 255, 0);
+
+    uint8_t out[BLELN_TEST_NONCE_LEN]= {};
+    TEST_ASSERT_TRUE(BLELNHandshakeMsg::readChallengeNonce(true, msg, out));
+    TEST_ASSERT_EQUAL_MEMORY(nonce, out, sizeof(nonce));
+}
+
+void test_truncated_unknown_record_before_field() {
+    // Unknown record claiming more bytes than left hides the field behind it
+    uint8_t nonce[BLELN_TEST_NONCE_LEN]= {};
+    std::string msg(1, (char)BLELN_TLV_MSG_CHALLENGE_RESPONSE_NONCE);
+    msg+= record(TAG_UNKNOWN, 0, 0);
+    msg[2]= (char)200;
+    msg+= BLELNHandshakeMsg::makeChallengeNonce(true, nonce).substr(1);
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readChallengeNonce(true, msg, nonce));
+}
+
+void test_missing_field() {
+    std::string msg= BLELNHandshakeMsg::makeCert(true, cert);
+    // Drop sign record (last one)
+    msg.resize(msg.size() - 2 - BLELN_MANU_SIGN_LEN);
+
+    BLELNCert out{};
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readCert(true, msg, out));
+}
+
+void test_wrong_message_type() {
+    uint8_t sign[BLELN_NONCE_SIGN_LEN];
+    uint8_t nonce[BLELN_TEST_NONCE_LEN];
+    fill(sign, sizeof(sign), 1);
+    fill(nonce, sizeof(nonce), 2);
+    BLELNCert out{};
+
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readCert(true, BLELNHandshakeMsg::makeCertAndAnswer(cert, sign), out));
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readChallengeAnswer(true,
+                      BLELNHandshakeMsg::makeChallengeAnswerAndNonce(true, sign, nonce), sign));
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readAuthOk(true, ""));
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readAuthOk(true, BLELNHandshakeMsg::makeAuthOk(false)));
+    TEST_ASSERT_TRUE(BLELNHandshakeMsg::readAuthOk(true, BLELNHandshakeMsg::makeAuthOk(true)));
+}
+
+void test_challenge_roundtrips() {
+    uint8_t sign[BLELN_NONCE_SIGN_LEN];
+    uint8_t nonce[BLELN_TEST_NONCE_LEN];
+    fill(sign, sizeof(sign), 7);
+    fill(nonce, sizeof(nonce), 9);
+
+    for(int tlv=0; tlv<2; tlv++){
+        uint8_t signOut[BLELN_NONCE_SIGN_LEN]= {};
+        uint8_t nonceOut[BLELN_TEST_NONCE_LEN]= {};
+
+        TEST_ASSERT_TRUE(BLELNHandshakeMsg::readChallengeAnswerAndNonce(tlv,
+                         BLELNHandshakeMsg::makeChallengeAnswerAndNonce(tlv, sign, nonce), signOut, nonceOut));
+        TEST_ASSERT_EQUAL_MEMORY(sign, signOut, sizeof(sign));
+        TEST_ASSERT_EQUAL_MEMORY(nonce, nonceOut, sizeof(nonce));
+
+        memset(signOut, 0, sizeof(signOut));
+        TEST_ASSERT_TRUE(BLELNHandshakeMsg::readChallengeAnswer(tlv,
+                         BLELNHandshakeMsg::makeChallengeAnswer(tlv, sign), signOut));
+        TEST_ASSERT_EQUAL_MEMORY(sign, signOut, sizeof(sign));
+    }
+}
+
+void test_cert_and_answer_roundtrip() {
+    uint8_t sign[BLELN_NONCE_SIGN_LEN];
+    uint8_t signOut[BLELN_NONCE_SIGN_LEN]= {};
+    fill(sign, sizeof(sign), 0x33);
+
+    std::string msg= BLELNHandshakeMsg::makeCertAndAnswer(cert, sign);
+    BLELNCert out{};
+    TEST_ASSERT_TRUE(BLELNHandshakeMsg::readCertAndAnswer(msg, out, signOut));
+    TEST_ASSERT_TRUE(sameCert(cert, out));
+    TEST_ASSERT_EQUAL_MEMORY(sign, signOut, sizeof(sign));
+
+    msg.pop_back();
+    TEST_ASSERT_FALSE(BLELNHandshakeMsg::readCertAndAnswer(msg, out, signOut));
+}
+
+void test_ticket_roundtrip() {
+    uint8_t ticket[BLELN_RESUME_TICKET_LEN];
+    fill(ticket, sizeof(ticket), 0x21);
+
+    for(int tlv=0; tlv<2; tlv++){
+        uint8_t ticketOut[BLELN_RESUME_TICKET_LEN]= {};
+        uint32_t lifetime= 0;
+        TEST_ASSERT_TRUE(BLELNHandshakeMsg::readTicket(tlv, BLELNHandshakeMsg::makeTicket(tlv, ticket, 86400),
+                                                       ticketOut, &lifetime));
+        TEST_ASSERT_EQUAL_MEMORY(ticket, ticketOut, sizeof(ticket));
+        TEST_ASSERT_EQUAL_UINT32(86400, lifetime);
+    }
+}
+
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_cert_roundtrip_tlv);
+    RUN_TEST(test_cert_roundtrip_csv);
+    RUN_TEST(test_truncated_message);
+    RUN_TEST(test_record_longer_than_message);
+    RUN_TEST(test_oversized_record_value);
+    RUN_TEST(test_unknown_tags_skipped);
+    RUN_TEST(test_truncated_unknown_record_before_field);
+    RUN_TEST(test_missing_field);
+    RUN_TEST(test_wrong_message_type);
+    RUN_TEST(test_challenge_roundtrips);
+    RUN_TEST(test_cert_and_answer_roundtrip);
+    RUN_TEST(test_ticket_roundtrip);
+    return UNITY_END();
+}
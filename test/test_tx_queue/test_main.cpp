@@ -0,0 +1,165 @@
+/**
+    MioGiapicco Light Firmware - Firmware for Light Device of MioGiapicco system
+    Copyright (C) 2026  Dawid Kulpa
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Please feel free to contact me at any time by email <dawidkulpadev@gmail.com>
+*/
+
+#include <unity.h>
+#include "bleln/BLELNTxQueue.h"
+
+#define FRAG_LEN    20
+
+static BLELNTxQueue *q;
+
+void setUp() {
+    q= new BLELNTxQueue();
+}
+
+void tearDown() {
+    delete q;
+}
+
+
+void test_push_and_order() {
+    TEST_ASSERT_TRUE(q->empty());
+    TEST_ASSERT_TRUE(q->push("key", BLELNTxChannel::Key));
+    TEST_ASSERT_TRUE(q->pushFragmented(std::string(40, 'd'), FRAG_LEN, 1, BLELNTxChannel::Data));
+    TEST_ASSERT_EQUAL_UINT16(4, q->depth());
+
+    TEST_ASSERT_TRUE(q->front() == "key");
+    TEST_ASSERT_TRUE(q->getFrontChannel() == BLELNTxChannel::Key);
+    q->pop();
+    for(uint8_t i=0; i<3; i++){
+        TEST_ASSERT_TRUE(q->getFrontChannel() == BLELNTxChannel::Data);
+        TEST_ASSERT_EQUAL_UINT8(i, q->front()[1] & BLELN_FRAG_IDX_MASK);
+        q->pop();
+    }
+    TEST_ASSERT_TRUE(q->empty());
+}
+
+void test_byte_limit_rejects_whole_message() {
+    std::string frame(BLELN_FRAG_FRAME_MAX_LEN, 'x');
+    TEST_ASSERT_TRUE(q->push(frame, BLELNTxChannel::Data));
+    TEST_ASSERT_TRUE(q->push(frame, BLELNTxChannel::Data));
+    TEST_ASSERT_FALSE(q->push("x", BLELNTxChannel::Data));
+    TEST_ASSERT_FALSE(q->pushFragmented("x", FRAG_LEN, 0, BLELNTxChannel::Data));
+    TEST_ASSERT_EQUAL_UINT16(2, q->depth());
+
+    // Freed bytes are accounted for
+    q->pop();
+    TEST_ASSERT_TRUE(q->push("x", BLELNTxChannel::Data));
+}
+
+void test_failed_fragmentation_queues_nothing() {
+    // Longer than 128 fragments of this size
+    std::string frame(BLELNFragmenter::maxFrameLen(FRAG_LEN) + 1, 'x');
+    TEST_ASSERT_FALSE(q->pushFragmented(frame, FRAG_LEN, 0, BLELNTxChannel::Data));
+    TEST_ASSERT_TRUE(q->empty());
+    TEST_ASSERT_TRUE(q->push(std::string(BLELN_TX_QUEUE_MAX_BYTES, 'x'), BLELNTxChannel::Data));
+}
+
+void test_credits_per_round() {
+    for(int i=0; i<BLELN_TX_CREDITS; i++){
+        TEST_ASSERT_TRUE(q->takeCredit());
+    }
+    TEST_ASSERT_FALSE(q->takeCredit());
+    TEST_ASSERT_FALSE(q->takeCredit());
+
+    q->refillCredits();
+    TEST_ASSERT_TRUE(q->takeCredit());
+
+    // Refill does not stack above the per round amount
+    q->refillCredits();
+    q->refillCredits();
+    for(int i=0; i<BLELN_TX_CREDITS; i++){
+        TEST_ASSERT_TRUE(q->takeCredit());
+    }
+    TEST_ASSERT_FALSE(q->takeCredit());
+}
+
+void test_backoff_after_failure() {
+    q->push("a", BLELNTxChannel::Data);
+    TEST_ASSERT_FALSE(q->isBackingOff(1000));
+
+    TEST_ASSERT_TRUE(q->failFront(1000));
+    TEST_ASSERT_TRUE(q->isBackingOff(1000));
+    TEST_ASSERT_TRUE(q->isBackingOff(1000 + BLELN_TX_RETRY_MS - 1));
+    TEST_ASSERT_FALSE(q->isBackingOff(1000 + BLELN_TX_RETRY_MS));
+
+    // Sent at last - next notification starts without backoff
+    q->push("b", BLELNTxChannel::Data);
+    q->pop();
+    TEST_ASSERT_FALSE(q->isBackingOff(1001));
+}
+
+void test_backoff_across_millis_wrap() {
+    q->push("a", BLELNTxChannel::Data);
+    unsigned long now= (unsigned long)-5;
+
+    q->failFront(now);
+    TEST_ASSERT_TRUE(q->isBackingOff(now + 1));
+    TEST_ASSERT_TRUE(q->isBackingOff(now + BLELN_TX_RETRY_MS - 1));
+    TEST_ASSERT_FALSE(q->isBackingOff(now + BLELN_TX_RETRY_MS));
+}
+
+void test_retry_limit() {
+    q->push("a", BLELNTxChannel::Data);
+    for(int i=0; i<BLELN_TX_MAX_RETRIES; i++){
+        TEST_ASSERT_TRUE(q->failFront(i));
+    }
+    TEST_ASSERT_FALSE(q->failFront(BLELN_TX_MAX_RETRIES));
+}
+
+void test_drop_message_keeps_next() {
+    q->pushFragmented(std::string(60, 'a'), FRAG_LEN, 1, BLELNTxChannel::Data);
+    q->pushFragmented(std::string(30, 'b'), FRAG_LEN, 2, BLELNTxChannel::Data);
+    TEST_ASSERT_EQUAL_UINT16(6, q->depth());
+
+    // Failed in the middle of first message - its rest goes, second one stays whole
+    q->pop();
+    q->failFront(0);
+    q->dropMessage();
+    TEST_ASSERT_EQUAL_UINT16(2, q->depth());
+    TEST_ASSERT_EQUAL_UINT8(2, q->front()[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, q->front()[1]);
+    TEST_ASSERT_FALSE(q->isBackingOff(0));
+}
+
+void test_clear() {
+    q->push(std::string(BLELN_TX_QUEUE_MAX_BYTES, 'x'), BLELNTxChannel::Group);
+    q->failFront(100);
+    q->clear();
+
+    TEST_ASSERT_TRUE(q->empty());
+    TEST_ASSERT_FALSE(q->isBackingOff(101));
+    TEST_ASSERT_TRUE(q->push(std::string(BLELN_TX_QUEUE_MAX_BYTES, 'x'), BLELNTxChannel::Group));
+}
+
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_and_order);
+    RUN_TEST(test_byte_limit_rejects_whole_message);
+    RUN_TEST(test_failed_fragmentation_queues_nothing);
+    RUN_TEST(test_credits_per_round);
+    RUN_TEST(test_backoff_after_failure);
+    RUN_TEST(test_backoff_across_millis_wrap);
+    RUN_TEST(test_retry_limit);
+    RUN_TEST(test_drop_message_keeps_next);
+    RUN_TEST(test_clear);
+    return UNITY_END();
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+Benchmark regression gate for native benchmarks (pio run -e native_bench).
+
+Compares median times of a fresh results file against a baseline recorded on the same machine
+and fails when any case got slower than the allowed threshold.
+
+usage:
+  bench_gate.py RESULTS [--baseline FILE] [--threshold PCT] [--update-baseline]
+
+examples:
+  .pio/build/native_bench/program --out bench_output.txt
+  python3 tools/bench_gate.py bench_output.txt --update-baseline     # record baseline
+  python3 tools/bench_gate.py bench_output.txt --threshold 15        # gate
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "native", "bench", "baseline.json")
+
+
+def load(path):
+    with open(path, "r") as f:
+        data = json.load(f)
+    return {r["name"]: r for r in data["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Native benchmark regression gate")
+    parser.add_argument("results", help="JSON written by the native_bench program")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="Baseline JSON (default: native/bench/baseline.json)")
+    parser.add_argument("--threshold", type=float, default=10.0, help="Allowed median slowdown in percent (default: 10)")
+    parser.add_argument("--update-baseline", action="store_true", help="Replace baseline with given results")
+    args = parser.parse_args()
+
+    if args.update_baseline:
+        shutil.copyfile(args.results, args.baseline)
+        print("Baseline updated: " + os.path.normpath(args.baseline))
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print("No baseline at " + os.path.normpath(args.baseline) + " - record one with --update-baseline")
+        return 2
+
+    results = load(args.results)
+    baseline = load(args.baseline)
+
+    failed = []
+    print("%-40s %12s %12s %9s" % ("case", "base [us]", "now [us]", "change"))
+    for name, base in baseline.items():
+        if name not in results:
+            print("%-40s %12.2f %12s %9s" % (name, base["ns_median"] / 1000.0, "-", "missing"))
+            failed.append(name)
+            continue
+
+        now = results[name]
+        change = (now["ns_median"] - base["ns_median"]) * 100.0 / base["ns_median"] if base["ns_median"] > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  <-- REGRESSION"
+            failed.append(name)
+        print("%-40s %12.2f %12.2f %+8.1f%%%s" % (name, base["ns_median"] / 1000.0, now["ns_median"] / 1000.0, change, mark))
+
+    for name in results:
+        if name not in baseline:
+            print("%-40s %12s %12.2f %9s" % (name, "-", results[name]["ns_median"] / 1000.0, "new"))
+
+    if failed:
+        print("\n%d case(s) regressed more than %.1f%%" % (len(failed), args.threshold))
+        return 1
+
+    print("\nNo regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())